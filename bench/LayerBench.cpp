@@ -0,0 +1,263 @@
+#include <benchmark/benchmark.h>
+
+#include <EthernetFrame.hpp>
+#include <IpFrame.hpp>
+#include <Ipv6Frame.hpp>
+#include <TcpFrame.hpp>
+#include <Checksum.hpp>
+#include <Arena.hpp>
+#include <OutputBuffer.hpp>
+
+#include <sstream>
+
+#include "Packets.hpp"
+
+using namespace std;
+
+/* FRAMES */
+
+static void BM_EthernetFrameStream(benchmark::State& state)
+{
+	const vector<char> frame(makeFrame(makeDatagram(IP_PROTOCOL_TCP, state.range(0)), ETHERTYPE_IPV4));
+	istringstream input(string(frame.begin(), frame.end()));
+
+	for (auto _ : state) {
+		input.clear();
+		input.seekg(0);
+		const EthernetFrame ef(input);
+		benchmark::DoNotOptimize(ef.getIpFrame());
+	}
+	state.SetBytesProcessed(state.iterations() * frame.size());
+}
+
+static void BM_EthernetFrameBytes(benchmark::State& state)
+{
+	const vector<char> frame(makeFrame(makeDatagram(IP_PROTOCOL_TCP, state.range(0)), ETHERTYPE_IPV4));
+	Arena arena;
+
+	for (auto _ : state) {
+		const EthernetFrame ef(frame.data(), frame.size(), &arena);
+		benchmark::DoNotOptimize(ef.getIpFrame());
+		arena.reset();
+	}
+	state.SetBytesProcessed(state.iterations() * frame.size());
+}
+
+static void BM_IpFrameFromBytes(benchmark::State& state)
+{
+	const vector<char> datagram(makeDatagram(IP_PROTOCOL_TCP, state.range(0)));
+	IpFrame ipf(datagram.data(), datagram.size());
+
+	for (auto _ : state) {
+		ipf.fromBytes(datagram.data(), datagram.size());
+		benchmark::DoNotOptimize(ipf.checksumIsOk());
+	}
+	state.SetBytesProcessed(state.iterations() * datagram.size());
+}
+
+static void BM_Ipv6Frame(benchmark::State& state)
+{
+	const vector<char> datagram(makeDatagram6(IP_PROTOCOL_TCP, state.range(0)));
+	Arena arena;
+
+	for (auto _ : state) {
+		const Ipv6Frame* ipf(arena.create<Ipv6Frame>(datagram.data(), datagram.size(), &arena));
+		benchmark::DoNotOptimize(ipf->getTcpFrame());
+		arena.reset();
+	}
+	state.SetBytesProcessed(state.iterations() * datagram.size());
+}
+
+static void BM_TcpFrameFromBytes(benchmark::State& state)
+{
+	const vector<char> segment(makeTransport(IP_PROTOCOL_TCP, 0));
+	TcpFrame tcpf(segment.data());
+
+	for (auto _ : state) {
+		tcpf.fromBytes(segment.data());
+		benchmark::DoNotOptimize(tcpf.getFlags());
+	}
+}
+
+BENCHMARK(BM_EthernetFrameStream)->Arg(64)->Arg(1460);
+BENCHMARK(BM_EthernetFrameBytes)->Arg(64)->Arg(1460);
+BENCHMARK(BM_IpFrameFromBytes)->Arg(64)->Arg(1460);
+BENCHMARK(BM_Ipv6Frame)->Arg(64)->Arg(1440);
+BENCHMARK(BM_TcpFrameFromBytes);
+
+/* CHECKSUMS */
+
+typedef uint16_t (*ChecksumKernel)(const uint8_t*, const size_t&);
+
+static void runChecksum(benchmark::State& state, ChecksumKernel kernel, const bool& supported)
+{
+	vector<uint8_t> bytes(state.range(0));
+
+	if (!supported) {
+		state.SkipWithError("not supported by this CPU");
+		return;
+	}
+
+	for (size_t i(0); i < bytes.size(); i++)
+		bytes[i] = i * 31;
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(kernel(bytes.data(), bytes.size()));
+	state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+static void BM_ChecksumReference(benchmark::State& state) { runChecksum(state, Checksum::sumReference, true); }
+static void BM_ChecksumScalar(benchmark::State& state) { runChecksum(state, Checksum::sumScalar, true); }
+static void BM_ChecksumSse2(benchmark::State& state) { runChecksum(state, Checksum::sumSse2, __builtin_cpu_supports("sse2")); }
+static void BM_ChecksumAvx2(benchmark::State& state) { runChecksum(state, Checksum::sumAvx2, __builtin_cpu_supports("avx2")); }
+static void BM_ChecksumDispatch(benchmark::State& state) { runChecksum(state, Checksum::sum, true); }
+
+static void BM_ChecksumPseudoHeader(benchmark::State& state)
+{
+	uint32_t source(BENCH_SOURCE_ADDRESS);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(source);
+		benchmark::DoNotOptimize(Checksum::pseudoHeader(source, BENCH_DESTINATION_ADDRESS, IP_PROTOCOL_TCP, 1480));
+	}
+}
+
+BENCHMARK(BM_ChecksumReference)->Arg(20)->Arg(64)->Arg(1500)->Arg(65535);
+BENCHMARK(BM_ChecksumScalar)->Arg(20)->Arg(64)->Arg(1500)->Arg(65535);
+BENCHMARK(BM_ChecksumSse2)->Arg(20)->Arg(64)->Arg(1500)->Arg(65535);
+BENCHMARK(BM_ChecksumAvx2)->Arg(20)->Arg(64)->Arg(1500)->Arg(65535);
+BENCHMARK(BM_ChecksumDispatch)->Arg(20)->Arg(64)->Arg(1500)->Arg(65535);
+BENCHMARK(BM_ChecksumPseudoHeader);
+
+/* FORMATTERS */
+
+// one decoded frame of each kind, shared by the formatter benchmarks
+struct DecodedFrames {
+	vector<char> bytes;
+	vector<char> bytes6;
+	EthernetFrame ethernet;
+	EthernetFrame ethernet6;
+
+	DecodedFrames()
+		: bytes(makeFrame(makeDatagram(IP_PROTOCOL_TCP, 64), ETHERTYPE_IPV4)),
+		bytes6(makeFrame(makeDatagram6(IP_PROTOCOL_TCP, 64), ETHERTYPE_IPV6)),
+		ethernet(bytes.data(), bytes.size()), ethernet6(bytes6.data(), bytes6.size())
+	{
+	}
+};
+
+static const DecodedFrames& decodedFrames()
+{
+	static const DecodedFrames frames;
+	return frames;
+}
+
+template <typename Format>
+static void runFormatter(benchmark::State& state, Format format)
+{
+	for (auto _ : state) {
+		const string text(format(decodedFrames()));
+		benchmark::DoNotOptimize(text.data());
+	}
+}
+
+static void BM_EthernetAddressAsString(benchmark::State& state)
+{
+	runFormatter(state, [](const DecodedFrames& f) { return f.ethernet.getSourceAddressAsString(); });
+}
+
+static void BM_EthertypeAsString(benchmark::State& state)
+{
+	runFormatter(state, [](const DecodedFrames& f) { return f.ethernet.getEthertypeAsString(); });
+}
+
+static void BM_IpAddressAsString(benchmark::State& state)
+{
+	runFormatter(state, [](const DecodedFrames& f) { return f.ethernet.getIpFrame()->getSourceAddressAsString(); });
+}
+
+static void BM_IpProtocolAsString(benchmark::State& state)
+{
+	runFormatter(state, [](const DecodedFrames& f) { return f.ethernet.getIpFrame()->getProtocolAsString(); });
+}
+
+static void BM_IpPrecedenceAsString(benchmark::State& state)
+{
+	runFormatter(state, [](const DecodedFrames& f) { return f.ethernet.getIpFrame()->getPrecedenceAsString(); });
+}
+
+static void BM_Ipv6AddressAsString(benchmark::State& state)
+{
+	runFormatter(state, [](const DecodedFrames& f) { return f.ethernet6.getIpv6Frame()->getSourceAddressAsString(); });
+}
+
+static void BM_TcpPortAsString(benchmark::State& state)
+{
+	runFormatter(state, [](const DecodedFrames& f) { return f.ethernet.getIpFrame()->getTcpFrame()->getSourcePortAsString(); });
+}
+
+static void BM_TcpFlagsAsString(benchmark::State& state)
+{
+	runFormatter(state, [](const DecodedFrames& f) { return f.ethernet.getIpFrame()->getTcpFrame()->getFlagsAsString(); });
+}
+
+BENCHMARK(BM_EthernetAddressAsString);
+BENCHMARK(BM_EthertypeAsString);
+BENCHMARK(BM_IpAddressAsString);
+BENCHMARK(BM_IpProtocolAsString);
+BENCHMARK(BM_IpPrecedenceAsString);
+BENCHMARK(BM_Ipv6AddressAsString);
+BENCHMARK(BM_TcpPortAsString);
+BENCHMARK(BM_TcpFlagsAsString);
+
+/* OUTPUT BUFFER */
+
+// the same fields without a string in between; the buffer is cleared once it holds a batch's worth
+template <typename Append>
+static void runEncoder(benchmark::State& state, Append append)
+{
+	OutputBuffer out;
+
+	for (auto _ : state) {
+		append(out, decodedFrames());
+		if (out.size() >= OUTPUT_BUFFER_CHUNK_LENGTH * 8)
+			out.clear();
+	}
+}
+
+static void BM_EthernetAddressEncode(benchmark::State& state)
+{
+	runEncoder(state, [](OutputBuffer& out, const DecodedFrames& f) {
+		out.mac(reinterpret_cast<const uint8_t*>(f.ethernet.getSourceAddress()));
+	});
+}
+
+static void BM_IpAddressEncode(benchmark::State& state)
+{
+	runEncoder(state, [](OutputBuffer& out, const DecodedFrames& f) { out.ipv4(f.ethernet.getIpFrame()->getSourceAddress()); });
+}
+
+static void BM_Ipv6AddressEncode(benchmark::State& state)
+{
+	runEncoder(state, [](OutputBuffer& out, const DecodedFrames& f) { out.ipv6(f.ethernet6.getIpv6Frame()->getSourceAddress()); });
+}
+
+static void BM_DecimalEncode(benchmark::State& state)
+{
+	runEncoder(state, [](OutputBuffer& out, const DecodedFrames& f) {
+		out.decimal(f.ethernet.getIpFrame()->getTcpFrame()->getSequenceNumber());
+	});
+}
+
+static void BM_HexEncode(benchmark::State& state)
+{
+	runEncoder(state, [](OutputBuffer& out, const DecodedFrames& f) {
+		out.hex(f.ethernet.getIpFrame()->getTcpFrame()->getSequenceNumber());
+	});
+}
+
+BENCHMARK(BM_EthernetAddressEncode);
+BENCHMARK(BM_IpAddressEncode);
+BENCHMARK(BM_Ipv6AddressEncode);
+BENCHMARK(BM_DecimalEncode);
+BENCHMARK(BM_HexEncode);
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <IpFrame.hpp>
+#include <Ipv6Frame.hpp>
+#include <EthernetFrame.hpp>
+#include <CaptureFormat.hpp>
+#include <Checksum.hpp>
+
+/*
+ * Well-formed packets for the benchmarks, built in memory so every run
+ * measures the same bytes. Checksums are filled in, so decoders take the
+ * same path as on real traffic.
+ */
+
+#define BENCH_SOURCE_ADDRESS 0x0A000001
+#define BENCH_DESTINATION_ADDRESS 0x0A000002
+
+inline void store16(std::vector<char>& bytes, const unsigned& offset, const unsigned& value)
+{
+	bytes[offset] = value >> 8;
+	bytes[offset + 1] = value;
+}
+
+inline void store32(std::vector<char>& bytes, const unsigned& offset, const unsigned& value)
+{
+	store16(bytes, offset, value >> 16);
+	store16(bytes, offset + 2, value);
+}
+
+inline uint16_t complement(const char* bytes, const unsigned& length, const unsigned& pseudoHeader)
+{
+	return ~Checksum::add(pseudoHeader, Checksum::sum(reinterpret_cast<const uint8_t*>(bytes), length)) & 0xFFFF;
+}
+
+// source then destination, as they sit in an IPv6 header
+inline std::vector<char> benchAddresses6()
+{
+	std::vector<char> addresses(2 * IPV6_STD_ADDRESS_LENGTH);
+	store32(addresses, 0, 0x20010DB8);
+	store32(addresses, 12, BENCH_SOURCE_ADDRESS);
+	store32(addresses, 16, 0x20010DB8);
+	store32(addresses, 28, BENCH_DESTINATION_ADDRESS);
+	return addresses;
+}
+
+/*
+ * A transport header of the given protocol followed by payload octets, with
+ * its checksum filled in over the IPv4 pseudo-header, or the IPv6 one when
+ * addresses6 is given.
+ */
+inline std::vector<char> makeTransport(const unsigned& protocol, const unsigned& payloadLength,
+	const std::vector<char>* addresses6 = nullptr)
+{
+	const unsigned headerLength(protocol == IP_PROTOCOL_TCP ? TCP_MIN_HEADER_LENGTH
+		: protocol == IP_PROTOCOL_UDP ? UDP_HEADER_LENGTH : ICMP_HEADER_LENGTH);
+	std::vector<char> bytes(headerLength + payloadLength);
+	unsigned checkSumOffset(0);
+	unsigned pseudoHeader(0);
+
+	for (unsigned i(0); i < payloadLength; i++)
+		bytes[headerLength + i] = i * 7;
+
+	if (protocol == IP_PROTOCOL_ICMP) {
+		bytes[0] = ICMP_TYPE_ECHO_REQUEST;
+		store32(bytes, 4, 0x12340001);
+		checkSumOffset = 2;
+	} else {
+		pseudoHeader = addresses6
+			? Checksum::pseudoHeader(reinterpret_cast<const uint8_t*>(addresses6->data()), protocol, bytes.size())
+			: Checksum::pseudoHeader(BENCH_SOURCE_ADDRESS, BENCH_DESTINATION_ADDRESS, protocol, bytes.size());
+		store16(bytes, 0, 1031);
+		store16(bytes, 2, 139);
+	}
+
+	if (protocol == IP_PROTOCOL_TCP) {
+		store32(bytes, 4, 0x01020304);
+		bytes[12] = (TCP_MIN_HEADER_LENGTH / 4) << 4;
+		bytes[13] = TCP_FLAG_ACK | TCP_FLAG_PSH;
+		store16(bytes, 14, 0xFFFF);
+		checkSumOffset = 16;
+	} else if (protocol == IP_PROTOCOL_UDP) {
+		store16(bytes, 4, bytes.size());
+		checkSumOffset = 6;
+	}
+
+	store16(bytes, checkSumOffset, complement(bytes.data(), bytes.size(), pseudoHeader));
+	return bytes;
+}
+
+// the same, behind a minimal IPv4 header
+inline std::vector<char> makeDatagram(const unsigned& protocol, const unsigned& payloadLength)
+{
+	const std::vector<char> transport(makeTransport(protocol, payloadLength));
+	std::vector<char> bytes(IP_STD_MIN_HEADER_LENGTH);
+
+	bytes[0] = 0x45;
+	store16(bytes, 2, IP_STD_MIN_HEADER_LENGTH + transport.size());
+	bytes[8] = 64;
+	bytes[9] = protocol;
+	store32(bytes, 12, BENCH_SOURCE_ADDRESS);
+	store32(bytes, 16, BENCH_DESTINATION_ADDRESS);
+	store16(bytes, 10, complement(bytes.data(), IP_STD_MIN_HEADER_LENGTH, 0));
+
+	bytes.insert(bytes.end(), transport.begin(), transport.end());
+	return bytes;
+}
+
+// or behind a fixed IPv6 header with no extension headers
+inline std::vector<char> makeDatagram6(const unsigned& protocol, const unsigned& payloadLength)
+{
+	const std::vector<char> addresses(benchAddresses6());
+	const std::vector<char> transport(makeTransport(protocol, payloadLength, &addresses));
+	std::vector<char> bytes(8);
+
+	bytes[0] = 0x60;
+	store16(bytes, 4, transport.size());
+	bytes[6] = protocol;
+	bytes[7] = 64;
+
+	bytes.insert(bytes.end(), addresses.begin(), addresses.end());
+	bytes.insert(bytes.end(), transport.begin(), transport.end());
+	return bytes;
+}
+
+// an ethernet II header, with one 802.1Q tag when vlan is not 0
+inline std::vector<char> makeFrame(const std::vector<char>& datagram, const unsigned& ethertype, const unsigned& vlan = 0)
+{
+	std::vector<char> bytes(2 * ETH_STD_ADDRESS_LENGTH);
+
+	for (unsigned i(0); i < bytes.size(); i++)
+		bytes[i] = i < ETH_STD_ADDRESS_LENGTH ? 0x02 + i : 0x12 + i;
+	if (vlan) {
+		bytes.resize(bytes.size() + ETH_STD_VLAN_TAG_LENGTH);
+		store16(bytes, 2 * ETH_STD_ADDRESS_LENGTH, ETHERTYPE_VLAN);
+		store16(bytes, 2 * ETH_STD_ADDRESS_LENGTH + 2, vlan);
+	}
+	bytes.resize(bytes.size() + ETH_STD_ETHERTYPE_LENGTH);
+	store16(bytes, bytes.size() - ETH_STD_ETHERTYPE_LENGTH, ethertype);
+
+	bytes.insert(bytes.end(), datagram.begin(), datagram.end());
+	return bytes;
+}
+
+/*
+ * A classic pcap file in memory: count records cycling through a mix of
+ * IPv4 TCP, UDP and ICMP, IPv6 TCP and VLAN tagged IPv4 TCP.
+ */
+inline std::string makeCapture(const unsigned& count, const unsigned& payloadLength)
+{
+	const std::vector<char> frames[] = {
+		makeFrame(makeDatagram(IP_PROTOCOL_TCP, payloadLength), ETHERTYPE_IPV4),
+		makeFrame(makeDatagram(IP_PROTOCOL_UDP, payloadLength), ETHERTYPE_IPV4),
+		makeFrame(makeDatagram(IP_PROTOCOL_ICMP, payloadLength), ETHERTYPE_IPV4),
+		makeFrame(makeDatagram6(IP_PROTOCOL_TCP, payloadLength), ETHERTYPE_IPV6),
+		makeFrame(makeDatagram(IP_PROTOCOL_TCP, payloadLength), ETHERTYPE_IPV4, 100),
+	};
+	const unsigned kinds(sizeof(frames) / sizeof(frames[0]));
+	std::string capture;
+	uint32_t header[PCAP_FILE_HEADER_LENGTH / 4] = { PCAP_MAGIC_MICROSECONDS, 0x00040002, 0, 0, 0xFFFF, LINKTYPE_ETHERNET };
+
+	capture.append(reinterpret_cast<const char*>(header), sizeof(header));
+	for (unsigned i(0); i < count; i++) {
+		const std::vector<char>& frame(frames[i % kinds]);
+		const uint32_t record[PCAP_RECORD_HEADER_LENGTH / 4] = { i / 1000, i % 1000 * 1000,
+			static_cast<uint32_t>(frame.size()), static_cast<uint32_t>(frame.size()) };
+
+		capture.append(reinterpret_cast<const char*>(record), sizeof(record));
+		capture.append(frame.data(), frame.size());
+	}
+	return capture;
+}
@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include <CaptureReader.hpp>
+#include <EthernetFrame.hpp>
+#include <PacketSummary.hpp>
+#include <Arena.hpp>
+
+#include <sstream>
+
+#include "Packets.hpp"
+
+using namespace std;
+
+// frames decoded between arena resets, as in a worker batch
+#define BENCH_BATCH_LENGTH 256
+
+/*
+ * End to end over a synthetic capture held in memory, so the numbers are
+ * frames per second of the decoder and not of the disk.
+ */
+
+static const string& capture(const unsigned& payloadLength)
+{
+	static const string small(makeCapture(100000, 64));
+	static const string large(makeCapture(20000, 1400));
+	return payloadLength < 1000 ? small : large;
+}
+
+static void setFrameRate(benchmark::State& state, const uint64_t& frames, const uint64_t& bytes)
+{
+	state.counters["frames"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+	state.SetBytesProcessed(bytes);
+}
+
+static void BM_ReadCapture(benchmark::State& state)
+{
+	uint64_t frames(0), bytes(0);
+
+	for (auto _ : state) {
+		istringstream input(capture(state.range(0)));
+		CaptureReader reader(input);
+		CaptureRecord record;
+
+		while (reader.next(record))
+			frames++;
+		bytes += reader.getBytesRead();
+	}
+	setFrameRate(state, frames, bytes);
+}
+
+static void BM_SummarizeCapture(benchmark::State& state)
+{
+	uint64_t frames(0), bytes(0);
+
+	for (auto _ : state) {
+		istringstream input(capture(state.range(0)));
+		CaptureReader reader(input);
+		CaptureRecord record;
+		PacketSummary summary;
+
+		while (reader.next(record)) {
+			summary.fromBytes(record.data, record.capturedLength, record.timestamp);
+			benchmark::DoNotOptimize(summary.layers);
+			frames++;
+		}
+		bytes += reader.getBytesRead();
+	}
+	setFrameRate(state, frames, bytes);
+}
+
+static void BM_DecodeCapture(benchmark::State& state)
+{
+	uint64_t frames(0), bytes(0);
+	Arena arena;
+
+	for (auto _ : state) {
+		istringstream input(capture(state.range(0)));
+		CaptureReader reader(input);
+		CaptureRecord record;
+
+		while (reader.next(record)) {
+			const EthernetFrame* ef(arena.create<EthernetFrame>(record.data, record.capturedLength, &arena));
+			benchmark::DoNotOptimize(ef);
+			if (++frames % BENCH_BATCH_LENGTH == 0)
+				arena.reset();
+		}
+		arena.reset();
+		bytes += reader.getBytesRead();
+	}
+	setFrameRate(state, frames, bytes);
+}
+
+BENCHMARK(BM_ReadCapture)->Arg(64)->Arg(1400)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SummarizeCapture)->Arg(64)->Arg(1400)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DecodeCapture)->Arg(64)->Arg(1400)->Unit(benchmark::kMillisecond);
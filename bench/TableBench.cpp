@@ -0,0 +1,171 @@
+#include <benchmark/benchmark.h>
+
+#include <CaptureReader.hpp>
+#include <PacketSummary.hpp>
+#include <PacketTable.hpp>
+
+#include <sstream>
+
+#include "Packets.hpp"
+
+using namespace std;
+
+// rows appended at a time, as a worker hands over a decoded batch
+#define BENCH_TABLE_BATCH_LENGTH 256
+#define BENCH_TABLE_PORT 443
+
+/*
+ * Summaries of the synthetic capture mix, repeated to the row count asked
+ * for. Ports and timestamps are spread out, so an equality scan selects a
+ * fraction of the rows instead of all or none.
+ */
+static vector<PacketSummary> makeSummaries(const size_t& rows)
+{
+	istringstream input(makeCapture(1000, 64));
+	CaptureReader reader(input);
+	CaptureRecord record;
+	vector<PacketSummary> mix;
+	vector<PacketSummary> summaries(rows);
+
+	while (reader.next(record)) {
+		mix.emplace_back();
+		mix.back().fromBytes(record.data, record.capturedLength, record.timestamp);
+	}
+
+	for (size_t row(0); row < rows; row++) {
+		summaries[row] = mix[row % mix.size()];
+		summaries[row].timestamp += row * 1000;
+		summaries[row].destinationPort = row % 7 ? 1024 + row % 5000 : BENCH_TABLE_PORT;
+	}
+	return summaries;
+}
+
+static const PacketTable& table(const size_t& rows)
+{
+	static size_t filled(0);
+	static PacketTable packets;
+
+	if (filled != rows) {
+		const vector<PacketSummary> summaries(makeSummaries(rows));
+		packets.clear();
+		packets.append(summaries.data(), summaries.size());
+		filled = rows;
+	}
+	return packets;
+}
+
+static void setRowRate(benchmark::State& state)
+{
+	state.counters["rows"] = benchmark::Counter(state.iterations() * state.range(0), benchmark::Counter::kIsRate);
+}
+
+/* FILLING */
+
+static void BM_TableAppend(benchmark::State& state)
+{
+	const vector<PacketSummary> summaries(makeSummaries(state.range(0)));
+	PacketTable packets;
+
+	for (auto _ : state) {
+		packets.clear();
+		for (size_t row(0); row < summaries.size(); row += BENCH_TABLE_BATCH_LENGTH)
+			packets.append(summaries.data() + row, min<size_t>(BENCH_TABLE_BATCH_LENGTH, summaries.size() - row));
+		benchmark::DoNotOptimize(packets.getTimestamps());
+	}
+	setRowRate(state);
+}
+
+/* SCANS */
+
+static void BM_TableScanProtocol(benchmark::State& state)
+{
+	const PacketTable& packets(table(state.range(0)));
+	Selection selection;
+
+	for (auto _ : state) {
+		packets.scanEqual(COLUMN_PROTOCOL, IP_PROTOCOL_TCP, selection);
+		benchmark::DoNotOptimize(selection.getWords());
+	}
+	state.SetLabel(PacketTable::getImplementation());
+	setRowRate(state);
+}
+
+static void BM_TableScanPort(benchmark::State& state)
+{
+	const PacketTable& packets(table(state.range(0)));
+	Selection selection;
+
+	for (auto _ : state) {
+		packets.scanEqual(COLUMN_DESTINATION_PORT, BENCH_TABLE_PORT, selection);
+		benchmark::DoNotOptimize(selection.getWords());
+	}
+	state.SetLabel(PacketTable::getImplementation());
+	setRowRate(state);
+}
+
+static void BM_TableScanPrefix(benchmark::State& state)
+{
+	const PacketTable& packets(table(state.range(0)));
+	Selection selection;
+
+	for (auto _ : state) {
+		packets.scanPrefix(COLUMN_SOURCE_ADDRESS, BENCH_SOURCE_ADDRESS, 8, selection);
+		benchmark::DoNotOptimize(selection.getWords());
+	}
+	state.SetLabel(PacketTable::getImplementation());
+	setRowRate(state);
+}
+
+static void BM_TableScanTime(benchmark::State& state)
+{
+	const PacketTable& packets(table(state.range(0)));
+	const uint64_t start(packets.getTimestamps()[0]);
+	Selection selection;
+
+	for (auto _ : state) {
+		packets.scanRange(COLUMN_TIMESTAMP, start, start + state.range(0) * 500, selection);
+		benchmark::DoNotOptimize(selection.getWords());
+	}
+	state.SetLabel(PacketTable::getImplementation());
+	setRowRate(state);
+}
+
+// protocol == TCP && dport == 443, counted
+static void BM_TableQuery(benchmark::State& state)
+{
+	const PacketTable& packets(table(state.range(0)));
+	Selection protocol, port;
+
+	for (auto _ : state) {
+		packets.scanEqual(COLUMN_PROTOCOL, IP_PROTOCOL_TCP, protocol);
+		packets.scanEqual(COLUMN_DESTINATION_PORT, BENCH_TABLE_PORT, port);
+		protocol.intersect(port);
+		benchmark::DoNotOptimize(protocol.count());
+	}
+	state.SetLabel(PacketTable::getImplementation());
+	setRowRate(state);
+}
+
+// the same query row by row over the columns, what the scans replace
+static void BM_TableQueryLoop(benchmark::State& state)
+{
+	const PacketTable& packets(table(state.range(0)));
+	const uint8_t* protocols(packets.getProtocols());
+	const uint16_t* ports(packets.getDestinationPorts());
+
+	for (auto _ : state) {
+		size_t selected(0);
+		for (size_t row(0); row < packets.size(); row++)
+			selected += protocols[row] == IP_PROTOCOL_TCP && ports[row] == BENCH_TABLE_PORT;
+		benchmark::DoNotOptimize(selected);
+	}
+	setRowRate(state);
+}
+
+BENCHMARK(BM_TableAppend)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TableScanProtocol)->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TableScanPort)->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TableScanPrefix)->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TableScanTime)->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TableQuery)->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TableQueryLoop)->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
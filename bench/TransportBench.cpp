@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+
+#include <TcpFrame.hpp>
+#include <UdpFrame.hpp>
+#include <IcmpFrame.hpp>
+#include <TcpView.hpp>
+#include <UdpView.hpp>
+#include <IcmpView.hpp>
+#include <IpFrame.hpp>
+#include <Arena.hpp>
+#include <Checksum.hpp>
+
+#include "Packets.hpp"
+
+using namespace std;
+
+/* DECODERS */
+
+template <typename Layer, unsigned Protocol>
+static void BM_Decode(benchmark::State& state)
+{
+	const vector<char> bytes(makeTransport(Protocol, state.range(0)));
+	const unsigned pseudoHeader(Protocol == IP_PROTOCOL_ICMP ? 0
+		: Checksum::pseudoHeader(BENCH_SOURCE_ADDRESS, BENCH_DESTINATION_ADDRESS, Protocol, bytes.size()));
+
+	for (auto _ : state) {
+		const Layer layer(bytes.data(), bytes.size(), pseudoHeader);
+		bool ok(layer.checkSumIsOk());
+		benchmark::DoNotOptimize(ok);
+	}
+	state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+// headers only, no checksum: what the packet summary and the flow table pay
+template <typename View, unsigned Protocol>
+static void BM_View(benchmark::State& state)
+{
+	const vector<char> bytes(makeTransport(Protocol, state.range(0)));
+
+	for (auto _ : state) {
+		const View view(bytes.data(), bytes.size());
+		bool valid(view.isValid());
+		unsigned payloadLength(view.getPayloadLength());
+		benchmark::DoNotOptimize(valid);
+		benchmark::DoNotOptimize(payloadLength);
+	}
+	state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+// the decode path as the workers run it: IPv4 plus transport, all out of an arena
+template <unsigned Protocol>
+static void BM_Datagram(benchmark::State& state)
+{
+	const vector<char> bytes(makeDatagram(Protocol, state.range(0)));
+	Arena arena;
+
+	for (auto _ : state) {
+		const IpFrame* frame(arena.create<IpFrame>(bytes.data(), bytes.size(), &arena));
+		benchmark::DoNotOptimize(frame);
+		arena.reset();
+	}
+	state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+BENCHMARK_TEMPLATE(BM_Decode, TcpFrame, IP_PROTOCOL_TCP)->Arg(0)->Arg(64)->Arg(1460);
+BENCHMARK_TEMPLATE(BM_Decode, UdpFrame, IP_PROTOCOL_UDP)->Arg(0)->Arg(64)->Arg(1472);
+BENCHMARK_TEMPLATE(BM_Decode, IcmpFrame, IP_PROTOCOL_ICMP)->Arg(0)->Arg(56)->Arg(1472);
+
+BENCHMARK_TEMPLATE(BM_View, TcpView, IP_PROTOCOL_TCP)->Arg(64);
+BENCHMARK_TEMPLATE(BM_View, UdpView, IP_PROTOCOL_UDP)->Arg(64);
+BENCHMARK_TEMPLATE(BM_View, IcmpView, IP_PROTOCOL_ICMP)->Arg(56);
+
+BENCHMARK_TEMPLATE(BM_Datagram, IP_PROTOCOL_TCP)->Arg(64)->Arg(1460);
+BENCHMARK_TEMPLATE(BM_Datagram, IP_PROTOCOL_UDP)->Arg(64)->Arg(1472);
+BENCHMARK_TEMPLATE(BM_Datagram, IP_PROTOCOL_ICMP)->Arg(56)->Arg(1472);
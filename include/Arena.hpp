@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// measured in octets; a batch of decoded frames usually fits in the first block
+#define ARENA_BLOCK_LENGTH 0x80000
+
+/*
+ * Bump allocator for objects that all die together, such as everything
+ * decoded from one batch of frames. allocate() is a pointer increment;
+ * reset() rewinds to the first block in O(1) and keeps every block for
+ * the next round, so a worker stops calling malloc once it has warmed up.
+ * Destructors of objects made with create() never run: only types that
+ * own nothing outside the arena may live in it.
+ */
+class Arena {
+private:
+	struct Block {
+		Block* next;
+		size_t length;
+	};
+
+	Block* first;
+	Block* current;
+	char* position;
+	char* end;
+	size_t blockLength;
+	size_t reserved;
+
+	bool advance(const size_t&);
+
+public:
+	Arena(const size_t& = ARENA_BLOCK_LENGTH);
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	~Arena();
+
+	void* allocate(const size_t&, const size_t& = alignof(std::max_align_t));
+
+	template <typename T, typename... Arguments>
+	T* create(Arguments&&... arguments)
+	{
+		void* memory(allocate(sizeof(T), alignof(T)));
+		return memory ? new (memory) T(std::forward<Arguments>(arguments)...) : nullptr;
+	}
+
+	// everything allocated so far is gone
+	void reset();
+
+	size_t getReserved() const;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define CACHE_LINE_LENGTH 64
+
+/*
+ * Lock-free bounded multi-producer multi-consumer queue (Vyukov's design).
+ * Every cell carries a sequence number, so producers and consumers only
+ * ever contend on their own head/tail counter with a single CAS.
+ * Capacity is rounded up to a power of two.
+ */
+template <typename T>
+class BoundedQueue {
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::vector<Cell> cells;
+	size_t mask;
+	alignas(CACHE_LINE_LENGTH) std::atomic<size_t> head;
+	alignas(CACHE_LINE_LENGTH) std::atomic<size_t> tail;
+
+public:
+	BoundedQueue(const size_t& capacity) : head(0), tail(0)
+	{
+		size_t length(2);
+		while (length < capacity)
+			length *= 2;
+
+		cells = std::vector<Cell>(length);
+		for (size_t i(0); i < length; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		mask = length - 1;
+	}
+
+	bool push(const T& value)
+	{
+		size_t position(tail.load(std::memory_order_relaxed));
+
+		for (;;) {
+			Cell& cell(cells[position & mask]);
+			const size_t sequence(cell.sequence.load(std::memory_order_acquire));
+			const intptr_t difference(static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position));
+
+			if (difference == 0) {
+				if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					cell.value = value;
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool pop(T& value)
+	{
+		size_t position(head.load(std::memory_order_relaxed));
+
+		for (;;) {
+			Cell& cell(cells[position & mask]);
+			const size_t sequence(cell.sequence.load(std::memory_order_acquire));
+			const intptr_t difference(static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1));
+
+			if (difference == 0) {
+				if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					value = cell.value;
+					cell.sequence.store(position + mask + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+};
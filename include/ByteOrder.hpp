@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// network (big endian) loads from possibly unaligned wire bytes
+inline uint16_t load16(const uint8_t* bytes)
+{
+	uint16_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return __builtin_bswap16(value);
+}
+
+inline uint32_t load32(const uint8_t* bytes)
+{
+	uint32_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return __builtin_bswap32(value);
+}
+
+// and the matching stores, for code that writes headers
+inline void store16(uint8_t* bytes, const uint16_t& value)
+{
+	const uint16_t swapped(__builtin_bswap16(value));
+	memcpy(bytes, &swapped, sizeof(swapped));
+}
+
+inline void store32(uint8_t* bytes, const uint32_t& value)
+{
+	const uint32_t swapped(__builtin_bswap32(value));
+	memcpy(bytes, &swapped, sizeof(swapped));
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// classic pcap, measured in octets
+#define PCAP_MAGIC_MICROSECONDS		0xA1B2C3D4
+#define PCAP_MAGIC_NANOSECONDS		0xA1B23C4D
+#define PCAP_FILE_HEADER_LENGTH		24
+#define PCAP_RECORD_HEADER_LENGTH	16
+
+// pcapng, measured in octets
+#define PCAPNG_BLOCK_SECTION_HEADER			0x0A0D0D0A
+#define PCAPNG_BLOCK_INTERFACE_DESCRIPTION	0x00000001
+#define PCAPNG_BLOCK_SIMPLE_PACKET			0x00000003
+#define PCAPNG_BLOCK_ENHANCED_PACKET		0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC				0x1A2B3C4D
+#define PCAPNG_MIN_BLOCK_LENGTH				12
+// type, length, byte-order magic, version, section length and trailing length
+#define PCAPNG_SECTION_HEADER_LENGTH		28
+#define PCAPNG_OPTION_END					0
+#define PCAPNG_OPTION_IF_TSRESOL			9
+
+// enough bytes to tell the formats apart
+#define CAPTURE_DETECT_LENGTH		PCAP_FILE_HEADER_LENGTH
+// no record (pcap record or pcapng block) is accepted past this size
+#define CAPTURE_MAX_RECORD_LENGTH	0x1000000
+
+#define LINKTYPE_ETHERNET	1
+
+typedef enum {
+	CAPTURE_TYPE_UNKNOWN,
+	CAPTURE_TYPE_RAW,
+	CAPTURE_TYPE_PCAP,
+	CAPTURE_TYPE_PCAPNG
+} CaptureType;
+
+struct CaptureRecord {
+	uint64_t timestamp; // nanoseconds since the epoch
+	unsigned capturedLength;
+	unsigned originalLength;
+	unsigned linkType;
+	const char* data;
+};
+
+/*
+ * Stateless-ish parser for capture file framing. It never reads from a
+ * stream itself, so the same code splits records for the streaming reader
+ * and for anything that already holds the bytes in memory.
+ */
+class CaptureFormat {
+private:
+	struct Interface {
+		unsigned linkType;
+		uint64_t unitsPerSecond;
+	};
+
+	CaptureType type;
+	bool swapped;
+	unsigned linkType;
+	uint64_t unitsPerSecond;
+	std::vector<Interface> interfaces;
+
+	uint16_t read16(const char*) const;
+	uint32_t read32(const char*) const;
+	uint64_t toNanoseconds(const uint64_t&, const uint64_t&) const;
+
+	void parseSectionHeader(const char*, const unsigned&);
+	void parseInterfaceDescription(const char*, const unsigned&);
+	bool parseEnhancedPacket(const char*, const unsigned&, CaptureRecord&) const;
+	bool parseSimplePacket(const char*, const unsigned&, CaptureRecord&) const;
+
+public:
+	CaptureFormat();
+
+	// looks at the first CAPTURE_DETECT_LENGTH bytes (or fewer on tiny files)
+	bool detect(const char*, const unsigned&);
+
+	CaptureType getType() const;
+	const char* getTypeAsString() const;
+
+	// bytes before the first record that are not a record themselves
+	unsigned getFileHeaderLength() const;
+	// bytes needed before getRecordLength can be asked
+	unsigned getRecordHeaderLength() const;
+	// full on-disk length of the record starting at the given header, 0 if malformed
+	unsigned getRecordLength(const char*) const;
+
+	// returns true when the record carried a packet; filler blocks return false
+	bool parseRecord(const char*, const unsigned&, CaptureRecord&);
+	// the raw format has no framing at all, the whole input is one frame
+	void rawRecord(const char*, const unsigned&, CaptureRecord&) const;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CaptureFormat.hpp"
+
+#define CAPTURE_INDEX_MAGIC		"PAIDX001"
+#define CAPTURE_INDEX_SUFFIX	".idx"
+
+struct CaptureIndexEntry {
+	uint64_t offset; // of the frame bytes, from the start of the capture
+	uint64_t timestamp;
+	uint32_t capturedLength;
+	uint32_t linkType;
+};
+
+/*
+ * Where every frame of a capture starts, built by one pass over the
+ * mapped file. Saved next to the capture and trusted again only while the
+ * capture keeps the size and modification time it was built from.
+ */
+class CaptureIndex {
+private:
+	struct Header {
+		char magic[8];
+		uint64_t captureSize;
+		int64_t captureModified;
+		uint32_t captureType;
+		uint32_t reserved;
+		uint64_t entries;
+	};
+
+	std::vector<CaptureIndexEntry> entries;
+	CaptureType type;
+	bool complete;
+
+public:
+	CaptureIndex();
+
+	bool build(const char*, const uint64_t&);
+	bool load(const std::string&, const uint64_t&, const int64_t&);
+	bool save(const std::string&, const uint64_t&, const int64_t&) const;
+
+	uint64_t size() const;
+	const CaptureIndexEntry& operator[](const uint64_t&) const;
+	CaptureType getType() const;
+	// false when the pass stopped at a truncated or malformed record
+	bool isComplete() const;
+};
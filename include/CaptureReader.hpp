@@ -0,0 +1,43 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+
+#include "CaptureFormat.hpp"
+
+// measured in octets
+#define CAPTURE_READER_INITIAL_BUFFER_LENGTH 0x10000
+
+/*
+ * Pulls one record at a time out of a pcap, pcapng or raw frame stream.
+ * The record handed out points into a single reusable buffer, so it is only
+ * valid until the next call to next(), and memory stays bounded by the
+ * largest record seen (at most CAPTURE_MAX_RECORD_LENGTH).
+ */
+class CaptureReader {
+private:
+	std::istream& input;
+	CaptureFormat format;
+	char* buffer;
+	unsigned bufferLength;
+	// bytes already sitting at the start of the buffer from detection
+	unsigned pending;
+	bool ok;
+	uint64_t bytesRead;
+	uint64_t recordsRead;
+
+	bool reserve(const unsigned&);
+	bool fill(const unsigned&, const unsigned&);
+	bool nextRaw(CaptureRecord&);
+
+public:
+	CaptureReader(std::istream&);
+	~CaptureReader();
+
+	bool next(CaptureRecord&);
+
+	bool isOk() const;
+	const CaptureFormat& getFormat() const;
+	uint64_t getBytesRead() const;
+	uint64_t getRecordsRead() const;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * RFC 1071 internet checksum. Every sum is returned folded to 16 bits, in
+ * network order and not yet complemented, so sums of separate pieces (a
+ * pseudo-header and a payload) can be combined with add() before finish().
+ *
+ * sum() dispatches once, at first use, to the widest kernel the CPU runs;
+ * sumReference() is the plain word-by-word loop the kernels must agree with.
+ */
+class Checksum {
+public:
+	static uint16_t sum(const uint8_t*, const size_t&);
+
+	static uint16_t sumReference(const uint8_t*, const size_t&);
+	static uint16_t sumScalar(const uint8_t*, const size_t&);
+	static uint16_t sumSse2(const uint8_t*, const size_t&);
+	static uint16_t sumAvx2(const uint8_t*, const size_t&);
+
+	static uint16_t add(const uint32_t&, const uint32_t&);
+	static uint16_t pseudoHeader(const uint32_t&, const uint32_t&, const unsigned&, const unsigned&);
+	// IPv6: the source and destination addresses as the 32 octets they fill in the header
+	static uint16_t pseudoHeader(const uint8_t*, const unsigned&, const unsigned&);
+	static uint16_t finish(const uint32_t&);
+
+	static const char* getImplementation();
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PacketSummary.hpp"
+
+#define COLUMN_FILE_MAGIC		"PACOL001"
+// rows gathered before a row group is encoded and written
+#define COLUMN_ROW_GROUP_ROWS	0x10000
+// a dictionary holding more distinct values than this share of the rows is dropped for bit-packing
+#define COLUMN_DICTIONARY_RATIO	2
+// decoders read whole words, so chunks are loaded with this much zeroed slack
+#define COLUMN_DECODE_PADDING	16
+
+typedef enum {
+	COLUMN_TIMESTAMP,
+	COLUMN_FRAME_LENGTH,
+	COLUMN_ETHERTYPE,
+	COLUMN_LAYERS,
+	COLUMN_PROTOCOL,
+	COLUMN_SOURCE_ADDRESS,
+	COLUMN_DESTINATION_ADDRESS,
+	COLUMN_SOURCE_PORT,
+	COLUMN_DESTINATION_PORT,
+	COLUMN_TTL,
+	COLUMN_SERVICE,
+	COLUMN_IP_FLAGS,
+	COLUMN_FRAGMENT_OFFSET,
+	COLUMN_IP_LENGTH,
+	COLUMN_TCP_FLAGS,
+	COLUMN_SEQUENCE,
+	COLUMN_ACKNOWLEDGEMENT,
+	COLUMN_WINDOW,
+	COLUMN_PAYLOAD_LENGTH,
+	COLUMN_COUNT
+} ColumnId;
+
+typedef enum {
+	// zigzag varints of the difference to the previous value, the first one to the minimum
+	COLUMN_ENCODING_DELTA=1,
+	// sorted distinct values, then each row as a bit-packed index into them
+	COLUMN_ENCODING_DICTIONARY,
+	// each row minus the minimum, in just enough bits for the maximum
+	COLUMN_ENCODING_BITPACKED
+} ColumnEncoding;
+
+// where one column of one row group sits in the file, and what it holds
+struct ColumnChunk {
+	uint64_t offset;
+	uint64_t minimum;
+	uint64_t maximum;
+	uint32_t length;
+	uint8_t encoding;
+	// bits per packed value or dictionary index
+	uint8_t width;
+	uint16_t reserved;
+};
+
+struct ColumnRowGroup {
+	uint64_t firstRow;
+	uint32_t rows;
+	uint32_t reserved;
+	ColumnChunk chunks[COLUMN_COUNT];
+};
+
+/*
+ * A column file is a header, the column chunks of every row group one
+ * after the other, then a footer with one ColumnRowGroup per group and a
+ * trailer pointing back at the footer. Readers start from the trailer, so
+ * the file can be written in a single pass, and only touch the chunks of
+ * the columns they ask for. Everything is in host byte order, like the
+ * capture index.
+ */
+class ColumnFormat {
+public:
+	struct Header {
+		char magic[8];
+		uint32_t columns;
+		uint32_t rowGroupRows;
+	};
+
+	struct Trailer {
+		uint64_t footerOffset;
+		uint64_t groups;
+		uint64_t rows;
+		char magic[8];
+	};
+
+	static const char* getName(const ColumnId&);
+	static bool parseName(const std::string&, ColumnId&);
+	static ColumnEncoding getEncoding(const ColumnId&);
+	static const char* getEncodingAsString(const ColumnEncoding&);
+	static uint64_t getValue(const PacketSummary&, const ColumnId&);
+
+	// appends the encoded values to the buffer and fills in everything about the chunk but its offset
+	static void encode(const uint64_t*, const size_t&, const ColumnEncoding&, std::vector<uint8_t>&, ColumnChunk&);
+	// the input must be followed by COLUMN_DECODE_PADDING readable octets
+	static bool decode(const uint8_t*, const size_t&, const ColumnChunk&, const uint32_t&, std::vector<uint64_t>&);
+
+private:
+	static unsigned bitWidth(const uint64_t&);
+	static void putVarint(std::vector<uint8_t>&, uint64_t);
+	static bool getVarint(const uint8_t*&, const uint8_t*, uint64_t&);
+	static void pack(const uint64_t*, const size_t&, const uint64_t&, const unsigned&, std::vector<uint8_t>&);
+	static bool unpack(const uint8_t*, const size_t&, const uint64_t&, const unsigned&, const size_t&, uint64_t*);
+};
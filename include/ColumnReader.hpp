@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ColumnFormat.hpp"
+
+/*
+ * Opens a column file from its footer and hands out one column of one row
+ * group at a time. Only the chunk asked for is read from disk and decoded,
+ * and the row group statistics let a scan rule out whole groups before
+ * reading anything at all.
+ */
+class ColumnReader {
+private:
+	FILE* file;
+	uint64_t fileLength;
+	std::vector<ColumnRowGroup> groups;
+	uint64_t rows;
+	// the chunk being decoded, with COLUMN_DECODE_PADDING zeroed octets after it
+	std::vector<uint8_t> chunk;
+	uint64_t bytesRead;
+	std::string error;
+
+	bool fail(const std::string&);
+
+public:
+	ColumnReader();
+	~ColumnReader();
+
+	bool open(const std::string&);
+	bool read(const unsigned&, const ColumnId&, std::vector<uint64_t>&);
+	// false only when no row of the group can hold a value in [low, high]
+	bool mayContain(const unsigned&, const ColumnId&, const uint64_t&, const uint64_t&) const;
+
+	unsigned getRowGroupCount() const;
+	const ColumnRowGroup& getRowGroup(const unsigned&) const;
+	uint64_t getRows() const;
+	uint64_t getBytesRead() const;
+	const std::string& getError() const;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ColumnFormat.hpp"
+#include "PacketSummary.hpp"
+
+/*
+ * Gathers decoded packets into row groups of COLUMN_ROW_GROUP_ROWS and
+ * writes each column of a full group as one chunk, encoded the way
+ * ColumnFormat picks for it, with its minimum and maximum kept in the
+ * footer. Nothing is readable until close() has written the footer.
+ */
+class ColumnWriter {
+private:
+	FILE* file;
+	std::string filename;
+	std::vector<PacketSummary> pending;
+	std::vector<ColumnRowGroup> groups;
+	// one column of the pending rows, and its encoded form
+	std::vector<uint64_t> values;
+	std::vector<uint8_t> encoded;
+	uint64_t offset;
+	uint64_t rows;
+	std::string error;
+
+	bool writeRowGroup();
+	bool writeBytes(const void*, const size_t&);
+
+public:
+	ColumnWriter();
+	~ColumnWriter();
+
+	bool open(const std::string&);
+	bool append(const PacketSummary*, const size_t&);
+	bool close();
+
+	uint64_t getRows() const;
+	uint64_t getBytesWritten() const;
+	const std::string& getError() const;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#define COUNT_MIN_DEFAULT_WIDTH	2048
+#define COUNT_MIN_DEFAULT_DEPTH	4
+
+/*
+ * Count-Min sketch: depth rows of width counters, each key adding its
+ * weight to one counter per row. An estimate is the smallest of those
+ * counters, never below the true total and above it by at most
+ * e / width of everything added, with probability 1 - e^-depth. Keys are
+ * given as 64-bit hashes; the row positions are derived from its two
+ * halves, so an update costs one hash and depth adds. Two sketches of the
+ * same shape merge by adding their counters.
+ */
+class CountMinSketch {
+private:
+	std::vector<uint64_t> counters;
+	unsigned width;
+	unsigned depth;
+	uint64_t total;
+
+	unsigned getColumn(const uint64_t&, const unsigned&) const;
+
+public:
+	// the width is rounded up to a power of two
+	CountMinSketch(const unsigned& = COUNT_MIN_DEFAULT_WIDTH, const unsigned& = COUNT_MIN_DEFAULT_DEPTH);
+
+	// returns the key's estimate with this update included
+	uint64_t add(const uint64_t&, const uint64_t&);
+	uint64_t estimate(const uint64_t&) const;
+	// fails unless both have the same width and depth
+	bool merge(const CountMinSketch&);
+	void clear();
+
+	uint64_t getTotal() const;
+	unsigned getWidth() const;
+	unsigned getDepth() const;
+};
+
+/* UPDATES */
+
+inline unsigned CountMinSketch::getColumn(const uint64_t& hash, const unsigned& row) const
+{
+	// h1 + i * h2 behaves like depth independent hashes
+	const uint32_t low(hash);
+	const uint32_t high((hash >> 32) | 1);
+	return (low + row * high) & (width - 1);
+}
+
+inline uint64_t CountMinSketch::add(const uint64_t& hash, const uint64_t& weight)
+{
+	uint64_t* row(counters.data());
+	uint64_t smallest(UINT64_MAX);
+
+	for (unsigned i(0); i < depth; i++, row += width) {
+		uint64_t& counter(row[getColumn(hash, i)]);
+		counter += weight;
+		smallest = counter < smallest ? counter : smallest;
+	}
+	total += weight;
+	return smallest;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "CaptureFormat.hpp"
+#include "OutputBuffer.hpp"
+#include "PacketSummary.hpp"
+
+// frames handed to a worker at once
+#define PIPELINE_BATCH_FRAMES		256
+// batches in flight per worker; bounds memory and how far the reader runs ahead
+#define PIPELINE_BATCHES_PER_WORKER	4
+// failed attempts a stage spins through before it sleeps until the next event
+#define PIPELINE_SPIN_TRIES			64
+
+struct FrameBatch {
+	uint64_t sequence;
+	std::vector<CaptureRecord> records;
+	// holds the frames when the source cannot lend them (streamed input)
+	std::vector<char> storage;
+	// decoded text, kept with its chunks from one use of the batch to the next
+	OutputBuffer output;
+	// decoded headers of the frames that passed the filter, when they are being exported
+	std::vector<PacketSummary> summaries;
+	uint64_t decoded;
+	uint64_t skipped;
+	uint64_t filtered;
+};
+
+// fills the next batch, returns false once the input is exhausted
+typedef std::function<bool(FrameBatch&)> BatchSource;
+// decodes one batch on the given worker
+typedef std::function<void(FrameBatch&, const unsigned&)> BatchDecoder;
+// receives batches strictly in capture order
+typedef std::function<void(FrameBatch&)> BatchSink;
+
+/*
+ * Reader -> N decoders -> ordered writer. The reader deals batches round
+ * robin into per-worker lock-free queues; a worker whose queue is empty
+ * steals from its neighbours. Finished batches land in a reorder ring and
+ * the calling thread writes them out by sequence number. A stage with
+ * nothing to do spins briefly, then sleeps until another stage moves a
+ * batch, so slow input does not keep every core busy.
+ */
+class DecodePipeline {
+private:
+	unsigned workers;
+	std::atomic<uint64_t> steals;
+
+public:
+	DecodePipeline(const unsigned&);
+
+	void run(const BatchSource&, const BatchDecoder&, const BatchSink&);
+
+	unsigned getWorkers() const;
+	uint64_t getSteals() const;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ * Compile-time protocol registry. A registry is a list of
+ * Dissector<key, Layer> entries, where key is an ethertype or an IP
+ * protocol number and Layer the class that decodes it:
+ *
+ *     typedef DissectorRegistry<
+ *         Dissector<IP_PROTOCOL_TCP, TcpFrame>,
+ *         Dissector<IP_PROTOCOL_UDP, UdpFrame>
+ *     > TransportDissectors;
+ *
+ * dispatch() expands into one comparison per entry, in order, and calls
+ * visitor.visit<Layer>() for the matching one, so each call site is
+ * inlined and there is no virtual call or function pointer anywhere.
+ * Entries are tried first to last: common protocols go first, and a new
+ * entry at the end costs the ones before it nothing.
+ */
+template <unsigned Key, typename Layer>
+struct Dissector {
+	static constexpr unsigned key = Key;
+	typedef Layer Type;
+};
+
+template <typename... Entries>
+struct DissectorRegistry {
+	// false when nothing is registered under key
+	template <typename Visitor>
+	static bool dispatch(const unsigned& key, Visitor& visitor)
+	{
+		return ((key == Entries::key && (visitor.template visit<typename Entries::Type>(), true)) || ...);
+	}
+
+	static constexpr bool has(const unsigned& key)
+	{
+		return ((key == Entries::key) || ...);
+	}
+};
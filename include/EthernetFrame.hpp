@@ -4,6 +4,8 @@
 #include <fstream>
 
 #include "IpFrame.hpp"
+#include "Ipv6Frame.hpp"
+#include "Arena.hpp"
 
 // ethernet II standard structures
 // measured in octets
@@ -13,8 +15,17 @@
 #define ETH_STD_ETHERTYPE_LENGTH	2
 #define ETH_STD_MAX_PAYLOAD_LENGTH	1500
 #define ETH_STD_MAX_FCS_LENGTH		4
+#define ETH_STD_HEADER_LENGTH		14
+#define ETH_STD_VLAN_TAG_LENGTH		4
+// outer (service) and inner (customer) tag at most
+#define ETH_STD_MAX_VLAN_TAGS		2
 
-#define ETHERTYPE_IPV4	0x0800
+#define ETHERTYPE_IPV4		0x0800
+#define ETHERTYPE_ARP		0x0806
+#define ETHERTYPE_VLAN		0x8100
+#define ETHERTYPE_IPV6		0x86DD
+#define ETHERTYPE_QINQ		0x88A8
+#define ETHERTYPE_QINQ_OLD	0x9100
 
 class EthernetFrame {
 
@@ -32,18 +43,34 @@ class EthernetFrame {
 		char* type;
 		char* payload;
 		char* frameCheckSequence;
-		IpFrame* ipFrame;
+		// tag control information of the stripped VLAN tags, outermost first;
+		// type then holds the ethertype the tags carry
+		uint16_t vlanTags[ETH_STD_MAX_VLAN_TAGS];
+		unsigned vlanCount;
+		// built by the dissector registered for networkType, see EthernetFrame.cpp
+		void* network;
+		unsigned networkType;
+		// when set, every buffer and layer object comes from here and is never freed one by one
+		Arena* arena;
 
 		const std::string addressToString(const char*) const;
 		unsigned getPayloadLength(const char*) const;
+		static bool isVlanType(const unsigned&);
 
-		void init();
+		// false when the fields could not be allocated and the frame stays empty
+		bool init();
 		void clean();
+		void createNetworkLayer(const unsigned&);
+		void releaseNetworkLayer();
+
+		struct NetworkBuilder;
+		struct NetworkDeleter;
 
 	public:
 		// constructors / destructors
 		EthernetFrame();
 		EthernetFrame(std::istream& input);
+		EthernetFrame(const char*, const unsigned&, Arena* = nullptr);
 		~EthernetFrame();
 
 		const char* getPreamble() const;
@@ -56,16 +83,23 @@ class EthernetFrame {
 		const std::string getDestinationAddressAsString() const;
 		const std::string getSourceAddressAsString() const;
 		const std::string getEthertypeAsString() const;
+		const char* getEthertypeName() const;
+		unsigned getEthertype() const;
+		unsigned getVlanCount() const;
+		unsigned getVlanId(const unsigned&) const;
+		unsigned getVlanPriority(const unsigned&) const;
 
 		void setPreamble(const char*);
 		void setDestinationAddress(const char*);
 		void setSourceAddress(const char*);
 		void setType(const char*);
 		void setPayload(const char*);
+		void setPayload(const char*, const unsigned&);
 		void setPayload(std::istream&);
 		void setFrameCheckSequence(const char*);
 
 		const IpFrame* getIpFrame() const;
+		const Ipv6Frame* getIpv6Frame() const;
 
 		std::ofstream operator<< (EthernetFrame);
 		std::ifstream operator>> (EthernetFrame);
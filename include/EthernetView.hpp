@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ByteOrder.hpp"
+
+// measured in octets
+#define ETH_VIEW_ADDRESS_LENGTH	6
+#define ETH_VIEW_HEADER_LENGTH	14
+#define ETH_VIEW_VLAN_TAG_LENGTH	4
+
+// 802.1Q, 802.1ad (QinQ) and the pre-standard QinQ type
+#define ETH_VIEW_TYPE_VLAN		0x8100
+#define ETH_VIEW_TYPE_QINQ		0x88A8
+#define ETH_VIEW_TYPE_QINQ_OLD	0x9100
+// a single tag or an outer and an inner one
+#define ETH_VIEW_MAX_VLAN_TAGS	2
+
+/*
+ * Non-owning, allocation-free window over an ethernet II frame. Every getter
+ * reads straight from the caller's buffer, which must outlive the view.
+ * Accessors are defined inline so the decode path costs a few loads.
+ *
+ * Up to ETH_VIEW_MAX_VLAN_TAGS tags are stepped over at construction, so
+ * getType() and getPayload() describe what the tags carry; getOuterType()
+ * still gives the ethertype as it sits after the addresses.
+ */
+class EthernetView {
+private:
+	const uint8_t* bytes;
+	unsigned length;
+	unsigned headerLength;
+
+	void skipTags()
+	{
+		if (length < ETH_VIEW_HEADER_LENGTH)
+			return;
+
+		for (unsigned tags(0); tags < ETH_VIEW_MAX_VLAN_TAGS; tags++) {
+			const unsigned type(load16(bytes + headerLength - 2));
+			if ((type != ETH_VIEW_TYPE_VLAN && type != ETH_VIEW_TYPE_QINQ && type != ETH_VIEW_TYPE_QINQ_OLD)
+					|| headerLength + ETH_VIEW_VLAN_TAG_LENGTH > length)
+				return;
+			headerLength += ETH_VIEW_VLAN_TAG_LENGTH;
+		}
+	}
+
+public:
+	EthernetView() : bytes(nullptr), length(0), headerLength(ETH_VIEW_HEADER_LENGTH) {}
+	EthernetView(const uint8_t* b, const unsigned& l) : bytes(b), length(l), headerLength(ETH_VIEW_HEADER_LENGTH)
+	{
+		skipTags();
+	}
+	EthernetView(const char* b, const unsigned& l)
+		: bytes(reinterpret_cast<const uint8_t*>(b)), length(l), headerLength(ETH_VIEW_HEADER_LENGTH)
+	{
+		skipTags();
+	}
+
+	bool isValid() const { return length >= headerLength; }
+
+	const uint8_t* getDestinationAddress() const { return bytes; }
+	const uint8_t* getSourceAddress() const { return bytes + ETH_VIEW_ADDRESS_LENGTH; }
+	unsigned getType() const { return load16(bytes + headerLength - 2); }
+	unsigned getOuterType() const { return load16(bytes + 2 * ETH_VIEW_ADDRESS_LENGTH); }
+
+	unsigned getVlanCount() const { return (headerLength - ETH_VIEW_HEADER_LENGTH) / ETH_VIEW_VLAN_TAG_LENGTH; }
+	// tag control information of the given tag, outermost first
+	unsigned getVlanTag(const unsigned& i) const { return load16(bytes + ETH_VIEW_HEADER_LENGTH + i * ETH_VIEW_VLAN_TAG_LENGTH); }
+	unsigned getVlanId(const unsigned& i) const { return getVlanTag(i) & 0xFFF; }
+
+	unsigned getHeaderLength() const { return headerLength; }
+	const uint8_t* getPayload() const { return bytes + headerLength; }
+	unsigned getPayloadLength() const { return length - headerLength; }
+
+	const uint8_t* getBytes() const { return bytes; }
+	unsigned getLength() const { return length; }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// deepest AND/OR/NOT nesting a program may need while evaluating
+#define FILTER_MAX_STACK 32
+// deepest parenthesis and NOT nesting the parser recurses into
+#define FILTER_MAX_NESTING 256
+
+typedef enum {
+	FILTER_EQUAL,
+	FILTER_NOT_EQUAL,
+	FILTER_LESS,
+	FILTER_LESS_EQUAL,
+	FILTER_GREATER,
+	FILTER_GREATER_EQUAL,
+	FILTER_AND,
+	FILTER_OR,
+	FILTER_NOT
+} FilterOpcode;
+
+struct FilterInstruction {
+	uint8_t opcode;
+	uint8_t field;
+	uint32_t mask;
+	uint32_t value;
+};
+
+/*
+ * Compiles expressions such as
+ *     ip.src == 10.0.0.0/8 and tcp.dport == 443 and tcp.flags.syn
+ * into a postfix program of masked field tests that runs against the raw
+ * frame bytes, so frames can be rejected before any decoder object exists.
+ * A test on a layer the frame does not have is false.
+ */
+class Filter {
+private:
+	struct Token {
+		int type;
+		std::string text;
+	};
+
+	std::vector<FilterInstruction> program;
+	std::string error;
+
+	std::vector<Token> tokens;
+	size_t position;
+	unsigned nesting;
+
+	bool tokenize(const std::string&);
+	bool parseOr();
+	bool parseAnd();
+	bool parseNot();
+	bool parsePrimary();
+	bool parseValue(uint32_t&, uint32_t&);
+	bool accept(const int&, const char* = nullptr);
+	bool fail(const std::string&);
+	bool enter();
+	void emit(const uint8_t&, const uint8_t& = 0, const uint32_t& = 0, const uint32_t& = 0);
+
+public:
+	Filter();
+
+	bool compile(const std::string&);
+	bool matches(const char*, const unsigned&) const;
+
+	bool isEmpty() const;
+	size_t getLength() const;
+	const std::string& getError() const;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "PacketSummary.hpp"
+
+// flows held at once unless told otherwise
+#define FLOW_TABLE_DEFAULT_FLOWS	0x100000
+// measured in nanoseconds
+#define FLOW_TABLE_IDLE_TIMEOUT		120000000000ULL
+#define FLOW_TABLE_SWEEP_INTERVAL	1000000000ULL
+
+// marks the end of the idle list and of the free list
+#define FLOW_NONE 0xFFFFFFFF
+
+typedef enum {
+	FLOW_STATE_SYN_SENT,
+	FLOW_STATE_SYN_RECEIVED,
+	FLOW_STATE_ESTABLISHED,
+	// one side has sent a FIN
+	FLOW_STATE_CLOSING,
+	// both sides have sent a FIN
+	FLOW_STATE_CLOSED,
+	FLOW_STATE_RESET,
+	// not TCP, or picked up without seeing the handshake
+	FLOW_STATE_UNTRACKED
+} FlowState;
+
+/*
+ * One connection, in one cache line. Endpoint A is whoever sent the first
+ * packet seen; index 0 of the per-direction arrays is A -> B.
+ */
+struct alignas(64) Flow {
+	uint32_t addressA;
+	uint32_t addressB;
+	uint16_t portA;
+	uint16_t portB;
+	uint8_t protocol;
+	uint8_t state;
+	// every TCP flag seen, per direction
+	uint8_t flags[2];
+	uint64_t firstSeen;
+	uint64_t lastSeen;
+	uint64_t bytes[2];
+	uint32_t packets[2];
+	// idle list links, owned by the table
+	uint32_t newer;
+	uint32_t older;
+};
+
+static_assert(sizeof(Flow) == 64, "Flow must fill exactly one cache line");
+
+// a flow leaving the table, idle or pushed out; it is gone once this returns
+typedef std::function<void(const Flow&)> FlowCallback;
+
+/*
+ * Tracks connections by 5-tuple. Flows live in a pool allocated once, the
+ * index is an open addressing table of (hash, flow) pairs probed linearly
+ * and compacted with backward shift deletion, so there are no tombstones
+ * and no allocation per flow. Flows are also kept on a list ordered by
+ * last activity: idle ones expire from its head, and when the pool is full
+ * the least recently active flow makes room for the new one.
+ */
+class FlowTable {
+private:
+	struct Slot {
+		uint32_t hash;
+		// index into the pool plus one, 0 when the slot is empty
+		uint32_t flow;
+	};
+
+	Flow* flows;
+	Slot* slots;
+	uint32_t maxFlows;
+	uint32_t mask;
+	uint32_t used;
+	uint32_t freeFlows;
+	uint32_t oldest;
+	uint32_t newest;
+	uint64_t idleTimeout;
+	uint64_t nextSweep;
+	uint64_t created;
+	uint64_t expired;
+	uint64_t evicted;
+	FlowCallback onEvict;
+
+	uint32_t hashKey(const uint32_t&, const uint32_t&, const uint16_t&, const uint16_t&, const uint8_t&) const;
+	int direction(const Flow&, const uint32_t&, const uint32_t&, const uint16_t&, const uint16_t&, const uint8_t&) const;
+	uint32_t allocate();
+	void release(uint32_t);
+	void removeSlot(uint32_t);
+	void unlink(const uint32_t&);
+	void append(const uint32_t&);
+	void advance(Flow&, const int&, const uint8_t&);
+
+public:
+	FlowTable(const unsigned& = FLOW_TABLE_DEFAULT_FLOWS, const uint64_t& = FLOW_TABLE_IDLE_TIMEOUT);
+	~FlowTable();
+
+	// false if the pool could not be allocated
+	bool isOk() const;
+
+	// accounts one packet to its flow, creating it if needed; nullptr for non IPv4 TCP/UDP
+	const Flow* update(const PacketSummary&);
+	const Flow* update(const uint32_t&, const uint32_t&, const uint16_t&, const uint16_t&, const uint8_t&,
+		const uint8_t&, const unsigned&, const uint64_t&);
+	const Flow* find(const uint32_t&, const uint32_t&, const uint16_t&, const uint16_t&, const uint8_t&) const;
+
+	// evicts flows idle since before now - timeout, returns how many
+	unsigned expire(const uint64_t&);
+	// evicts everything, oldest first
+	void flush();
+
+	void setEvictionCallback(const FlowCallback&);
+
+	// position in the pool, stable for the life of the flow and below getCapacity()
+	uint32_t getIndex(const Flow&) const;
+	// 0 when the packet went from A to B
+	static int getSide(const Flow&, const uint32_t&, const uint16_t&);
+
+	unsigned size() const;
+	unsigned getCapacity() const;
+	uint64_t getCreated() const;
+	uint64_t getExpired() const;
+	uint64_t getEvicted() const;
+	uint64_t getMemoryUsage() const;
+
+	static const char* getStateAsString(const uint8_t&);
+};
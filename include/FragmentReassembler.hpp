@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+
+// datagrams being put back together at once
+#define FRAGMENT_MAX_DATAGRAMS	256
+// a datagram split into more gaps than this is given up on
+#define FRAGMENT_MAX_HOLES		16
+// measured in octets: the largest header, then the largest payload
+#define FRAGMENT_HEADER_ROOM	60
+#define FRAGMENT_BUFFER_LENGTH	(FRAGMENT_HEADER_ROOM + 65535)
+
+// measured in nanoseconds
+#define FRAGMENT_TIMEOUT		30000000000ULL
+#define FRAGMENT_WHEEL_TICK		1000000000ULL
+// must cover FRAGMENT_TIMEOUT in ticks
+#define FRAGMENT_WHEEL_SLOTS	64
+
+#define FRAGMENT_NONE 0xFFFFFFFF
+
+/*
+ * Puts fragmented IPv4 datagrams back together, keyed by source,
+ * destination, id and protocol. Every datagram in progress gets one
+ * buffer from a pool reserved up front and a short list of the holes
+ * still missing (RFC 815); data is only copied into holes, so the first
+ * copy of any octet wins over later overlapping fragments.
+ *
+ * Datagrams sit on a timing wheel by the time their first fragment
+ * arrived and are dropped FRAGMENT_TIMEOUT later. When every buffer is
+ * busy the datagram closest to timing out makes room, so a fragment
+ * flood costs a fixed amount of memory and never more.
+ */
+class FragmentReassembler {
+private:
+	struct Hole {
+		// inclusive payload octet range
+		uint32_t first;
+		uint32_t last;
+	};
+
+	struct Datagram {
+		uint32_t source;
+		uint32_t destination;
+		uint16_t id;
+		uint8_t protocol;
+		uint8_t headerLength;
+		// payload length, 0 until the last fragment says
+		uint32_t length;
+		uint32_t holeCount;
+		Hole holes[FRAGMENT_MAX_HOLES];
+		uint32_t fragments;
+		uint64_t deadline;
+		// hash chain, or free list when unused
+		uint32_t chain;
+		uint32_t wheelNext;
+		uint32_t wheelPrevious;
+	};
+
+	Datagram* datagrams;
+	uint8_t* buffers;
+	uint32_t* buckets;
+	uint32_t bucketMask;
+	uint32_t capacity;
+	uint32_t freeDatagrams;
+	uint32_t active;
+	uint32_t wheel[FRAGMENT_WHEEL_SLOTS];
+	uint64_t currentTick;
+	bool ticking;
+
+	// the last completed datagram stays in its buffer until the next call
+	uint32_t completed;
+	const char* datagram;
+	unsigned datagramLength;
+	unsigned datagramFragments;
+
+	uint64_t reassembled;
+	uint64_t timedOut;
+	uint64_t evicted;
+	uint64_t malformed;
+
+	uint32_t hashKey(const uint32_t&, const uint32_t&, const uint16_t&, const uint8_t&) const;
+	uint32_t find(const uint32_t&, const uint32_t&, const uint16_t&, const uint8_t&) const;
+	uint32_t create(const uint32_t&, const uint32_t&, const uint16_t&, const uint8_t&, const uint64_t&);
+	void release(uint32_t);
+	void advance(const uint64_t&);
+	void expireSlot(const unsigned&);
+	bool fill(Datagram&, uint8_t*, const uint32_t&, const uint32_t&, const uint8_t*);
+	void finish(Datagram&, uint8_t*);
+
+public:
+	FragmentReassembler(const unsigned& = FRAGMENT_MAX_DATAGRAMS);
+	~FragmentReassembler();
+
+	bool isOk() const;
+
+	// takes one IPv4 fragment; true when it completed a datagram
+	bool add(const char*, const unsigned&, const uint64_t&);
+
+	// the whole datagram, header included, valid until the next add()
+	const char* getDatagram() const;
+	unsigned getDatagramLength() const;
+	unsigned getDatagramFragments() const;
+
+	unsigned size() const;
+	uint64_t getReassembled() const;
+	uint64_t getTimedOut() const;
+	uint64_t getEvicted() const;
+	uint64_t getMalformed() const;
+	uint64_t getMemoryUsage() const;
+
+	static bool isFragment(const char*, const unsigned&);
+};
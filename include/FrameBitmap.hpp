@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// a container holding more frames than this switches from a sorted array to a bitmap
+#define FRAME_BITMAP_ARRAY_LIMIT	4096
+// 64K frames to a container, 64 to a word
+#define FRAME_BITMAP_WORDS			1024
+
+/*
+ * A set of frame numbers in the style of a roaring bitmap: numbers are
+ * split by their high 16 bits into containers, each a sorted array of low
+ * halves while sparse and a 64K-bit bitmap once dense. Hosts seen in a few
+ * frames cost a few octets, busy ones at most a bit per frame.
+ */
+class FrameBitmap {
+private:
+	struct Container {
+		uint16_t key;
+		uint32_t cardinality;
+		std::vector<uint16_t> values;
+		std::vector<uint64_t> words;
+	};
+
+	std::vector<Container> containers;
+
+	static void toWords(Container&);
+	static void toValues(Container&);
+	static void intersect(Container&, const Container&);
+
+public:
+	// fastest with frames in increasing order, as an index pass adds them
+	void add(const uint32_t&);
+	void intersect(const FrameBitmap&);
+	void clear();
+
+	uint64_t count() const;
+	bool empty() const;
+	void getFrames(std::vector<uint32_t>&) const;
+
+	size_t getSerializedLength() const;
+	void serialize(std::vector<uint8_t>&) const;
+	bool deserialize(const uint8_t*, const size_t&);
+};
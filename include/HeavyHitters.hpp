@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PacketSummary.hpp"
+#include "CountMinSketch.hpp"
+#include "SpaceSaving.hpp"
+#include "HyperLogLog.hpp"
+
+// keys listed per dimension unless told otherwise
+#define HEAVY_HITTERS_DEFAULT_TOP	10
+
+// what the traffic is broken down by
+typedef enum {
+	HEAVY_HITTER_SOURCES=0,
+	HEAVY_HITTER_DESTINATIONS,
+	// TCP and UDP, each end counted once
+	HEAVY_HITTER_PORTS,
+	// source, destination, protocol and ports as seen, so each direction is its own flow
+	HEAVY_HITTER_FLOWS,
+	HEAVY_HITTER_DIMENSIONS
+} HeavyHitterDimension;
+
+// estimate is at least the key's true byte count, guaranteed at most
+struct HeavyHitter {
+	SketchKey key;
+	uint64_t estimate;
+	uint64_t guaranteed;
+};
+
+/*
+ * Top talkers in fixed memory, whatever the number of addresses and flows:
+ * per dimension, a Count-Min sketch and a Space-Saving summary weigh the
+ * keys by frame bytes, and a HyperLogLog counts the distinct ones. Each
+ * key is hashed once and the hash feeds all three. The Space-Saving
+ * summary names the heavy keys; the sketch keeps light keys from churning
+ * through it and tightens its estimate of the heavy ones. One instance
+ * per decoder thread, nothing shared; merge() adds them up once the
+ * threads are done.
+ */
+class HeavyHitters {
+private:
+	struct Dimension {
+		CountMinSketch frequencies;
+		SpaceSaving top;
+		HyperLogLog distinct;
+
+		void add(const SketchKey&, const uint64_t&);
+	};
+
+	Dimension dimensions[HEAVY_HITTER_DIMENSIONS];
+
+public:
+	// the summary needs the frame only for IPv6 addresses, which it does not hold
+	void count(const PacketSummary&, const char*);
+	bool merge(const HeavyHitters&);
+
+	// the heaviest keys, heaviest first, at most the given count
+	void getTop(const HeavyHitterDimension&, const unsigned&, std::vector<HeavyHitter>&) const;
+	double getDistinct(const HeavyHitterDimension&) const;
+	uint64_t getTotal(const HeavyHitterDimension&) const;
+
+	static const char* getDimensionName(const HeavyHitterDimension&);
+	static std::string keyToString(const HeavyHitterDimension&, const SketchKey&);
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 4096 registers of one octet, about 1.6% standard error
+#define HYPER_LOG_LOG_DEFAULT_PRECISION	12
+#define HYPER_LOG_LOG_MIN_PRECISION		4
+#define HYPER_LOG_LOG_MAX_PRECISION		18
+
+/*
+ * HyperLogLog distinct counter over 64-bit hashes: the top precision bits
+ * of a hash pick a register, which keeps the longest run of leading zeros
+ * seen in the rest. The estimate has a standard error of about
+ * 1.04 / sqrt(2^precision) whatever the number of keys, and falls back to
+ * linear counting while many registers are still empty. Two counters of
+ * the same precision merge by taking the larger of each register.
+ */
+class HyperLogLog {
+private:
+	std::vector<uint8_t> registers;
+	unsigned precision;
+
+public:
+	// the precision is clamped to the range above
+	HyperLogLog(const unsigned& = HYPER_LOG_LOG_DEFAULT_PRECISION);
+
+	void add(const uint64_t&);
+	double estimate() const;
+	// fails unless both have the same precision
+	bool merge(const HyperLogLog&);
+	void clear();
+
+	unsigned getPrecision() const;
+};
+
+/* UPDATES */
+
+inline void HyperLogLog::add(const uint64_t& hash)
+{
+	// a stop bit under the remaining bits caps the run for an all-zero rest
+	const uint64_t rest(hash << precision | uint64_t(1) << (precision - 1));
+	uint8_t& reg(registers[hash >> (64 - precision)]);
+	const uint8_t rank(__builtin_clzll(rest) + 1);
+
+	if (rank > reg)
+		reg = rank;
+}
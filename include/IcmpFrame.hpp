@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+
+// measured in bytes
+#define ICMP_HEADER_LENGTH 8
+
+// measured in bits
+#define ICMP_TYPE_SIZE 8
+#define ICMP_CODE_SIZE 8
+#define ICMP_CHECKSUM_SIZE 16
+#define ICMP_REST_OF_HEADER_SIZE 32
+
+typedef enum {
+	ICMP_TYPE_ECHO_REPLY = 0,
+	ICMP_TYPE_DESTINATION_UNREACHABLE = 3,
+	ICMP_TYPE_SOURCE_QUENCH = 4,
+	ICMP_TYPE_REDIRECT = 5,
+	ICMP_TYPE_ECHO_REQUEST = 8,
+	ICMP_TYPE_ROUTER_ADVERTISEMENT = 9,
+	ICMP_TYPE_ROUTER_SOLICITATION = 10,
+	ICMP_TYPE_TIME_EXCEEDED = 11,
+	ICMP_TYPE_PARAMETER_PROBLEM = 12,
+	ICMP_TYPE_TIMESTAMP = 13,
+	ICMP_TYPE_TIMESTAMP_REPLY = 14
+} IcmpType;
+
+class IcmpFrame
+{
+private:
+	unsigned type : ICMP_TYPE_SIZE;
+	unsigned code : ICMP_CODE_SIZE;
+	unsigned checkSum : ICMP_CHECKSUM_SIZE;
+	unsigned calculatedCheckSum : ICMP_CHECKSUM_SIZE;
+	unsigned restOfHeader : ICMP_REST_OF_HEADER_SIZE;
+	unsigned checkSumVerifiable : 1;
+
+	void calculateCheckSum(const char*, const unsigned&);
+public:
+	// shortest payload the transport dissector hands over
+	static const unsigned MIN_LENGTH = ICMP_HEADER_LENGTH;
+
+	IcmpFrame();
+	IcmpFrame(const char*);
+	// whole message, which also verifies the checksum; ICMP has no pseudo-header, so that sum is unused
+	IcmpFrame(const char*, const unsigned&, const unsigned&);
+	// captured bytes, the unused sum and the message length from the IP header
+	IcmpFrame(const char*, const unsigned&, const unsigned&, const unsigned&);
+	~IcmpFrame();
+
+	void fromBytes(const char*);
+
+	const char* getTypeAsString() const;
+
+	void setType(const unsigned&);
+	void setCode(const unsigned&);
+	void setCheckSum(const unsigned&);
+	void setRestOfHeader(const unsigned&);
+
+	unsigned getType() const;
+	unsigned getCode() const;
+	unsigned getCheckSum() const;
+	unsigned getRestOfHeader() const;
+	// only meaningful for echo and timestamp messages
+	unsigned getIdentifier() const;
+	unsigned getSequenceNumber() const;
+	bool isEcho() const;
+
+	unsigned getCalculatedCheckSum() const;
+
+	// a snapped message lacks bytes the checksum covers, so it can't be checked
+	bool checkSumIsVerifiable() const;
+	bool checkSumIsOk() const;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ByteOrder.hpp"
+
+// measured in octets
+#define ICMP_VIEW_HEADER_LENGTH 8
+
+/*
+ * Non-owning view over an ICMP message; see IpView for the validity contract.
+ */
+class IcmpView {
+private:
+	const uint8_t* bytes;
+	unsigned length;
+
+public:
+	IcmpView() : bytes(nullptr), length(0) {}
+	IcmpView(const uint8_t* b, const unsigned& l) : bytes(b), length(l) {}
+	IcmpView(const char* b, const unsigned& l) : bytes(reinterpret_cast<const uint8_t*>(b)), length(l) {}
+
+	bool isValid() const { return length >= ICMP_VIEW_HEADER_LENGTH; }
+
+	unsigned getType() const { return bytes[0]; }
+	unsigned getCode() const { return bytes[1]; }
+	unsigned getCheckSum() const { return load16(bytes + 2); }
+	// identifier and sequence number for echo, gateway or unused for the rest
+	uint32_t getRestOfHeader() const { return load32(bytes + 4); }
+
+	const uint8_t* getPayload() const { return bytes + ICMP_VIEW_HEADER_LENGTH; }
+	unsigned getPayloadLength() const { return length - ICMP_VIEW_HEADER_LENGTH; }
+
+	const uint8_t* getBytes() const { return bytes; }
+	unsigned getLength() const { return length; }
+};
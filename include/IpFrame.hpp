@@ -4,6 +4,9 @@
 #include <fstream>
 
 #include <TcpFrame.hpp>
+#include <UdpFrame.hpp>
+#include <IcmpFrame.hpp>
+#include <Arena.hpp>
 
 // measured in bits
 #define IP_STD_VERSION_LENGTH 4
@@ -18,6 +21,7 @@
 #define IP_STD_ADDRESS_LENGTH 32
 // in bytes
 #define IP_STD_MIN_HEADER_LENGTH 20
+#define IP_STD_MAX_DATAGRAM_LENGTH 65535
 
 enum {
 	IP_PROTOCOL_HOPOPT,
@@ -28,6 +32,16 @@ enum {
 	IP_PROTOCOL_ST,
 	IP_PROTOCOL_TCP,
 	IP_PROTOCOL_CBT,
+	IP_PROTOCOL_EGP,
+	IP_PROTOCOL_IGP,
+	IP_PROTOCOL_BBN_RCC_MON,
+	IP_PROTOCOL_NVP_II,
+	IP_PROTOCOL_PUP,
+	IP_PROTOCOL_ARGUS,
+	IP_PROTOCOL_EMCON,
+	IP_PROTOCOL_XNET,
+	IP_PROTOCOL_CHAOS,
+	IP_PROTOCOL_UDP,
 };
 
 class IpFrame {
@@ -46,32 +60,52 @@ private:
 	unsigned calculatedCheckSum : IP_STD_CHECKSUM_LENGTH;
 	unsigned sourceAddress : IP_STD_ADDRESS_LENGTH;
 	unsigned destinationAddress : IP_STD_ADDRESS_LENGTH;
+	// octets of the datagram actually present, never more than totalLength
+	unsigned capturedLength;
 	char* options;
 	char* payload;
 
-	TcpFrame* tcpFrame;
+	// built by the dissector registered for transportProtocol, see IpFrame.cpp
+	void* transport;
+	unsigned transportProtocol;
+	// when set, options, payload and the transport layer come from here
+	Arena* arena;
 
+	struct TransportBuilder;
+	struct TransportDeleter;
+
+	unsigned getHeaderLength() const;
 	unsigned getPayloadLength() const;
 	unsigned getOptionsLength() const;
 	std::string addressToString(const unsigned&) const;
-	void calculateCheckSum();
+	void calculateCheckSum(const char*);
 	void constructPayload();
+	void init();
+	char* reserve(char*, const unsigned&);
 
 public:
+	// shortest payload the network dissector hands over
+	static const unsigned MIN_LENGTH = 0;
+
 	IpFrame();
 	IpFrame(const char*);
+	IpFrame(const char*, const unsigned&, Arena* = nullptr);
 	IpFrame(std::istream&);
 	~IpFrame();
 
 	void fromBytes(const char*);
+	void fromBytes(const char*, const unsigned&);
 
 	std::string getSourceAddressAsString() const;
 	std::string getDestinationAddressAsString() const;
-	std::string getPrecedenceAsString() const;
-	std::string getDelayAsString() const;
-	std::string getThroughputAsString() const;
-	std::string getReliabilityAsString() const;
-	std::string getProtocolAsString() const;
+	const char* getPrecedenceAsString() const;
+	// the name of any of the eight precedence levels, for code that only has the number
+	static const char* getPrecedenceName(const unsigned&);
+	const char* getDelayAsString() const;
+	const char* getThroughputAsString() const;
+	const char* getReliabilityAsString() const;
+	const char* getProtocolAsString() const;
+	static const char* getProtocolName(const unsigned&);
 
 	// setters
 	void setVersion(const unsigned&);
@@ -113,6 +147,8 @@ public:
 	const char* getOptions(void) const;
 	const char* getPayload(void) const;
 	const TcpFrame* getTcpFrame(void) const;
+	const UdpFrame* getUdpFrame(void) const;
+	const IcmpFrame* getIcmpFrame(void) const;
 
 	bool checksumIsOk() const;
 };
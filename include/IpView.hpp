@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ByteOrder.hpp"
+#include "Checksum.hpp"
+
+// measured in octets
+#define IP_VIEW_MIN_HEADER_LENGTH 20
+
+#define IP_VIEW_PROTOCOL_UDP 17
+
+/*
+ * Non-owning view over an IPv4 datagram. isValid() must hold before any
+ * other getter is used; lengths are clamped to the bytes actually present,
+ * so snapped captures and ethernet padding never lead past the buffer.
+ */
+class IpView {
+private:
+	const uint8_t* bytes;
+	unsigned length;
+
+public:
+	IpView() : bytes(nullptr), length(0) {}
+	IpView(const uint8_t* b, const unsigned& l) : bytes(b), length(l) {}
+	IpView(const char* b, const unsigned& l) : bytes(reinterpret_cast<const uint8_t*>(b)), length(l) {}
+
+	bool isValid() const
+	{
+		return length >= IP_VIEW_MIN_HEADER_LENGTH
+			&& getVersion() == 4
+			&& getHeaderLength() >= IP_VIEW_MIN_HEADER_LENGTH
+			&& getHeaderLength() <= length;
+	}
+
+	unsigned getVersion() const { return bytes[0] >> 4; }
+	unsigned getIhl() const { return bytes[0] & 0xF; }
+	unsigned getHeaderLength() const { return getIhl() * 4; }
+	unsigned getService() const { return bytes[1]; }
+	unsigned getTotalLength() const { return load16(bytes + 2); }
+	unsigned getId() const { return load16(bytes + 4); }
+	bool getDf() const { return bytes[6] & 0x40; }
+	bool getMf() const { return bytes[6] & 0x20; }
+	unsigned getOffset() const { return load16(bytes + 6) & 0x1FFF; }
+	unsigned getTtl() const { return bytes[8]; }
+	unsigned getProtocol() const { return bytes[9]; }
+	unsigned getCheckSum() const { return load16(bytes + 10); }
+	uint32_t getSourceAddress() const { return load32(bytes + 12); }
+	uint32_t getDestinationAddress() const { return load32(bytes + 16); }
+
+	// octets of the datagram present in the buffer
+	unsigned getCapturedLength() const { return getTotalLength() < length ? getTotalLength() : length; }
+
+	const uint8_t* getOptions() const { return bytes + IP_VIEW_MIN_HEADER_LENGTH; }
+	unsigned getOptionsLength() const { return getHeaderLength() - IP_VIEW_MIN_HEADER_LENGTH; }
+
+	const uint8_t* getPayload() const { return bytes + getHeaderLength(); }
+	unsigned getPayloadLength() const
+	{
+		return getCapturedLength() > getHeaderLength() ? getCapturedLength() - getHeaderLength() : 0;
+	}
+
+	// a correct header sums to all ones, checksum field included
+	bool checksumIsOk() const
+	{
+		return Checksum::sum(bytes, getHeaderLength()) == 0xFFFF;
+	}
+
+	// TCP/UDP checksum over pseudo-header and segment; a snapped segment cannot pass
+	bool transportChecksumIsOk() const
+	{
+		if (getTotalLength() < getHeaderLength() || getPayloadLength() != getTotalLength() - getHeaderLength())
+			return false;
+
+		// UDP over IPv4 may leave the checksum out altogether
+		if (getProtocol() == IP_VIEW_PROTOCOL_UDP && getPayloadLength() >= 8 && load16(getPayload() + 6) == 0)
+			return true;
+
+		return Checksum::add(
+			Checksum::pseudoHeader(getSourceAddress(), getDestinationAddress(), getProtocol(), getPayloadLength()),
+			Checksum::sum(getPayload(), getPayloadLength())) == 0xFFFF;
+	}
+
+	const uint8_t* getBytes() const { return bytes; }
+	unsigned getLength() const { return length; }
+};
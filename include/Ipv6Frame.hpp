@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include <TcpFrame.hpp>
+#include <UdpFrame.hpp>
+#include <Arena.hpp>
+
+// measured in bits
+#define IPV6_STD_VERSION_LENGTH 4
+#define IPV6_STD_TRAFFIC_CLASS_LENGTH 8
+#define IPV6_STD_FLOW_LABEL_LENGTH 20
+#define IPV6_STD_PAYLOAD_LENGTH_LENGTH 16
+#define IPV6_STD_NEXT_HEADER_LENGTH 8
+#define IPV6_STD_HOP_LIMIT_LENGTH 8
+#define IPV6_STD_FRAGMENT_LENGTH 16
+
+// in bytes
+#define IPV6_STD_HEADER_LENGTH 40
+#define IPV6_STD_ADDRESS_LENGTH 16
+
+#define IPV6_PROTOCOL_ICMPV6 58
+
+class Ipv6Frame {
+private:
+	unsigned version : IPV6_STD_VERSION_LENGTH;
+	unsigned trafficClass : IPV6_STD_TRAFFIC_CLASS_LENGTH;
+	unsigned flowLabel : IPV6_STD_FLOW_LABEL_LENGTH;
+	unsigned payloadLength : IPV6_STD_PAYLOAD_LENGTH_LENGTH;
+	unsigned nextHeader : IPV6_STD_NEXT_HEADER_LENGTH;
+	unsigned hopLimit : IPV6_STD_HOP_LIMIT_LENGTH;
+	// found by walking the extension headers
+	unsigned protocol : IPV6_STD_NEXT_HEADER_LENGTH;
+	unsigned fragment : IPV6_STD_FRAGMENT_LENGTH;
+	bool chainIsOk;
+	uint8_t sourceAddress[IPV6_STD_ADDRESS_LENGTH];
+	uint8_t destinationAddress[IPV6_STD_ADDRESS_LENGTH];
+	// fixed header plus extension headers
+	unsigned headerLength;
+	// octets of the upper-layer payload actually present
+	unsigned upperLayerLength;
+	char* payload;
+
+	// built by the dissector registered for transportProtocol, see Ipv6Frame.cpp
+	void* transport;
+	unsigned transportProtocol;
+	// when set, the payload and the transport layer come from here
+	Arena* arena;
+
+	struct TransportBuilder;
+	struct TransportDeleter;
+
+	std::string addressToString(const uint8_t*) const;
+	void constructPayload();
+	void init();
+	char* reserve(char*, const unsigned&);
+
+public:
+	// shortest payload the network dissector hands over
+	static const unsigned MIN_LENGTH = IPV6_STD_HEADER_LENGTH;
+
+	Ipv6Frame(const char*, const unsigned&, Arena* = nullptr);
+	~Ipv6Frame();
+
+	void fromBytes(const char*, const unsigned&);
+
+	std::string getSourceAddressAsString() const;
+	std::string getDestinationAddressAsString() const;
+	const char* getProtocolAsString() const;
+
+	unsigned getVersion() const;
+	unsigned getTrafficClass() const;
+	unsigned getFlowLabel() const;
+	unsigned getPayloadLength() const;
+	unsigned getNextHeader() const;
+	unsigned getHopLimit() const;
+	const uint8_t* getSourceAddress() const;
+	const uint8_t* getDestinationAddress() const;
+
+	// upper-layer protocol after the extension headers
+	unsigned getProtocol() const;
+	unsigned getHeaderLength() const;
+	unsigned getExtensionHeadersLength() const;
+	// false when the extension header chain could not be followed to a transport
+	bool extensionHeadersAreOk() const;
+	bool isFragment() const;
+	unsigned getFragmentOffset() const;
+	bool getMoreFragments() const;
+
+	const char* getPayload(void) const;
+	unsigned getUpperLayerLength() const;
+	const TcpFrame* getTcpFrame(void) const;
+	const UdpFrame* getUdpFrame(void) const;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ByteOrder.hpp"
+
+// measured in octets
+#define IPV6_VIEW_HEADER_LENGTH 40
+#define IPV6_VIEW_ADDRESS_LENGTH 16
+#define IPV6_VIEW_FRAGMENT_HEADER_LENGTH 8
+
+// next header values that are extension headers rather than a transport
+#define IPV6_VIEW_HOP_BY_HOP		0
+#define IPV6_VIEW_ROUTING			43
+#define IPV6_VIEW_FRAGMENT			44
+#define IPV6_VIEW_ESP				50
+#define IPV6_VIEW_AUTHENTICATION	51
+#define IPV6_VIEW_NO_NEXT_HEADER	59
+#define IPV6_VIEW_DESTINATION		60
+#define IPV6_VIEW_MOBILITY			135
+
+// a chain longer than this is treated as malformed
+#define IPV6_VIEW_MAX_EXTENSION_HEADERS 8
+
+/*
+ * Non-owning view over an IPv6 packet; see IpView for the validity contract.
+ * walkExtensionHeaders() is the one place the extension header chain is
+ * followed, so the frame decoder, the packet summary and the filter agree
+ * on where the transport header starts.
+ */
+class Ipv6View {
+private:
+	const uint8_t* bytes;
+	unsigned length;
+
+public:
+	Ipv6View() : bytes(nullptr), length(0) {}
+	Ipv6View(const uint8_t* b, const unsigned& l) : bytes(b), length(l) {}
+	Ipv6View(const char* b, const unsigned& l) : bytes(reinterpret_cast<const uint8_t*>(b)), length(l) {}
+
+	bool isValid() const { return length >= IPV6_VIEW_HEADER_LENGTH && getVersion() == 6; }
+
+	unsigned getVersion() const { return bytes[0] >> 4; }
+	unsigned getTrafficClass() const { return load16(bytes) >> 4 & 0xFF; }
+	unsigned getFlowLabel() const { return load32(bytes) & 0xFFFFF; }
+	// octets after the fixed header, extension headers included
+	unsigned getPayloadLength() const { return load16(bytes + 4); }
+	unsigned getNextHeader() const { return bytes[6]; }
+	unsigned getHopLimit() const { return bytes[7]; }
+	const uint8_t* getSourceAddress() const { return bytes + 8; }
+	const uint8_t* getDestinationAddress() const { return bytes + 24; }
+
+	// octets of the packet present in the buffer
+	unsigned getCapturedLength() const
+	{
+		const unsigned total(IPV6_VIEW_HEADER_LENGTH + getPayloadLength());
+		return total < length ? total : length;
+	}
+
+	/*
+	 * Follows the chain from the fixed header. On success protocol is the
+	 * upper-layer protocol, offset is where its header starts and fragment
+	 * is the offset-and-flags word of a fragment header (0 when there is
+	 * none). A non-first fragment stops the walk right after the fragment
+	 * header, as what follows is payload. Returns false on a truncated or
+	 * overlong chain, ESP, or no next header.
+	 */
+	bool walkExtensionHeaders(unsigned& protocol, unsigned& offset, unsigned& fragment) const
+	{
+		const unsigned captured(getCapturedLength());
+
+		protocol = getNextHeader();
+		offset = IPV6_VIEW_HEADER_LENGTH;
+		fragment = 0;
+
+		for (unsigned headers(0); headers < IPV6_VIEW_MAX_EXTENSION_HEADERS; headers++) {
+			unsigned headerLength;
+
+			switch (protocol) {
+			case IPV6_VIEW_HOP_BY_HOP:
+			case IPV6_VIEW_ROUTING:
+			case IPV6_VIEW_DESTINATION:
+			case IPV6_VIEW_MOBILITY:
+				if (offset + 2 > captured)
+					return false;
+				headerLength = (bytes[offset + 1] + 1) * 8;
+				break;
+			case IPV6_VIEW_AUTHENTICATION:
+				if (offset + 2 > captured)
+					return false;
+				headerLength = (bytes[offset + 1] + 2) * 4;
+				break;
+			case IPV6_VIEW_FRAGMENT:
+				if (offset + IPV6_VIEW_FRAGMENT_HEADER_LENGTH > captured)
+					return false;
+				headerLength = IPV6_VIEW_FRAGMENT_HEADER_LENGTH;
+				fragment = load16(bytes + offset + 2);
+				break;
+			case IPV6_VIEW_ESP:
+			case IPV6_VIEW_NO_NEXT_HEADER:
+				return false;
+			default:
+				return offset <= captured;
+			}
+
+			if (offset + headerLength > captured)
+				return false;
+			protocol = bytes[offset];
+			offset += headerLength;
+
+			if (fragment & 0xFFF8)
+				return true;
+		}
+
+		return false;
+	}
+
+	const uint8_t* getBytes() const { return bytes; }
+	unsigned getLength() const { return length; }
+};
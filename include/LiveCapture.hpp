@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "CaptureFormat.hpp"
+
+// ring geometry defaults; the block size must be a multiple of the page size
+#define LIVE_CAPTURE_BLOCK_SIZE		0x100000
+#define LIVE_CAPTURE_BLOCK_COUNT	64
+#define LIVE_CAPTURE_FRAME_SIZE		2048
+// a partially filled block is handed over after this many milliseconds
+#define LIVE_CAPTURE_BLOCK_TIMEOUT	100
+
+typedef std::function<void(const CaptureRecord&)> RecordCallback;
+
+/*
+ * Live capture from a Linux interface through an AF_PACKET socket with a
+ * TPACKET_V3 block ring shared with the kernel. Frames are read in place
+ * from the ring; the only syscalls are a poll when no block is ready and
+ * the statistics query.
+ */
+class LiveCapture {
+private:
+	int fd;
+	char* ring;
+	size_t ringLength;
+	unsigned blockSize;
+	unsigned blockCount;
+	unsigned currentBlock;
+	std::string error;
+
+	uint64_t received;
+	uint64_t dropped;
+	uint64_t freezes;
+
+	bool fail(const std::string&);
+
+public:
+	LiveCapture();
+	~LiveCapture();
+
+	// fanout group 0 means the socket is not part of a fanout group
+	bool open(const std::string&, const unsigned&, const unsigned&, const unsigned&);
+	void close();
+
+	// waits up to the timeout (ms) for a block, hands over its frames and returns their count
+	int dispatch(const RecordCallback&, const int&);
+
+	// folds the kernel counters (which reset on every read) into the totals
+	bool updateStatistics();
+
+	uint64_t getReceived() const;
+	uint64_t getDropped() const;
+	uint64_t getFreezes() const;
+	const std::string& getError() const;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "CaptureFormat.hpp"
+#include "CaptureIndex.hpp"
+
+/*
+ * A capture file mapped read-only into memory. Records it hands out point
+ * straight into the mapping, so frames are never copied or re-read.
+ */
+class MappedCapture {
+private:
+	std::string filename;
+	const char* bytes;
+	uint64_t length;
+	int64_t modified;
+	CaptureIndex index;
+	bool indexLoaded;
+	bool indexSaved;
+
+	void unmap();
+
+public:
+	MappedCapture();
+	~MappedCapture();
+
+	bool open(const std::string&);
+
+	// loads the saved index if it still matches, otherwise builds and saves it
+	const CaptureIndex& getIndex();
+	bool isIndexLoaded() const;
+	bool isIndexSaved() const;
+
+	uint64_t getLength() const;
+	// nanoseconds since the epoch, what saved indexes are checked against
+	int64_t getModified() const;
+	const char* getBytes() const;
+	CaptureRecord getRecord(const uint64_t&) const;
+};
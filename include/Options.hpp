@@ -0,0 +1,70 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include "RecordWriter.hpp"
+
+// decoder threads past this many per core only add queues and stacks
+#define OPTIONS_MAX_THREADS_PER_CORE 4
+
+/*
+ * Command line switches. With no arguments at all the program falls back
+ * to the interactive menu.
+ */
+class Options {
+private:
+	bool interactive;
+	std::string filename;
+	unsigned threads;
+	std::string interface;
+	unsigned blockSize;
+	unsigned ringBlocks;
+	unsigned fanout;
+	unsigned count;
+	std::string filter;
+	unsigned flows;
+	bool streams;
+	bool tcpMetrics;
+	bool defragment;
+	OutputFormat format;
+	std::string exportFilename;
+	bool statistics;
+	unsigned statisticsInterval;
+	std::string statisticsFilename;
+	unsigned heavyHitters;
+	std::string error;
+
+	bool parseUnsigned(const std::string&, unsigned&);
+
+public:
+	Options();
+
+	bool parse(int, char**);
+
+	bool isInteractive() const;
+	const std::string& getFilename() const;
+	unsigned getThreads() const;
+	const std::string& getInterface() const;
+	unsigned getBlockSize() const;
+	unsigned getRingBlocks() const;
+	unsigned getFanout() const;
+	unsigned getCount() const;
+	const std::string& getFilter() const;
+	unsigned getFlows() const;
+	bool getStreams() const;
+	bool getTcpMetrics() const;
+	bool getDefragment() const;
+	OutputFormat getFormat() const;
+	const std::string& getExportFilename() const;
+	bool getStatistics() const;
+	unsigned getStatisticsInterval() const;
+	const std::string& getStatisticsFilename() const;
+	unsigned getHeavyHitters() const;
+	const std::string& getError() const;
+
+	void setFilename(const std::string&);
+	void setInterface(const std::string&);
+
+	static void printUsage(std::ostream&, const char*);
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+
+#include "TextFormat.hpp"
+
+// measured in octets
+#define OUTPUT_BUFFER_CHUNK_LENGTH	0x10000
+
+/*
+ * Text output gathered in fixed-size chunks and handed to the kernel with
+ * one writev per flush. Chunks are kept when the buffer is cleared, so once
+ * the largest batch has been seen nothing is allocated again, and growing
+ * never moves text already written. Fields are encoded straight into the
+ * chunk with the TextFormat encoders; nothing goes through a stream.
+ */
+class OutputBuffer {
+private:
+	std::vector<char*> chunks;
+	// text held by every chunk before the current one
+	std::vector<size_t> lengths;
+	std::vector<iovec> vectors;
+	size_t current;
+	char* cursor;
+	char* end;
+
+	void nextChunk();
+	char* claim(const size_t&);
+	OutputBuffer& append(const char*, const size_t&);
+
+public:
+	OutputBuffer();
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+	~OutputBuffer();
+
+	OutputBuffer& text(const char*, const size_t&);
+	OutputBuffer& text(const char*);
+	OutputBuffer& text(const std::string&);
+	OutputBuffer& put(const char&);
+	OutputBuffer& decimal(const uint64_t&);
+	OutputBuffer& hex(const uint64_t&, const unsigned& = 1);
+	OutputBuffer& mac(const uint8_t*);
+	OutputBuffer& ipv4(const uint32_t&);
+	OutputBuffer& ipv6(const uint8_t*);
+	// like ostream << double with the default precision
+	OutputBuffer& real(const double&);
+
+	// room for a whole record written with the encoders directly, then committed with advance
+	char* reserve(const size_t&);
+	void advance(const size_t&);
+
+	size_t size() const;
+	bool empty() const;
+	// forgets the text, keeps the chunks
+	void clear();
+	// writes everything to the descriptor, then clears; false if the write failed
+	bool flush(const int&);
+};
+
+inline char* OutputBuffer::claim(const size_t& length)
+{
+	if (static_cast<size_t>(end - cursor) < length)
+		nextChunk();
+	return cursor;
+}
+
+// text that fits is copied here; the rest, and anything crossing into a new chunk, goes through append
+inline OutputBuffer& OutputBuffer::text(const char* s, const size_t& length)
+{
+	if (length > static_cast<size_t>(end - cursor))
+		return append(s, length);
+	memcpy(cursor, s, length);
+	cursor += length;
+	return *this;
+}
+
+inline char* OutputBuffer::reserve(const size_t& length)
+{
+	return claim(length);
+}
+
+inline void OutputBuffer::advance(const size_t& length)
+{
+	cursor += length;
+}
+
+inline OutputBuffer& OutputBuffer::put(const char& c)
+{
+	*claim(1) = c;
+	cursor++;
+	return *this;
+}
+
+inline OutputBuffer& OutputBuffer::text(const char* s)
+{
+	return text(s, strlen(s));
+}
+
+inline OutputBuffer& OutputBuffer::text(const std::string& s)
+{
+	return text(s.data(), s.size());
+}
+
+inline OutputBuffer& OutputBuffer::decimal(const uint64_t& value)
+{
+	char* const at(claim(TEXT_MAX_DECIMAL_LENGTH));
+	cursor = at + formatDecimal(at, value);
+	return *this;
+}
+
+inline OutputBuffer& OutputBuffer::hex(const uint64_t& value, const unsigned& width)
+{
+	char* const at(claim(TEXT_MAX_HEX_LENGTH > width ? TEXT_MAX_HEX_LENGTH : width));
+	cursor = at + formatHex(at, value, width);
+	return *this;
+}
+
+inline OutputBuffer& OutputBuffer::mac(const uint8_t* address)
+{
+	char* const at(claim(TEXT_MAC_LENGTH));
+	cursor = at + formatMac(at, address);
+	return *this;
+}
+
+inline OutputBuffer& OutputBuffer::ipv4(const uint32_t& address)
+{
+	char* const at(claim(TEXT_MAX_IPV4_LENGTH));
+	cursor = at + formatIpv4(at, address);
+	return *this;
+}
+
+inline OutputBuffer& OutputBuffer::ipv6(const uint8_t* address)
+{
+	char* const at(claim(TEXT_MAX_IPV6_LENGTH));
+	cursor = at + formatIpv6(at, address);
+	return *this;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+class IpView;
+
+// layers present, bits of PacketSummary::layers
+#define PACKET_LAYER_IPV4		0x01
+#define PACKET_LAYER_TCP		0x02
+#define PACKET_LAYER_UDP		0x04
+#define PACKET_LAYER_ICMP		0x08
+// a non-first fragment: no transport header to read
+#define PACKET_LAYER_FRAGMENT	0x10
+#define PACKET_LAYER_IPV6		0x20
+// one or two VLAN tags were stepped over; ethertype is the one they carry
+#define PACKET_LAYER_VLAN		0x40
+
+// bits of PacketSummary::ipFlags
+#define PACKET_IP_DF 0x01
+#define PACKET_IP_MF 0x02
+
+#define PACKET_SUMMARY_LENGTH 64
+
+/*
+ * Everything the analyzer usually looks at for one packet, in one cache
+ * line with no pointers, so millions of them can sit in a flat array and
+ * be copied with memcpy. Offsets point back into the original frame.
+ * Multi-octet fields are in host byte order.
+ */
+struct alignas(PACKET_SUMMARY_LENGTH) PacketSummary {
+	uint64_t timestamp;
+	uint8_t destinationMac[6];
+	uint8_t sourceMac[6];
+	uint16_t ethertype;
+	uint8_t layers;
+	uint8_t protocol;
+	uint32_t sourceAddress;
+	uint32_t destinationAddress;
+	uint16_t sourcePort;
+	uint16_t destinationPort;
+	uint32_t sequenceNumber;
+	uint32_t acknowledgementNumber;
+	uint16_t window;
+	uint8_t tcpFlags;
+	uint8_t ttl;
+	uint8_t service;
+	uint8_t ipFlags;
+	uint16_t fragmentOffset;
+	// both saturate at 0xFFFF: jumbo frames, and an IPv6 header with a payload past 65495 octets
+	uint16_t ipTotalLength;
+	uint16_t frameLength;
+	uint16_t ipOffset;
+	uint16_t transportOffset;
+	uint16_t payloadOffset;
+	uint16_t payloadLength;
+
+	// one pass over the frame; returns false when it is not even ethernet
+	bool fromBytes(const char*, const unsigned&, const uint64_t&);
+	// a bare IPv4 datagram, as FragmentReassembler rebuilds it; offsets are from its first octet
+	bool fromDatagram(const char*, const unsigned&, const uint64_t&);
+
+private:
+	void readIpv4(const IpView&, const unsigned&);
+	void readTransport(const char*, const unsigned&);
+};
+
+static_assert(sizeof(PacketSummary) == PACKET_SUMMARY_LENGTH, "PacketSummary must fill exactly one cache line");
+static_assert(std::is_trivially_copyable<PacketSummary>::value, "PacketSummary must be memcpy-able");
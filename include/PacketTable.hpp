@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PacketSummary.hpp"
+#include "Selection.hpp"
+
+typedef enum {
+	COLUMN_TIMESTAMP,
+	COLUMN_SOURCE_ADDRESS,
+	COLUMN_DESTINATION_ADDRESS,
+	COLUMN_SOURCE_PORT,
+	COLUMN_DESTINATION_PORT,
+	COLUMN_PROTOCOL,
+	COLUMN_TCP_FLAGS,
+	COLUMN_LENGTH
+} PacketColumn;
+
+/*
+ * Decoded packets stored column by column, one contiguous array per field.
+ * Every scan evaluates low <= (value & mask) <= high over a whole column
+ * and writes a Selection; equality, prefix and flag tests are all special
+ * cases of it. Scans run as AVX2 kernels when the CPU has them.
+ */
+class PacketTable {
+private:
+	std::vector<uint64_t> timestamps;
+	std::vector<uint32_t> sourceAddresses;
+	std::vector<uint32_t> destinationAddresses;
+	std::vector<uint16_t> sourcePorts;
+	std::vector<uint16_t> destinationPorts;
+	std::vector<uint8_t> protocols;
+	std::vector<uint8_t> tcpFlags;
+	std::vector<uint16_t> lengths;
+
+public:
+	void append(const PacketSummary*, const size_t&);
+	void reserve(const size_t&);
+	void clear();
+	size_t size() const;
+
+	void scan(const PacketColumn&, const uint64_t&, const uint64_t&, const uint64_t&, Selection&) const;
+	void scanEqual(const PacketColumn&, const uint64_t&, Selection&) const;
+	void scanRange(const PacketColumn&, const uint64_t&, const uint64_t&, Selection&) const;
+	// addresses inside value/prefixLength, e.g. 10.0.0.0/8
+	void scanPrefix(const PacketColumn&, const uint32_t&, const unsigned&, Selection&) const;
+	// rows with every bit of the mask set, e.g. SYN and ACK
+	void scanAllBits(const PacketColumn&, const uint64_t&, Selection&) const;
+
+	const uint64_t* getTimestamps() const;
+	const uint32_t* getSourceAddresses() const;
+	const uint32_t* getDestinationAddresses() const;
+	const uint16_t* getSourcePorts() const;
+	const uint16_t* getDestinationPorts() const;
+	const uint8_t* getProtocols() const;
+	const uint8_t* getTcpFlags() const;
+	const uint16_t* getLengths() const;
+
+	static const char* getImplementation();
+};
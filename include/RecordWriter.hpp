@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "PacketSummary.hpp"
+#include "OutputBuffer.hpp"
+
+// "SNFR" as it reads in a little endian dump
+#define RECORD_STREAM_MAGIC		0x52464E53
+#define RECORD_STREAM_VERSION	1
+// measured in octets
+#define RECORD_STREAM_HEADER_LENGTH	64
+#define PACKET_RECORD_LENGTH		128
+#define PACKET_RECORD_ADDRESS_LENGTH	16
+
+typedef enum {
+	// the indented dump
+	OUTPUT_FORMAT_TEXT,
+	// one JSON object per line
+	OUTPUT_FORMAT_JSON,
+	// a header row, then one row per frame
+	OUTPUT_FORMAT_CSV,
+	// a RecordStreamHeader, then one PacketRecord per frame
+	OUTPUT_FORMAT_BINARY
+} OutputFormat;
+
+/*
+ * Starts a binary record stream. Everything in the stream is in host byte
+ * order, which a reader can check against the magic.
+ */
+struct alignas(RECORD_STREAM_HEADER_LENGTH) RecordStreamHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t headerLength;
+	uint16_t recordLength;
+	uint8_t reserved[54];
+};
+
+/*
+ * One frame of a binary record stream. Records have a fixed schema, so a
+ * reader maps the file and walks it with a stride; the length prefix lets
+ * a later version append fields without breaking that reader, which just
+ * steps over what it does not know. A mapped stream keeps every summary
+ * on a cache line of its own.
+ */
+struct alignas(PACKET_RECORD_LENGTH) PacketRecord {
+	// of the whole record, this field included
+	uint32_t length;
+	// outermost tag, valid when summary.layers has PACKET_LAYER_VLAN
+	uint16_t vlanId;
+	uint16_t reserved;
+	// IPv6 only, since PacketSummary has no room for them
+	uint8_t sourceAddress6[PACKET_RECORD_ADDRESS_LENGTH];
+	uint8_t destinationAddress6[PACKET_RECORD_ADDRESS_LENGTH];
+	uint8_t padding[24];
+	PacketSummary summary;
+};
+
+static_assert(sizeof(RecordStreamHeader) == RECORD_STREAM_HEADER_LENGTH, "RecordStreamHeader must fill its length");
+static_assert(sizeof(PacketRecord) == PACKET_RECORD_LENGTH, "PacketRecord must fill its length");
+static_assert(std::is_trivially_copyable<PacketRecord>::value, "PacketRecord must be memcpy-able");
+
+/*
+ * Turns packet summaries into machine-readable records. A summary comes
+ * from one pass over the frame with the views, so a record costs a few
+ * loads and the encoding, with no layer objects built; the frame is only
+ * read again for what the summary leaves out (IPv6 addresses, VLAN id).
+ */
+class RecordWriter {
+public:
+	static bool parseFormat(const std::string&, OutputFormat&);
+	static const char* getFormatAsString(const OutputFormat&);
+
+	// what goes before the first record: the CSV header row or the stream header
+	static void writeHeader(OutputBuffer&, const OutputFormat&);
+	static void write(OutputBuffer&, const OutputFormat&, const PacketSummary&, const char*);
+
+	static void writeJson(OutputBuffer&, const PacketSummary&, const char*);
+	static void writeCsv(OutputBuffer&, const PacketSummary&, const char*);
+	static void writeBinary(OutputBuffer&, const PacketSummary&, const char*);
+};
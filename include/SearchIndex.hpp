@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CaptureFormat.hpp"
+#include "FrameBitmap.hpp"
+
+#define SEARCH_INDEX_MAGIC		"PASRC001"
+#define SEARCH_INDEX_SUFFIX		".sidx"
+// frames between two checkpoints
+#define SEARCH_INDEX_STRIDE		1024
+
+// where frame k * SEARCH_INDEX_STRIDE starts, and the time span of it and the frames up to the next one
+struct SearchCheckpoint {
+	uint64_t offset; // of the record, from the start of the capture
+	uint64_t minimumTimestamp;
+	uint64_t maximumTimestamp;
+};
+
+/*
+ * What it takes to find frames in a capture without decoding it again: a
+ * checkpoint every SEARCH_INDEX_STRIDE frames, and a FrameBitmap of frame
+ * numbers for every IPv4 address and every TCP or UDP port seen. Saved
+ * next to the capture and, like the capture index, trusted only while the
+ * capture keeps its size and modification time.
+ *
+ * The saved file is a header, the checkpoints, the address and port keys
+ * sorted by value, then the serialized bitmaps. It is mapped rather than
+ * read, so opening costs nothing and a lookup touches a binary search and
+ * one bitmap. A freshly built index is served from the same layout in
+ * memory. Frame numbers are 32-bit; indexing stops at 2^32 - 1 frames.
+ */
+class SearchIndex {
+private:
+	struct Header {
+		char magic[8];
+		uint64_t captureSize;
+		int64_t captureModified;
+		uint32_t captureType;
+		uint32_t stride;
+		uint64_t frames;
+		uint64_t checkpoints;
+		uint64_t addresses;
+		uint64_t ports;
+		uint64_t bitmapLength;
+	};
+
+	struct Key {
+		uint32_t value;
+		uint32_t length;
+		uint64_t offset; // of the bitmap, from the start of the bitmaps
+	};
+
+	// the whole index, either in image or mapped from disk
+	const uint8_t* data;
+	uint64_t length;
+	std::vector<uint8_t> image;
+	void* mapping;
+
+	const Header* header;
+	const SearchCheckpoint* checkpoints;
+	const Key* addresses;
+	const Key* ports;
+	const uint8_t* bitmaps;
+
+	bool attach(const uint8_t*, const uint64_t&);
+	void unmap();
+	bool find(const Key*, const uint64_t&, const uint32_t&, FrameBitmap&) const;
+
+public:
+	SearchIndex();
+	SearchIndex(const SearchIndex&) = delete;
+	SearchIndex& operator=(const SearchIndex&) = delete;
+	~SearchIndex();
+
+	bool build(const char*, const uint64_t&, const int64_t&);
+	bool load(const std::string&, const uint64_t&, const int64_t&);
+	bool save(const std::string&) const;
+
+	// false, with the bitmap empty, when nothing was ever seen with that value
+	bool findAddress(const uint32_t&, FrameBitmap&) const;
+	bool findPort(const uint16_t&, FrameBitmap&) const;
+
+	uint64_t getFrames() const;
+	uint64_t getCheckpointCount() const;
+	const SearchCheckpoint& getCheckpoint(const uint64_t&) const;
+	uint64_t getAddressCount() const;
+	uint64_t getPortCount() const;
+	uint64_t getLength() const;
+	CaptureType getType() const;
+};
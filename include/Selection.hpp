@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * One bit per table row, 64 rows to a word; what a PacketTable scan
+ * produces and what the next scan or an aggregate consumes.
+ */
+class Selection {
+private:
+	std::vector<uint64_t> words;
+	size_t rows;
+
+public:
+	Selection();
+
+	void resize(const size_t&);
+	void intersect(const Selection&);
+	void unite(const Selection&);
+	void invert();
+
+	size_t count() const;
+	bool test(const size_t&) const;
+	size_t size() const;
+
+	uint64_t* getWords();
+	const uint64_t* getWords() const;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// tracked keys; a key's count is off by at most the total weight over this
+#define SPACE_SAVING_DEFAULT_CAPACITY	1024
+#define SKETCH_KEY_WORDS				5
+
+// up to 40 octets identifying what is counted, unused words left zero
+struct SketchKey {
+	uint64_t words[SKETCH_KEY_WORDS];
+
+	uint64_t getHash() const;
+	bool operator==(const SketchKey&) const;
+};
+
+// count is never below the key's true weight, count - error never above it
+struct SpaceSavingEntry {
+	SketchKey key;
+	uint64_t hash;
+	uint64_t count;
+	uint64_t error;
+};
+
+/*
+ * Space-Saving top-K summary with a fixed number of counters. A tracked
+ * key adds to its own counter; an untracked one takes over the smallest
+ * counter, inheriting its count as the error bound, so every key heavier
+ * than total / capacity is guaranteed to be tracked. Given an upper bound
+ * on a key's weight, such as a Count-Min estimate, an untracked key that
+ * cannot outweigh the smallest counter is left out, which spares the
+ * eviction for the long tail of light keys and keeps both guarantees. The counts sit in a
+ * 4-ary min-heap for the eviction, where the children of a node take 64
+ * contiguous octets, and the keys behind an open addressing table for the
+ * lookup, so nothing is allocated after construction. Merging follows the
+ * mergeable summaries construction: counts add up, a key missing from a
+ * full side is charged that side's minimum, and the heaviest keys stay.
+ */
+class SpaceSaving {
+private:
+	// a copy of the entry's count, so sifting never leaves the heap
+	struct HeapNode {
+		uint64_t count;
+		uint64_t entry;
+	};
+
+	std::vector<SpaceSavingEntry> entries;
+	// smallest count first
+	std::vector<HeapNode> heap;
+	// where each entry sits in the heap
+	std::vector<uint32_t> positions;
+	// low half of the hash above entry index + 1, by hash, linear probing, 0 when free;
+	// a probe only reads an entry once the hashes agree
+	std::vector<uint64_t> slots;
+	unsigned capacity;
+	uint64_t total;
+
+	uint32_t find(const SketchKey&, const uint64_t&) const;
+	void eraseSlot(const uint32_t&);
+	void siftUp(unsigned);
+	void siftDown(unsigned);
+	void rebuild();
+
+public:
+	SpaceSaving(const unsigned& = SPACE_SAVING_DEFAULT_CAPACITY);
+
+	// key, its hash, weight and, if known, an upper bound on the key's weight so far, this update included
+	void add(const SketchKey&, const uint64_t&, const uint64_t&, const uint64_t& = UINT64_MAX);
+	void merge(const SpaceSaving&);
+	void clear();
+
+	// what an untracked key may have weighed, 0 until every counter is taken
+	uint64_t getMinimum() const;
+	uint64_t getTotal() const;
+	unsigned getCapacity() const;
+	// the heaviest keys, heaviest first, at most the given count
+	void getTop(const unsigned&, std::vector<SpaceSavingEntry>&) const;
+};
+
+/* KEYS */
+
+inline uint64_t SketchKey::getHash() const
+{
+	uint64_t hash(0x9E3779B97F4A7C15);
+
+	for (unsigned i(0); i < SKETCH_KEY_WORDS; i++) {
+		hash = (hash ^ words[i]) * 0xBF58476D1CE4E5B9;
+		hash ^= hash >> 31;
+	}
+	// the splitmix64 finalizer, so every output bit depends on every input bit
+	hash = (hash ^ hash >> 30) * 0xBF58476D1CE4E5B9;
+	hash = (hash ^ hash >> 27) * 0x94D049BB133111EB;
+	return hash ^ hash >> 31;
+}
+
+inline bool SketchKey::operator==(const SketchKey& other) const
+{
+	uint64_t difference(0);
+
+	for (unsigned i(0); i < SKETCH_KEY_WORDS; i++)
+		difference |= words[i] ^ other.words[i];
+	return !difference;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// measured in octets
+#define STREAM_CHUNK_LENGTH			2048
+#define STREAM_FLOW_MAX_BYTES		0x100000
+#define STREAM_MAX_BYTES			0x10000000
+
+// marks the end of a chunk list
+#define STREAM_NONE 0xFFFFFFFF
+
+// in-order bytes of one direction of a flow; data is only valid during the call
+typedef std::function<void(const uint32_t&, const int&, const char*, const unsigned&)> StreamCallback;
+
+/*
+ * Rebuilds the byte streams of TCP connections tracked by a FlowTable,
+ * addressed by flow index and side. Segments that arrive in order go
+ * straight from the frame to the callback; only data ahead of a hole is
+ * copied, into fixed-size chunks from a pool reserved up front and kept
+ * on a per-direction list sorted by sequence number. Overlaps are trimmed
+ * so the first copy of any byte wins and retransmissions are dropped.
+ *
+ * Each direction may hold at most maxFlowBytes out of order and all of
+ * them together at most maxBytes. When a direction runs out of room the
+ * hole in front of it is given up on: its buffered data is delivered and
+ * the skipped bytes are counted, so a lost segment never stalls a stream
+ * nor lets a hostile capture grow memory.
+ */
+class StreamReassembler {
+private:
+	struct Chunk {
+		uint32_t sequence;
+		uint32_t next;
+		uint16_t length;
+		char data[STREAM_CHUNK_LENGTH - 10];
+	};
+
+	struct Stream {
+		uint32_t next;
+		uint32_t head;
+		uint32_t buffered;
+		uint32_t started;
+		uint64_t delivered;
+		uint64_t skipped;
+	};
+
+	Stream* streams;
+	Chunk* chunks;
+	uint32_t flowCount;
+	uint32_t chunkCount;
+	uint32_t usedChunks;
+	uint32_t freeChunks;
+	uint32_t maxFlowBytes;
+	uint64_t overlapped;
+	uint64_t dropped;
+	uint64_t bufferedBytes;
+	StreamCallback onData;
+
+	void place(const uint32_t&, const int&, Stream&, uint32_t, const char*, unsigned);
+	void deliver(const uint32_t&, const int&, Stream&, const char*, const unsigned&);
+	void drain(const uint32_t&, const int&, Stream&);
+	void insert(Stream&, const uint32_t&, const char*, const unsigned&);
+	uint32_t* insertPieces(Stream&, uint32_t*, uint32_t, const char*, unsigned);
+	bool fits(const Stream&, const unsigned&) const;
+	uint32_t allocate();
+	void freeChunk(const uint32_t&);
+
+public:
+	StreamReassembler(const unsigned&, const unsigned& = STREAM_FLOW_MAX_BYTES, const uint64_t& = STREAM_MAX_BYTES);
+	~StreamReassembler();
+
+	bool isOk() const;
+
+	// one segment of the given flow and side; payload is the TCP payload only
+	void segment(const uint32_t&, const int&, const uint32_t&, const uint8_t&, const char*, const unsigned&);
+	// forgets both directions of a flow, to be called as the flow leaves its table
+	void release(const uint32_t&);
+
+	void setCallback(const StreamCallback&);
+
+	uint64_t getDelivered(const uint32_t&, const int&) const;
+	uint64_t getSkipped(const uint32_t&, const int&) const;
+	uint64_t getBuffered() const;
+	uint64_t getOverlapped() const;
+	uint64_t getDropped() const;
+	uint64_t getMemoryUsage() const;
+};
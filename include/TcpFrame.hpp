@@ -16,6 +16,17 @@
 #define TCP_CHECKSUM_SIZE 16
 #define TCP_URGENT_POINTER_SIZE 16
 
+// longest text getFlagsAsString returns, measured in characters
+#define TCP_FLAGS_TEXT_LENGTH 23
+
+// bits of the flags field
+#define TCP_FLAG_FIN 0x01
+#define TCP_FLAG_SYN 0x02
+#define TCP_FLAG_RST 0x04
+#define TCP_FLAG_PSH 0x08
+#define TCP_FLAG_ACK 0x10
+#define TCP_FLAG_URG 0x20
+
 class TcpFrame
 {
 private:
@@ -29,12 +40,20 @@ private:
 	unsigned checkSum : TCP_CHECKSUM_SIZE;
 	unsigned calculatedCheckSum : TCP_CHECKSUM_SIZE;
 	unsigned urgentPointer : TCP_URGENT_POINTER_SIZE;
+	unsigned checkSumVerifiable : 1;
 
 	std::string portToString(const unsigned&) const;
-	void calculateCheckSum();
+	void calculateCheckSum(const char*, const unsigned&, const unsigned&);
 public:
+	// shortest payload the transport dissector hands over
+	static const unsigned MIN_LENGTH = TCP_MIN_HEADER_LENGTH;
+
 	TcpFrame();
 	TcpFrame(const char*);
+	// whole segment and the folded pseudo-header sum, which also verifies the checksum
+	TcpFrame(const char*, const unsigned&, const unsigned&);
+	// captured bytes, the pseudo-header sum and the segment length from the IP header
+	TcpFrame(const char*, const unsigned&, const unsigned&, const unsigned&);
 	~TcpFrame();
 
 	void fromBytes(const char*);
@@ -42,6 +61,8 @@ public:
 	std::string getSourcePortAsString() const;
 	std::string getDestinationPortAsString() const;
 	std::string getFlagsAsString() const;
+	// the same text written into a buffer of TCP_FLAGS_TEXT_LENGTH, returns its length
+	unsigned formatFlags(char*) const;
 
 	void setSourcePort(const unsigned&);
 	void setDestinationPort(const unsigned&);
@@ -65,5 +86,7 @@ public:
 
 	unsigned getCalculatedCheckSum() const;
 
+	// a snapped segment lacks bytes the checksum covers, so it can't be checked
+	bool checkSumIsVerifiable() const;
 	bool checkSumIsOk() const;
 };
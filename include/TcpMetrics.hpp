@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+
+#include "PacketSummary.hpp"
+#include "TcpView.hpp"
+
+// histogram bucket i counts samples from 2^i up to 2^(i+1) microseconds, the first also those below
+#define TCP_METRICS_BUCKETS			24
+// measured in nanoseconds: an earlier segment seen this soon after a later one is taken as reordered,
+// not resent, while the flow has no RTT estimate to go by
+#define TCP_METRICS_REORDER_WINDOW	3000000ULL
+
+// bits of TcpMetrics::Connection::synOptions, under them the offered shift
+#define TCP_METRICS_SYN_SEEN			0x80
+#define TCP_METRICS_SYN_WINDOW_SCALE	0x40
+
+// RTT samples by power of two of microseconds
+struct RttHistogram {
+	uint64_t buckets[TCP_METRICS_BUCKETS];
+	uint64_t samples;
+	uint64_t total;
+
+	void add(const uint64_t&);
+	// microseconds, 0 without samples
+	uint64_t getMean() const;
+	static uint64_t getBucketStart(const unsigned&);
+};
+
+/*
+ * Derives performance metrics from the TCP connections of a FlowTable as
+ * their segments go by, addressed by flow index and side like the
+ * StreamReassembler, in a fixed record per flow reserved up front:
+ *
+ *   - handshake RTT, from the SYN to the SYN/ACK, unless the SYN was resent;
+ *   - data RTT, one segment in flight timed at a time per direction until an
+ *     ACK covers it, discarded if it is resent (Karn's rule);
+ *   - retransmissions and out-of-order segments, data starting below the
+ *     highest sequence sent, told apart by how long after it they come;
+ *   - zero-window events, a side closing its window, and window shrinks, the
+ *     right edge of a window moving left, which needs the scale of the
+ *     window and so the handshake.
+ *
+ * Samples go to histograms shared by all flows; the counters of a flow
+ * are added to the totals when it is released.
+ */
+class TcpMetrics {
+private:
+	struct Side {
+		// the sequence number after the highest octet sent, and when it last moved
+		uint32_t next;
+		uint32_t timedEnd;
+		uint64_t advancedAt;
+		// when the timed segment was sent, 0 while none is
+		uint64_t timedAt;
+		// ack + window in octets, as last advertised by this side, and that ack
+		uint32_t rightEdge;
+		uint32_t acknowledged;
+		// smoothed as in RFC 6298, in microseconds, 0 until the first sample
+		uint32_t smoothedRtt;
+		uint32_t rttSamples;
+		uint32_t retransmissions;
+		uint32_t outOfOrder;
+		uint32_t zeroWindows;
+		uint32_t windowShrinks;
+		uint8_t started;
+		uint8_t zeroWindow;
+		uint8_t edgeKnown;
+		uint8_t windowScale;
+	};
+
+	struct Connection {
+		uint64_t synAt;
+		// microseconds, at least 1 once measured
+		uint32_t handshakeRtt;
+		uint8_t synResent;
+		// what each side's SYN said of window scaling, TCP_METRICS_SYN_* bits and the shift
+		uint8_t synOptions[2];
+		Side sides[2];
+	};
+
+	Connection* connections;
+	uint32_t flowCount;
+	RttHistogram handshakes;
+	RttHistogram roundTrips;
+	uint64_t retransmissions;
+	uint64_t outOfOrder;
+	uint64_t zeroWindows;
+	uint64_t windowShrinks;
+
+	void handshake(Connection&, const int&, const PacketSummary&, const TcpView&);
+	void sequence(Side&, const PacketSummary&);
+	void acknowledge(Side&, const PacketSummary&);
+	void window(Connection&, Side&, const PacketSummary&);
+	static bool before(const uint32_t&, const uint32_t&);
+
+public:
+	TcpMetrics(const unsigned&);
+	~TcpMetrics();
+
+	bool isOk() const;
+
+	// one segment of the given flow and side; the view is the segment's TCP header and what follows
+	void segment(const uint32_t&, const int&, const PacketSummary&, const TcpView&);
+	// adds a flow's counters to the totals and forgets it, to be called as the flow leaves its table
+	void release(const uint32_t&);
+
+	// microseconds, 0 when not measured
+	uint32_t getHandshakeRtt(const uint32_t&) const;
+	uint32_t getSmoothedRtt(const uint32_t&, const int&) const;
+	uint32_t getRttSamples(const uint32_t&, const int&) const;
+	uint32_t getRetransmissions(const uint32_t&, const int&) const;
+	uint32_t getOutOfOrder(const uint32_t&, const int&) const;
+	uint32_t getZeroWindows(const uint32_t&, const int&) const;
+	uint32_t getWindowShrinks(const uint32_t&, const int&) const;
+
+	const RttHistogram& getHandshakes() const;
+	const RttHistogram& getRoundTrips() const;
+	uint64_t getRetransmissions() const;
+	uint64_t getOutOfOrder() const;
+	uint64_t getZeroWindows() const;
+	uint64_t getWindowShrinks() const;
+	uint64_t getMemoryUsage() const;
+};
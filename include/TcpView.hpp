@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ByteOrder.hpp"
+
+// measured in octets
+#define TCP_VIEW_MIN_HEADER_LENGTH 20
+
+// option kinds, RFC 9293 and RFC 7323
+#define TCP_VIEW_OPTION_END				0
+#define TCP_VIEW_OPTION_NOP				1
+#define TCP_VIEW_OPTION_WINDOW_SCALE	3
+#define TCP_VIEW_MAX_WINDOW_SCALE		14
+
+/*
+ * Non-owning view over a TCP segment; see IpView for the validity contract.
+ */
+class TcpView {
+private:
+	const uint8_t* bytes;
+	unsigned length;
+
+public:
+	TcpView() : bytes(nullptr), length(0) {}
+	TcpView(const uint8_t* b, const unsigned& l) : bytes(b), length(l) {}
+	TcpView(const char* b, const unsigned& l) : bytes(reinterpret_cast<const uint8_t*>(b)), length(l) {}
+
+	bool isValid() const
+	{
+		return length >= TCP_VIEW_MIN_HEADER_LENGTH
+			&& getHeaderLength() >= TCP_VIEW_MIN_HEADER_LENGTH
+			&& getHeaderLength() <= length;
+	}
+
+	unsigned getSourcePort() const { return load16(bytes); }
+	unsigned getDestinationPort() const { return load16(bytes + 2); }
+	uint32_t getSequenceNumber() const { return load32(bytes + 4); }
+	uint32_t getAcknowledgementNumber() const { return load32(bytes + 8); }
+	unsigned getDataOffset() const { return bytes[12] >> 4; }
+	unsigned getHeaderLength() const { return getDataOffset() * 4; }
+	unsigned getFlags() const { return bytes[13] & 0b111111; }
+	unsigned getWindow() const { return load16(bytes + 14); }
+	unsigned getCheckSum() const { return load16(bytes + 16); }
+	unsigned getUrgentPointer() const { return load16(bytes + 18); }
+
+	// the shift a SYN offers for the windows its sender will advertise, false if it offers none
+	bool getWindowScale(unsigned& scale) const
+	{
+		const uint8_t* option(bytes + TCP_VIEW_MIN_HEADER_LENGTH);
+		const uint8_t* end(bytes + getHeaderLength());
+
+		while (option < end && *option != TCP_VIEW_OPTION_END) {
+			if (*option == TCP_VIEW_OPTION_NOP) {
+				option++;
+				continue;
+			}
+			if (end - option < 2 || option[1] < 2 || option[1] > end - option)
+				return false;
+			if (*option == TCP_VIEW_OPTION_WINDOW_SCALE && option[1] == 3) {
+				// larger shifts are treated as the largest, as RFC 7323 asks
+				scale = option[2] < TCP_VIEW_MAX_WINDOW_SCALE ? option[2] : TCP_VIEW_MAX_WINDOW_SCALE;
+				return true;
+			}
+			option += option[1];
+		}
+		return false;
+	}
+
+	const uint8_t* getPayload() const { return bytes + getHeaderLength(); }
+	unsigned getPayloadLength() const { return length - getHeaderLength(); }
+
+	const uint8_t* getBytes() const { return bytes; }
+	unsigned getLength() const { return length; }
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// longest text each encoder writes, measured in characters
+#define TEXT_MAX_DECIMAL_LENGTH	20
+#define TEXT_MAX_HEX_LENGTH		16
+#define TEXT_MAC_LENGTH			17
+// the IPv4 encoder may scribble a little past the text it returns, never past this
+#define TEXT_MAX_IPV4_LENGTH	15
+#define TEXT_MAX_IPV6_LENGTH	39
+
+/*
+ * Lookup tables for the encoders below, built by the compiler so they are
+ * ready before any static constructor runs.
+ */
+struct TextTables {
+	// "00" to "99", two characters per entry
+	char digitPairs[200];
+	// "00" to "ff", two characters per entry
+	char hexPairs[512];
+	// 0 to 255 in decimal, padded to three characters, with the real length in the fourth
+	char octets[256][4];
+	// 10 to the power of the index
+	uint64_t powersOfTen[TEXT_MAX_DECIMAL_LENGTH];
+
+	constexpr TextTables() : digitPairs(), hexPairs(), octets(), powersOfTen()
+	{
+		const char hexDigits[] = "0123456789abcdef";
+
+		for (unsigned i(0); i < 100; i++) {
+			digitPairs[2 * i] = '0' + i / 10;
+			digitPairs[2 * i + 1] = '0' + i % 10;
+		}
+		for (unsigned i(0); i < 256; i++) {
+			const unsigned length(i >= 100 ? 3 : i >= 10 ? 2 : 1);
+
+			hexPairs[2 * i] = hexDigits[i >> 4];
+			hexPairs[2 * i + 1] = hexDigits[i & 0xF];
+			for (unsigned j(length), value(i); j > 0; j--, value /= 10)
+				octets[i][j - 1] = '0' + value % 10;
+			octets[i][3] = length;
+		}
+		powersOfTen[0] = 1;
+		for (unsigned i(1); i < TEXT_MAX_DECIMAL_LENGTH; i++)
+			powersOfTen[i] = powersOfTen[i - 1] * 10;
+	}
+};
+
+extern const TextTables textTables;
+
+/*
+ * Hand-rolled encoders that write into a caller's buffer and return how
+ * many characters they wrote. They never allocate and never terminate the
+ * text; output matches what an ostream prints for the same value.
+ */
+
+// digits in value, from the bit length: 1233 / 4096 is just over log10(2)
+inline unsigned decimalLength(const uint64_t& value)
+{
+	const unsigned guess((64 - __builtin_clzll(value | 1)) * 1233 >> 12);
+	return guess + ((value | 1) >= textTables.powersOfTen[guess]);
+}
+
+// like ostream << dec; digits go straight into place, two at a time from the right
+inline unsigned formatDecimal(char* out, uint64_t value)
+{
+	const unsigned length(decimalLength(value));
+	char* at(out + length);
+
+	while (value >= 100) {
+		at -= 2;
+		memcpy(at, textTables.digitPairs + value % 100 * 2, 2);
+		value /= 100;
+	}
+	if (value >= 10)
+		memcpy(at - 2, textTables.digitPairs + value * 2, 2);
+	else
+		at[-1] = '0' + value;
+
+	return length;
+}
+
+// like ostream << hex, zero padded to width as with setfill('0') << setw(width)
+inline unsigned formatHex(char* out, uint64_t value, const unsigned& width = 1)
+{
+	const unsigned significant(value ? (64 - __builtin_clzll(value) + 3) / 4 : 1);
+	const unsigned length(significant > width ? significant : width);
+
+	for (unsigned i(length); i > 0; i--) {
+		out[i - 1] = textTables.hexPairs[(value & 0xF) * 2 + 1];
+		value >>= 4;
+	}
+	return length;
+}
+
+// six octets as aa:bb:cc:dd:ee:ff
+inline unsigned formatMac(char* out, const uint8_t* address)
+{
+	for (unsigned i(0); i < 6; i++) {
+		memcpy(out + 3 * i, textTables.hexPairs + address[i] * 2, 2);
+		if (i < 5)
+			out[3 * i + 2] = ':';
+	}
+	return TEXT_MAC_LENGTH;
+}
+
+// a host order address in dotted decimal
+inline unsigned formatIpv4(char* out, const uint32_t& address)
+{
+	char* at(out);
+
+	for (int shift(24); shift >= 0; shift -= 8) {
+		const char* octet(textTables.octets[address >> shift & 0xFF]);
+		memcpy(at, octet, 3);
+		at += octet[3];
+		if (shift)
+			*at++ = '.';
+	}
+	return at - out;
+}
+
+// sixteen octets in RFC 5952 form
+unsigned formatIpv6(char*, const uint8_t*);
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#define TRAFFIC_DEFAULT_PACKETS	1000000
+#define TRAFFIC_DEFAULT_FLOWS	1000
+#define TRAFFIC_DEFAULT_SEED	1
+
+// measured in octets, ethernet frames without FCS
+#define TRAFFIC_MIN_FRAME_LENGTH	60
+#define TRAFFIC_MAX_FRAME_LENGTH	1514
+// records are gathered in memory and written in chunks this large
+#define TRAFFIC_WRITE_LENGTH		0x400000
+// random payload octets are copied out of a pool this large (a power of two)
+#define TRAFFIC_PAYLOAD_POOL_LENGTH	0x10000
+
+typedef enum {
+	TRAFFIC_SIZE_FIXED,
+	TRAFFIC_SIZE_UNIFORM,
+	// 7:4:1 of 64, 576 and 1500 octet packets
+	TRAFFIC_SIZE_IMIX
+} TrafficSizeMode;
+
+/*
+ * What to generate. Rates are probabilities between 0 and 1, applied per
+ * flow (ipv6Rate, vlanRate) or per packet (the rest).
+ */
+struct TrafficProfile {
+	uint64_t seed;
+	uint64_t packets;
+	unsigned flows;
+	TrafficSizeMode sizeMode;
+	unsigned minSize;
+	unsigned maxSize;
+	unsigned tcpWeight;
+	unsigned udpWeight;
+	unsigned icmpWeight;
+	double ipv6Rate;
+	double vlanRate;
+	double fragmentRate;
+	double reorderRate;
+	double corruptRate;
+
+	TrafficProfile();
+};
+
+/*
+ * Writes a classic pcap of synthetic flows. Everything is drawn from one
+ * seeded generator with no library distributions involved, so the same
+ * profile produces the same bytes on every machine. Headers are laid out
+ * with the decoder's own constants and carry correct checksums unless a
+ * packet was picked for corruption.
+ *
+ * IPv4 datagrams picked for fragmentation are sent as two fragments;
+ * reordering swaps a packet with the next one of the same flow and
+ * direction while timestamps keep increasing, as a capture of reordered
+ * traffic would show. TCP handshakes are never reordered.
+ */
+class TrafficGenerator {
+private:
+	struct Flow {
+		uint8_t clientAddress[16];
+		uint8_t serverAddress[16];
+		uint16_t clientPort;
+		uint16_t serverPort;
+		uint8_t protocol;
+		bool ipv6;
+		uint16_t vlan;
+		uint32_t sequence[2];
+		uint32_t sent;
+		uint16_t id;
+	};
+
+	TrafficProfile profile;
+	uint64_t state;
+	std::vector<Flow> flows;
+	std::vector<uint8_t> pool;
+	std::vector<uint8_t> buffer;
+	size_t position;
+	// a packet picked for reordering waits here until the next one of its flow and direction is out
+	std::vector<uint8_t> held;
+	Flow* heldFlow;
+	bool heldFromClient;
+	// a datagram being cut into fragments
+	std::vector<uint8_t> scratch;
+	// microseconds
+	uint64_t time;
+	uint64_t fragmentThreshold;
+	uint64_t reorderThreshold;
+	uint64_t corruptThreshold;
+
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t fragmented;
+	uint64_t reordered;
+	uint64_t corrupted;
+
+	uint64_t next();
+	uint32_t nextBelow(const uint32_t&);
+	bool draw(const uint64_t&);
+	static uint64_t threshold(const double&);
+
+	void createFlow(Flow&);
+	unsigned drawFrameLength();
+	uint8_t* beginRecord(const unsigned&);
+	void stamp(uint8_t*);
+	unsigned writeLink(uint8_t*, const Flow&, const bool&) const;
+	void writeTransport(uint8_t*, Flow&, const bool&, const unsigned&, const unsigned&);
+	void writePacket(Flow&);
+	void writeFragments(const size_t&, const unsigned&);
+	void release(const size_t&, Flow&, const bool&, const bool&);
+	bool flush(std::ostream&);
+
+public:
+	TrafficGenerator(const TrafficProfile&);
+
+	bool write(std::ostream&);
+
+	uint64_t getPackets() const;
+	uint64_t getBytes() const;
+	uint64_t getFragmented() const;
+	uint64_t getReordered() const;
+	uint64_t getCorrupted() const;
+};
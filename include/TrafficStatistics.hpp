@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PacketSummary.hpp"
+
+// seconds between snapshots unless told otherwise
+#define STATISTICS_DEFAULT_INTERVAL	1
+#define STATISTICS_PROTOCOLS		0x100
+#define STATISTICS_PORTS			0x10000
+#define STATISTICS_PRECEDENCES		8
+#define STATISTICS_TCP_FLAGS		8
+#define STATISTICS_TCP_FLAG_SETS	0x100
+// frame lengths up to 64, 127, 255, 511, 1023, 1518 octets and longer, as RMON counts them
+#define STATISTICS_SIZE_BUCKETS		7
+// ports listed in a snapshot
+#define STATISTICS_TOP_PORTS		10
+
+/*
+ * The counters of one decoder thread. Only that thread writes them, with
+ * relaxed loads and stores that compile to plain adds, while the thread
+ * taking snapshots reads them at any time; no lock and no atomic
+ * read-modify-write is involved. Each block is aligned to and padded out
+ * to whole cache lines, so threads never share one.
+ */
+struct alignas(64) TrafficCounters {
+	std::atomic<uint64_t> frames;
+	std::atomic<uint64_t> bytes;
+	std::atomic<uint64_t> ipv4;
+	std::atomic<uint64_t> ipv6;
+	std::atomic<uint64_t> sizes[STATISTICS_SIZE_BUCKETS];
+	// by IP protocol number, and by the precedence bits of the TOS or traffic class
+	std::atomic<uint64_t> protocols[STATISTICS_PROTOCOLS];
+	std::atomic<uint64_t> precedences[STATISTICS_PRECEDENCES];
+	// by the whole flags octet, one add per segment; snapshots split them into single flags
+	std::atomic<uint64_t> tcpFlagSets[STATISTICS_TCP_FLAG_SETS];
+	// TCP and UDP, each end counted once
+	std::atomic<uint64_t> ports[STATISTICS_PORTS];
+};
+
+static_assert(sizeof(TrafficCounters) % 64 == 0, "TrafficCounters must fill whole cache lines");
+
+// every thread's counters added up at one point in time
+struct TrafficSnapshot {
+	uint64_t frames;
+	uint64_t bytes;
+	uint64_t ipv4;
+	uint64_t ipv6;
+	uint64_t sizes[STATISTICS_SIZE_BUCKETS];
+	uint64_t protocols[STATISTICS_PROTOCOLS];
+	uint64_t precedences[STATISTICS_PRECEDENCES];
+	// entry i counts the segments with flag 1 << i set
+	uint64_t tcpFlags[STATISTICS_TCP_FLAGS];
+	std::vector<uint64_t> ports;
+
+	TrafficSnapshot();
+
+	// the ports with the most frames, most first, at most the given count
+	void getTopPorts(const unsigned&, std::vector<uint16_t>&) const;
+	static const char* getSizeBucketName(const unsigned&);
+	static const char* getTcpFlagName(const unsigned&);
+};
+
+class TrafficStatistics {
+private:
+	std::unique_ptr<TrafficCounters[]> counters;
+	unsigned threads;
+
+	static void add(std::atomic<uint64_t>&, const uint64_t&);
+	static unsigned getSizeBucket(const unsigned&);
+
+public:
+	TrafficStatistics(const unsigned&);
+
+	TrafficCounters& getCounters(const unsigned&);
+	void snapshot(TrafficSnapshot&) const;
+
+	// called by the thread owning the counters only
+	static void count(TrafficCounters&, const PacketSummary&);
+};
+
+/* COUNTING */
+
+inline void TrafficStatistics::add(std::atomic<uint64_t>& counter, const uint64_t& amount)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+inline unsigned TrafficStatistics::getSizeBucket(const unsigned& length)
+{
+	if (length <= 64)
+		return 0;
+	if (length > 1518)
+		return 6;
+	if (length >= 1024)
+		return 5;
+	// 65-127 is 1 through 512-1023 is 4, by the highest bit set
+	return 31 - __builtin_clz(length) - 5;
+}
+
+inline void TrafficStatistics::count(TrafficCounters& c, const PacketSummary& summary)
+{
+	add(c.frames, 1);
+	add(c.bytes, summary.frameLength);
+	add(c.sizes[getSizeBucket(summary.frameLength)], 1);
+
+	if (!(summary.layers & (PACKET_LAYER_IPV4 | PACKET_LAYER_IPV6)))
+		return;
+
+	add(summary.layers & PACKET_LAYER_IPV4 ? c.ipv4 : c.ipv6, 1);
+	add(c.protocols[summary.protocol], 1);
+	add(c.precedences[summary.service >> 5], 1);
+
+	if (summary.layers & (PACKET_LAYER_TCP | PACKET_LAYER_UDP)) {
+		add(c.ports[summary.sourcePort], 1);
+		if (summary.destinationPort != summary.sourcePort)
+			add(c.ports[summary.destinationPort], 1);
+	}
+	if (summary.layers & PACKET_LAYER_TCP)
+		add(c.tcpFlagSets[summary.tcpFlags], 1);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+
+// measured in bytes
+#define UDP_HEADER_LENGTH 8
+
+// measured in bits
+#define UDP_PORT_SIZE 16
+#define UDP_LENGTH_SIZE 16
+#define UDP_CHECKSUM_SIZE 16
+
+class UdpFrame
+{
+private:
+	unsigned sourcePort : UDP_PORT_SIZE;
+	unsigned destinationPort : UDP_PORT_SIZE;
+	unsigned length : UDP_LENGTH_SIZE;
+	unsigned checkSum : UDP_CHECKSUM_SIZE;
+	unsigned calculatedCheckSum : UDP_CHECKSUM_SIZE;
+	unsigned checkSumVerifiable : 1;
+
+	std::string portToString(const unsigned&) const;
+	void calculateCheckSum(const char*, const unsigned&, const unsigned&);
+public:
+	// shortest payload the transport dissector hands over
+	static const unsigned MIN_LENGTH = UDP_HEADER_LENGTH;
+
+	UdpFrame();
+	UdpFrame(const char*);
+	// whole datagram and the folded pseudo-header sum, which also verifies the checksum
+	UdpFrame(const char*, const unsigned&, const unsigned&);
+	// as the transport dissector builds it; the datagram carries its own length, so the IP one is unused
+	UdpFrame(const char*, const unsigned&, const unsigned&, const unsigned&);
+	~UdpFrame();
+
+	void fromBytes(const char*);
+
+	std::string getSourcePortAsString() const;
+	std::string getDestinationPortAsString() const;
+
+	void setSourcePort(const unsigned&);
+	void setDestinationPort(const unsigned&);
+	void setLength(const unsigned&);
+	void setCheckSum(const unsigned&);
+
+	unsigned getSourcePort() const;
+	unsigned getDestinationPort() const;
+	unsigned getLength() const;
+	unsigned getCheckSum() const;
+
+	unsigned getCalculatedCheckSum() const;
+
+	// a sender may leave the checksum out (zero), which is always OK
+	bool checkSumIsPresent() const;
+	// a snapped datagram lacks bytes the checksum covers, so it can't be checked
+	bool checkSumIsVerifiable() const;
+	bool checkSumIsOk() const;
+};
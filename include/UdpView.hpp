@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ByteOrder.hpp"
+
+// measured in octets
+#define UDP_VIEW_HEADER_LENGTH 8
+
+/*
+ * Non-owning view over a UDP datagram; see IpView for the validity contract.
+ */
+class UdpView {
+private:
+	const uint8_t* bytes;
+	unsigned length;
+
+public:
+	UdpView() : bytes(nullptr), length(0) {}
+	UdpView(const uint8_t* b, const unsigned& l) : bytes(b), length(l) {}
+	UdpView(const char* b, const unsigned& l) : bytes(reinterpret_cast<const uint8_t*>(b)), length(l) {}
+
+	bool isValid() const
+	{
+		return length >= UDP_VIEW_HEADER_LENGTH && getLength() >= UDP_VIEW_HEADER_LENGTH;
+	}
+
+	unsigned getSourcePort() const { return load16(bytes); }
+	unsigned getDestinationPort() const { return load16(bytes + 2); }
+	// as announced in the header, payload included
+	unsigned getLength() const { return load16(bytes + 4); }
+	unsigned getCheckSum() const { return load16(bytes + 6); }
+
+	// octets of the datagram present in the buffer
+	unsigned getCapturedLength() const { return getLength() < length ? getLength() : length; }
+
+	const uint8_t* getPayload() const { return bytes + UDP_VIEW_HEADER_LENGTH; }
+	unsigned getPayloadLength() const { return getCapturedLength() - UDP_VIEW_HEADER_LENGTH; }
+
+	const uint8_t* getBytes() const { return bytes; }
+};
@@ -0,0 +1,80 @@
+#include <Arena.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+// block data starts right after the header, suitably aligned
+static const size_t BLOCK_HEADER_LENGTH((sizeof(void*) * 2 + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1));
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+Arena::Arena(const size_t& length)
+	: first(nullptr), current(nullptr), position(nullptr), end(nullptr), blockLength(length), reserved(0)
+{
+}
+
+Arena::~Arena()
+{
+	while (first) {
+		Block* next(first->next);
+		free(first);
+		first = next;
+	}
+}
+
+/* ALLOCATION */
+
+void* Arena::allocate(const size_t& length, const size_t& alignment)
+{
+	char* aligned(reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(position) + alignment - 1) & ~(alignment - 1)));
+
+	if (!position || aligned + length > end) {
+		if (!advance(length + alignment))
+			return nullptr;
+		aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(position) + alignment - 1) & ~(alignment - 1));
+	}
+
+	position = aligned + length;
+	return aligned;
+}
+
+bool Arena::advance(const size_t& length)
+{
+	// blocks kept from earlier rounds are reused before anything new is asked for
+	Block* next(current ? current->next : first);
+	while (next && next->length < length) {
+		current = next;
+		next = next->next;
+	}
+
+	if (!next) {
+		const size_t dataLength(length > blockLength ? length : blockLength);
+		next = static_cast<Block*>(malloc(BLOCK_HEADER_LENGTH + dataLength));
+		if (!next)
+			return false;
+
+		next->next = nullptr;
+		next->length = dataLength;
+		reserved += BLOCK_HEADER_LENGTH + dataLength;
+		if (current)
+			current->next = next;
+		else
+			first = next;
+	}
+
+	current = next;
+	position = reinterpret_cast<char*>(current) + BLOCK_HEADER_LENGTH;
+	end = position + current->length;
+	return true;
+}
+
+void Arena::reset()
+{
+	current = first;
+	position = first ? reinterpret_cast<char*>(first) + BLOCK_HEADER_LENGTH : nullptr;
+	end = first ? position + first->length : nullptr;
+}
+
+size_t Arena::getReserved() const { return reserved; }
@@ -0,0 +1,271 @@
+#include <CaptureFormat.hpp>
+
+#include <cstring>
+
+using namespace std;
+
+static uint32_t nativeWord(const char* bytes)
+{
+	uint32_t word;
+	memcpy(&word, bytes, sizeof(word));
+	return word;
+}
+
+/* CONSTRUCTORS */
+
+CaptureFormat::CaptureFormat()
+	: type(CAPTURE_TYPE_UNKNOWN), swapped(false), linkType(LINKTYPE_ETHERNET), unitsPerSecond(1000000)
+{
+}
+
+/* DETECTION */
+
+bool CaptureFormat::detect(const char* bytes, const unsigned& length)
+{
+	type = CAPTURE_TYPE_UNKNOWN;
+	swapped = false;
+	if (length == 0)
+		return false;
+
+	if (length >= PCAP_FILE_HEADER_LENGTH) {
+		const uint32_t magic(nativeWord(bytes));
+
+		swapped = magic == __builtin_bswap32(PCAP_MAGIC_MICROSECONDS)
+			|| magic == __builtin_bswap32(PCAP_MAGIC_NANOSECONDS);
+
+		const uint32_t ordered(read32(bytes));
+		if (ordered == PCAP_MAGIC_MICROSECONDS || ordered == PCAP_MAGIC_NANOSECONDS) {
+			type = CAPTURE_TYPE_PCAP;
+			unitsPerSecond = ordered == PCAP_MAGIC_NANOSECONDS ? 1000000000 : 1000000;
+			linkType = read32(bytes + 20) & 0xFFFFFFF;
+			return true;
+		}
+
+		if (nativeWord(bytes) == PCAPNG_BLOCK_SECTION_HEADER) {
+			const uint32_t byteOrder(nativeWord(bytes + 8));
+			if (byteOrder == PCAPNG_BYTE_ORDER_MAGIC || byteOrder == __builtin_bswap32(PCAPNG_BYTE_ORDER_MAGIC)) {
+				type = CAPTURE_TYPE_PCAPNG;
+				swapped = byteOrder != PCAPNG_BYTE_ORDER_MAGIC;
+				return true;
+			}
+		}
+	}
+
+	// anything else is taken to be a single bare ethernet frame
+	type = CAPTURE_TYPE_RAW;
+	swapped = false;
+	linkType = LINKTYPE_ETHERNET;
+	return true;
+}
+
+CaptureType CaptureFormat::getType() const { return type; }
+
+const char* CaptureFormat::getTypeAsString() const
+{
+	switch (type) {
+	case CAPTURE_TYPE_RAW:
+		return "raw frame";
+	case CAPTURE_TYPE_PCAP:
+		return "pcap";
+	case CAPTURE_TYPE_PCAPNG:
+		return "pcapng";
+	default:
+		return "unknown";
+	}
+}
+
+/* FRAMING */
+
+unsigned CaptureFormat::getFileHeaderLength() const
+{
+	return type == CAPTURE_TYPE_PCAP ? PCAP_FILE_HEADER_LENGTH : 0;
+}
+
+unsigned CaptureFormat::getRecordHeaderLength() const
+{
+	switch (type) {
+	case CAPTURE_TYPE_PCAP:
+		return PCAP_RECORD_HEADER_LENGTH;
+	case CAPTURE_TYPE_PCAPNG:
+		return PCAPNG_MIN_BLOCK_LENGTH;
+	default:
+		return 0;
+	}
+}
+
+unsigned CaptureFormat::getRecordLength(const char* header) const
+{
+	uint64_t length(0);
+
+	switch (type) {
+	case CAPTURE_TYPE_PCAP:
+		length = static_cast<uint64_t>(PCAP_RECORD_HEADER_LENGTH) + read32(header + 8);
+		break;
+	case CAPTURE_TYPE_PCAPNG:
+		// a new section may switch byte order, so its length is read with its own
+		if (nativeWord(header) == PCAPNG_BLOCK_SECTION_HEADER) {
+			const uint32_t byteOrder(nativeWord(header + 8));
+			length = byteOrder == PCAPNG_BYTE_ORDER_MAGIC ? nativeWord(header + 4) : __builtin_bswap32(nativeWord(header + 4));
+		} else {
+			length = read32(header + 4);
+		}
+		if (length < PCAPNG_MIN_BLOCK_LENGTH || length % 4)
+			return 0;
+		break;
+	default:
+		return 0;
+	}
+
+	return length > CAPTURE_MAX_RECORD_LENGTH ? 0 : static_cast<unsigned>(length);
+}
+
+bool CaptureFormat::parseRecord(const char* record, const unsigned& length, CaptureRecord& out)
+{
+	if (type == CAPTURE_TYPE_PCAP) {
+		const uint64_t seconds(read32(record));
+		const uint64_t fraction(read32(record + 4));
+
+		out.capturedLength = read32(record + 8);
+		out.originalLength = read32(record + 12);
+		if (out.capturedLength > length - PCAP_RECORD_HEADER_LENGTH)
+			return false;
+		out.timestamp = seconds * 1000000000 + toNanoseconds(fraction, unitsPerSecond);
+		out.linkType = linkType;
+		out.data = record + PCAP_RECORD_HEADER_LENGTH;
+		return true;
+	}
+
+	if (type != CAPTURE_TYPE_PCAPNG)
+		return false;
+
+	if (nativeWord(record) == PCAPNG_BLOCK_SECTION_HEADER) {
+		parseSectionHeader(record, length);
+		return false;
+	}
+
+	switch (read32(record)) {
+	case PCAPNG_BLOCK_INTERFACE_DESCRIPTION:
+		parseInterfaceDescription(record, length);
+		return false;
+	case PCAPNG_BLOCK_ENHANCED_PACKET:
+		return parseEnhancedPacket(record, length, out);
+	case PCAPNG_BLOCK_SIMPLE_PACKET:
+		return parseSimplePacket(record, length, out);
+	default:
+		return false;
+	}
+}
+
+void CaptureFormat::rawRecord(const char* bytes, const unsigned& length, CaptureRecord& out) const
+{
+	out.timestamp = 0;
+	out.capturedLength = length;
+	out.originalLength = length;
+	out.linkType = LINKTYPE_ETHERNET;
+	out.data = bytes;
+}
+
+/* PCAPNG BLOCKS */
+
+void CaptureFormat::parseSectionHeader(const char* block, const unsigned& length)
+{
+	// a truncated header still starts a new section, in the byte order it had before
+	if (length >= PCAPNG_SECTION_HEADER_LENGTH)
+		swapped = nativeWord(block + 8) != PCAPNG_BYTE_ORDER_MAGIC;
+	interfaces.clear();
+}
+
+void CaptureFormat::parseInterfaceDescription(const char* block, const unsigned& length)
+{
+	Interface interface;
+	interface.linkType = length >= 20 ? read16(block + 8) : 0;
+	interface.unitsPerSecond = 1000000;
+
+	// options sit between the fixed part and the trailing length
+	unsigned position(16);
+	while (position + 4 <= length - 4) {
+		const unsigned code(read16(block + position));
+		const unsigned optionLength(read16(block + position + 2));
+
+		if (code == PCAPNG_OPTION_END || position + 4 + optionLength > length - 4)
+			break;
+
+		if (code == PCAPNG_OPTION_IF_TSRESOL && optionLength >= 1) {
+			const uint8_t resolution(block[position + 4]);
+			const unsigned exponent(resolution & 0x7F);
+
+			if (resolution & 0x80) {
+				interface.unitsPerSecond = exponent < 64 ? uint64_t(1) << exponent : 0;
+			} else {
+				interface.unitsPerSecond = 1;
+				for (unsigned i(0); i < exponent && i < 19; i++)
+					interface.unitsPerSecond *= 10;
+			}
+		}
+
+		position += 4 + ((optionLength + 3) & ~3u);
+	}
+
+	interfaces.push_back(interface);
+}
+
+bool CaptureFormat::parseEnhancedPacket(const char* block, const unsigned& length, CaptureRecord& out) const
+{
+	if (length < 32)
+		return false;
+
+	const unsigned interfaceId(read32(block + 8));
+	if (interfaceId >= interfaces.size())
+		return false;
+
+	const uint64_t ticks((static_cast<uint64_t>(read32(block + 12)) << 32) | read32(block + 16));
+
+	out.capturedLength = read32(block + 20);
+	out.originalLength = read32(block + 24);
+	if (out.capturedLength > length - 32)
+		return false;
+
+	out.timestamp = toNanoseconds(ticks, interfaces[interfaceId].unitsPerSecond);
+	out.linkType = interfaces[interfaceId].linkType;
+	out.data = block + 28;
+	return true;
+}
+
+bool CaptureFormat::parseSimplePacket(const char* block, const unsigned& length, CaptureRecord& out) const
+{
+	if (length < 16 || interfaces.empty())
+		return false;
+
+	out.originalLength = read32(block + 8);
+	out.capturedLength = out.originalLength < length - 16 ? out.originalLength : length - 16;
+	out.timestamp = 0;
+	out.linkType = interfaces[0].linkType;
+	out.data = block + 12;
+	return true;
+}
+
+/* HELPERS */
+
+uint16_t CaptureFormat::read16(const char* bytes) const
+{
+	uint16_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return swapped ? __builtin_bswap16(value) : value;
+}
+
+uint32_t CaptureFormat::read32(const char* bytes) const
+{
+	const uint32_t value(nativeWord(bytes));
+	return swapped ? __builtin_bswap32(value) : value;
+}
+
+uint64_t CaptureFormat::toNanoseconds(const uint64_t& ticks, const uint64_t& units) const
+{
+	if (units == 0)
+		return 0;
+	if (units == 1000000000)
+		return ticks;
+
+	const unsigned __int128 fraction(static_cast<unsigned __int128>(ticks % units) * 1000000000 / units);
+	return ticks / units * 1000000000 + static_cast<uint64_t>(fraction);
+}
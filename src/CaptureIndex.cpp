@@ -0,0 +1,137 @@
+#include <CaptureIndex.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+using namespace std;
+
+CaptureIndex::CaptureIndex() : type(CAPTURE_TYPE_UNKNOWN), complete(false) {}
+
+/* BUILDING */
+
+bool CaptureIndex::build(const char* bytes, const uint64_t& length)
+{
+	CaptureFormat format;
+	CaptureRecord record;
+
+	entries.clear();
+	complete = false;
+
+	const unsigned detected(length < CAPTURE_DETECT_LENGTH ? length : CAPTURE_DETECT_LENGTH);
+	if (!format.detect(bytes, detected))
+		return false;
+	type = format.getType();
+
+	if (type == CAPTURE_TYPE_RAW) {
+		const uint64_t frameLength(length < CAPTURE_MAX_RECORD_LENGTH ? length : CAPTURE_MAX_RECORD_LENGTH);
+		entries.push_back({ 0, 0, static_cast<uint32_t>(frameLength), LINKTYPE_ETHERNET });
+		complete = true;
+		return true;
+	}
+
+	// one entry per ~100 octets is a good first guess for real traffic
+	entries.reserve(length / 128);
+
+	const unsigned headerLength(format.getRecordHeaderLength());
+	uint64_t position(format.getFileHeaderLength());
+
+	while (position + headerLength <= length) {
+		const unsigned recordLength(format.getRecordLength(bytes + position));
+		if (recordLength < headerLength || position + recordLength > length)
+			return true;
+
+		if (format.parseRecord(bytes + position, recordLength, record)) {
+			entries.push_back({
+				static_cast<uint64_t>(record.data - bytes),
+				record.timestamp,
+				record.capturedLength,
+				record.linkType
+			});
+		}
+		position += recordLength;
+	}
+
+	complete = position == length;
+	return true;
+}
+
+/* PERSISTENCE */
+
+bool CaptureIndex::load(const string& filename, const uint64_t& captureSize, const int64_t& captureModified)
+{
+	FILE* file(fopen(filename.c_str(), "rb"));
+	if (!file)
+		return false;
+
+	// the entry count must account for the whole file before anything is allocated for it
+	Header header;
+	struct stat status;
+	bool loaded(fstat(fileno(file), &status) == 0
+		&& fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, CAPTURE_INDEX_MAGIC, sizeof(header.magic)) == 0
+		&& header.captureSize == captureSize
+		&& header.captureModified == captureModified
+		&& (header.captureType == CAPTURE_TYPE_PCAP || header.captureType == CAPTURE_TYPE_PCAPNG)
+		&& header.entries <= (static_cast<uint64_t>(status.st_size) - sizeof(header)) / sizeof(CaptureIndexEntry)
+		&& static_cast<uint64_t>(status.st_size) == sizeof(header) + header.entries * sizeof(CaptureIndexEntry));
+
+	if (loaded) {
+		entries.resize(header.entries);
+		loaded = fread(entries.data(), sizeof(CaptureIndexEntry), entries.size(), file) == entries.size();
+	}
+	fclose(file);
+
+	// frames are handed out as pointers into the mapping, so none may reach past its end
+	for (uint64_t i(0); loaded && i < entries.size(); i++) {
+		loaded = entries[i].capturedLength <= CAPTURE_MAX_RECORD_LENGTH && entries[i].capturedLength <= captureSize
+			&& entries[i].offset <= captureSize - entries[i].capturedLength;
+	}
+
+	if (!loaded) {
+		entries.clear();
+		return false;
+	}
+
+	type = static_cast<CaptureType>(header.captureType);
+	complete = true;
+	return true;
+}
+
+bool CaptureIndex::save(const string& filename, const uint64_t& captureSize, const int64_t& captureModified) const
+{
+	// a partial index would hide frames appended later, so only complete ones persist;
+	// a raw frame has nothing worth indexing
+	if (!complete || type == CAPTURE_TYPE_RAW)
+		return false;
+
+	const string temporary(filename + ".tmp");
+	FILE* file(fopen(temporary.c_str(), "wb"));
+	if (!file)
+		return false;
+
+	Header header;
+	memcpy(header.magic, CAPTURE_INDEX_MAGIC, sizeof(header.magic));
+	header.captureSize = captureSize;
+	header.captureModified = captureModified;
+	header.captureType = type;
+	header.reserved = 0;
+	header.entries = entries.size();
+
+	bool saved(fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(entries.data(), sizeof(CaptureIndexEntry), entries.size(), file) == entries.size());
+	saved = fclose(file) == 0 && saved;
+
+	if (!saved || rename(temporary.c_str(), filename.c_str()) != 0) {
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+/* ACCESS */
+
+uint64_t CaptureIndex::size() const { return entries.size(); }
+const CaptureIndexEntry& CaptureIndex::operator[](const uint64_t& i) const { return entries[i]; }
+CaptureType CaptureIndex::getType() const { return type; }
+bool CaptureIndex::isComplete() const { return complete; }
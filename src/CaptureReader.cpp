@@ -0,0 +1,126 @@
+#include <CaptureReader.hpp>
+
+#include <cstdlib>
+
+using namespace std;
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+CaptureReader::CaptureReader(istream& in)
+	: input(in), buffer(nullptr), bufferLength(0), pending(0), ok(false), bytesRead(0), recordsRead(0)
+{
+	if (!reserve(CAPTURE_READER_INITIAL_BUFFER_LENGTH))
+		return;
+
+	input.read(buffer, CAPTURE_DETECT_LENGTH);
+	const unsigned detected(input.gcount());
+	bytesRead += detected;
+
+	ok = format.detect(buffer, detected);
+
+	// the pcap file header is not a record, everything else still is
+	pending = detected - format.getFileHeaderLength();
+}
+
+CaptureReader::~CaptureReader()
+{
+	free(buffer);
+}
+
+/* READING */
+
+bool CaptureReader::next(CaptureRecord& record)
+{
+	if (!ok)
+		return false;
+
+	if (format.getType() == CAPTURE_TYPE_RAW)
+		return nextRaw(record);
+
+	const unsigned headerLength(format.getRecordHeaderLength());
+
+	for (;;) {
+		if (pending < headerLength && !fill(pending, headerLength - pending))
+			return false;
+		if (pending < headerLength)
+			pending = headerLength;
+
+		const unsigned recordLength(format.getRecordLength(buffer));
+		if (recordLength < pending || !reserve(recordLength)) {
+			// framing is lost, nothing after this point can be trusted
+			ok = false;
+			return false;
+		}
+
+		if (!fill(pending, recordLength - pending)) {
+			ok = false;
+			return false;
+		}
+		pending = 0;
+
+		if (format.parseRecord(buffer, recordLength, record)) {
+			recordsRead++;
+			return true;
+		}
+	}
+}
+
+bool CaptureReader::nextRaw(CaptureRecord& record)
+{
+	if (recordsRead > 0)
+		return false;
+
+	unsigned length(pending);
+	while (input && length < CAPTURE_MAX_RECORD_LENGTH) {
+		if (length == bufferLength && !reserve(bufferLength * 2))
+			break;
+		input.read(buffer + length, bufferLength - length);
+		length += input.gcount();
+		bytesRead += input.gcount();
+	}
+	pending = 0;
+
+	if (length == 0)
+		return false;
+
+	format.rawRecord(buffer, length, record);
+	recordsRead++;
+	return true;
+}
+
+/* HELPERS */
+
+bool CaptureReader::reserve(const unsigned& length)
+{
+	if (length <= bufferLength)
+		return true;
+	if (length > CAPTURE_MAX_RECORD_LENGTH)
+		return false;
+
+	unsigned newLength(bufferLength ? bufferLength : CAPTURE_READER_INITIAL_BUFFER_LENGTH);
+	while (newLength < length)
+		newLength *= 2;
+
+	char* grown(static_cast<char*>(realloc(buffer, newLength)));
+	if (!grown)
+		return false;
+
+	buffer = grown;
+	bufferLength = newLength;
+	return true;
+}
+
+bool CaptureReader::fill(const unsigned& offset, const unsigned& length)
+{
+	if (length == 0)
+		return true;
+
+	input.read(buffer + offset, length);
+	bytesRead += input.gcount();
+	return static_cast<unsigned>(input.gcount()) == length;
+}
+
+bool CaptureReader::isOk() const { return ok; }
+const CaptureFormat& CaptureReader::getFormat() const { return format; }
+uint64_t CaptureReader::getBytesRead() const { return bytesRead; }
+uint64_t CaptureReader::getRecordsRead() const { return recordsRead; }
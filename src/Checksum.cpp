@@ -0,0 +1,222 @@
+#include <Checksum.hpp>
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHECKSUM_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+typedef uint16_t (*SumFunction)(const uint8_t*, const size_t&);
+
+// lanes are 32 bits wide and grow by at most 2 * 0xFFFF per iteration
+#define CHECKSUM_LANE_ITERATIONS 0x4000
+
+/* HELPERS */
+
+static uint16_t fold(uint64_t sum)
+{
+	while (sum >> 16)
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	return sum;
+}
+
+/*
+ * The kernels add words in host order; RFC 1071 allows that as long as the
+ * folded result is swapped back, and lets wide loads skip any shuffling.
+ */
+static uint16_t fromHostOrder(const uint64_t& sum)
+{
+	const uint16_t folded(fold(sum));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	return __builtin_bswap16(folded);
+#else
+	return folded;
+#endif
+}
+
+static uint64_t sumTail(const uint8_t* bytes, size_t length)
+{
+	uint64_t sum(0);
+
+	while (length >= 4) {
+		uint32_t word;
+		memcpy(&word, bytes, sizeof(word));
+		sum += word;
+		bytes += 4;
+		length -= 4;
+	}
+	if (length >= 2) {
+		uint16_t word;
+		memcpy(&word, bytes, sizeof(word));
+		sum += word;
+		bytes += 2;
+		length -= 2;
+	}
+	// a lone last octet is the high half of a zero padded network word
+	if (length) {
+		const uint8_t padded[2] = { bytes[0], 0 };
+		uint16_t word;
+		memcpy(&word, padded, sizeof(word));
+		sum += word;
+	}
+	return sum;
+}
+
+/* KERNELS */
+
+uint16_t Checksum::sumReference(const uint8_t* bytes, const size_t& length)
+{
+	uint64_t sum(0);
+	size_t i(0);
+
+	for (; i + 1 < length; i += 2)
+		sum += (bytes[i] << 8) | bytes[i + 1];
+	if (i < length)
+		sum += bytes[i] << 8;
+
+	return fold(sum);
+}
+
+uint16_t Checksum::sumScalar(const uint8_t* bytes, const size_t& length)
+{
+	uint64_t sum(0);
+	size_t i(0);
+
+	// four independent accumulators keep the adds from serializing
+	uint64_t a(0), b(0), c(0), d(0);
+	for (; i + 16 <= length; i += 16) {
+		uint32_t words[4];
+		memcpy(words, bytes + i, sizeof(words));
+		a += words[0];
+		b += words[1];
+		c += words[2];
+		d += words[3];
+	}
+	sum = a + b + c + d + sumTail(bytes + i, length - i);
+
+	return fromHostOrder(sum);
+}
+
+#ifdef CHECKSUM_X86
+
+__attribute__((target("sse2")))
+uint16_t Checksum::sumSse2(const uint8_t* bytes, const size_t& length)
+{
+	const __m128i zero(_mm_setzero_si128());
+	__m128i total(zero);
+	size_t i(0);
+
+	while (i + 16 <= length) {
+		__m128i lanes(zero);
+
+		for (unsigned n(0); n < CHECKSUM_LANE_ITERATIONS && i + 16 <= length; n++, i += 16) {
+			const __m128i words(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i)));
+			lanes = _mm_add_epi32(lanes, _mm_unpacklo_epi16(words, zero));
+			lanes = _mm_add_epi32(lanes, _mm_unpackhi_epi16(words, zero));
+		}
+
+		total = _mm_add_epi64(total, _mm_unpacklo_epi32(lanes, zero));
+		total = _mm_add_epi64(total, _mm_unpackhi_epi32(lanes, zero));
+	}
+
+	uint64_t halves[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(halves), total);
+
+	return fromHostOrder(halves[0] + halves[1] + sumTail(bytes + i, length - i));
+}
+
+__attribute__((target("avx2")))
+uint16_t Checksum::sumAvx2(const uint8_t* bytes, const size_t& length)
+{
+	const __m256i zero(_mm256_setzero_si256());
+	__m256i total(zero);
+	size_t i(0);
+
+	while (i + 64 <= length) {
+		__m256i lanes(zero);
+
+		// two loads per round give the adders two independent chains
+		for (unsigned n(0); n < CHECKSUM_LANE_ITERATIONS / 2 && i + 64 <= length; n++, i += 64) {
+			const __m256i first(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i)));
+			const __m256i second(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i + 32)));
+			lanes = _mm256_add_epi32(lanes, _mm256_unpacklo_epi16(first, zero));
+			lanes = _mm256_add_epi32(lanes, _mm256_unpackhi_epi16(first, zero));
+			lanes = _mm256_add_epi32(lanes, _mm256_unpacklo_epi16(second, zero));
+			lanes = _mm256_add_epi32(lanes, _mm256_unpackhi_epi16(second, zero));
+		}
+
+		total = _mm256_add_epi64(total, _mm256_unpacklo_epi32(lanes, zero));
+		total = _mm256_add_epi64(total, _mm256_unpackhi_epi32(lanes, zero));
+	}
+
+	uint64_t quarters[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(quarters), total);
+
+	return fromHostOrder(quarters[0] + quarters[1] + quarters[2] + quarters[3] + sumTail(bytes + i, length - i));
+}
+
+#else
+
+uint16_t Checksum::sumSse2(const uint8_t* bytes, const size_t& length) { return sumScalar(bytes, length); }
+uint16_t Checksum::sumAvx2(const uint8_t* bytes, const size_t& length) { return sumScalar(bytes, length); }
+
+#endif
+
+/* DISPATCH */
+
+static SumFunction chooseKernel(const char** name)
+{
+#ifdef CHECKSUM_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		*name = "avx2";
+		return Checksum::sumAvx2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		*name = "sse2";
+		return Checksum::sumSse2;
+	}
+#endif
+	*name = "scalar";
+	return Checksum::sumScalar;
+}
+
+static const char* kernelName;
+static const SumFunction kernel(chooseKernel(&kernelName));
+
+uint16_t Checksum::sum(const uint8_t* bytes, const size_t& length)
+{
+	// IPv4 and TCP headers are too short to repay the vector setup
+	if (length < 64)
+		return sumScalar(bytes, length);
+	return kernel(bytes, length);
+}
+
+const char* Checksum::getImplementation() { return kernelName; }
+
+/* COMBINING */
+
+uint16_t Checksum::add(const uint32_t& a, const uint32_t& b)
+{
+	return fold(static_cast<uint64_t>(a) + b);
+}
+
+uint16_t Checksum::pseudoHeader(const uint32_t& source, const uint32_t& destination, const unsigned& protocol, const unsigned& length)
+{
+	return fold(static_cast<uint64_t>(source >> 16) + (source & 0xFFFF)
+		+ (destination >> 16) + (destination & 0xFFFF) + protocol + length);
+}
+
+uint16_t Checksum::pseudoHeader(const uint8_t* addresses, const unsigned& protocol, const unsigned& length)
+{
+	// the upper-layer length is a 32-bit field here
+	return fold(static_cast<uint64_t>(sum(addresses, 32)) + (length >> 16) + (length & 0xFFFF) + protocol);
+}
+
+uint16_t Checksum::finish(const uint32_t& sum)
+{
+	return ~fold(sum) & 0xFFFF;
+}
@@ -0,0 +1,291 @@
+#include <ColumnFormat.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+static const char* columnNames[COLUMN_COUNT] = {
+	"ts", "len", "ethertype", "layers", "proto", "src", "dst", "sport", "dport", "ttl", "tos",
+	"ip_flags", "frag", "ip_len", "flags", "seq", "ack", "win", "payload"
+};
+
+// counters and clocks move in small steps, addresses and ports repeat, the rest is narrow
+static const ColumnEncoding columnEncodings[COLUMN_COUNT] = {
+	COLUMN_ENCODING_DELTA, COLUMN_ENCODING_BITPACKED, COLUMN_ENCODING_DICTIONARY, COLUMN_ENCODING_BITPACKED,
+	COLUMN_ENCODING_BITPACKED, COLUMN_ENCODING_DICTIONARY, COLUMN_ENCODING_DICTIONARY, COLUMN_ENCODING_DICTIONARY,
+	COLUMN_ENCODING_DICTIONARY, COLUMN_ENCODING_BITPACKED, COLUMN_ENCODING_BITPACKED, COLUMN_ENCODING_BITPACKED,
+	COLUMN_ENCODING_BITPACKED, COLUMN_ENCODING_BITPACKED, COLUMN_ENCODING_BITPACKED, COLUMN_ENCODING_DELTA,
+	COLUMN_ENCODING_DELTA, COLUMN_ENCODING_BITPACKED, COLUMN_ENCODING_BITPACKED
+};
+
+/* SCHEMA */
+
+const char* ColumnFormat::getName(const ColumnId& column)
+{
+	return column < COLUMN_COUNT ? columnNames[column] : "unknown";
+}
+
+bool ColumnFormat::parseName(const string& name, ColumnId& column)
+{
+	for (unsigned i(0); i < COLUMN_COUNT; i++) {
+		if (name == columnNames[i]) {
+			column = static_cast<ColumnId>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+ColumnEncoding ColumnFormat::getEncoding(const ColumnId& column)
+{
+	return columnEncodings[column];
+}
+
+const char* ColumnFormat::getEncodingAsString(const ColumnEncoding& encoding)
+{
+	switch (encoding) {
+	case COLUMN_ENCODING_DELTA:
+		return "delta";
+	case COLUMN_ENCODING_DICTIONARY:
+		return "dictionary";
+	case COLUMN_ENCODING_BITPACKED:
+		return "bit-packed";
+	default:
+		return "unknown";
+	}
+}
+
+uint64_t ColumnFormat::getValue(const PacketSummary& summary, const ColumnId& column)
+{
+	switch (column) {
+	case COLUMN_TIMESTAMP:
+		return summary.timestamp;
+	case COLUMN_FRAME_LENGTH:
+		return summary.frameLength;
+	case COLUMN_ETHERTYPE:
+		return summary.ethertype;
+	case COLUMN_LAYERS:
+		return summary.layers;
+	case COLUMN_PROTOCOL:
+		return summary.protocol;
+	case COLUMN_SOURCE_ADDRESS:
+		return summary.sourceAddress;
+	case COLUMN_DESTINATION_ADDRESS:
+		return summary.destinationAddress;
+	case COLUMN_SOURCE_PORT:
+		return summary.sourcePort;
+	case COLUMN_DESTINATION_PORT:
+		return summary.destinationPort;
+	case COLUMN_TTL:
+		return summary.ttl;
+	case COLUMN_SERVICE:
+		return summary.service;
+	case COLUMN_IP_FLAGS:
+		return summary.ipFlags;
+	case COLUMN_FRAGMENT_OFFSET:
+		return summary.fragmentOffset;
+	case COLUMN_IP_LENGTH:
+		return summary.ipTotalLength;
+	case COLUMN_TCP_FLAGS:
+		return summary.tcpFlags;
+	case COLUMN_SEQUENCE:
+		return summary.sequenceNumber;
+	case COLUMN_ACKNOWLEDGEMENT:
+		return summary.acknowledgementNumber;
+	case COLUMN_WINDOW:
+		return summary.window;
+	case COLUMN_PAYLOAD_LENGTH:
+		return summary.payloadLength;
+	default:
+		return 0;
+	}
+}
+
+/* ENCODING */
+
+void ColumnFormat::encode(const uint64_t* values, const size_t& count, const ColumnEncoding& preferred,
+	vector<uint8_t>& out, ColumnChunk& chunk)
+{
+	const size_t start(out.size());
+	uint64_t minimum(count ? values[0] : 0);
+	uint64_t maximum(minimum);
+	ColumnEncoding encoding(count ? preferred : COLUMN_ENCODING_BITPACKED);
+
+	for (size_t i(1); i < count; i++) {
+		minimum = values[i] < minimum ? values[i] : minimum;
+		maximum = values[i] > maximum ? values[i] : maximum;
+	}
+	chunk.minimum = minimum;
+	chunk.maximum = maximum;
+	chunk.width = 0;
+	chunk.reserved = 0;
+
+	if (encoding == COLUMN_ENCODING_DICTIONARY) {
+		vector<uint64_t> dictionary(values, values + count);
+		sort(dictionary.begin(), dictionary.end());
+		dictionary.erase(unique(dictionary.begin(), dictionary.end()), dictionary.end());
+
+		if (dictionary.size() * COLUMN_DICTIONARY_RATIO > count) {
+			encoding = COLUMN_ENCODING_BITPACKED;
+		} else {
+			// sorted, so the dictionary itself is delta encoded without signs
+			uint64_t previous(0);
+			putVarint(out, dictionary.size());
+			for (const uint64_t& value : dictionary) {
+				putVarint(out, value - previous);
+				previous = value;
+			}
+
+			vector<uint64_t> indices(count);
+			for (size_t i(0); i < count; i++)
+				indices[i] = lower_bound(dictionary.begin(), dictionary.end(), values[i]) - dictionary.begin();
+			chunk.width = bitWidth(dictionary.size() - 1);
+			pack(indices.data(), count, 0, chunk.width, out);
+		}
+	}
+
+	if (encoding == COLUMN_ENCODING_DELTA) {
+		uint64_t previous(minimum);
+		for (size_t i(0); i < count; i++) {
+			const int64_t delta(values[i] - previous);
+			putVarint(out, static_cast<uint64_t>(delta) << 1 ^ static_cast<uint64_t>(delta >> 63));
+			previous = values[i];
+		}
+	} else if (encoding == COLUMN_ENCODING_BITPACKED) {
+		chunk.width = bitWidth(maximum - minimum);
+		pack(values, count, minimum, chunk.width, out);
+	}
+
+	chunk.encoding = encoding;
+	chunk.length = out.size() - start;
+}
+
+bool ColumnFormat::decode(const uint8_t* bytes, const size_t& length, const ColumnChunk& chunk, const uint32_t& rows,
+	vector<uint64_t>& values)
+{
+	const uint8_t* at(bytes);
+	const uint8_t* end(bytes + length);
+
+	values.resize(rows);
+
+	switch (chunk.encoding) {
+	case COLUMN_ENCODING_DELTA: {
+		uint64_t previous(chunk.minimum);
+		uint64_t zigzag;
+		for (uint32_t i(0); i < rows; i++) {
+			if (!getVarint(at, end, zigzag))
+				return false;
+			previous += (zigzag >> 1) ^ (0 - (zigzag & 1));
+			values[i] = previous;
+		}
+		return true;
+	}
+	case COLUMN_ENCODING_DICTIONARY: {
+		uint64_t entries;
+		if (!getVarint(at, end, entries) || entries == 0 || entries > rows)
+			return false;
+
+		vector<uint64_t> dictionary(entries);
+		uint64_t previous(0);
+		for (uint64_t& value : dictionary) {
+			if (!getVarint(at, end, value))
+				return false;
+			value += previous;
+			previous = value;
+		}
+
+		if (!unpack(at, end - at, 0, chunk.width, rows, values.data()))
+			return false;
+		for (uint64_t& value : values) {
+			if (value >= entries)
+				return false;
+			value = dictionary[value];
+		}
+		return true;
+	}
+	case COLUMN_ENCODING_BITPACKED:
+		return unpack(bytes, length, chunk.minimum, chunk.width, rows, values.data());
+	default:
+		return false;
+	}
+}
+
+/* HELPERS */
+
+unsigned ColumnFormat::bitWidth(const uint64_t& value)
+{
+	return value ? 64 - __builtin_clzll(value) : 0;
+}
+
+void ColumnFormat::putVarint(vector<uint8_t>& out, uint64_t value)
+{
+	while (value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value) | 0x80);
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+bool ColumnFormat::getVarint(const uint8_t*& at, const uint8_t* end, uint64_t& value)
+{
+	value = 0;
+	for (unsigned shift(0); at < end && shift < 64; shift += 7) {
+		const uint8_t octet(*at++);
+		value |= static_cast<uint64_t>(octet & 0x7F) << shift;
+		if (!(octet & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// values go in least significant bit first, through little endian words
+void ColumnFormat::pack(const uint64_t* values, const size_t& count, const uint64_t& minimum, const unsigned& width,
+	vector<uint8_t>& out)
+{
+	uint64_t word(0);
+	unsigned used(0);
+	uint8_t bytes[sizeof(word)];
+
+	if (width == 0)
+		return;
+
+	for (size_t i(0); i < count; i++) {
+		const uint64_t value(values[i] - minimum);
+		word |= value << used;
+		used += width;
+		if (used >= 64) {
+			memcpy(bytes, &word, sizeof(word));
+			out.insert(out.end(), bytes, bytes + sizeof(bytes));
+			used -= 64;
+			// whatever did not fit in the word just written starts the next one
+			word = used ? value >> (width - used) : 0;
+		}
+	}
+
+	memcpy(bytes, &word, sizeof(word));
+	out.insert(out.end(), bytes, bytes + (used + 7) / 8);
+}
+
+bool ColumnFormat::unpack(const uint8_t* bytes, const size_t& length, const uint64_t& minimum, const unsigned& width,
+	const size_t& count, uint64_t* values)
+{
+	if (width > 64 || (static_cast<uint64_t>(count) * width + 7) / 8 > length)
+		return false;
+
+	const uint64_t mask(width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1);
+	uint64_t position(0);
+
+	for (size_t i(0); i < count; i++, position += width) {
+		const uint8_t* at(bytes + position / 8);
+		const unsigned shift(position % 8);
+		uint64_t word;
+
+		memcpy(&word, at, sizeof(word));
+		word >>= shift;
+		if (shift + width > 64)
+			word |= static_cast<uint64_t>(at[sizeof(word)]) << (64 - shift);
+		values[i] = minimum + (word & mask);
+	}
+	return true;
+}
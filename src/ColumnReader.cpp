@@ -0,0 +1,100 @@
+#include <ColumnReader.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+using namespace std;
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+ColumnReader::ColumnReader() : file(nullptr), fileLength(0), rows(0), bytesRead(0) {}
+
+ColumnReader::~ColumnReader()
+{
+	if (file)
+		fclose(file);
+}
+
+/* READING */
+
+bool ColumnReader::open(const string& filename)
+{
+	file = fopen(filename.c_str(), "rb");
+	if (!file)
+		return fail("Cannot open " + filename + ": " + strerror(errno));
+
+	ColumnFormat::Header header;
+	ColumnFormat::Trailer trailer;
+
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic))
+			|| header.columns != COLUMN_COUNT)
+		return fail(filename + " is not a column file");
+
+	// an unfinished file has no trailer, which is what tells it apart
+	if (fseek(file, 0, SEEK_END) != 0)
+		return fail("Cannot seek in " + filename);
+	fileLength = ftell(file);
+	if (fileLength < sizeof(header) + sizeof(trailer) || fseek(file, fileLength - sizeof(trailer), SEEK_SET) != 0
+			|| fread(&trailer, sizeof(trailer), 1, file) != 1 || memcmp(trailer.magic, COLUMN_FILE_MAGIC, sizeof(trailer.magic)))
+		return fail(filename + " was not closed properly");
+
+	const uint64_t footerLength(fileLength - sizeof(trailer) - trailer.footerOffset);
+	if (trailer.footerOffset > fileLength - sizeof(trailer) || footerLength != trailer.groups * sizeof(ColumnRowGroup))
+		return fail(filename + " has a damaged footer");
+
+	groups.resize(trailer.groups);
+	if (fseek(file, trailer.footerOffset, SEEK_SET) != 0
+			|| fread(groups.data(), sizeof(ColumnRowGroup), groups.size(), file) != groups.size())
+		return fail(filename + " has a damaged footer");
+
+	for (const ColumnRowGroup& group : groups) {
+		if (group.rows > header.rowGroupRows)
+			return fail(filename + " has a damaged footer");
+		for (const ColumnChunk& c : group.chunks) {
+			if (c.offset < sizeof(header) || c.offset + c.length > trailer.footerOffset)
+				return fail(filename + " has a chunk outside the file");
+		}
+	}
+
+	rows = trailer.rows;
+	bytesRead = sizeof(header) + sizeof(trailer) + footerLength;
+	return true;
+}
+
+bool ColumnReader::read(const unsigned& group, const ColumnId& column, vector<uint64_t>& values)
+{
+	if (group >= groups.size() || column >= COLUMN_COUNT)
+		return fail("No such row group or column");
+
+	const ColumnChunk& c(groups[group].chunks[column]);
+
+	chunk.resize(c.length + COLUMN_DECODE_PADDING);
+	memset(chunk.data() + c.length, 0, COLUMN_DECODE_PADDING);
+	if (fseek(file, c.offset, SEEK_SET) != 0 || (c.length && fread(chunk.data(), c.length, 1, file) != 1))
+		return fail(string("Reading column ") + ColumnFormat::getName(column) + " failed");
+	bytesRead += c.length;
+
+	if (!ColumnFormat::decode(chunk.data(), c.length, c, groups[group].rows, values))
+		return fail(string("Column ") + ColumnFormat::getName(column) + " of row group " + to_string(group) + " is damaged");
+	return true;
+}
+
+bool ColumnReader::mayContain(const unsigned& group, const ColumnId& column, const uint64_t& low, const uint64_t& high) const
+{
+	const ColumnChunk& c(groups[group].chunks[column]);
+	return c.minimum <= high && c.maximum >= low;
+}
+
+/* HELPERS */
+
+bool ColumnReader::fail(const string& message)
+{
+	error = message;
+	return false;
+}
+
+unsigned ColumnReader::getRowGroupCount() const { return groups.size(); }
+const ColumnRowGroup& ColumnReader::getRowGroup(const unsigned& i) const { return groups[i]; }
+uint64_t ColumnReader::getRows() const { return rows; }
+uint64_t ColumnReader::getBytesRead() const { return bytesRead; }
+const string& ColumnReader::getError() const { return error; }
@@ -0,0 +1,125 @@
+#include <ColumnWriter.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+using namespace std;
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+ColumnWriter::ColumnWriter() : file(nullptr), offset(0), rows(0) {}
+
+ColumnWriter::~ColumnWriter()
+{
+	// a file that was never closed has no footer and is of no use to anyone
+	if (file) {
+		fclose(file);
+		remove(filename.c_str());
+	}
+}
+
+/* WRITING */
+
+bool ColumnWriter::open(const string& name)
+{
+	filename = name;
+	file = fopen(filename.c_str(), "wb");
+	if (!file) {
+		error = "Cannot open " + filename + ": " + strerror(errno);
+		return false;
+	}
+
+	ColumnFormat::Header header;
+	memcpy(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic));
+	header.columns = COLUMN_COUNT;
+	header.rowGroupRows = COLUMN_ROW_GROUP_ROWS;
+
+	pending.reserve(COLUMN_ROW_GROUP_ROWS);
+	values.resize(COLUMN_ROW_GROUP_ROWS);
+	offset = 0;
+	rows = 0;
+	return writeBytes(&header, sizeof(header));
+}
+
+bool ColumnWriter::append(const PacketSummary* summaries, const size_t& count)
+{
+	for (size_t i(0); i < count; ) {
+		const size_t room(COLUMN_ROW_GROUP_ROWS - pending.size());
+		const size_t taken(count - i < room ? count - i : room);
+
+		pending.insert(pending.end(), summaries + i, summaries + i + taken);
+		i += taken;
+		if (pending.size() == COLUMN_ROW_GROUP_ROWS && !writeRowGroup())
+			return false;
+	}
+	return true;
+}
+
+bool ColumnWriter::close()
+{
+	if (!file)
+		return false;
+
+	bool written(pending.empty() || writeRowGroup());
+
+	ColumnFormat::Trailer trailer;
+	trailer.footerOffset = offset;
+	trailer.groups = groups.size();
+	trailer.rows = rows;
+	memcpy(trailer.magic, COLUMN_FILE_MAGIC, sizeof(trailer.magic));
+
+	written = written && writeBytes(groups.data(), groups.size() * sizeof(ColumnRowGroup))
+		&& writeBytes(&trailer, sizeof(trailer));
+	if (fclose(file) != 0 && written) {
+		error = "Writing " + filename + " failed: " + strerror(errno);
+		written = false;
+	}
+	file = nullptr;
+
+	if (!written)
+		remove(filename.c_str());
+	return written;
+}
+
+/* HELPERS */
+
+bool ColumnWriter::writeRowGroup()
+{
+	ColumnRowGroup group;
+
+	memset(&group, 0, sizeof(group));
+	group.firstRow = rows;
+	group.rows = pending.size();
+
+	for (unsigned c(0); c < COLUMN_COUNT; c++) {
+		const ColumnId column(static_cast<ColumnId>(c));
+
+		for (size_t i(0); i < pending.size(); i++)
+			values[i] = ColumnFormat::getValue(pending[i], column);
+
+		encoded.clear();
+		ColumnFormat::encode(values.data(), pending.size(), ColumnFormat::getEncoding(column), encoded, group.chunks[c]);
+		group.chunks[c].offset = offset;
+		if (!writeBytes(encoded.data(), encoded.size()))
+			return false;
+	}
+
+	groups.push_back(group);
+	rows += pending.size();
+	pending.clear();
+	return true;
+}
+
+bool ColumnWriter::writeBytes(const void* bytes, const size_t& length)
+{
+	if (length && fwrite(bytes, length, 1, file) != 1) {
+		error = "Writing " + filename + " failed: " + strerror(errno);
+		return false;
+	}
+	offset += length;
+	return true;
+}
+
+uint64_t ColumnWriter::getRows() const { return rows; }
+uint64_t ColumnWriter::getBytesWritten() const { return offset; }
+const string& ColumnWriter::getError() const { return error; }
@@ -0,0 +1,43 @@
+#include <CountMinSketch.hpp>
+
+#include <algorithm>
+
+using namespace std;
+
+CountMinSketch::CountMinSketch(const unsigned& w, const unsigned& d)
+	: width(1), depth(d ? d : 1), total(0)
+{
+	while (width < w)
+		width <<= 1;
+	counters.assign(static_cast<size_t>(width) * depth, 0);
+}
+
+uint64_t CountMinSketch::estimate(const uint64_t& hash) const
+{
+	const uint64_t* row(counters.data());
+	uint64_t smallest(UINT64_MAX);
+
+	for (unsigned i(0); i < depth; i++, row += width)
+		smallest = min(smallest, row[getColumn(hash, i)]);
+	return smallest;
+}
+
+bool CountMinSketch::merge(const CountMinSketch& other)
+{
+	if (other.width != width || other.depth != depth)
+		return false;
+	for (size_t i(0); i < counters.size(); i++)
+		counters[i] += other.counters[i];
+	total += other.total;
+	return true;
+}
+
+void CountMinSketch::clear()
+{
+	fill(counters.begin(), counters.end(), 0);
+	total = 0;
+}
+
+uint64_t CountMinSketch::getTotal() const { return total; }
+unsigned CountMinSketch::getWidth() const { return width; }
+unsigned CountMinSketch::getDepth() const { return depth; }
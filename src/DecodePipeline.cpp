@@ -0,0 +1,172 @@
+#include <DecodePipeline.hpp>
+#include <BoundedQueue.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+/*
+ * Where idle stages sleep. Every event bumps the epoch; a stage about to
+ * sleep reads the epoch, tries once more and sleeps only if no event came
+ * in between, so a wakeup cannot be lost. Events only take the lock while
+ * someone sleeps.
+ */
+class PipelineEvents {
+private:
+	mutex lock;
+	condition_variable wakeup;
+	atomic<uint64_t> epoch;
+	atomic<unsigned> sleepers;
+
+public:
+	PipelineEvents() : epoch(0), sleepers(0) {}
+
+	void notify()
+	{
+		epoch.fetch_add(1);
+		if (sleepers.load()) {
+			lock_guard<mutex> guard(lock);
+			wakeup.notify_all();
+		}
+	}
+
+	// returns once attempt() succeeds; it is retried after every event
+	template <typename Attempt>
+	void await(const Attempt& attempt)
+	{
+		for (unsigned tries(0); tries < PIPELINE_SPIN_TRIES; tries++) {
+			if (attempt())
+				return;
+			this_thread::yield();
+		}
+
+		for (;;) {
+			sleepers.fetch_add(1);
+			const uint64_t seen(epoch.load());
+			if (attempt()) {
+				sleepers.fetch_sub(1);
+				return;
+			}
+			{
+				unique_lock<mutex> guard(lock);
+				wakeup.wait(guard, [&]() { return epoch.load() != seen; });
+			}
+			sleepers.fetch_sub(1);
+		}
+	}
+};
+
+DecodePipeline::DecodePipeline(const unsigned& w) : workers(w ? w : 1), steals(0) {}
+
+unsigned DecodePipeline::getWorkers() const { return workers; }
+uint64_t DecodePipeline::getSteals() const { return steals.load(); }
+
+void DecodePipeline::run(const BatchSource& source, const BatchDecoder& decoder, const BatchSink& sink)
+{
+	const size_t capacity(workers * PIPELINE_BATCHES_PER_WORKER);
+
+	vector<unique_ptr<FrameBatch>> batches;
+	BoundedQueue<FrameBatch*> idle(capacity);
+	vector<unique_ptr<BoundedQueue<FrameBatch*>>> queues;
+	unique_ptr<atomic<FrameBatch*>[]> completed(new atomic<FrameBatch*>[capacity]);
+
+	for (size_t i(0); i < capacity; i++) {
+		batches.emplace_back(new FrameBatch());
+		idle.push(batches.back().get());
+		completed[i].store(nullptr);
+	}
+	for (unsigned i(0); i < workers; i++)
+		queues.emplace_back(new BoundedQueue<FrameBatch*>(capacity));
+
+	atomic<bool> readerDone(false);
+	atomic<uint64_t> totalBatches(0);
+	atomic<bool> stop(false);
+	PipelineEvents events;
+
+	// at most `capacity` batches exist, so the reader can never lap the writer
+	thread reader([&]() {
+		uint64_t sequence(0);
+		FrameBatch* batch;
+
+		for (;;) {
+			events.await([&]() { return idle.pop(batch); });
+
+			batch->records.clear();
+			batch->storage.clear();
+			batch->output.clear();
+			batch->summaries.clear();
+			batch->decoded = 0;
+			batch->skipped = 0;
+			batch->filtered = 0;
+
+			if (!source(*batch)) {
+				idle.push(batch);
+				break;
+			}
+
+			batch->sequence = sequence;
+			queues[sequence % workers]->push(batch);
+			events.notify();
+			sequence++;
+		}
+
+		totalBatches.store(sequence);
+		readerDone.store(true, memory_order_release);
+		events.notify();
+	});
+
+	vector<thread> decoders;
+	for (unsigned worker(0); worker < workers; worker++) {
+		decoders.emplace_back([&, worker]() {
+			FrameBatch* batch;
+			bool found(false);
+			const auto take([&]() {
+				found = queues[worker]->pop(batch);
+				for (unsigned victim(1); !found && victim < workers; victim++) {
+					found = queues[(worker + victim) % workers]->pop(batch);
+					if (found)
+						steals++;
+				}
+				return found || stop.load(memory_order_acquire);
+			});
+
+			for (;;) {
+				events.await(take);
+				if (!found)
+					break;
+
+				decoder(*batch, worker);
+				completed[batch->sequence % capacity].store(batch, memory_order_release);
+				events.notify();
+			}
+		});
+	}
+
+	// the calling thread is the ordered output stage
+	uint64_t next(0);
+	for (;;) {
+		FrameBatch* batch(nullptr);
+
+		events.await([&]() {
+			batch = completed[next % capacity].load(memory_order_acquire);
+			return batch || (readerDone.load(memory_order_acquire) && next == totalBatches.load());
+		});
+		if (!batch)
+			break;
+
+		completed[next % capacity].store(nullptr, memory_order_relaxed);
+		sink(*batch);
+		idle.push(batch);
+		events.notify();
+		next++;
+	}
+
+	stop.store(true, memory_order_release);
+	events.notify();
+	reader.join();
+	for (thread& t : decoders)
+		t.join();
+}
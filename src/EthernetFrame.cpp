@@ -1,11 +1,52 @@
 #include "EthernetFrame.hpp"
+#include "EthernetView.hpp"
+#include "Dissectors.hpp"
+#include "TextFormat.hpp"
 
-#include <iomanip>
-#include <sstream>
 #include <cstring>
 
 using namespace std;
 
+/* NETWORK DISSECTORS */
+
+// every layer here is built from (payload, length, arena)
+typedef DissectorRegistry<
+	Dissector<ETHERTYPE_IPV4, IpFrame>,
+	Dissector<ETHERTYPE_IPV6, Ipv6Frame>
+> NetworkDissectors;
+
+struct EthernetFrame::NetworkBuilder {
+	EthernetFrame& frame;
+	unsigned length;
+
+	template <typename Layer>
+	void visit()
+	{
+		if (length < Layer::MIN_LENGTH)
+			return;
+		frame.network = frame.arena
+			? static_cast<void*>(frame.arena->create<Layer>(frame.payload, length, frame.arena))
+			: static_cast<void*>(new Layer(frame.payload, length, frame.arena));
+	}
+};
+
+struct EthernetFrame::NetworkDeleter {
+	void* network;
+
+	template <typename Layer>
+	void visit()
+	{
+		delete static_cast<Layer*>(network);
+	}
+};
+
+// every field of a frame, in frame order; see init()
+#define ETHERNET_FRAME_FIELDS_LENGTH (ETH_STD_PREAMBLE_LENGTH + 2 * ETH_STD_ADDRESS_LENGTH + ETH_STD_ETHERTYPE_LENGTH \
+	+ ETH_STD_MAX_PAYLOAD_LENGTH + ETH_STD_MAX_FCS_LENGTH)
+
+// what a frame reads as when its fields could not be allocated: all zero, and never written
+static char emptyFields[ETHERNET_FRAME_FIELDS_LENGTH];
+
 /* CLASS CONSTANTS */
 const unsigned EthernetFrame::PREAMBLE_LENGTH = ETH_STD_PREAMBLE_LENGTH;
 const unsigned EthernetFrame::SFD_LENGTH = ETH_STD_SFD_LENGTH;
@@ -17,22 +58,48 @@ const unsigned EthernetFrame::MAX_FCS_LENGTH = ETH_STD_MAX_FCS_LENGTH;
 /* CONSTRUCTORS AND DESTRUCTORS */
 
 EthernetFrame::EthernetFrame()
+	: arena(nullptr)
 {
 	init();
 }
 
 EthernetFrame::EthernetFrame(istream& input)
+	: arena(nullptr)
 {
-	init();
+	if (!init())
+		return;
 
 	input.read(preamble, PREAMBLE_LENGTH);
 	input.read(destinationAddress, ADDRESS_LENGTH);
 	input.read(sourceAddress, ADDRESS_LENGTH);
 	input.read(type, ETHERTYPE_LENGTH);
+	while (vlanCount < ETH_STD_MAX_VLAN_TAGS && isVlanType(getEthertype()) && input) {
+		char tag[ETH_STD_VLAN_TAG_LENGTH];
+		input.read(tag, ETH_STD_VLAN_TAG_LENGTH);
+		vlanTags[vlanCount++] = static_cast<uint8_t>(tag[0]) * 0x100 + static_cast<uint8_t>(tag[1]);
+		setType(tag + 2);
+	}
 	setPayload(input);
 	input.read(frameCheckSequence, MAX_FCS_LENGTH);
 }
 
+EthernetFrame::EthernetFrame(const char* bytes, const unsigned& length, Arena* frameArena)
+	: arena(frameArena)
+{
+	const EthernetView view(bytes, length);
+
+	if (!init() || !view.isValid())
+		return;
+
+	setDestinationAddress(bytes);
+	setSourceAddress(bytes + ADDRESS_LENGTH);
+	setType(bytes + view.getHeaderLength() - ETHERTYPE_LENGTH);
+	for (vlanCount = 0; vlanCount < view.getVlanCount(); vlanCount++)
+		vlanTags[vlanCount] = view.getVlanTag(vlanCount);
+	// captures normally strip the FCS, so everything after the header is payload
+	setPayload(reinterpret_cast<const char*>(view.getPayload()), view.getPayloadLength());
+}
+
 EthernetFrame::~EthernetFrame()
 {
 	clean();
@@ -40,24 +107,55 @@ EthernetFrame::~EthernetFrame()
 
 /* INTIALIZATION AND CLEANING */
 
-void EthernetFrame::init()
+bool EthernetFrame::init()
 {
-	preamble = static_cast<char*>(malloc(PREAMBLE_LENGTH));
-	destinationAddress = static_cast<char*>(malloc(ADDRESS_LENGTH));
-	sourceAddress = static_cast<char*>(malloc(ADDRESS_LENGTH));
-	type = static_cast<char*>(malloc(ETHERTYPE_LENGTH));
-	payload = static_cast<char*>(malloc(MAX_PAYLOAD_LENGTH));
-	frameCheckSequence = static_cast<char*>(malloc(MAX_FCS_LENGTH));
+	const unsigned length(ETHERNET_FRAME_FIELDS_LENGTH);
+
+	network = nullptr;
+	networkType = 0;
+	vlanCount = 0;
+
+	// every field lives in one block, in frame order
+	preamble = static_cast<char*>(arena ? arena->allocate(length, 1) : malloc(length));
+	// out of memory the frame stays empty, as an invalid one does
+	if (!preamble)
+		preamble = emptyFields;
+	else
+		memset(preamble, 0, length);
+	destinationAddress = preamble + PREAMBLE_LENGTH;
+	sourceAddress = destinationAddress + ADDRESS_LENGTH;
+	type = sourceAddress + ADDRESS_LENGTH;
+	payload = type + ETHERTYPE_LENGTH;
+	frameCheckSequence = payload + MAX_PAYLOAD_LENGTH;
+	return preamble != emptyFields;
 }
 
 void EthernetFrame::clean()
 {
+	// arena memory goes all at once when the arena is reset
+	if (arena || preamble == emptyFields)
+		return;
+
 	free(preamble);
-	free(destinationAddress);
-	free(sourceAddress);
-	free(type);
-	free(payload);
-	free(frameCheckSequence);
+	releaseNetworkLayer();
+}
+
+void EthernetFrame::createNetworkLayer(const unsigned& length)
+{
+	NetworkBuilder builder{ *this, length };
+
+	releaseNetworkLayer();
+	networkType = getEthertype();
+	NetworkDissectors::dispatch(networkType, builder);
+}
+
+void EthernetFrame::releaseNetworkLayer()
+{
+	NetworkDeleter deleter{ network };
+
+	if (network && !arena)
+		NetworkDissectors::dispatch(networkType, deleter);
+	network = nullptr;
 }
 
 /* REGULAR GETTERS */
@@ -81,78 +179,132 @@ const string EthernetFrame::getSourceAddressAsString() const
 
 const string EthernetFrame::getEthertypeAsString() const
 {
-	stringstream ss;
-
-	unsigned ethType;
-	ethType = type[0] * 0x100;
-	ethType += type[1];
-
-	ss << setfill('0') << setw(4) << hex << ethType;
+	char text[TEXT_MAX_HEX_LENGTH];
+	return string(text, formatHex(text, getEthertype(), 4)) + " (" + getEthertypeName() + ")";
+}
 
-	switch (ethType) {
+const char* EthernetFrame::getEthertypeName() const
+{
+	switch (getEthertype()) {
 	case ETHERTYPE_IPV4:
-		ss << " (IPv4)";
-		break;
+		return "IPv4";
+	case ETHERTYPE_IPV6:
+		return "IPv6";
+	case ETHERTYPE_ARP:
+		return "ARP";
+	case ETHERTYPE_VLAN:
+		return "802.1Q";
+	case ETHERTYPE_QINQ:
+	case ETHERTYPE_QINQ_OLD:
+		return "802.1ad";
 	default:
-		ss << " (UNKNOWN)";
-		break;
+		return "UNKNOWN";
 	}
-	return ss.str();
 }
 
+unsigned EthernetFrame::getEthertype() const
+{
+	return static_cast<uint8_t>(type[0]) * 0x100 + static_cast<uint8_t>(type[1]);
+}
+
+unsigned EthernetFrame::getVlanCount() const { return vlanCount; }
+unsigned EthernetFrame::getVlanId(const unsigned& i) const { return vlanTags[i] & 0xFFF; }
+unsigned EthernetFrame::getVlanPriority(const unsigned& i) const { return vlanTags[i] >> 13; }
+
 /* REGULAR SETTERS */
-void EthernetFrame::setPreamble(const char* p) { memcpy(this->preamble, p, PREAMBLE_LENGTH); }
-void EthernetFrame::setDestinationAddress(const char* d) { memcpy(this->destinationAddress, d, ADDRESS_LENGTH); }
-void EthernetFrame::setSourceAddress(const char* s) { memcpy(this->sourceAddress, s, ADDRESS_LENGTH); }
-void EthernetFrame::setType(const char* t) { memcpy(this->type, t, ETHERTYPE_LENGTH); }
+// an empty frame shares its fields with every other one, so none of these may write them
 
-void EthernetFrame::setPayload(const char* p)
+void EthernetFrame::setPreamble(const char* p)
 {
-	memcpy(this->payload, p, getPayloadLength(p));
+	if (preamble != emptyFields)
+		memcpy(this->preamble, p, PREAMBLE_LENGTH);
 }
 
-void EthernetFrame::setFrameCheckSequence(const char* f) { memcpy(this->frameCheckSequence, f, MAX_FCS_LENGTH); }
+void EthernetFrame::setDestinationAddress(const char* d)
+{
+	if (preamble != emptyFields)
+		memcpy(this->destinationAddress, d, ADDRESS_LENGTH);
+}
 
-/* SETTERS FROM INPUT STREAM */
-void EthernetFrame::setPayload(istream& is)
+void EthernetFrame::setSourceAddress(const char* s)
+{
+	if (preamble != emptyFields)
+		memcpy(this->sourceAddress, s, ADDRESS_LENGTH);
+}
+
+void EthernetFrame::setType(const char* t)
 {
-	string p;
-	char payloadBuffer[MAX_PAYLOAD_LENGTH - 4];
+	if (preamble != emptyFields)
+		memcpy(this->type, t, ETHERTYPE_LENGTH);
+}
 
-	is.get(payloadBuffer, 5);
-	p.append(payloadBuffer, 4);
+void EthernetFrame::setPayload(const char* p)
+{
+	setPayload(p, getPayloadLength(p));
+}
 
-	unsigned length(getPayloadLength(p.c_str()));
+void EthernetFrame::setPayload(const char* p, const unsigned& length)
+{
+	const unsigned copied(length < MAX_PAYLOAD_LENGTH ? length : MAX_PAYLOAD_LENGTH);
 
-	is.get(payloadBuffer, length - 4);
+	if (preamble == emptyFields)
+		return;
+	memcpy(this->payload, p, copied);
+	createNetworkLayer(copied);
+}
 
-	p.append(payloadBuffer, length - 4);
+void EthernetFrame::setFrameCheckSequence(const char* f)
+{
+	if (preamble != emptyFields)
+		memcpy(this->frameCheckSequence, f, MAX_FCS_LENGTH);
+}
 
-	memcpy(this->payload, p.c_str(), length);
+/* SETTERS FROM INPUT STREAM */
+void EthernetFrame::setPayload(istream& is)
+{
+	if (preamble == emptyFields)
+		return;
+
+	// the IPv4 total length or IPv6 payload length sits in the first six octets, read straight into place
+	is.read(this->payload, 6);
+	unsigned length(is.gcount());
+
+	if (length == 6) {
+		unsigned announced(getPayloadLength(this->payload));
+		if (announced > MAX_PAYLOAD_LENGTH)
+			announced = MAX_PAYLOAD_LENGTH;
+		if (announced > length) {
+			is.read(this->payload + length, announced - length);
+			length += is.gcount();
+		}
+	}
 
-	ipFrame = new IpFrame(this->payload);
+	createNetworkLayer(length);
 }
 
 /* HELPERS */
 const string EthernetFrame::addressToString(const char* bytes) const
 {
-	// unsigned numBytes = sizeof(bytes);
-	stringstream resultStream;
-
-	for (unsigned i(0); i < ADDRESS_LENGTH; i++) {
-		resultStream << setfill('0') << setw(2) << hex << (unsigned int)static_cast<unsigned char>(bytes[i]);
-		if (i + 1 < ADDRESS_LENGTH)
-			resultStream << ":" ;
-	}
-
-	return resultStream.str();
+	char text[TEXT_MAC_LENGTH];
+	return string(text, formatMac(text, reinterpret_cast<const uint8_t*>(bytes)));
 }
 
 unsigned EthernetFrame::getPayloadLength(const char* p) const
 {
-	return static_cast<unsigned char>(p[2]) * 0xFF + static_cast<unsigned char>(p[3]);
+	if (getEthertype() == ETHERTYPE_IPV6)
+		return IPV6_STD_HEADER_LENGTH + static_cast<unsigned char>(p[4]) * 0x100 + static_cast<unsigned char>(p[5]);
+	return static_cast<unsigned char>(p[2]) * 0x100 + static_cast<unsigned char>(p[3]);
+}
+
+bool EthernetFrame::isVlanType(const unsigned& ethertype)
+{
+	return ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ || ethertype == ETHERTYPE_QINQ_OLD;
 }
 
 const IpFrame* EthernetFrame::getIpFrame() const {
-	return this->ipFrame;
+	return networkType == ETHERTYPE_IPV4 ? static_cast<const IpFrame*>(this->network) : nullptr;
+}
+
+const Ipv6Frame* EthernetFrame::getIpv6Frame() const {
+	return networkType == ETHERTYPE_IPV6 ? static_cast<const Ipv6Frame*>(this->network) : nullptr;
 }
\ No newline at end of file
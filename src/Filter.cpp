@@ -0,0 +1,535 @@
+#include <Filter.hpp>
+#include <ByteOrder.hpp>
+#include <EthernetView.hpp>
+#include <IpView.hpp>
+#include <Ipv6View.hpp>
+#include <TcpView.hpp>
+#include <UdpView.hpp>
+#include <IcmpView.hpp>
+#include <IpFrame.hpp>
+#include <EthernetFrame.hpp>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+typedef enum {
+	TOKEN_WORD,
+	TOKEN_NUMBER,
+	TOKEN_OPERATOR,
+	TOKEN_OPEN,
+	TOKEN_CLOSE,
+	TOKEN_END
+} TokenType;
+
+// bits of FilterFrame::layers
+typedef enum {
+	LAYER_ETHERNET = 0x01,
+	LAYER_IP = 0x02,
+	LAYER_TCP = 0x04,
+	LAYER_UDP = 0x08,
+	LAYER_ICMP = 0x10,
+	LAYER_IPV6 = 0x20,
+	LAYER_VLAN = 0x40
+} FilterLayer;
+
+struct FilterField {
+	const char* name;
+	uint8_t layer;
+	uint8_t offset;
+	// 0 only tests that the layer is there
+	uint8_t width;
+	uint32_t mask;
+};
+
+// offsets are from the start of the field's own layer
+static const FilterField fields[] = {
+	{ "eth", LAYER_ETHERNET, 0, 0, 0 },
+	{ "eth.type", LAYER_ETHERNET, 12, 2, 0xFFFF },
+	{ "vlan", LAYER_VLAN, 0, 0, 0 },
+	{ "vlan.id", LAYER_VLAN, 0, 2, 0x0FFF },
+	{ "vlan.pcp", LAYER_VLAN, 0, 1, 0xE0 },
+	{ "ip", LAYER_IP, 0, 0, 0 },
+	{ "ip.tos", LAYER_IP, 1, 1, 0xFF },
+	{ "ip.len", LAYER_IP, 2, 2, 0xFFFF },
+	{ "ip.id", LAYER_IP, 4, 2, 0xFFFF },
+	{ "ip.flags.df", LAYER_IP, 6, 1, 0x40 },
+	{ "ip.flags.mf", LAYER_IP, 6, 1, 0x20 },
+	{ "ip.frag", LAYER_IP, 6, 2, 0x1FFF },
+	{ "ip.ttl", LAYER_IP, 8, 1, 0xFF },
+	{ "ip.proto", LAYER_IP, 9, 1, 0xFF },
+	{ "ip.src", LAYER_IP, 12, 4, 0xFFFFFFFF },
+	{ "ip.dst", LAYER_IP, 16, 4, 0xFFFFFFFF },
+	{ "ip6", LAYER_IPV6, 0, 0, 0 },
+	{ "ip6.tclass", LAYER_IPV6, 0, 2, 0x0FF0 },
+	{ "ip6.flow", LAYER_IPV6, 0, 4, 0x000FFFFF },
+	{ "ip6.plen", LAYER_IPV6, 4, 2, 0xFFFF },
+	{ "ip6.nxt", LAYER_IPV6, 6, 1, 0xFF },
+	{ "ip6.hlim", LAYER_IPV6, 7, 1, 0xFF },
+	{ "tcp", LAYER_TCP, 0, 0, 0 },
+	{ "tcp.sport", LAYER_TCP, 0, 2, 0xFFFF },
+	{ "tcp.dport", LAYER_TCP, 2, 2, 0xFFFF },
+	{ "tcp.seq", LAYER_TCP, 4, 4, 0xFFFFFFFF },
+	{ "tcp.ack", LAYER_TCP, 8, 4, 0xFFFFFFFF },
+	{ "tcp.flags", LAYER_TCP, 13, 1, 0x3F },
+	{ "tcp.flags.fin", LAYER_TCP, 13, 1, 0x01 },
+	{ "tcp.flags.syn", LAYER_TCP, 13, 1, 0x02 },
+	{ "tcp.flags.rst", LAYER_TCP, 13, 1, 0x04 },
+	{ "tcp.flags.psh", LAYER_TCP, 13, 1, 0x08 },
+	{ "tcp.flags.ack", LAYER_TCP, 13, 1, 0x10 },
+	{ "tcp.flags.urg", LAYER_TCP, 13, 1, 0x20 },
+	{ "tcp.window", LAYER_TCP, 14, 2, 0xFFFF },
+	{ "udp", LAYER_UDP, 0, 0, 0 },
+	{ "udp.sport", LAYER_UDP, 0, 2, 0xFFFF },
+	{ "udp.dport", LAYER_UDP, 2, 2, 0xFFFF },
+	{ "udp.len", LAYER_UDP, 4, 2, 0xFFFF },
+	{ "icmp", LAYER_ICMP, 0, 0, 0 },
+	{ "icmp.type", LAYER_ICMP, 0, 1, 0xFF },
+	{ "icmp.code", LAYER_ICMP, 1, 1, 0xFF },
+};
+
+// either-direction names expand to a test on each of two fields
+struct FilterAlias {
+	const char* name;
+	const char* first;
+	const char* second;
+};
+
+static const FilterAlias aliases[] = {
+	{ "ip.addr", "ip.src", "ip.dst" },
+	{ "tcp.port", "tcp.sport", "tcp.dport" },
+	{ "udp.port", "udp.sport", "udp.dport" },
+};
+
+static const unsigned fieldCount(sizeof(fields) / sizeof(fields[0]));
+static const unsigned aliasCount(sizeof(aliases) / sizeof(aliases[0]));
+
+static int findField(const string& name)
+{
+	for (unsigned i(0); i < fieldCount; i++)
+		if (name == fields[i].name)
+			return i;
+	return -1;
+}
+
+/* EVALUATION */
+
+struct FilterFrame {
+	const uint8_t* bytes;
+	unsigned base[7];
+	unsigned layers;
+};
+
+static unsigned layerIndex(const unsigned& layer)
+{
+	return __builtin_ctz(layer);
+}
+
+static void locateLayers(const uint8_t* bytes, const unsigned& length, FilterFrame& frame)
+{
+	const EthernetView ethernet(bytes, length);
+	unsigned protocol, transport, end;
+
+	frame.bytes = bytes;
+	frame.layers = 0;
+
+	if (!ethernet.isValid())
+		return;
+	frame.layers |= LAYER_ETHERNET;
+	frame.base[layerIndex(LAYER_ETHERNET)] = 0;
+
+	// vlan fields read the outer tag
+	if (ethernet.getVlanCount()) {
+		frame.layers |= LAYER_VLAN;
+		frame.base[layerIndex(LAYER_VLAN)] = 14;
+	}
+
+	const unsigned ip(ethernet.getHeaderLength());
+
+	if (ethernet.getType() == ETHERTYPE_IPV6) {
+		const Ipv6View ip6(bytes + ip, length - ip);
+		unsigned fragment;
+
+		if (!ip6.isValid())
+			return;
+		frame.layers |= LAYER_IPV6;
+		frame.base[layerIndex(LAYER_IPV6)] = ip;
+
+		if (!ip6.walkExtensionHeaders(protocol, transport, fragment) || (fragment & 0xFFF8))
+			return;
+		transport += ip;
+		end = ip + ip6.getCapturedLength();
+	} else if (ethernet.getType() == ETHERTYPE_IPV4) {
+		const IpView ip4(bytes + ip, length - ip);
+
+		if (!ip4.isValid())
+			return;
+		frame.layers |= LAYER_IP;
+		frame.base[layerIndex(LAYER_IP)] = ip;
+
+		// only the first fragment carries a transport header
+		if (ip4.getOffset())
+			return;
+
+		protocol = ip4.getProtocol();
+		transport = ip + ip4.getHeaderLength();
+		end = ip + ip4.getCapturedLength();
+	} else {
+		return;
+	}
+
+	// the datagram ends where its length field says, ethernet padding is not transport
+	const unsigned available(end > transport ? end - transport : 0);
+
+	switch (protocol) {
+	case IP_PROTOCOL_TCP:
+		if (available >= TCP_VIEW_MIN_HEADER_LENGTH) {
+			frame.layers |= LAYER_TCP;
+			frame.base[layerIndex(LAYER_TCP)] = transport;
+		}
+		break;
+	case IP_PROTOCOL_UDP:
+		if (available >= UDP_VIEW_HEADER_LENGTH) {
+			frame.layers |= LAYER_UDP;
+			frame.base[layerIndex(LAYER_UDP)] = transport;
+		}
+		break;
+	case IP_PROTOCOL_ICMP:
+		if (available >= ICMP_VIEW_HEADER_LENGTH) {
+			frame.layers |= LAYER_ICMP;
+			frame.base[layerIndex(LAYER_ICMP)] = transport;
+		}
+		break;
+	}
+}
+
+static bool loadField(const FilterFrame& frame, const FilterField& field, uint32_t& value)
+{
+	if (!(frame.layers & field.layer))
+		return false;
+
+	const uint8_t* at(frame.bytes + frame.base[layerIndex(field.layer)] + field.offset);
+	switch (field.width) {
+	case 1:
+		value = at[0];
+		break;
+	case 2:
+		value = load16(at);
+		break;
+	case 4:
+		value = load32(at);
+		break;
+	default:
+		value = 0;
+		return true;
+	}
+
+	value = (value & field.mask) >> __builtin_ctz(field.mask);
+	return true;
+}
+
+Filter::Filter() : position(0), nesting(0) {}
+
+bool Filter::matches(const char* data, const unsigned& length) const
+{
+	if (program.empty())
+		return true;
+
+	FilterFrame frame;
+	bool stack[FILTER_MAX_STACK];
+	unsigned top(0);
+
+	locateLayers(reinterpret_cast<const uint8_t*>(data), length, frame);
+
+	for (const FilterInstruction& instruction : program) {
+		uint32_t value;
+
+		switch (instruction.opcode) {
+		case FILTER_AND:
+			top--;
+			stack[top - 1] = stack[top - 1] && stack[top];
+			continue;
+		case FILTER_OR:
+			top--;
+			stack[top - 1] = stack[top - 1] || stack[top];
+			continue;
+		case FILTER_NOT:
+			stack[top - 1] = !stack[top - 1];
+			continue;
+		}
+
+		if (!loadField(frame, fields[instruction.field], value)) {
+			stack[top++] = false;
+			continue;
+		}
+
+		value &= instruction.mask;
+		switch (instruction.opcode) {
+		case FILTER_EQUAL:
+			stack[top++] = value == instruction.value;
+			break;
+		case FILTER_NOT_EQUAL:
+			stack[top++] = value != instruction.value;
+			break;
+		case FILTER_LESS:
+			stack[top++] = value < instruction.value;
+			break;
+		case FILTER_LESS_EQUAL:
+			stack[top++] = value <= instruction.value;
+			break;
+		case FILTER_GREATER:
+			stack[top++] = value > instruction.value;
+			break;
+		default:
+			stack[top++] = value >= instruction.value;
+			break;
+		}
+	}
+
+	return stack[0];
+}
+
+/* COMPILATION */
+
+bool Filter::compile(const string& expression)
+{
+	program.clear();
+	error.clear();
+	position = 0;
+	nesting = 0;
+
+	if (!tokenize(expression))
+		return false;
+	if (tokens.size() == 1)
+		return true;
+
+	if (!parseOr())
+		return false;
+	if (tokens[position].type != TOKEN_END)
+		return fail("Unexpected '" + tokens[position].text + "'");
+
+	// postfix depth: tests push, binary operators pop one
+	int depth(0), deepest(0);
+	for (const FilterInstruction& instruction : program) {
+		if (instruction.opcode == FILTER_AND || instruction.opcode == FILTER_OR)
+			depth--;
+		else if (instruction.opcode != FILTER_NOT)
+			depth++;
+		deepest = depth > deepest ? depth : deepest;
+	}
+	if (deepest > FILTER_MAX_STACK)
+		return fail("Expression is nested too deeply");
+
+	return true;
+}
+
+bool Filter::tokenize(const string& expression)
+{
+	tokens.clear();
+	size_t i(0);
+
+	while (i < expression.size()) {
+		const char c(expression[i]);
+		Token token;
+
+		if (isspace(c)) {
+			i++;
+			continue;
+		}
+
+		if (c == '(' || c == ')') {
+			token.type = c == '(' ? TOKEN_OPEN : TOKEN_CLOSE;
+			token.text = string(1, c);
+			i++;
+		} else if (isalpha(c) || c == '_') {
+			const size_t start(i);
+			while (i < expression.size() && (isalnum(expression[i]) || expression[i] == '.' || expression[i] == '_'))
+				i++;
+			token.type = TOKEN_WORD;
+			token.text = expression.substr(start, i - start);
+		} else if (isdigit(c)) {
+			const size_t start(i);
+			while (i < expression.size() && (isxdigit(expression[i]) || strchr("xX./", expression[i])))
+				i++;
+			token.type = TOKEN_NUMBER;
+			token.text = expression.substr(start, i - start);
+		} else if (strchr("=!<>&|", c)) {
+			const size_t start(i);
+			while (i < expression.size() && strchr("=!<>&|", expression[i]) && i - start < 2)
+				i++;
+			token.type = TOKEN_OPERATOR;
+			token.text = expression.substr(start, i - start);
+		} else {
+			return fail(string("Unexpected character '") + c + "'");
+		}
+
+		tokens.push_back(token);
+	}
+
+	tokens.push_back({ TOKEN_END, "end of expression" });
+	return true;
+}
+
+bool Filter::parseOr()
+{
+	if (!parseAnd())
+		return false;
+
+	while (accept(TOKEN_WORD, "or") || accept(TOKEN_OPERATOR, "||")) {
+		if (!parseAnd())
+			return false;
+		emit(FILTER_OR);
+	}
+	return true;
+}
+
+bool Filter::parseAnd()
+{
+	if (!parseNot())
+		return false;
+
+	while (accept(TOKEN_WORD, "and") || accept(TOKEN_OPERATOR, "&&")) {
+		if (!parseNot())
+			return false;
+		emit(FILTER_AND);
+	}
+	return true;
+}
+
+bool Filter::parseNot()
+{
+	if (accept(TOKEN_WORD, "not") || accept(TOKEN_OPERATOR, "!")) {
+		if (!enter() || !parseNot())
+			return false;
+		nesting--;
+		emit(FILTER_NOT);
+		return true;
+	}
+	return parsePrimary();
+}
+
+bool Filter::parsePrimary()
+{
+	if (accept(TOKEN_OPEN)) {
+		if (!enter() || !parseOr())
+			return false;
+		if (!accept(TOKEN_CLOSE))
+			return fail("Missing ')'");
+		nesting--;
+		return true;
+	}
+
+	if (tokens[position].type != TOKEN_WORD)
+		return fail("Expected a field, got '" + tokens[position].text + "'");
+
+	const string name(tokens[position++].text);
+	int first(findField(name)), second(-1);
+
+	for (unsigned i(0); first < 0 && i < aliasCount; i++) {
+		if (name == aliases[i].name) {
+			first = findField(aliases[i].first);
+			second = findField(aliases[i].second);
+		}
+	}
+	if (first < 0)
+		return fail("Unknown field: " + name);
+
+	static const char* operators[] = { "==", "!=", "<", "<=", ">", ">=" };
+	uint8_t opcode(FILTER_NOT_EQUAL);
+	uint32_t value(0);
+	uint32_t mask(0xFFFFFFFF);
+	bool compared(false);
+
+	for (uint8_t i(0); i < 6 && !compared; i++) {
+		if (accept(TOKEN_OPERATOR, operators[i])) {
+			opcode = FILTER_EQUAL + i;
+			compared = true;
+		}
+	}
+
+	if (compared && !parseValue(value, mask))
+		return false;
+	// a bare field is true when present and non-zero, a bare layer when present
+	if (!compared && fields[first].width == 0)
+		opcode = FILTER_EQUAL;
+
+	emit(opcode, first, mask, value);
+	if (second >= 0) {
+		emit(opcode, second, mask, value);
+		// either side may match, but neither may differ
+		emit(opcode == FILTER_NOT_EQUAL ? FILTER_AND : FILTER_OR);
+	}
+	return true;
+}
+
+bool Filter::parseValue(uint32_t& value, uint32_t& mask)
+{
+	if (tokens[position].type != TOKEN_NUMBER)
+		return fail("Expected a value, got '" + tokens[position].text + "'");
+
+	const string text(tokens[position++].text);
+	const size_t slash(text.find('/'));
+	const string number(text.substr(0, slash));
+
+	if (number.find('.') != string::npos) {
+		unsigned octets[4];
+		char trailing;
+		if (sscanf(number.c_str(), "%u.%u.%u.%u%c", &octets[0], &octets[1], &octets[2], &octets[3], &trailing) != 4
+				|| octets[0] > 255 || octets[1] > 255 || octets[2] > 255 || octets[3] > 255)
+			return fail("Bad address: " + text);
+		value = octets[0] << 24 | octets[1] << 16 | octets[2] << 8 | octets[3];
+	} else {
+		char* end;
+		const unsigned long parsed(strtoul(number.c_str(), &end, 0));
+		if (*end != '\0' || parsed > 0xFFFFFFFF)
+			return fail("Bad number: " + text);
+		value = parsed;
+	}
+
+	if (slash != string::npos) {
+		char* end;
+		const unsigned long prefix(strtoul(text.c_str() + slash + 1, &end, 10));
+		if (*end != '\0' || prefix > 32 || end == text.c_str() + slash + 1)
+			return fail("Bad prefix length: " + text);
+		mask = prefix == 0 ? 0 : 0xFFFFFFFF << (32 - prefix);
+		value &= mask;
+	}
+	return true;
+}
+
+/* HELPERS */
+
+bool Filter::accept(const int& type, const char* text)
+{
+	if (tokens[position].type != type || (text && tokens[position].text != text))
+		return false;
+	position++;
+	return true;
+}
+
+// the parser recurses once per level, so a hostile expression must not overflow the stack
+bool Filter::enter()
+{
+	if (++nesting > FILTER_MAX_NESTING)
+		return fail("Expression is nested too deeply");
+	return true;
+}
+
+bool Filter::fail(const string& message)
+{
+	error = message;
+	program.clear();
+	return false;
+}
+
+void Filter::emit(const uint8_t& opcode, const uint8_t& field, const uint32_t& mask, const uint32_t& value)
+{
+	program.push_back({ opcode, field, mask, value });
+}
+
+bool Filter::isEmpty() const { return program.empty(); }
+size_t Filter::getLength() const { return program.size(); }
+const string& Filter::getError() const { return error; }
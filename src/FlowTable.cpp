@@ -0,0 +1,349 @@
+#include <FlowTable.hpp>
+#include <IpFrame.hpp>
+#include <TcpFrame.hpp>
+
+#include <cstdlib>
+
+using namespace std;
+
+static uint64_t mix(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33;
+	x *= 0xC4CEB9FE1A85EC53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+FlowTable::FlowTable(const unsigned& capacity, const uint64_t& timeout)
+	: flows(nullptr), slots(nullptr), maxFlows(capacity ? capacity : 1), mask(0), used(0), freeFlows(FLOW_NONE),
+	oldest(FLOW_NONE), newest(FLOW_NONE), idleTimeout(timeout), nextSweep(0), created(0), expired(0), evicted(0)
+{
+	// at most two thirds full keeps linear probes short, and never full, or a probe for a new key would not end
+	uint64_t slotCount(1);
+	while (slotCount <= static_cast<uint64_t>(maxFlows) + maxFlows / 2)
+		slotCount *= 2;
+	mask = slotCount - 1;
+
+	// zeroed pages are only backed by memory once a flow touches them
+	flows = static_cast<Flow*>(calloc(maxFlows, sizeof(Flow)));
+	slots = static_cast<Slot*>(calloc(slotCount, sizeof(Slot)));
+}
+
+FlowTable::~FlowTable()
+{
+	free(flows);
+	free(slots);
+}
+
+bool FlowTable::isOk() const
+{
+	return flows && slots;
+}
+
+/* TRACKING */
+
+const Flow* FlowTable::update(const PacketSummary& packet)
+{
+	// flows are keyed on IPv4 addresses, the summary holds none for IPv6
+	if (!(packet.layers & PACKET_LAYER_IPV4) || !(packet.layers & (PACKET_LAYER_TCP | PACKET_LAYER_UDP))
+			|| (packet.layers & PACKET_LAYER_FRAGMENT))
+		return nullptr;
+
+	return update(packet.sourceAddress, packet.destinationAddress, packet.sourcePort, packet.destinationPort,
+		packet.protocol, packet.tcpFlags, packet.ipTotalLength, packet.timestamp);
+}
+
+const Flow* FlowTable::update(const uint32_t& source, const uint32_t& destination, const uint16_t& sourcePort,
+	const uint16_t& destinationPort, const uint8_t& protocol, const uint8_t& tcpFlags, const unsigned& length,
+	const uint64_t& timestamp)
+{
+	if (!isOk())
+		return nullptr;
+
+	if (timestamp >= nextSweep) {
+		expire(timestamp);
+		nextSweep = timestamp + FLOW_TABLE_SWEEP_INTERVAL;
+	}
+
+	const uint32_t hash(hashKey(source, destination, sourcePort, destinationPort, protocol));
+	const bool opening(protocol == IP_PROTOCOL_TCP && (tcpFlags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) == TCP_FLAG_SYN);
+
+	for (uint32_t slot(hash & mask); slots[slot].flow; slot = (slot + 1) & mask) {
+		if (slots[slot].hash != hash)
+			continue;
+
+		const uint32_t index(slots[slot].flow - 1);
+		Flow& flow(flows[index]);
+		const int side(direction(flow, source, destination, sourcePort, destinationPort, protocol));
+		if (side < 0)
+			continue;
+
+		// a fresh SYN on a finished connection is a new connection reusing the ports
+		if (opening && (flow.state == FLOW_STATE_CLOSED || flow.state == FLOW_STATE_RESET)) {
+			release(index);
+			break;
+		}
+
+		flow.packets[side]++;
+		flow.bytes[side] += length;
+		flow.lastSeen = timestamp > flow.lastSeen ? timestamp : flow.lastSeen;
+		advance(flow, side, tcpFlags);
+
+		unlink(index);
+		append(index);
+		return &flow;
+	}
+
+	const uint32_t index(allocate());
+	Flow& flow(flows[index]);
+
+	flow.addressA = source;
+	flow.addressB = destination;
+	flow.portA = sourcePort;
+	flow.portB = destinationPort;
+	flow.protocol = protocol;
+	flow.state = FLOW_STATE_UNTRACKED;
+	flow.flags[0] = flow.flags[1] = 0;
+	flow.firstSeen = flow.lastSeen = timestamp;
+	flow.bytes[0] = length;
+	flow.bytes[1] = 0;
+	flow.packets[0] = 1;
+	flow.packets[1] = 0;
+	if (opening)
+		flow.state = FLOW_STATE_SYN_SENT;
+	advance(flow, 0, tcpFlags);
+
+	// evictions may have shifted slots around, so look for the free one now
+	uint32_t slot(hash & mask);
+	while (slots[slot].flow)
+		slot = (slot + 1) & mask;
+	slots[slot].hash = hash;
+	slots[slot].flow = index + 1;
+
+	append(index);
+	used++;
+	created++;
+	return &flow;
+}
+
+const Flow* FlowTable::find(const uint32_t& source, const uint32_t& destination, const uint16_t& sourcePort,
+	const uint16_t& destinationPort, const uint8_t& protocol) const
+{
+	if (!isOk())
+		return nullptr;
+
+	const uint32_t hash(hashKey(source, destination, sourcePort, destinationPort, protocol));
+
+	for (uint32_t slot(hash & mask); slots[slot].flow; slot = (slot + 1) & mask) {
+		const Flow& flow(flows[slots[slot].flow - 1]);
+		if (slots[slot].hash == hash && direction(flow, source, destination, sourcePort, destinationPort, protocol) >= 0)
+			return &flow;
+	}
+	return nullptr;
+}
+
+void FlowTable::advance(Flow& flow, const int& side, const uint8_t& tcpFlags)
+{
+	if (flow.protocol != IP_PROTOCOL_TCP)
+		return;
+
+	flow.flags[side] |= tcpFlags;
+
+	if (tcpFlags & TCP_FLAG_RST) {
+		flow.state = FLOW_STATE_RESET;
+		return;
+	}
+
+	switch (flow.state) {
+	case FLOW_STATE_SYN_SENT:
+		if (side == 1 && (tcpFlags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) == (TCP_FLAG_SYN | TCP_FLAG_ACK))
+			flow.state = FLOW_STATE_SYN_RECEIVED;
+		break;
+	case FLOW_STATE_SYN_RECEIVED:
+		if (side == 0 && (tcpFlags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) == TCP_FLAG_ACK)
+			flow.state = FLOW_STATE_ESTABLISHED;
+		break;
+	default:
+		break;
+	}
+
+	if (flow.state != FLOW_STATE_RESET && (flow.flags[0] | flow.flags[1]) & TCP_FLAG_FIN)
+		flow.state = (flow.flags[0] & flow.flags[1] & TCP_FLAG_FIN) ? FLOW_STATE_CLOSED : FLOW_STATE_CLOSING;
+}
+
+/* EVICTION */
+
+unsigned FlowTable::expire(const uint64_t& now)
+{
+	unsigned count(0);
+
+	// the list is in order of last activity, so the first live flow ends the sweep
+	while (oldest != FLOW_NONE && flows[oldest].lastSeen + idleTimeout <= now) {
+		release(oldest);
+		expired++;
+		count++;
+	}
+	return count;
+}
+
+void FlowTable::flush()
+{
+	while (oldest != FLOW_NONE)
+		release(oldest);
+}
+
+uint32_t FlowTable::allocate()
+{
+	if (freeFlows != FLOW_NONE) {
+		const uint32_t index(freeFlows);
+		freeFlows = flows[index].newer;
+		return index;
+	}
+
+	if (used < maxFlows)
+		return used;
+
+	// the pool is full: the least recently active flow goes
+	const uint32_t index(oldest);
+	release(index);
+	evicted++;
+	freeFlows = flows[index].newer;
+	return index;
+}
+
+void FlowTable::release(uint32_t index)
+{
+	const Flow& flow(flows[index]);
+
+	if (onEvict)
+		onEvict(flow);
+
+	const uint32_t hash(hashKey(flow.addressA, flow.addressB, flow.portA, flow.portB, flow.protocol));
+	uint32_t slot(hash & mask);
+	while (slots[slot].flow != index + 1)
+		slot = (slot + 1) & mask;
+	removeSlot(slot);
+
+	unlink(index);
+	flows[index].newer = freeFlows;
+	freeFlows = index;
+	used--;
+}
+
+void FlowTable::removeSlot(uint32_t hole)
+{
+	// pull back every later entry of the run that may legally sit in the hole
+	for (uint32_t next((hole + 1) & mask); slots[next].flow; next = (next + 1) & mask) {
+		const uint32_t home(slots[next].hash & mask);
+		if (((next - home) & mask) >= ((next - hole) & mask)) {
+			slots[hole] = slots[next];
+			hole = next;
+		}
+	}
+	slots[hole].flow = 0;
+}
+
+/* IDLE LIST */
+
+void FlowTable::unlink(const uint32_t& index)
+{
+	Flow& flow(flows[index]);
+
+	if (flow.older != FLOW_NONE)
+		flows[flow.older].newer = flow.newer;
+	else
+		oldest = flow.newer;
+
+	if (flow.newer != FLOW_NONE)
+		flows[flow.newer].older = flow.older;
+	else
+		newest = flow.older;
+}
+
+void FlowTable::append(const uint32_t& index)
+{
+	Flow& flow(flows[index]);
+
+	flow.newer = FLOW_NONE;
+	flow.older = newest;
+	if (newest != FLOW_NONE)
+		flows[newest].newer = index;
+	else
+		oldest = index;
+	newest = index;
+}
+
+/* HELPERS */
+
+uint32_t FlowTable::hashKey(const uint32_t& source, const uint32_t& destination, const uint16_t& sourcePort,
+	const uint16_t& destinationPort, const uint8_t& protocol) const
+{
+	// both directions of a connection must land on the same hash
+	const uint64_t a(static_cast<uint64_t>(source) << 16 | sourcePort);
+	const uint64_t b(static_cast<uint64_t>(destination) << 16 | destinationPort);
+	const uint64_t low(a < b ? a : b);
+	const uint64_t high(a < b ? b : a);
+
+	return static_cast<uint32_t>(mix(mix(low ^ static_cast<uint64_t>(protocol) << 48) ^ high));
+}
+
+int FlowTable::direction(const Flow& flow, const uint32_t& source, const uint32_t& destination,
+	const uint16_t& sourcePort, const uint16_t& destinationPort, const uint8_t& protocol) const
+{
+	if (flow.protocol != protocol)
+		return -1;
+	if (flow.addressA == source && flow.addressB == destination && flow.portA == sourcePort
+			&& flow.portB == destinationPort)
+		return 0;
+	if (flow.addressA == destination && flow.addressB == source && flow.portA == destinationPort
+			&& flow.portB == sourcePort)
+		return 1;
+	return -1;
+}
+
+void FlowTable::setEvictionCallback(const FlowCallback& callback) { onEvict = callback; }
+
+uint32_t FlowTable::getIndex(const Flow& flow) const
+{
+	return &flow - flows;
+}
+
+int FlowTable::getSide(const Flow& flow, const uint32_t& source, const uint16_t& sourcePort)
+{
+	return flow.addressA == source && flow.portA == sourcePort ? 0 : 1;
+}
+
+unsigned FlowTable::size() const { return used; }
+unsigned FlowTable::getCapacity() const { return maxFlows; }
+uint64_t FlowTable::getCreated() const { return created; }
+uint64_t FlowTable::getExpired() const { return expired; }
+uint64_t FlowTable::getEvicted() const { return evicted; }
+
+uint64_t FlowTable::getMemoryUsage() const
+{
+	return static_cast<uint64_t>(maxFlows) * sizeof(Flow) + (static_cast<uint64_t>(mask) + 1) * sizeof(Slot);
+}
+
+const char* FlowTable::getStateAsString(const uint8_t& state)
+{
+	switch (state) {
+	case FLOW_STATE_SYN_SENT:
+		return "SYN sent";
+	case FLOW_STATE_SYN_RECEIVED:
+		return "SYN received";
+	case FLOW_STATE_ESTABLISHED:
+		return "Established";
+	case FLOW_STATE_CLOSING:
+		return "Closing";
+	case FLOW_STATE_CLOSED:
+		return "Closed";
+	case FLOW_STATE_RESET:
+		return "Reset";
+	default:
+		return "Untracked";
+	}
+}
@@ -0,0 +1,330 @@
+#include <FragmentReassembler.hpp>
+#include <IpView.hpp>
+#include <Checksum.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+FragmentReassembler::FragmentReassembler(const unsigned& maxDatagrams)
+	: datagrams(nullptr), buffers(nullptr), buckets(nullptr), bucketMask(0), capacity(maxDatagrams ? maxDatagrams : 1),
+	freeDatagrams(FRAGMENT_NONE), active(0), currentTick(0), ticking(false), completed(FRAGMENT_NONE), datagram(nullptr),
+	datagramLength(0), datagramFragments(0), reassembled(0), timedOut(0), evicted(0), malformed(0)
+{
+	uint32_t bucketCount(1);
+	while (bucketCount < capacity * 2)
+		bucketCount *= 2;
+	bucketMask = bucketCount - 1;
+
+	datagrams = static_cast<Datagram*>(calloc(capacity, sizeof(Datagram)));
+	buffers = static_cast<uint8_t*>(malloc(static_cast<size_t>(capacity) * FRAGMENT_BUFFER_LENGTH));
+	buckets = static_cast<uint32_t*>(malloc(bucketCount * sizeof(uint32_t)));
+	if (!isOk())
+		return;
+
+	for (uint32_t i(0); i < bucketCount; i++)
+		buckets[i] = FRAGMENT_NONE;
+	for (unsigned i(0); i < FRAGMENT_WHEEL_SLOTS; i++)
+		wheel[i] = FRAGMENT_NONE;
+	for (uint32_t i(capacity); i > 0; i--) {
+		datagrams[i - 1].chain = freeDatagrams;
+		freeDatagrams = i - 1;
+	}
+}
+
+FragmentReassembler::~FragmentReassembler()
+{
+	free(datagrams);
+	free(buffers);
+	free(buckets);
+}
+
+bool FragmentReassembler::isOk() const
+{
+	return datagrams && buffers && buckets;
+}
+
+bool FragmentReassembler::isFragment(const char* bytes, const unsigned& length)
+{
+	const IpView ip(bytes, length);
+	return ip.isValid() && (ip.getMf() || ip.getOffset());
+}
+
+/* REASSEMBLY */
+
+bool FragmentReassembler::add(const char* bytes, const unsigned& length, const uint64_t& timestamp)
+{
+	if (!isOk())
+		return false;
+
+	if (completed != FRAGMENT_NONE) {
+		release(completed);
+		completed = FRAGMENT_NONE;
+	}
+	advance(timestamp);
+
+	const IpView ip(bytes, length);
+	if (!ip.isValid() || !(ip.getMf() || ip.getOffset()))
+		return false;
+
+	const uint32_t first(ip.getOffset() * 8);
+	const uint32_t payloadLength(ip.getTotalLength() > ip.getHeaderLength() ? ip.getTotalLength() - ip.getHeaderLength() : 0);
+	const uint32_t last(first + payloadLength - 1);
+
+	// snapped fragments cannot be put back together, and only the last may end off an 8 octet boundary
+	if (payloadLength == 0 || ip.getCapturedLength() < ip.getTotalLength() || (ip.getMf() && payloadLength % 8)
+			|| last >= FRAGMENT_BUFFER_LENGTH - FRAGMENT_HEADER_ROOM) {
+		malformed++;
+		return false;
+	}
+
+	uint32_t index(find(ip.getSourceAddress(), ip.getDestinationAddress(), ip.getId(), ip.getProtocol()));
+	if (index == FRAGMENT_NONE)
+		index = create(ip.getSourceAddress(), ip.getDestinationAddress(), ip.getId(), ip.getProtocol(), timestamp);
+
+	Datagram& entry(datagrams[index]);
+	uint8_t* buffer(buffers + static_cast<size_t>(index) * FRAGMENT_BUFFER_LENGTH);
+	entry.fragments++;
+
+	if (!ip.getMf()) {
+		// the last fragment fixes the length; a second, different one makes no sense
+		if ((entry.length && entry.length != last + 1) || !fill(entry, buffer, first, last, ip.getPayload())) {
+			malformed++;
+			release(index);
+			return false;
+		}
+		entry.length = last + 1;
+
+		unsigned kept(0);
+		for (unsigned i(0); i < entry.holeCount; i++) {
+			if (entry.holes[i].first > last)
+				continue;
+			entry.holes[kept] = entry.holes[i];
+			entry.holes[kept].last = entry.holes[kept].last < last ? entry.holes[kept].last : last;
+			kept++;
+		}
+		entry.holeCount = kept;
+	} else if ((entry.length && last >= entry.length) || !fill(entry, buffer, first, last, ip.getPayload())) {
+		malformed++;
+		release(index);
+		return false;
+	}
+
+	if (first == 0) {
+		entry.headerLength = ip.getHeaderLength();
+		memcpy(buffer + FRAGMENT_HEADER_ROOM - entry.headerLength, bytes, entry.headerLength);
+	}
+
+	if (entry.holeCount || !entry.length || !entry.headerLength)
+		return false;
+
+	if (entry.headerLength + entry.length > 65535) {
+		malformed++;
+		release(index);
+		return false;
+	}
+
+	finish(entry, buffer);
+	completed = index;
+	reassembled++;
+	return true;
+}
+
+bool FragmentReassembler::fill(Datagram& entry, uint8_t* buffer, const uint32_t& first, const uint32_t& last,
+	const uint8_t* payload)
+{
+	Hole holes[FRAGMENT_MAX_HOLES + 1];
+	unsigned count(0);
+
+	// a fragment can split at most one hole in two, the others only shrink or go
+	for (unsigned i(0); i < entry.holeCount; i++) {
+		const Hole hole(entry.holes[i]);
+
+		if (hole.last < first || hole.first > last) {
+			holes[count++] = hole;
+			continue;
+		}
+
+		const uint32_t from(hole.first > first ? hole.first : first);
+		const uint32_t to(hole.last < last ? hole.last : last);
+		memcpy(buffer + FRAGMENT_HEADER_ROOM + from, payload + (from - first), to - from + 1);
+
+		if (hole.first < first)
+			holes[count++] = { hole.first, first - 1 };
+		if (hole.last > last)
+			holes[count++] = { last + 1, hole.last };
+		if (count > FRAGMENT_MAX_HOLES)
+			return false;
+	}
+
+	memcpy(entry.holes, holes, count * sizeof(Hole));
+	entry.holeCount = count;
+	return true;
+}
+
+void FragmentReassembler::finish(Datagram& entry, uint8_t* buffer)
+{
+	uint8_t* header(buffer + FRAGMENT_HEADER_ROOM - entry.headerLength);
+	const unsigned totalLength(entry.headerLength + entry.length);
+
+	// one whole datagram now: keep DF, clear MF and the offset, and make the checksum match
+	header[2] = totalLength >> 8;
+	header[3] = totalLength & 0xFF;
+	header[6] &= 0x40;
+	header[7] = 0;
+	header[10] = header[11] = 0;
+	const uint16_t sum(Checksum::finish(Checksum::sum(header, entry.headerLength)));
+	header[10] = sum >> 8;
+	header[11] = sum & 0xFF;
+
+	datagram = reinterpret_cast<const char*>(header);
+	datagramLength = totalLength;
+	datagramFragments = entry.fragments;
+}
+
+/* TABLE */
+
+uint32_t FragmentReassembler::hashKey(const uint32_t& source, const uint32_t& destination, const uint16_t& id,
+	const uint8_t& protocol) const
+{
+	uint64_t x((static_cast<uint64_t>(source) << 32 | destination) ^ (static_cast<uint64_t>(id) << 8 | protocol) * 0x9E3779B97F4A7C15ULL);
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33;
+	return static_cast<uint32_t>(x) & bucketMask;
+}
+
+uint32_t FragmentReassembler::find(const uint32_t& source, const uint32_t& destination, const uint16_t& id,
+	const uint8_t& protocol) const
+{
+	for (uint32_t i(buckets[hashKey(source, destination, id, protocol)]); i != FRAGMENT_NONE; i = datagrams[i].chain) {
+		const Datagram& entry(datagrams[i]);
+		if (entry.source == source && entry.destination == destination && entry.id == id && entry.protocol == protocol)
+			return i;
+	}
+	return FRAGMENT_NONE;
+}
+
+uint32_t FragmentReassembler::create(const uint32_t& source, const uint32_t& destination, const uint16_t& id,
+	const uint8_t& protocol, const uint64_t& timestamp)
+{
+	if (freeDatagrams == FRAGMENT_NONE) {
+		// every buffer is busy: the one due to time out first goes now
+		for (unsigned i(1); i <= FRAGMENT_WHEEL_SLOTS && freeDatagrams == FRAGMENT_NONE; i++) {
+			const unsigned slot((currentTick + i) % FRAGMENT_WHEEL_SLOTS);
+			if (wheel[slot] != FRAGMENT_NONE) {
+				release(wheel[slot]);
+				evicted++;
+			}
+		}
+	}
+
+	const uint32_t index(freeDatagrams);
+	Datagram& entry(datagrams[index]);
+	freeDatagrams = entry.chain;
+
+	entry.source = source;
+	entry.destination = destination;
+	entry.id = id;
+	entry.protocol = protocol;
+	entry.headerLength = 0;
+	entry.length = 0;
+	entry.holeCount = 1;
+	entry.holes[0] = { 0, FRAGMENT_BUFFER_LENGTH - FRAGMENT_HEADER_ROOM - 1 };
+	entry.fragments = 0;
+
+	const uint32_t bucket(hashKey(source, destination, id, protocol));
+	entry.chain = buckets[bucket];
+	buckets[bucket] = index;
+
+	entry.deadline = (ticking ? currentTick : timestamp / FRAGMENT_WHEEL_TICK) + FRAGMENT_TIMEOUT / FRAGMENT_WHEEL_TICK;
+	const unsigned slot(entry.deadline % FRAGMENT_WHEEL_SLOTS);
+	entry.wheelPrevious = FRAGMENT_NONE;
+	entry.wheelNext = wheel[slot];
+	if (wheel[slot] != FRAGMENT_NONE)
+		datagrams[wheel[slot]].wheelPrevious = index;
+	wheel[slot] = index;
+
+	active++;
+	return index;
+}
+
+void FragmentReassembler::release(uint32_t index)
+{
+	Datagram& entry(datagrams[index]);
+
+	uint32_t* link(&buckets[hashKey(entry.source, entry.destination, entry.id, entry.protocol)]);
+	while (*link != index)
+		link = &datagrams[*link].chain;
+	*link = entry.chain;
+
+	if (entry.wheelPrevious != FRAGMENT_NONE)
+		datagrams[entry.wheelPrevious].wheelNext = entry.wheelNext;
+	else
+		wheel[entry.deadline % FRAGMENT_WHEEL_SLOTS] = entry.wheelNext;
+	if (entry.wheelNext != FRAGMENT_NONE)
+		datagrams[entry.wheelNext].wheelPrevious = entry.wheelPrevious;
+
+	entry.chain = freeDatagrams;
+	freeDatagrams = index;
+	active--;
+}
+
+/* TIMEOUTS */
+
+void FragmentReassembler::advance(const uint64_t& timestamp)
+{
+	const uint64_t now(timestamp / FRAGMENT_WHEEL_TICK);
+
+	if (!ticking) {
+		currentTick = now;
+		ticking = true;
+		return;
+	}
+
+	// a jump past a whole turn of the wheel expires everything on it
+	if (now > currentTick + FRAGMENT_WHEEL_SLOTS) {
+		for (unsigned slot(0); slot < FRAGMENT_WHEEL_SLOTS; slot++)
+			expireSlot(slot);
+		currentTick = now;
+		return;
+	}
+
+	while (currentTick < now) {
+		currentTick++;
+		expireSlot(currentTick % FRAGMENT_WHEEL_SLOTS);
+	}
+}
+
+void FragmentReassembler::expireSlot(const unsigned& slot)
+{
+	// with the timeout shorter than a turn, everything in the slot is due
+	while (wheel[slot] != FRAGMENT_NONE) {
+		release(wheel[slot]);
+		timedOut++;
+	}
+}
+
+/* ACCESSORS */
+
+const char* FragmentReassembler::getDatagram() const { return datagram; }
+unsigned FragmentReassembler::getDatagramLength() const { return datagramLength; }
+unsigned FragmentReassembler::getDatagramFragments() const { return datagramFragments; }
+
+unsigned FragmentReassembler::size() const
+{
+	// the datagram last handed out is finished, it just has not been let go yet
+	return active - (completed != FRAGMENT_NONE ? 1 : 0);
+}
+uint64_t FragmentReassembler::getReassembled() const { return reassembled; }
+uint64_t FragmentReassembler::getTimedOut() const { return timedOut; }
+uint64_t FragmentReassembler::getEvicted() const { return evicted; }
+uint64_t FragmentReassembler::getMalformed() const { return malformed; }
+
+uint64_t FragmentReassembler::getMemoryUsage() const
+{
+	return static_cast<uint64_t>(capacity) * (sizeof(Datagram) + FRAGMENT_BUFFER_LENGTH) + (bucketMask + 1) * sizeof(uint32_t);
+}
@@ -0,0 +1,260 @@
+#include <FrameBitmap.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// serialized as a count, then (key, reserved, cardinality) per container, then the payloads in the same order
+#define FRAME_BITMAP_COUNT_LENGTH	4
+#define FRAME_BITMAP_HEADER_LENGTH	8
+
+/* BUILDING */
+
+void FrameBitmap::add(const uint32_t& frame)
+{
+	const uint16_t key(frame >> 16);
+	const uint16_t low(frame & 0xFFFF);
+
+	if (containers.empty() || containers.back().key < key) {
+		containers.emplace_back();
+		containers.back().key = key;
+		containers.back().cardinality = 0;
+	}
+
+	Container* container(&containers.back());
+	if (container->key != key) {
+		auto at(lower_bound(containers.begin(), containers.end(), key,
+			[](const Container& c, const uint16_t& k) { return c.key < k; }));
+		if (at->key != key) {
+			at = containers.emplace(at);
+			at->key = key;
+			at->cardinality = 0;
+		}
+		container = &*at;
+	}
+
+	if (!container->words.empty()) {
+		uint64_t& word(container->words[low >> 6]);
+		const uint64_t bit(uint64_t(1) << (low & 63));
+		if (!(word & bit)) {
+			word |= bit;
+			container->cardinality++;
+		}
+		return;
+	}
+
+	vector<uint16_t>& values(container->values);
+	if (values.empty() || values.back() < low) {
+		values.push_back(low);
+	} else {
+		const auto at(lower_bound(values.begin(), values.end(), low));
+		if (*at == low)
+			return;
+		values.insert(at, low);
+	}
+	if (++container->cardinality > FRAME_BITMAP_ARRAY_LIMIT)
+		toWords(*container);
+}
+
+void FrameBitmap::intersect(const FrameBitmap& other)
+{
+	auto theirs(other.containers.begin());
+	size_t kept(0);
+
+	for (size_t i(0); i < containers.size(); i++) {
+		Container& ours(containers[i]);
+		while (theirs != other.containers.end() && theirs->key < ours.key)
+			theirs++;
+		if (theirs == other.containers.end() || theirs->key != ours.key)
+			continue;
+
+		intersect(ours, *theirs);
+		if (!ours.cardinality)
+			continue;
+		if (kept != i)
+			containers[kept] = move(ours);
+		kept++;
+	}
+	containers.resize(kept);
+}
+
+void FrameBitmap::clear()
+{
+	containers.clear();
+}
+
+/* ACCESS */
+
+uint64_t FrameBitmap::count() const
+{
+	uint64_t total(0);
+	for (const Container& container : containers)
+		total += container.cardinality;
+	return total;
+}
+
+bool FrameBitmap::empty() const
+{
+	return containers.empty();
+}
+
+void FrameBitmap::getFrames(vector<uint32_t>& frames) const
+{
+	frames.clear();
+	for (const Container& container : containers) {
+		const uint32_t high(static_cast<uint32_t>(container.key) << 16);
+
+		if (container.words.empty()) {
+			for (const uint16_t& low : container.values)
+				frames.push_back(high | low);
+			continue;
+		}
+		for (unsigned w(0); w < FRAME_BITMAP_WORDS; w++) {
+			for (uint64_t word(container.words[w]); word; word &= word - 1)
+				frames.push_back(high | w << 6 | __builtin_ctzll(word));
+		}
+	}
+}
+
+/* PERSISTENCE */
+
+size_t FrameBitmap::getSerializedLength() const
+{
+	size_t length(FRAME_BITMAP_COUNT_LENGTH);
+	for (const Container& container : containers) {
+		length += FRAME_BITMAP_HEADER_LENGTH;
+		length += container.words.empty() ? container.values.size() * sizeof(uint16_t) : FRAME_BITMAP_WORDS * sizeof(uint64_t);
+	}
+	return length;
+}
+
+void FrameBitmap::serialize(vector<uint8_t>& out) const
+{
+	const size_t start(out.size());
+	const uint32_t count(containers.size());
+	uint8_t* at;
+
+	out.resize(start + getSerializedLength());
+	at = out.data() + start;
+
+	memcpy(at, &count, sizeof(count));
+	at += FRAME_BITMAP_COUNT_LENGTH;
+	for (const Container& container : containers) {
+		const uint16_t reserved(0);
+		memcpy(at, &container.key, sizeof(container.key));
+		memcpy(at + 2, &reserved, sizeof(reserved));
+		memcpy(at + 4, &container.cardinality, sizeof(container.cardinality));
+		at += FRAME_BITMAP_HEADER_LENGTH;
+	}
+	for (const Container& container : containers) {
+		if (container.words.empty()) {
+			memcpy(at, container.values.data(), container.values.size() * sizeof(uint16_t));
+			at += container.values.size() * sizeof(uint16_t);
+		} else {
+			memcpy(at, container.words.data(), FRAME_BITMAP_WORDS * sizeof(uint64_t));
+			at += FRAME_BITMAP_WORDS * sizeof(uint64_t);
+		}
+	}
+}
+
+bool FrameBitmap::deserialize(const uint8_t* bytes, const size_t& length)
+{
+	uint32_t count;
+
+	containers.clear();
+	if (length < FRAME_BITMAP_COUNT_LENGTH)
+		return false;
+	memcpy(&count, bytes, sizeof(count));
+	if (count > 0x10000 || length < FRAME_BITMAP_COUNT_LENGTH + count * static_cast<size_t>(FRAME_BITMAP_HEADER_LENGTH))
+		return false;
+
+	const uint8_t* header(bytes + FRAME_BITMAP_COUNT_LENGTH);
+	const uint8_t* payload(header + count * FRAME_BITMAP_HEADER_LENGTH);
+	const uint8_t* end(bytes + length);
+
+	containers.resize(count);
+	for (Container& container : containers) {
+		memcpy(&container.key, header, sizeof(container.key));
+		memcpy(&container.cardinality, header + 4, sizeof(container.cardinality));
+		header += FRAME_BITMAP_HEADER_LENGTH;
+
+		if (container.cardinality == 0 || container.cardinality > 0x10000) {
+			containers.clear();
+			return false;
+		}
+
+		const bool dense(container.cardinality > FRAME_BITMAP_ARRAY_LIMIT);
+		const size_t payloadLength(dense ? FRAME_BITMAP_WORDS * sizeof(uint64_t) : container.cardinality * sizeof(uint16_t));
+		if (payloadLength > static_cast<size_t>(end - payload)) {
+			containers.clear();
+			return false;
+		}
+
+		if (dense) {
+			container.words.resize(FRAME_BITMAP_WORDS);
+			memcpy(container.words.data(), payload, payloadLength);
+		} else {
+			container.values.resize(container.cardinality);
+			memcpy(container.values.data(), payload, payloadLength);
+		}
+		payload += payloadLength;
+	}
+	return true;
+}
+
+/* CONTAINERS */
+
+void FrameBitmap::toWords(Container& container)
+{
+	container.words.assign(FRAME_BITMAP_WORDS, 0);
+	for (const uint16_t& low : container.values)
+		container.words[low >> 6] |= uint64_t(1) << (low & 63);
+	container.values.clear();
+	container.values.shrink_to_fit();
+}
+
+void FrameBitmap::toValues(Container& container)
+{
+	container.values.clear();
+	for (unsigned w(0); w < FRAME_BITMAP_WORDS; w++) {
+		for (uint64_t word(container.words[w]); word; word &= word - 1)
+			container.values.push_back(w << 6 | __builtin_ctzll(word));
+	}
+	container.words.clear();
+	container.words.shrink_to_fit();
+}
+
+void FrameBitmap::intersect(Container& ours, const Container& theirs)
+{
+	if (!ours.words.empty() && !theirs.words.empty()) {
+		uint32_t cardinality(0);
+		for (unsigned w(0); w < FRAME_BITMAP_WORDS; w++) {
+			ours.words[w] &= theirs.words[w];
+			cardinality += __builtin_popcountll(ours.words[w]);
+		}
+		ours.cardinality = cardinality;
+		if (cardinality <= FRAME_BITMAP_ARRAY_LIMIT)
+			toValues(ours);
+		return;
+	}
+
+	// at least one side is an array, so the result is one too
+	vector<uint16_t> values;
+	if (ours.words.empty() && theirs.words.empty()) {
+		set_intersection(ours.values.begin(), ours.values.end(), theirs.values.begin(), theirs.values.end(),
+			back_inserter(values));
+	} else {
+		const vector<uint16_t>& sparse(ours.words.empty() ? ours.values : theirs.values);
+		const vector<uint64_t>& dense(ours.words.empty() ? theirs.words : ours.words);
+		for (const uint16_t& low : sparse) {
+			if (dense[low >> 6] & uint64_t(1) << (low & 63))
+				values.push_back(low);
+		}
+	}
+
+	ours.values.swap(values);
+	ours.words.clear();
+	ours.words.shrink_to_fit();
+	ours.cardinality = ours.values.size();
+}
@@ -0,0 +1,174 @@
+#include <HeavyHitters.hpp>
+#include <IpFrame.hpp>
+#include <Ipv6View.hpp>
+#include <TextFormat.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// SketchKey::words[2] of an address key, and the top octet of words[4] of a flow key
+#define KEY_FAMILY_IPV4 4
+#define KEY_FAMILY_IPV6 6
+
+static const char* dimensionNames[HEAVY_HITTER_DIMENSIONS] = {
+	"sources", "destinations", "ports", "flows"
+};
+
+/* KEYS */
+
+static unsigned putAddress(char* at, const uint64_t* words, const unsigned& family)
+{
+	uint8_t address[IPV6_VIEW_ADDRESS_LENGTH];
+
+	if (family == KEY_FAMILY_IPV4)
+		return formatIpv4(at, words[0]);
+	memcpy(address, words, sizeof(address));
+	return formatIpv6(at, address);
+}
+
+// address:port, with the IPv6 address in brackets as in RFC 5952
+static char* putEndpoint(char* at, const uint64_t* words, const unsigned& family, const unsigned& port)
+{
+	if (family == KEY_FAMILY_IPV6)
+		*at++ = '[';
+	at += putAddress(at, words, family);
+	if (family == KEY_FAMILY_IPV6)
+		*at++ = ']';
+	*at++ = ':';
+	return at + formatDecimal(at, port);
+}
+
+static const char* getTransportName(const unsigned& protocol)
+{
+	return protocol == IP_PROTOCOL_TCP ? "TCP" : "UDP";
+}
+
+/* COUNTING */
+
+void HeavyHitters::Dimension::add(const SketchKey& key, const uint64_t& weight)
+{
+	const uint64_t hash(key.getHash());
+
+	top.add(key, hash, weight, frequencies.add(hash, weight));
+	distinct.add(hash);
+}
+
+void HeavyHitters::count(const PacketSummary& summary, const char* frame)
+{
+	if (!(summary.layers & (PACKET_LAYER_IPV4 | PACKET_LAYER_IPV6)))
+		return;
+
+	SketchKey source = {}, destination = {};
+	uint64_t family;
+
+	// words 0 and 1 hold the address, an IPv4 one in the low half of word 0
+	if (summary.layers & PACKET_LAYER_IPV4) {
+		family = KEY_FAMILY_IPV4;
+		source.words[0] = summary.sourceAddress;
+		destination.words[0] = summary.destinationAddress;
+	} else {
+		const Ipv6View ip(frame + summary.ipOffset, IPV6_VIEW_HEADER_LENGTH);
+		family = KEY_FAMILY_IPV6;
+		memcpy(source.words, ip.getSourceAddress(), IPV6_VIEW_ADDRESS_LENGTH);
+		memcpy(destination.words, ip.getDestinationAddress(), IPV6_VIEW_ADDRESS_LENGTH);
+	}
+	source.words[2] = family;
+	destination.words[2] = family;
+	dimensions[HEAVY_HITTER_SOURCES].add(source, summary.frameLength);
+	dimensions[HEAVY_HITTER_DESTINATIONS].add(destination, summary.frameLength);
+
+	if (!(summary.layers & (PACKET_LAYER_TCP | PACKET_LAYER_UDP)))
+		return;
+
+	SketchKey port = {}, flow = {};
+	port.words[0] = static_cast<uint64_t>(summary.protocol) << 16 | summary.sourcePort;
+	dimensions[HEAVY_HITTER_PORTS].add(port, summary.frameLength);
+	if (summary.destinationPort != summary.sourcePort) {
+		port.words[0] = static_cast<uint64_t>(summary.protocol) << 16 | summary.destinationPort;
+		dimensions[HEAVY_HITTER_PORTS].add(port, summary.frameLength);
+	}
+
+	flow.words[0] = source.words[0];
+	flow.words[1] = source.words[1];
+	flow.words[2] = destination.words[0];
+	flow.words[3] = destination.words[1];
+	flow.words[4] = family << 56 | static_cast<uint64_t>(summary.protocol) << 32
+		| static_cast<uint64_t>(summary.sourcePort) << 16 | summary.destinationPort;
+	dimensions[HEAVY_HITTER_FLOWS].add(flow, summary.frameLength);
+}
+
+bool HeavyHitters::merge(const HeavyHitters& other)
+{
+	for (unsigned d(0); d < HEAVY_HITTER_DIMENSIONS; d++) {
+		if (!dimensions[d].frequencies.merge(other.dimensions[d].frequencies)
+			|| !dimensions[d].distinct.merge(other.dimensions[d].distinct))
+			return false;
+		dimensions[d].top.merge(other.dimensions[d].top);
+	}
+	return true;
+}
+
+/* ACCESS */
+
+void HeavyHitters::getTop(const HeavyHitterDimension& dimension, const unsigned& count, vector<HeavyHitter>& top) const
+{
+	const Dimension& d(dimensions[dimension]);
+	vector<SpaceSavingEntry> entries;
+
+	top.clear();
+	d.top.getTop(count, entries);
+	for (const SpaceSavingEntry& entry : entries) {
+		// both overestimate, so the smaller is the better bound
+		top.push_back({entry.key, min(entry.count, d.frequencies.estimate(entry.hash)), entry.count - entry.error});
+	}
+	stable_sort(top.begin(), top.end(), [](const HeavyHitter& a, const HeavyHitter& b) { return a.estimate > b.estimate; });
+}
+
+double HeavyHitters::getDistinct(const HeavyHitterDimension& dimension) const
+{
+	return dimensions[dimension].distinct.estimate();
+}
+
+uint64_t HeavyHitters::getTotal(const HeavyHitterDimension& dimension) const
+{
+	return dimensions[dimension].frequencies.getTotal();
+}
+
+const char* HeavyHitters::getDimensionName(const HeavyHitterDimension& dimension)
+{
+	return dimension < HEAVY_HITTER_DIMENSIONS ? dimensionNames[dimension] : "unknown";
+}
+
+string HeavyHitters::keyToString(const HeavyHitterDimension& dimension, const SketchKey& key)
+{
+	// two bracketed IPv6 addresses, two ports and a protocol name, with room for the IPv4 encoder to scribble
+	char text[2 * TEXT_MAX_IPV6_LENGTH + 2 * TEXT_MAX_DECIMAL_LENGTH + 16];
+	char* at(text);
+
+	switch (dimension) {
+	case HEAVY_HITTER_SOURCES:
+	case HEAVY_HITTER_DESTINATIONS:
+		at += putAddress(at, key.words, key.words[2]);
+		break;
+	case HEAVY_HITTER_PORTS:
+		at += formatDecimal(at, key.words[0] & 0xFFFF);
+		*at++ = '/';
+		at += strlen(strcpy(at, getTransportName(key.words[0] >> 16)));
+		break;
+	case HEAVY_HITTER_FLOWS: {
+		const unsigned family(key.words[4] >> 56);
+		const unsigned protocol(key.words[4] >> 32 & 0xFF);
+		at += strlen(strcpy(at, getTransportName(protocol)));
+		*at++ = ' ';
+		at = putEndpoint(at, key.words, family, key.words[4] >> 16 & 0xFFFF);
+		at += strlen(strcpy(at, " > "));
+		at = putEndpoint(at, key.words + 2, family, key.words[4] & 0xFFFF);
+		break;
+	}
+	default:
+		break;
+	}
+	return string(text, at - text);
+}
@@ -0,0 +1,48 @@
+#include <HyperLogLog.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+HyperLogLog::HyperLogLog(const unsigned& p)
+	: precision(min(max(p, static_cast<unsigned>(HYPER_LOG_LOG_MIN_PRECISION)),
+		static_cast<unsigned>(HYPER_LOG_LOG_MAX_PRECISION)))
+{
+	registers.assign(size_t(1) << precision, 0);
+}
+
+double HyperLogLog::estimate() const
+{
+	const double m(registers.size());
+	const double alpha(0.7213 / (1 + 1.079 / m));
+	double sum(0);
+	unsigned zeros(0);
+
+	for (const uint8_t& reg : registers) {
+		sum += ldexp(1.0, -reg);
+		zeros += reg == 0;
+	}
+
+	const double raw(alpha * m * m / sum);
+	// 64-bit hashes do not collide often enough to need a large range correction
+	if (raw <= 2.5 * m && zeros)
+		return m * log(m / zeros);
+	return raw;
+}
+
+bool HyperLogLog::merge(const HyperLogLog& other)
+{
+	if (other.precision != precision)
+		return false;
+	for (size_t i(0); i < registers.size(); i++)
+		registers[i] = max(registers[i], other.registers[i]);
+	return true;
+}
+
+void HyperLogLog::clear()
+{
+	fill(registers.begin(), registers.end(), 0);
+}
+
+unsigned HyperLogLog::getPrecision() const { return precision; }
@@ -0,0 +1,103 @@
+#include <IcmpFrame.hpp>
+#include <IcmpView.hpp>
+#include <Checksum.hpp>
+
+using namespace std;
+
+void IcmpFrame::fromBytes(const char* frameBytes)
+{
+	const IcmpView view(frameBytes, ICMP_HEADER_LENGTH);
+
+	setType(view.getType());
+	setCode(view.getCode());
+	setCheckSum(view.getCheckSum());
+	setRestOfHeader(view.getRestOfHeader());
+	calculatedCheckSum = 0;
+	checkSumVerifiable = 0;
+}
+
+IcmpFrame::IcmpFrame(const char* frameBytes)
+{
+	fromBytes(frameBytes);
+}
+
+IcmpFrame::IcmpFrame(const char* message, const unsigned& length, const unsigned& pseudoHeader)
+	: IcmpFrame(message, length, pseudoHeader, length)
+{}
+
+IcmpFrame::IcmpFrame(const char* message, const unsigned& capturedLength, const unsigned&,
+	const unsigned& messageLength)
+{
+	fromBytes(message);
+	checkSumVerifiable = capturedLength >= messageLength;
+	if (checkSumVerifiable)
+		calculateCheckSum(message, messageLength);
+}
+
+IcmpFrame::~IcmpFrame() {}
+
+const char* IcmpFrame::getTypeAsString() const
+{
+	switch (getType()) {
+	case ICMP_TYPE_ECHO_REPLY:
+		return "Echo reply";
+	case ICMP_TYPE_DESTINATION_UNREACHABLE:
+		return "Destination unreachable";
+	case ICMP_TYPE_SOURCE_QUENCH:
+		return "Source quench";
+	case ICMP_TYPE_REDIRECT:
+		return "Redirect";
+	case ICMP_TYPE_ECHO_REQUEST:
+		return "Echo request";
+	case ICMP_TYPE_ROUTER_ADVERTISEMENT:
+		return "Router advertisement";
+	case ICMP_TYPE_ROUTER_SOLICITATION:
+		return "Router solicitation";
+	case ICMP_TYPE_TIME_EXCEEDED:
+		return "Time exceeded";
+	case ICMP_TYPE_PARAMETER_PROBLEM:
+		return "Parameter problem";
+	case ICMP_TYPE_TIMESTAMP:
+		return "Timestamp";
+	case ICMP_TYPE_TIMESTAMP_REPLY:
+		return "Timestamp reply";
+	default:
+		return "Unknown";
+	}
+}
+
+void IcmpFrame::setType(const unsigned& t) { type = t; };
+void IcmpFrame::setCode(const unsigned& c) { code = c; };
+void IcmpFrame::setCheckSum(const unsigned& c) { checkSum = c; };
+void IcmpFrame::setRestOfHeader(const unsigned& r) { restOfHeader = r; };
+
+unsigned IcmpFrame::getType() const { return type; }
+unsigned IcmpFrame::getCode() const { return code; }
+unsigned IcmpFrame::getCheckSum() const { return checkSum; }
+unsigned IcmpFrame::getRestOfHeader() const { return restOfHeader; }
+unsigned IcmpFrame::getIdentifier() const { return getRestOfHeader() >> 16; }
+unsigned IcmpFrame::getSequenceNumber() const { return getRestOfHeader() & 0xFFFF; }
+unsigned IcmpFrame::getCalculatedCheckSum() const { return calculatedCheckSum; }
+
+bool IcmpFrame::isEcho() const
+{
+	return getType() == ICMP_TYPE_ECHO_REQUEST || getType() == ICMP_TYPE_ECHO_REPLY
+		|| getType() == ICMP_TYPE_TIMESTAMP || getType() == ICMP_TYPE_TIMESTAMP_REPLY;
+}
+
+void IcmpFrame::calculateCheckSum(const char* message, const unsigned& length)
+{
+	// the checksum covers the whole message and nothing else
+	const uint16_t sum(Checksum::sum(reinterpret_cast<const uint8_t*>(message), length));
+	this->calculatedCheckSum = Checksum::finish(Checksum::add(sum, ~getCheckSum() & 0xFFFF));
+}
+
+bool IcmpFrame::checkSumIsVerifiable() const
+{
+	return checkSumVerifiable;
+}
+
+bool IcmpFrame::checkSumIsOk() const
+{
+	return checkSumVerifiable && getCheckSum() == getCalculatedCheckSum();
+}
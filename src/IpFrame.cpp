@@ -1,79 +1,161 @@
 #include <IpFrame.hpp>
-#include <sstream>
-#include <iomanip>
+#include <IpView.hpp>
+#include <Checksum.hpp>
+#include <Dissectors.hpp>
+#include <TextFormat.hpp>
+#include <cstring>
 
 using namespace std;
 
-void IpFrame::fromBytes(const char* frameBytes)
-{
-	setVersion(frameBytes[0] >> 4);
-	setIhl(frameBytes[0] & 0xF);
-	setService(frameBytes[1]);
-	setTotalLength(frameBytes[2] * 0xFF + frameBytes[3]);
-	setId(frameBytes[4] * 0x100 + frameBytes[5]);
-	setDf((frameBytes[6] >> 6) & 1);
-	setMf((frameBytes[6] >> 7) & 1);
-	setOffset((frameBytes[6] & 0b11111) * 0x10 + frameBytes[7]);
-	setTtl(frameBytes[8]);
-	setProtocol(frameBytes[9]);
-	setCheckSum(frameBytes[10] * 0x100 + static_cast<uint8_t>(frameBytes[11]));
-	setSourceAddress((frameBytes[12] << 24) + (frameBytes[13] << 16) + (frameBytes[14] << 8) + (frameBytes[15]));
-	setDestinationAddress((frameBytes[16] << 24) + (frameBytes[17] << 16) + (frameBytes[18] << 8) + (frameBytes[19]));
-	calculateCheckSum();
+/* TRANSPORT DISSECTORS */
+
+// every layer here is built from (payload, length, pseudo-header sum)
+typedef DissectorRegistry<
+	Dissector<IP_PROTOCOL_TCP, TcpFrame>,
+	Dissector<IP_PROTOCOL_UDP, UdpFrame>,
+	Dissector<IP_PROTOCOL_ICMP, IcmpFrame>
+> TransportDissectors;
+
+struct IpFrame::TransportBuilder {
+	IpFrame& frame;
+	unsigned pseudoHeader;
+	// what the IP header says the segment holds, more than was captured when snapped
+	unsigned segmentLength;
+
+	template <typename Layer>
+	void visit()
+	{
+		if (frame.getPayloadLength() < Layer::MIN_LENGTH)
+			return;
+		frame.transport = frame.arena
+			? static_cast<void*>(frame.arena->create<Layer>(frame.getPayload(), frame.getPayloadLength(), pseudoHeader, segmentLength))
+			: static_cast<void*>(new Layer(frame.getPayload(), frame.getPayloadLength(), pseudoHeader, segmentLength));
+	}
+};
 
-	// if packet has options
-	if (getIhl() * getVersion() > 0x20) {
-		unsigned optionsSize(getIhl() * getVersion() - 0x20);
-		char optionsOnBytes[optionsSize];
+struct IpFrame::TransportDeleter {
+	void* transport;
 
-		for (unsigned i(0); i < optionsSize; i++) {
-			optionsOnBytes[i] = frameBytes[i + 19];
-		}
-		setOptions(optionsOnBytes);
+	template <typename Layer>
+	void visit()
+	{
+		delete static_cast<Layer*>(transport);
 	}
+};
 
-	// if there is a payload
-	if (getIhl() * getVersion() > getTotalLength()) {
-		const unsigned payloadStartByte = 19 + getIhl() * getVersion() - 0x20;
-		char payloadOnBytes[getPayloadLength()];
+void IpFrame::fromBytes(const char* frameBytes)
+{
+	fromBytes(frameBytes, IP_STD_MAX_DATAGRAM_LENGTH);
+}
 
-		for (unsigned i(0); i < getPayloadLength(); i++) {
-			payloadOnBytes[i] = frameBytes[i + payloadStartByte];
-		}
+void IpFrame::fromBytes(const char* frameBytes, const unsigned& length)
+{
+	const IpView view(frameBytes, length);
+
+	capturedLength = 0;
+	if (length < IP_STD_MIN_HEADER_LENGTH)
+		return;
+
+	setVersion(view.getVersion());
+	setIhl(view.getIhl());
+	setService(view.getService());
+	setTotalLength(view.getTotalLength());
+	setId(view.getId());
+	setDf(view.getDf());
+	setMf(view.getMf());
+	setOffset(view.getOffset());
+	setTtl(view.getTtl());
+	setProtocol(view.getProtocol());
+	setCheckSum(view.getCheckSum());
+	setSourceAddress(view.getSourceAddress());
+	setDestinationAddress(view.getDestinationAddress());
+
+	// snapped captures and ethernet padding both make length disagree with totalLength
+	capturedLength = view.getCapturedLength();
+
+	calculatedCheckSum = 0;
+	if (view.isValid())
+		calculateCheckSum(frameBytes);
 
-		setPayload(payloadOnBytes);
-	}
+	// if packet has options
+	if (getOptionsLength() > 0)
+		setOptions(frameBytes + IP_STD_MIN_HEADER_LENGTH);
+
+	// if there is a payload
+	if (getPayloadLength() > 0)
+		setPayload(frameBytes + getHeaderLength());
 }
 
 IpFrame::IpFrame(const char* frameBytes)
 {
+	init();
 	fromBytes(frameBytes);
 	constructPayload();
 }
 
-IpFrame::IpFrame(istream& input)
+IpFrame::IpFrame(const char* frameBytes, const unsigned& length, Arena* frameArena)
 {
-	char buffer[IP_STD_MIN_HEADER_LENGTH];
-	input.read(buffer, IP_STD_MIN_HEADER_LENGTH);
-	fromBytes(buffer);
+	init();
+	arena = frameArena;
+	fromBytes(frameBytes, length);
+	constructPayload();
+}
 
-	// if packet has options
-	if (getIhl() * getVersion() > 0x20) {
-		const unsigned optionsSize(getIhl() * getVersion() - 0x20);
-		input.read(options, optionsSize);
-	}
+IpFrame::IpFrame(istream& input)
+{
+	init();
 
-	// if there is a payload
-	if (getIhl() * getVersion() > getTotalLength()) {
-		input.read(payload, getPayloadLength());
+	char buffer[IP_STD_MAX_DATAGRAM_LENGTH];
+	input.read(buffer, IP_STD_MIN_HEADER_LENGTH);
+	unsigned length(input.gcount());
+
+	// the rest of the datagram, as announced by the header
+	if (length == IP_STD_MIN_HEADER_LENGTH) {
+		const unsigned totalLength(static_cast<uint8_t>(buffer[2]) * 0x100 + static_cast<uint8_t>(buffer[3]));
+		if (totalLength > length) {
+			input.read(buffer + length, totalLength - length);
+			length += input.gcount();
+		}
 	}
 
+	fromBytes(buffer, length);
 	constructPayload();
 }
 
 IpFrame::~IpFrame()
 {
+	if (arena)
+		return;
+
 	free(options);
+	free(payload);
+
+	TransportDeleter deleter{ transport };
+	if (transport)
+		TransportDissectors::dispatch(transportProtocol, deleter);
+}
+
+void IpFrame::init()
+{
+	capturedLength = 0;
+	options = nullptr;
+	payload = nullptr;
+	transport = nullptr;
+	transportProtocol = 0;
+	arena = nullptr;
+}
+
+char* IpFrame::reserve(char* buffer, const unsigned& length)
+{
+	// arena buffers are never given back, a new one simply replaces the old
+	if (arena)
+		return static_cast<char*>(arena->allocate(length, 1));
+
+	char* grown(static_cast<char*>(realloc(buffer, length)));
+	// on failure the old buffer is still ours, and null is what the caller keeps
+	if (!grown)
+		free(buffer);
+	return grown;
 }
 
 void IpFrame::setVersion(const unsigned& v) { version = v; }
@@ -90,17 +172,26 @@ void IpFrame::setSourceAddress(const unsigned& sa) { sourceAddress = sa; }
 void IpFrame::setDestinationAddress(const unsigned& da) { destinationAddress = da; }
 void IpFrame::setCheckSum(const unsigned& cs) { checkSum = cs; }
 
+// out of memory the datagram keeps its header fields but reads as captured empty, so no transport is built
+
 void IpFrame::setPayload(const char* bytes)
 {
-	for (unsigned i(0); i < getPayloadLength(); i++)
-		payload[i] = bytes[i];
-
+	payload = reserve(payload, getPayloadLength());
+	if (!payload) {
+		capturedLength = 0;
+		return;
+	}
+	memcpy(payload, bytes, getPayloadLength());
 }
 
 void IpFrame::setOptions(const char* bytes)
 {
-	for (unsigned i(0); i < getOptionsLength(); i++)
-		options[i] = bytes[i];
+	options = reserve(options, getOptionsLength());
+	if (!options) {
+		capturedLength = 0;
+		return;
+	}
+	memcpy(options, bytes, getOptionsLength());
 }
 
 unsigned IpFrame::getVersion() const { return version; }
@@ -130,17 +221,17 @@ string IpFrame::getDestinationAddressAsString() const
 	return addressToString(getDestinationAddress());
 }
 
-string IpFrame::getDelayAsString() const
+const char* IpFrame::getDelayAsString() const
 {
 	return getDelay() ? "Low delay" : "Normal delay";
 }
 
-string IpFrame::getThroughputAsString() const
+const char* IpFrame::getThroughputAsString() const
 {
 	return getThroughput() ? "High throughput" : "Normal throughput";
 }
 
-string IpFrame::getReliabilityAsString() const
+const char* IpFrame::getReliabilityAsString() const
 {
 	return getReliability() ? "High reliability" : "Normal reliability";
 }
@@ -165,9 +256,14 @@ unsigned IpFrame::getReservedTosBits() const
 	return getService() & 0b11;
 }
 
-string IpFrame::getPrecedenceAsString() const
+const char* IpFrame::getPrecedenceAsString() const
 {
-	switch (getPrecedence()) {
+	return getPrecedenceName(getPrecedence());
+}
+
+const char* IpFrame::getPrecedenceName(const unsigned& precedence)
+{
+	switch (precedence) {
 	case 0b111:
 		return "Network Control";
 		break;
@@ -198,9 +294,14 @@ string IpFrame::getPrecedenceAsString() const
 	}
 }
 
-string IpFrame::getProtocolAsString() const
+const char* IpFrame::getProtocolAsString() const
+{
+	return getProtocolName(getProtocol());
+}
+
+const char* IpFrame::getProtocolName(const unsigned& protocol)
 {
-	switch (getProtocol()) {
+	switch (protocol) {
 	case IP_PROTOCOL_HOPOPT:
 		return "HOPOPT";
 		break;
@@ -222,65 +323,75 @@ string IpFrame::getProtocolAsString() const
 	case IP_PROTOCOL_TCP:
 		return "TCP";
 		break;
+	case IP_PROTOCOL_UDP:
+		return "UDP";
+		break;
 	default:
 		return "Unknown";
 		break;
 	}
 }
 
+unsigned IpFrame::getHeaderLength() const
+{
+	return getIhl() * 4;
+}
+
 unsigned IpFrame::getPayloadLength() const
 {
-	return getTotalLength() - getIhl() * getVersion();
+	if (getHeaderLength() < IP_STD_MIN_HEADER_LENGTH || capturedLength <= getHeaderLength())
+		return 0;
+	return capturedLength - getHeaderLength();
 }
 
 unsigned IpFrame::getOptionsLength() const
 {
-	return getIhl() * getVersion() - 0x20;
+	if (getHeaderLength() <= IP_STD_MIN_HEADER_LENGTH || capturedLength < getHeaderLength())
+		return 0;
+	return getHeaderLength() - IP_STD_MIN_HEADER_LENGTH;
 }
 
 void IpFrame::constructPayload()
 {
-	switch (getProtocol()) {
-	case IP_PROTOCOL_TCP:
-		tcpFrame = new TcpFrame(getPayload());
-		break;
-	}
+	// a fragment holds only part of the transport segment, see FragmentReassembler
+	if (getMf() || getOffset())
+		return;
+
+	const unsigned segmentLength(getTotalLength() > getHeaderLength() ? getTotalLength() - getHeaderLength() : 0);
+	TransportBuilder builder{ *this, Checksum::pseudoHeader(getSourceAddress(), getDestinationAddress(), getProtocol(),
+		segmentLength), segmentLength };
+	transportProtocol = getProtocol();
+	TransportDissectors::dispatch(transportProtocol, builder);
 }
 
 const TcpFrame* IpFrame::getTcpFrame() const
 {
-	return tcpFrame;
+	return transportProtocol == IP_PROTOCOL_TCP ? static_cast<const TcpFrame*>(transport) : nullptr;
+}
+
+const UdpFrame* IpFrame::getUdpFrame() const
+{
+	return transportProtocol == IP_PROTOCOL_UDP ? static_cast<const UdpFrame*>(transport) : nullptr;
+}
+
+const IcmpFrame* IpFrame::getIcmpFrame() const
+{
+	return transportProtocol == IP_PROTOCOL_ICMP ? static_cast<const IcmpFrame*>(transport) : nullptr;
 }
 
 /* address is a bit field */
 string IpFrame::addressToString(const unsigned& address) const
 {
-	stringstream ss;
-	ss << (address / 0x1000000);
-	ss << '.';
-	ss << (address / 0x10000 & 0x0000FF);
-	ss << '.';
-	ss << (address / 0x100 & 0x00FF);
-	ss << '.';
-	ss << (address & 0xFF);
-	return ss.str();
+	char text[TEXT_MAX_IPV4_LENGTH];
+	return string(text, formatIpv4(text, address));
 }
 
-void IpFrame::calculateCheckSum()
-{
-	unsigned long cs;
-	cs = ~(getVersion() * 0x1000 + getIhl() * 0x100 + getService());
-	cs += ~(getTotalLength());
-	cs += ~(getId());
-	cs += ~((getDf() << 14) + (getMf() << 13) + getOffset());
-	cs += ~(getTtl() * 0x100 + getProtocol());
-	cs += ~(0xFFFF);
-	cs += ~(getSourceAddress() / 0x10000);
-	cs += ~(getSourceAddress() & 0xFFFF);
-	cs += ~(getDestinationAddress() / 0x10000);
-	cs += ~(getDestinationAddress() & 0xFFFF);
-	cs += ((cs & 0xFFFF0000) >> 32);
-	this->calculatedCheckSum = cs;
+void IpFrame::calculateCheckSum(const char* header)
+{
+	// summing the header as sent and then taking the sent checksum back out is
+	// the same as summing it with the checksum field zeroed
+	const uint16_t sum(Checksum::sum(reinterpret_cast<const uint8_t*>(header), getHeaderLength()));
+	this->calculatedCheckSum = Checksum::finish(Checksum::add(sum, ~getCheckSum() & 0xFFFF));
 }
 
 bool IpFrame::checksumIsOk() const
@@ -0,0 +1,206 @@
+#include <Ipv6Frame.hpp>
+#include <Ipv6View.hpp>
+#include <IpFrame.hpp>
+#include <Checksum.hpp>
+#include <Dissectors.hpp>
+#include <TextFormat.hpp>
+#include <cstring>
+
+using namespace std;
+
+/* TRANSPORT DISSECTORS */
+
+// the same layers as over IPv4, with the IPv6 pseudo-header sum
+typedef DissectorRegistry<
+	Dissector<IP_PROTOCOL_TCP, TcpFrame>,
+	Dissector<IP_PROTOCOL_UDP, UdpFrame>
+> TransportDissectors;
+
+struct Ipv6Frame::TransportBuilder {
+	Ipv6Frame& frame;
+	unsigned pseudoHeader;
+	// what the IP header says the segment holds, more than was captured when snapped
+	unsigned segmentLength;
+
+	template <typename Layer>
+	void visit()
+	{
+		if (frame.getUpperLayerLength() < Layer::MIN_LENGTH)
+			return;
+		frame.transport = frame.arena
+			? static_cast<void*>(frame.arena->create<Layer>(frame.getPayload(), frame.getUpperLayerLength(), pseudoHeader, segmentLength))
+			: static_cast<void*>(new Layer(frame.getPayload(), frame.getUpperLayerLength(), pseudoHeader, segmentLength));
+	}
+};
+
+struct Ipv6Frame::TransportDeleter {
+	void* transport;
+
+	template <typename Layer>
+	void visit()
+	{
+		delete static_cast<Layer*>(transport);
+	}
+};
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+Ipv6Frame::Ipv6Frame(const char* frameBytes, const unsigned& length, Arena* frameArena)
+{
+	init();
+	arena = frameArena;
+	fromBytes(frameBytes, length);
+	constructPayload();
+}
+
+Ipv6Frame::~Ipv6Frame()
+{
+	if (arena)
+		return;
+
+	free(payload);
+
+	TransportDeleter deleter{ transport };
+	if (transport)
+		TransportDissectors::dispatch(transportProtocol, deleter);
+}
+
+void Ipv6Frame::init()
+{
+	protocol = 0;
+	fragment = 0;
+	chainIsOk = false;
+	headerLength = IPV6_STD_HEADER_LENGTH;
+	upperLayerLength = 0;
+	payload = nullptr;
+	transport = nullptr;
+	transportProtocol = 0;
+	arena = nullptr;
+}
+
+char* Ipv6Frame::reserve(char* buffer, const unsigned& length)
+{
+	// arena buffers are never given back, a new one simply replaces the old
+	if (arena)
+		return static_cast<char*>(arena->allocate(length, 1));
+
+	char* grown(static_cast<char*>(realloc(buffer, length)));
+	// on failure the old buffer is still ours, and null is what the caller keeps
+	if (!grown)
+		free(buffer);
+	return grown;
+}
+
+void Ipv6Frame::fromBytes(const char* frameBytes, const unsigned& length)
+{
+	const Ipv6View view(frameBytes, length);
+	unsigned walkedProtocol, walkedOffset, walkedFragment;
+
+	version = view.getVersion();
+	trafficClass = view.getTrafficClass();
+	flowLabel = view.getFlowLabel();
+	payloadLength = view.getPayloadLength();
+	nextHeader = view.getNextHeader();
+	hopLimit = view.getHopLimit();
+	memcpy(sourceAddress, view.getSourceAddress(), IPV6_STD_ADDRESS_LENGTH);
+	memcpy(destinationAddress, view.getDestinationAddress(), IPV6_STD_ADDRESS_LENGTH);
+
+	chainIsOk = view.isValid() && view.walkExtensionHeaders(walkedProtocol, walkedOffset, walkedFragment);
+	if (!chainIsOk) {
+		protocol = nextHeader;
+		return;
+	}
+
+	protocol = walkedProtocol;
+	fragment = walkedFragment;
+	headerLength = walkedOffset;
+	upperLayerLength = view.getCapturedLength() - headerLength;
+
+	if (upperLayerLength > 0) {
+		payload = reserve(payload, upperLayerLength);
+		// out of memory there is no upper layer, so no transport is built
+		if (!payload)
+			upperLayerLength = 0;
+		else
+			memcpy(payload, frameBytes + headerLength, upperLayerLength);
+	}
+}
+
+void Ipv6Frame::constructPayload()
+{
+	// as over IPv4, a fragment holds only part of the transport segment
+	if (!chainIsOk || isFragment())
+		return;
+
+	const unsigned segmentLength(IPV6_STD_HEADER_LENGTH + getPayloadLength() > headerLength
+		? IPV6_STD_HEADER_LENGTH + getPayloadLength() - headerLength : 0);
+	TransportBuilder builder{ *this, Checksum::pseudoHeader(sourceAddress, getProtocol(), segmentLength), segmentLength };
+
+	transportProtocol = getProtocol();
+	TransportDissectors::dispatch(transportProtocol, builder);
+}
+
+/* GETTERS */
+
+unsigned Ipv6Frame::getVersion() const { return version; }
+unsigned Ipv6Frame::getTrafficClass() const { return trafficClass; }
+unsigned Ipv6Frame::getFlowLabel() const { return flowLabel; }
+unsigned Ipv6Frame::getPayloadLength() const { return payloadLength; }
+unsigned Ipv6Frame::getNextHeader() const { return nextHeader; }
+unsigned Ipv6Frame::getHopLimit() const { return hopLimit; }
+const uint8_t* Ipv6Frame::getSourceAddress() const { return sourceAddress; }
+const uint8_t* Ipv6Frame::getDestinationAddress() const { return destinationAddress; }
+unsigned Ipv6Frame::getProtocol() const { return protocol; }
+unsigned Ipv6Frame::getHeaderLength() const { return headerLength; }
+unsigned Ipv6Frame::getExtensionHeadersLength() const { return headerLength - IPV6_STD_HEADER_LENGTH; }
+bool Ipv6Frame::extensionHeadersAreOk() const { return chainIsOk; }
+bool Ipv6Frame::isFragment() const { return fragment != 0; }
+unsigned Ipv6Frame::getFragmentOffset() const { return fragment >> 3; }
+bool Ipv6Frame::getMoreFragments() const { return fragment & 1; }
+const char* Ipv6Frame::getPayload() const { return payload; }
+unsigned Ipv6Frame::getUpperLayerLength() const { return upperLayerLength; }
+
+const TcpFrame* Ipv6Frame::getTcpFrame() const
+{
+	return transportProtocol == IP_PROTOCOL_TCP ? static_cast<const TcpFrame*>(transport) : nullptr;
+}
+
+const UdpFrame* Ipv6Frame::getUdpFrame() const
+{
+	return transportProtocol == IP_PROTOCOL_UDP ? static_cast<const UdpFrame*>(transport) : nullptr;
+}
+
+string Ipv6Frame::getSourceAddressAsString() const
+{
+	return addressToString(getSourceAddress());
+}
+
+string Ipv6Frame::getDestinationAddressAsString() const
+{
+	return addressToString(getDestinationAddress());
+}
+
+const char* Ipv6Frame::getProtocolAsString() const
+{
+	switch (getProtocol()) {
+	case IP_PROTOCOL_TCP:
+		return "TCP";
+	case IP_PROTOCOL_UDP:
+		return "UDP";
+	case IPV6_PROTOCOL_ICMPV6:
+		return "ICMPv6";
+	case IPV6_VIEW_ESP:
+		return "ESP";
+	case IPV6_VIEW_NO_NEXT_HEADER:
+		return "No next header";
+	default:
+		return "Unknown";
+	}
+}
+
+/* RFC 5952 text form: lower case, no leading zeros, longest zero run as :: */
+string Ipv6Frame::addressToString(const uint8_t* address) const
+{
+	char text[TEXT_MAX_IPV6_LENGTH];
+	return string(text, formatIpv6(text, address));
+}
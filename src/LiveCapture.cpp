@@ -0,0 +1,196 @@
+#include <LiveCapture.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+LiveCapture::LiveCapture()
+	: fd(-1), ring(nullptr), ringLength(0), blockSize(0), blockCount(0), currentBlock(0),
+	received(0), dropped(0), freezes(0)
+{
+}
+
+LiveCapture::~LiveCapture()
+{
+	close();
+}
+
+bool LiveCapture::fail(const string& what)
+{
+	error = what + ": " + strerror(errno);
+	close();
+	return false;
+}
+
+#ifdef __linux__
+
+/* SETUP */
+
+bool LiveCapture::open(const string& interface, const unsigned& size, const unsigned& count, const unsigned& fanout)
+{
+	close();
+
+	const unsigned index(if_nametoindex(interface.c_str()));
+	if (index == 0) {
+		error = "No such interface: " + interface;
+		return false;
+	}
+
+	if (size < LIVE_CAPTURE_FRAME_SIZE || size % getpagesize() || count == 0) {
+		error = "Block size must be a multiple of the page size and hold at least one frame";
+		return false;
+	}
+
+	fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+	if (fd < 0)
+		return fail("socket(AF_PACKET)");
+
+	int version(TPACKET_V3);
+	if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+		return fail("PACKET_VERSION");
+
+	tpacket_req3 request;
+	memset(&request, 0, sizeof(request));
+	request.tp_block_size = size;
+	request.tp_block_nr = count;
+	request.tp_frame_size = LIVE_CAPTURE_FRAME_SIZE;
+	request.tp_frame_nr = size / LIVE_CAPTURE_FRAME_SIZE * count;
+	request.tp_retire_blk_tov = LIVE_CAPTURE_BLOCK_TIMEOUT;
+	request.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+	if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) != 0)
+		return fail("PACKET_RX_RING");
+
+	ringLength = static_cast<size_t>(size) * count;
+	void* mapped(mmap(nullptr, ringLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, fd, 0));
+	// locking needs privileges (or RLIMIT_MEMLOCK) that not every user has
+	if (mapped == MAP_FAILED)
+		mapped = mmap(nullptr, ringLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED) {
+		ringLength = 0;
+		return fail("mmap");
+	}
+	ring = static_cast<char*>(mapped);
+	blockSize = size;
+	blockCount = count;
+	currentBlock = 0;
+
+	sockaddr_ll address;
+	memset(&address, 0, sizeof(address));
+	address.sll_family = AF_PACKET;
+	address.sll_protocol = htons(ETH_P_ALL);
+	address.sll_ifindex = index;
+	if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+		return fail("bind");
+
+	if (fanout) {
+		const int group((fanout & 0xFFFF) | (PACKET_FANOUT_HASH << 16));
+		if (setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &group, sizeof(group)) != 0)
+			return fail("PACKET_FANOUT");
+	}
+
+	received = dropped = freezes = 0;
+	// start counting from now, not from whatever arrived during setup
+	updateStatistics();
+	received = dropped = freezes = 0;
+	return true;
+}
+
+void LiveCapture::close()
+{
+	if (ring)
+		munmap(ring, ringLength);
+	if (fd >= 0)
+		::close(fd);
+	ring = nullptr;
+	ringLength = 0;
+	fd = -1;
+}
+
+/* READING */
+
+int LiveCapture::dispatch(const RecordCallback& callback, const int& timeout)
+{
+	if (!ring)
+		return -1;
+
+	tpacket_block_desc* block(reinterpret_cast<tpacket_block_desc*>(ring + static_cast<size_t>(currentBlock) * blockSize));
+
+	if (!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) {
+		pollfd waiting;
+		waiting.fd = fd;
+		waiting.events = POLLIN | POLLERR;
+		waiting.revents = 0;
+		if (poll(&waiting, 1, timeout) < 0 && errno != EINTR)
+			return -1;
+		return 0;
+	}
+
+	const unsigned packets(block->hdr.bh1.num_pkts);
+	const tpacket3_hdr* header(reinterpret_cast<const tpacket3_hdr*>(
+		reinterpret_cast<const char*>(block) + block->hdr.bh1.offset_to_first_pkt));
+	CaptureRecord record;
+	record.linkType = LINKTYPE_ETHERNET;
+
+	for (unsigned i(0); i < packets; i++) {
+		record.timestamp = static_cast<uint64_t>(header->tp_sec) * 1000000000 + header->tp_nsec;
+		record.capturedLength = header->tp_snaplen;
+		record.originalLength = header->tp_len;
+		record.data = reinterpret_cast<const char*>(header) + header->tp_mac;
+		callback(record);
+
+		header = reinterpret_cast<const tpacket3_hdr*>(reinterpret_cast<const char*>(header) + header->tp_next_offset);
+	}
+
+	// hand the block back only after every frame in it has been used
+	__atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+	currentBlock = (currentBlock + 1) % blockCount;
+	return packets;
+}
+
+bool LiveCapture::updateStatistics()
+{
+	tpacket_stats_v3 statistics;
+	socklen_t length(sizeof(statistics));
+
+	if (fd < 0 || getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &statistics, &length) != 0)
+		return false;
+
+	// tp_packets already includes the dropped ones
+	received += statistics.tp_packets;
+	dropped += statistics.tp_drops;
+	freezes += statistics.tp_freeze_q_cnt;
+	return true;
+}
+
+#else
+
+bool LiveCapture::open(const string&, const unsigned&, const unsigned&, const unsigned&)
+{
+	error = "Live capture needs Linux AF_PACKET sockets";
+	return false;
+}
+
+void LiveCapture::close() {}
+int LiveCapture::dispatch(const RecordCallback&, const int&) { return -1; }
+bool LiveCapture::updateStatistics() { return false; }
+
+#endif
+
+uint64_t LiveCapture::getReceived() const { return received; }
+uint64_t LiveCapture::getDropped() const { return dropped; }
+uint64_t LiveCapture::getFreezes() const { return freezes; }
+const string& LiveCapture::getError() const { return error; }
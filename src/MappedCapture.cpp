@@ -0,0 +1,93 @@
+#include <MappedCapture.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+MappedCapture::MappedCapture() : bytes(nullptr), length(0), modified(0), indexLoaded(false), indexSaved(false) {}
+
+MappedCapture::~MappedCapture()
+{
+	unmap();
+}
+
+/* MAPPING */
+
+bool MappedCapture::open(const string& name)
+{
+	unmap();
+
+	const int fd(::open(name.c_str(), O_RDONLY));
+	if (fd < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* mapped(mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+	close(fd);
+	if (mapped == MAP_FAILED)
+		return false;
+
+	// the index pass reads front to back; the decode pass is sequential per worker
+	madvise(mapped, status.st_size, MADV_SEQUENTIAL);
+
+	filename = name;
+	bytes = static_cast<const char*>(mapped);
+	length = status.st_size;
+	modified = static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+	return true;
+}
+
+void MappedCapture::unmap()
+{
+	if (bytes)
+		munmap(const_cast<char*>(bytes), length);
+	bytes = nullptr;
+	length = 0;
+	indexLoaded = false;
+	indexSaved = false;
+}
+
+/* INDEX */
+
+const CaptureIndex& MappedCapture::getIndex()
+{
+	const string indexName(filename + CAPTURE_INDEX_SUFFIX);
+
+	if (index.size() || !bytes)
+		return index;
+
+	indexLoaded = index.load(indexName, length, modified);
+	if (!indexLoaded && index.build(bytes, length))
+		indexSaved = index.save(indexName, length, modified);
+
+	return index;
+}
+
+bool MappedCapture::isIndexLoaded() const { return indexLoaded; }
+bool MappedCapture::isIndexSaved() const { return indexSaved; }
+uint64_t MappedCapture::getLength() const { return length; }
+int64_t MappedCapture::getModified() const { return modified; }
+const char* MappedCapture::getBytes() const { return bytes; }
+
+CaptureRecord MappedCapture::getRecord(const uint64_t& frame) const
+{
+	const CaptureIndexEntry& entry(index[frame]);
+	CaptureRecord record;
+
+	record.timestamp = entry.timestamp;
+	record.capturedLength = entry.capturedLength;
+	record.originalLength = entry.capturedLength;
+	record.linkType = entry.linkType;
+	record.data = bytes + entry.offset;
+	return record;
+}
@@ -0,0 +1,201 @@
+#include <Options.hpp>
+#include <LiveCapture.hpp>
+#include <FlowTable.hpp>
+#include <TrafficStatistics.hpp>
+#include <HeavyHitters.hpp>
+
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <thread>
+
+using namespace std;
+
+Options::Options()
+	: interactive(true), threads(0), blockSize(LIVE_CAPTURE_BLOCK_SIZE), ringBlocks(LIVE_CAPTURE_BLOCK_COUNT),
+	fanout(0), count(0), flows(0), streams(false), tcpMetrics(false), defragment(false),
+	format(OUTPUT_FORMAT_TEXT), statistics(false), statisticsInterval(STATISTICS_DEFAULT_INTERVAL),
+	heavyHitters(0)
+{
+}
+
+bool Options::parse(int argc, char** argv)
+{
+	for (int i(1); i < argc; i++) {
+		const string argument(argv[i]);
+		const size_t equals(argument.find('='));
+		const string name(argument.substr(0, equals));
+		const string value(equals == string::npos ? "" : argument.substr(equals + 1));
+
+		if (name == "--threads") {
+			if (!parseUnsigned(value, threads))
+				return false;
+			const unsigned cores(thread::hardware_concurrency() ? thread::hardware_concurrency() : 1);
+			if (threads > OPTIONS_MAX_THREADS_PER_CORE * cores) {
+				error = "--threads must be at most " + to_string(OPTIONS_MAX_THREADS_PER_CORE * cores) + " on this machine";
+				return false;
+			}
+		} else if (name == "--interface") {
+			interface = value;
+		} else if (name == "--block-size") {
+			if (!parseUnsigned(value, blockSize))
+				return false;
+		} else if (name == "--ring-blocks") {
+			if (!parseUnsigned(value, ringBlocks))
+				return false;
+		} else if (name == "--fanout") {
+			if (!parseUnsigned(value, fanout))
+				return false;
+		} else if (name == "--count") {
+			if (!parseUnsigned(value, count))
+				return false;
+		} else if (name == "--filter") {
+			filter = value;
+		} else if (name == "--flows") {
+			flows = FLOW_TABLE_DEFAULT_FLOWS;
+			if (equals != string::npos && !parseUnsigned(value, flows))
+				return false;
+		} else if (name == "--streams") {
+			streams = true;
+		} else if (name == "--tcp-metrics") {
+			tcpMetrics = true;
+		} else if (name == "--defragment") {
+			defragment = true;
+		} else if (name == "--format") {
+			if (!RecordWriter::parseFormat(value, format)) {
+				error = "Unknown format: " + value;
+				return false;
+			}
+		} else if (name == "--export") {
+			if (value.empty()) {
+				error = "--export needs a file name";
+				return false;
+			}
+			exportFilename = value;
+		} else if (name == "--stats") {
+			statistics = true;
+			if (equals != string::npos && !parseUnsigned(value, statisticsInterval))
+				return false;
+		} else if (name == "--stats-out") {
+			if (value.empty()) {
+				error = "--stats-out needs a file name";
+				return false;
+			}
+			statistics = true;
+			statisticsFilename = value;
+		} else if (name == "--top") {
+			heavyHitters = HEAVY_HITTERS_DEFAULT_TOP;
+			if (equals != string::npos && !parseUnsigned(value, heavyHitters))
+				return false;
+		} else if (argument.size() > 1 && argument[0] == '-') {
+			error = "Unknown option: " + argument;
+			return false;
+		} else if (filename.empty()) {
+			filename = argument;
+		} else {
+			error = "Only one capture file can be analized at a time";
+			return false;
+		}
+	}
+
+	interactive = argc == 1;
+	// streams are reassembled and metrics derived per tracked flow
+	if ((streams || tcpMetrics) && !flows)
+		flows = FLOW_TABLE_DEFAULT_FLOWS;
+	if (!interactive && filename.empty() && interface.empty()) {
+		error = "No capture file or interface given";
+		return false;
+	}
+	if (!filename.empty() && !interface.empty()) {
+		error = "Analize either a capture file or an interface, not both";
+		return false;
+	}
+	// records are one per captured frame, flows and datagrams have no place among them
+	if (format != OUTPUT_FORMAT_TEXT && (flows || defragment)) {
+		error = string("--format=") + RecordWriter::getFormatAsString(format)
+			+ " cannot be combined with --flows, --streams, --tcp-metrics or --defragment";
+		return false;
+	}
+	return true;
+}
+
+bool Options::parseUnsigned(const string& value, unsigned& out)
+{
+	char* end;
+
+	// strtoul would take a sign and negate the result
+	if (value.empty() || !isdigit(static_cast<unsigned char>(value[0]))) {
+		error = "Expected a number, got: " + value;
+		return false;
+	}
+	errno = 0;
+	const unsigned long parsed(strtoul(value.c_str(), &end, 10));
+	if (*end != '\0') {
+		error = "Expected a number, got: " + value;
+		return false;
+	}
+	if (errno == ERANGE || parsed > UINT_MAX) {
+		error = "Number out of range: " + value;
+		return false;
+	}
+	out = parsed;
+	return true;
+}
+
+bool Options::isInteractive() const { return interactive; }
+const string& Options::getFilename() const { return filename; }
+const string& Options::getError() const { return error; }
+
+unsigned Options::getThreads() const
+{
+	if (threads)
+		return threads;
+	return thread::hardware_concurrency() ? thread::hardware_concurrency() : 1;
+}
+
+const string& Options::getInterface() const { return interface; }
+unsigned Options::getBlockSize() const { return blockSize; }
+unsigned Options::getRingBlocks() const { return ringBlocks; }
+unsigned Options::getFanout() const { return fanout; }
+unsigned Options::getCount() const { return count; }
+const string& Options::getFilter() const { return filter; }
+unsigned Options::getFlows() const { return flows; }
+bool Options::getStreams() const { return streams; }
+bool Options::getTcpMetrics() const { return tcpMetrics; }
+bool Options::getDefragment() const { return defragment; }
+OutputFormat Options::getFormat() const { return format; }
+const string& Options::getExportFilename() const { return exportFilename; }
+bool Options::getStatistics() const { return statistics; }
+unsigned Options::getStatisticsInterval() const { return statisticsInterval; }
+const string& Options::getStatisticsFilename() const { return statisticsFilename; }
+unsigned Options::getHeavyHitters() const { return heavyHitters; }
+
+void Options::setFilename(const string& f) { filename = f; }
+void Options::setInterface(const string& i) { interface = i; }
+
+void Options::printUsage(ostream& out, const char* program)
+{
+	out << "Usage: " << program << " [options] <capture file>" << endl;
+	out << "       " << program << " [options] --interface=NAME" << endl;
+	out << "       " << program << " (no arguments: interactive menu)" << endl;
+	out << "Options:" << endl;
+	out << "\t--threads=N\tdecoder threads (default: one per core)" << endl;
+	out << "\t--interface=NAME\tcapture live from a Linux interface" << endl;
+	out << "\t--block-size=N\tring block size in octets (default: " << LIVE_CAPTURE_BLOCK_SIZE << ")" << endl;
+	out << "\t--ring-blocks=N\tblocks in the capture ring (default: " << LIVE_CAPTURE_BLOCK_COUNT << ")" << endl;
+	out << "\t--fanout=ID\tjoin PACKET_FANOUT group ID, load balanced by flow hash" << endl;
+	out << "\t--count=N\tstop after N live frames" << endl;
+	out << "\t--filter=EXPR\tonly decode matching frames, e.g. \"ip.addr == 10.0.0.0/8 and tcp.dport == 443\"" << endl;
+	out << "\t--format=FORMAT\ttext (default), json, csv or bin: one record per frame on stdout, the report on stderr" << endl;
+	out << "\t--export=FILE\talso write the decoded headers to FILE as compressed columns, read back with sniffer-scan" << endl;
+	out << "\t--stats[=N]\tprint traffic statistics to stderr every N seconds (default: " << STATISTICS_DEFAULT_INTERVAL
+		<< ", 0 for only at the end)" << endl;
+	out << "\t--stats-out=FILE\talso append each statistics snapshot to FILE as a JSON line" << endl;
+	out << "\t--top[=N]\tlist the N heaviest sources, destinations, ports and flows by bytes at the end (default: "
+		<< HEAVY_HITTERS_DEFAULT_TOP << "), estimated in fixed memory" << endl;
+	out << "\t--flows[=N]\ttrack up to N connections (default: " << FLOW_TABLE_DEFAULT_FLOWS << ") and print each as it ends" << endl;
+	out << "\t--streams\talso reassemble the byte streams of tracked TCP flows and count reassembled and missing octets" << endl;
+	out << "\t--tcp-metrics\talso measure RTT, retransmissions and window events of tracked TCP flows" << endl;
+	out << "\t--defragment\treassemble fragmented IPv4 datagrams and decode them whole" << endl;
+}
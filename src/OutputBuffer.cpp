@@ -0,0 +1,123 @@
+#include <OutputBuffer.hpp>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace std;
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+OutputBuffer::OutputBuffer() : current(0), cursor(nullptr), end(nullptr) {}
+
+OutputBuffer::~OutputBuffer()
+{
+	for (char* chunk : chunks)
+		delete[] chunk;
+}
+
+/* APPENDING */
+
+OutputBuffer& OutputBuffer::append(const char* s, const size_t& length)
+{
+	size_t left(length);
+
+	// long text is split over chunks, short text is never split
+	while (left > 0) {
+		if (cursor == end || (left <= OUTPUT_BUFFER_CHUNK_LENGTH && static_cast<size_t>(end - cursor) < left))
+			nextChunk();
+
+		const size_t piece(static_cast<size_t>(end - cursor) < left ? end - cursor : left);
+		memcpy(cursor, s, piece);
+		cursor += piece;
+		s += piece;
+		left -= piece;
+	}
+	return *this;
+}
+
+OutputBuffer& OutputBuffer::real(const double& value)
+{
+	char text[32];
+	const int length(snprintf(text, sizeof(text), "%g", value));
+	return this->text(text, length > 0 ? length : 0);
+}
+
+void OutputBuffer::nextChunk()
+{
+	if (cursor) {
+		lengths.push_back(cursor - chunks[current]);
+		current++;
+	}
+
+	if (current == chunks.size()) {
+		// running out of memory here fails the same way the string it replaces would
+		chunks.push_back(new char[OUTPUT_BUFFER_CHUNK_LENGTH]);
+	}
+
+	cursor = chunks[current];
+	end = cursor + OUTPUT_BUFFER_CHUNK_LENGTH;
+}
+
+/* STATE */
+
+size_t OutputBuffer::size() const
+{
+	size_t total(cursor ? cursor - chunks[current] : 0);
+	for (const size_t& length : lengths)
+		total += length;
+	return total;
+}
+
+bool OutputBuffer::empty() const
+{
+	return lengths.empty() && (!cursor || cursor == chunks[current]);
+}
+
+void OutputBuffer::clear()
+{
+	lengths.clear();
+	current = 0;
+	cursor = nullptr;
+	end = nullptr;
+}
+
+/* OUTPUT */
+
+bool OutputBuffer::flush(const int& fd)
+{
+	if (empty())
+		return true;
+
+	vectors.clear();
+	for (size_t i(0); i <= current; i++) {
+		const size_t length(i < lengths.size() ? lengths[i] : cursor - chunks[i]);
+		if (length)
+			vectors.push_back({ chunks[i], length });
+	}
+	clear();
+
+	// writev may stop short (pipes, signals), the rest goes in the next call
+	size_t first(0);
+	while (first < vectors.size()) {
+		const int count(vectors.size() - first < IOV_MAX ? vectors.size() - first : IOV_MAX);
+		ssize_t written(writev(fd, &vectors[first], count));
+
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		while (first < vectors.size() && static_cast<size_t>(written) >= vectors[first].iov_len) {
+			written -= vectors[first].iov_len;
+			first++;
+		}
+		if (first < vectors.size()) {
+			vectors[first].iov_base = static_cast<char*>(vectors[first].iov_base) + written;
+			vectors[first].iov_len -= written;
+		}
+	}
+	return true;
+}
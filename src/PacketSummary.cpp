@@ -0,0 +1,145 @@
+#include <PacketSummary.hpp>
+#include <EthernetView.hpp>
+#include <IpView.hpp>
+#include <Ipv6View.hpp>
+#include <TcpView.hpp>
+#include <UdpView.hpp>
+#include <IcmpView.hpp>
+#include <IpFrame.hpp>
+#include <EthernetFrame.hpp>
+
+#include <cstring>
+
+using namespace std;
+
+bool PacketSummary::fromBytes(const char* bytes, const unsigned& length, const uint64_t& time)
+{
+	const EthernetView ethernet(bytes, length);
+
+	memset(this, 0, sizeof(*this));
+	timestamp = time;
+	frameLength = length < 0xFFFF ? length : 0xFFFF;
+
+	if (!ethernet.isValid())
+		return false;
+
+	memcpy(destinationMac, ethernet.getDestinationAddress(), sizeof(destinationMac));
+	memcpy(sourceMac, ethernet.getSourceAddress(), sizeof(sourceMac));
+	ethertype = ethernet.getType();
+
+	if (ethernet.getVlanCount())
+		layers |= PACKET_LAYER_VLAN;
+
+	unsigned transportLength;
+	if (ethertype == ETHERTYPE_IPV4) {
+		const IpView ip(ethernet.getPayload(), ethernet.getPayloadLength());
+		if (!ip.isValid())
+			return true;
+
+		readIpv4(ip, ethernet.getHeaderLength());
+		transportLength = ip.getPayloadLength();
+	} else if (ethertype == ETHERTYPE_IPV6) {
+		const Ipv6View ip(ethernet.getPayload(), ethernet.getPayloadLength());
+		unsigned walkedProtocol, walkedOffset, fragment;
+		if (!ip.isValid() || !ip.walkExtensionHeaders(walkedProtocol, walkedOffset, fragment))
+			return true;
+
+		// addresses do not fit here, sourceAddress and destinationAddress stay zero
+		layers |= PACKET_LAYER_IPV6;
+		protocol = walkedProtocol;
+		ttl = ip.getHopLimit();
+		service = ip.getTrafficClass();
+		ipFlags = fragment & 1 ? PACKET_IP_MF : 0;
+		fragmentOffset = fragment >> 3;
+		const unsigned totalLength(IPV6_VIEW_HEADER_LENGTH + ip.getPayloadLength());
+		ipTotalLength = totalLength < 0xFFFF ? totalLength : 0xFFFF;
+		ipOffset = ethernet.getHeaderLength();
+		transportOffset = ipOffset + walkedOffset;
+		transportLength = ip.getCapturedLength() - walkedOffset;
+	} else {
+		return true;
+	}
+
+	readTransport(bytes, transportLength);
+	return true;
+}
+
+bool PacketSummary::fromDatagram(const char* datagram, const unsigned& length, const uint64_t& time)
+{
+	const IpView ip(datagram, length);
+
+	memset(this, 0, sizeof(*this));
+	timestamp = time;
+	frameLength = length < 0xFFFF ? length : 0xFFFF;
+	ethertype = ETHERTYPE_IPV4;
+
+	if (!ip.isValid())
+		return false;
+
+	readIpv4(ip, 0);
+	readTransport(datagram, ip.getPayloadLength());
+	return true;
+}
+
+void PacketSummary::readIpv4(const IpView& ip, const unsigned& offset)
+{
+	layers |= PACKET_LAYER_IPV4;
+	protocol = ip.getProtocol();
+	sourceAddress = ip.getSourceAddress();
+	destinationAddress = ip.getDestinationAddress();
+	ttl = ip.getTtl();
+	service = ip.getService();
+	ipFlags = (ip.getDf() ? PACKET_IP_DF : 0) | (ip.getMf() ? PACKET_IP_MF : 0);
+	fragmentOffset = ip.getOffset();
+	ipTotalLength = ip.getTotalLength();
+	ipOffset = offset;
+	transportOffset = ipOffset + ip.getHeaderLength();
+}
+
+void PacketSummary::readTransport(const char* bytes, const unsigned& transportLength)
+{
+	payloadOffset = transportOffset;
+	payloadLength = transportLength;
+
+	// later fragments carry no transport header, only more payload
+	if (fragmentOffset) {
+		layers |= PACKET_LAYER_FRAGMENT;
+		return;
+	}
+
+	const uint8_t* transport(reinterpret_cast<const uint8_t*>(bytes) + transportOffset);
+
+	if (protocol == IP_PROTOCOL_TCP) {
+		const TcpView tcp(transport, transportLength);
+		if (!tcp.isValid())
+			return;
+
+		layers |= PACKET_LAYER_TCP;
+		sourcePort = tcp.getSourcePort();
+		destinationPort = tcp.getDestinationPort();
+		sequenceNumber = tcp.getSequenceNumber();
+		acknowledgementNumber = tcp.getAcknowledgementNumber();
+		window = tcp.getWindow();
+		tcpFlags = tcp.getFlags();
+		payloadOffset = transportOffset + tcp.getHeaderLength();
+		payloadLength = tcp.getPayloadLength();
+	} else if (protocol == IP_PROTOCOL_UDP) {
+		const UdpView udp(transport, transportLength);
+		if (!udp.isValid())
+			return;
+
+		layers |= PACKET_LAYER_UDP;
+		sourcePort = udp.getSourcePort();
+		destinationPort = udp.getDestinationPort();
+		payloadOffset = transportOffset + UDP_VIEW_HEADER_LENGTH;
+		payloadLength = udp.getPayloadLength();
+	} else if (protocol == IP_PROTOCOL_ICMP) {
+		const IcmpView icmp(transport, transportLength);
+		if (!icmp.isValid())
+			return;
+
+		layers |= PACKET_LAYER_ICMP;
+		payloadOffset = transportOffset + ICMP_VIEW_HEADER_LENGTH;
+		payloadLength = icmp.getPayloadLength();
+	}
+}
@@ -0,0 +1,291 @@
+#include <PacketTable.hpp>
+
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PACKET_TABLE_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/* SCALAR KERNEL */
+
+template <typename T>
+static uint64_t scanWordScalar(const T* column, const size_t& count, const T& low, const T& high, const T& mask)
+{
+	uint64_t selected(0);
+
+	for (size_t row(0); row < count; row++) {
+		const T value(column[row] & mask);
+		selected |= static_cast<uint64_t>(low <= value && value <= high) << row;
+	}
+	return selected;
+}
+
+template <typename T>
+static void scanWordsScalar(const T* column, const size_t& words, const T& low, const T& high, const T& mask, uint64_t* bits)
+{
+	for (size_t word(0); word < words; word++)
+		bits[word] = scanWordScalar(column + word * 64, 64, low, high, mask);
+}
+
+/* AVX2 KERNELS, 32 ROWS PER CHUNK */
+
+#ifdef PACKET_TABLE_X86
+
+__attribute__((target("avx2")))
+static inline uint32_t chunk8(const uint8_t* rows, const __m256i& low, const __m256i& high, const __m256i& mask)
+{
+	const __m256i value(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows)), mask));
+	const __m256i inside(_mm256_and_si256(
+		_mm256_cmpeq_epi8(_mm256_max_epu8(value, low), value),
+		_mm256_cmpeq_epi8(_mm256_min_epu8(value, high), value)));
+	return _mm256_movemask_epi8(inside);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i inside16(const uint16_t* rows, const __m256i& low, const __m256i& high, const __m256i& mask)
+{
+	const __m256i value(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows)), mask));
+	return _mm256_and_si256(
+		_mm256_cmpeq_epi16(_mm256_max_epu16(value, low), value),
+		_mm256_cmpeq_epi16(_mm256_min_epu16(value, high), value));
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t chunk16(const uint16_t* rows, const __m256i& low, const __m256i& high, const __m256i& mask)
+{
+	// packing interleaves the 128-bit lanes, the permute puts rows back in order
+	const __m256i packed(_mm256_packs_epi16(inside16(rows, low, high, mask), inside16(rows + 16, low, high, mask)));
+	return _mm256_movemask_epi8(_mm256_permute4x64_epi64(packed, 0xD8));
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t chunk32(const uint32_t* rows, const __m256i& low, const __m256i& high, const __m256i& mask)
+{
+	uint32_t selected(0);
+
+	for (unsigned part(0); part < 4; part++) {
+		const __m256i value(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + part * 8)), mask));
+		const __m256i inside(_mm256_and_si256(
+			_mm256_cmpeq_epi32(_mm256_max_epu32(value, low), value),
+			_mm256_cmpeq_epi32(_mm256_min_epu32(value, high), value)));
+		selected |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(inside))) << (part * 8);
+	}
+	return selected;
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t chunk64(const uint64_t* rows, const __m256i& low, const __m256i& high, const __m256i& mask)
+{
+	// no unsigned 64-bit compare in AVX2: flip the sign bit and compare signed
+	const __m256i sign(_mm256_set1_epi64x(numeric_limits<int64_t>::min()));
+	const __m256i signedLow(_mm256_xor_si256(low, sign));
+	const __m256i signedHigh(_mm256_xor_si256(high, sign));
+	uint32_t selected(0);
+
+	for (unsigned part(0); part < 8; part++) {
+		const __m256i value(_mm256_xor_si256(_mm256_and_si256(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + part * 4)), mask), sign));
+		const __m256i outside(_mm256_or_si256(
+			_mm256_cmpgt_epi64(signedLow, value),
+			_mm256_cmpgt_epi64(value, signedHigh)));
+		selected |= static_cast<uint32_t>(~_mm256_movemask_pd(_mm256_castsi256_pd(outside)) & 0xF) << (part * 4);
+	}
+	return selected;
+}
+
+__attribute__((target("avx2")))
+static void scanWordsAvx2(const uint8_t* column, const size_t& words, const uint8_t& l, const uint8_t& h, const uint8_t& m, uint64_t* bits)
+{
+	const __m256i low(_mm256_set1_epi8(l)), high(_mm256_set1_epi8(h)), mask(_mm256_set1_epi8(m));
+	for (size_t word(0); word < words; word++)
+		bits[word] = chunk8(column + word * 64, low, high, mask)
+			| static_cast<uint64_t>(chunk8(column + word * 64 + 32, low, high, mask)) << 32;
+}
+
+__attribute__((target("avx2")))
+static void scanWordsAvx2(const uint16_t* column, const size_t& words, const uint16_t& l, const uint16_t& h, const uint16_t& m, uint64_t* bits)
+{
+	const __m256i low(_mm256_set1_epi16(l)), high(_mm256_set1_epi16(h)), mask(_mm256_set1_epi16(m));
+	for (size_t word(0); word < words; word++)
+		bits[word] = chunk16(column + word * 64, low, high, mask)
+			| static_cast<uint64_t>(chunk16(column + word * 64 + 32, low, high, mask)) << 32;
+}
+
+__attribute__((target("avx2")))
+static void scanWordsAvx2(const uint32_t* column, const size_t& words, const uint32_t& l, const uint32_t& h, const uint32_t& m, uint64_t* bits)
+{
+	const __m256i low(_mm256_set1_epi32(l)), high(_mm256_set1_epi32(h)), mask(_mm256_set1_epi32(m));
+	for (size_t word(0); word < words; word++)
+		bits[word] = chunk32(column + word * 64, low, high, mask)
+			| static_cast<uint64_t>(chunk32(column + word * 64 + 32, low, high, mask)) << 32;
+}
+
+__attribute__((target("avx2")))
+static void scanWordsAvx2(const uint64_t* column, const size_t& words, const uint64_t& l, const uint64_t& h, const uint64_t& m, uint64_t* bits)
+{
+	const __m256i low(_mm256_set1_epi64x(l)), high(_mm256_set1_epi64x(h)), mask(_mm256_set1_epi64x(m));
+	for (size_t word(0); word < words; word++)
+		bits[word] = chunk64(column + word * 64, low, high, mask)
+			| static_cast<uint64_t>(chunk64(column + word * 64 + 32, low, high, mask)) << 32;
+}
+
+static bool detectAvx2()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+static const bool hasAvx2(detectAvx2());
+
+#else
+
+static const bool hasAvx2(false);
+
+template <typename T>
+static void scanWordsAvx2(const T* column, const size_t& words, const T& low, const T& high, const T& mask, uint64_t* bits)
+{
+	scanWordsScalar(column, words, low, high, mask, bits);
+}
+
+#endif
+
+/* DISPATCH */
+
+template <typename T>
+static void scanColumn(const vector<T>& column, const uint64_t& low, const uint64_t& high, const uint64_t& mask, Selection& out)
+{
+	const uint64_t widest(numeric_limits<T>::max());
+	const size_t rows(column.size());
+	const size_t words(rows / 64);
+
+	out.resize(rows);
+	// nothing this narrow can reach the lower bound
+	if (low > widest || low > high)
+		return;
+
+	const T l(low), h(high < widest ? high : widest), m(mask);
+	uint64_t* bits(out.getWords());
+
+	if (hasAvx2)
+		scanWordsAvx2(column.data(), words, l, h, m, bits);
+	else
+		scanWordsScalar(column.data(), words, l, h, m, bits);
+
+	if (rows % 64)
+		bits[words] = scanWordScalar(column.data() + words * 64, rows % 64, l, h, m);
+}
+
+void PacketTable::scan(const PacketColumn& column, const uint64_t& low, const uint64_t& high, const uint64_t& mask, Selection& out) const
+{
+	switch (column) {
+	case COLUMN_TIMESTAMP:
+		scanColumn(timestamps, low, high, mask, out);
+		break;
+	case COLUMN_SOURCE_ADDRESS:
+		scanColumn(sourceAddresses, low, high, mask, out);
+		break;
+	case COLUMN_DESTINATION_ADDRESS:
+		scanColumn(destinationAddresses, low, high, mask, out);
+		break;
+	case COLUMN_SOURCE_PORT:
+		scanColumn(sourcePorts, low, high, mask, out);
+		break;
+	case COLUMN_DESTINATION_PORT:
+		scanColumn(destinationPorts, low, high, mask, out);
+		break;
+	case COLUMN_PROTOCOL:
+		scanColumn(protocols, low, high, mask, out);
+		break;
+	case COLUMN_TCP_FLAGS:
+		scanColumn(tcpFlags, low, high, mask, out);
+		break;
+	case COLUMN_LENGTH:
+		scanColumn(lengths, low, high, mask, out);
+		break;
+	}
+}
+
+void PacketTable::scanEqual(const PacketColumn& column, const uint64_t& value, Selection& out) const
+{
+	scan(column, value, value, ~uint64_t(0), out);
+}
+
+void PacketTable::scanRange(const PacketColumn& column, const uint64_t& low, const uint64_t& high, Selection& out) const
+{
+	scan(column, low, high, ~uint64_t(0), out);
+}
+
+void PacketTable::scanPrefix(const PacketColumn& column, const uint32_t& value, const unsigned& prefixLength, Selection& out) const
+{
+	const uint32_t mask(prefixLength == 0 ? 0 : prefixLength >= 32 ? ~uint32_t(0) : ~uint32_t(0) << (32 - prefixLength));
+	scan(column, value & mask, value & mask, mask, out);
+}
+
+void PacketTable::scanAllBits(const PacketColumn& column, const uint64_t& bits, Selection& out) const
+{
+	scan(column, bits, bits, bits, out);
+}
+
+const char* PacketTable::getImplementation() { return hasAvx2 ? "avx2" : "scalar"; }
+
+/* FILLING */
+
+void PacketTable::append(const PacketSummary* packets, const size_t& count)
+{
+	reserve(size() + count);
+
+	for (size_t i(0); i < count; i++) {
+		const PacketSummary& packet(packets[i]);
+		timestamps.push_back(packet.timestamp);
+		sourceAddresses.push_back(packet.sourceAddress);
+		destinationAddresses.push_back(packet.destinationAddress);
+		sourcePorts.push_back(packet.sourcePort);
+		destinationPorts.push_back(packet.destinationPort);
+		protocols.push_back(packet.layers & (PACKET_LAYER_IPV4 | PACKET_LAYER_IPV6) ? packet.protocol : 0);
+		tcpFlags.push_back(packet.tcpFlags);
+		lengths.push_back(packet.frameLength);
+	}
+}
+
+void PacketTable::reserve(const size_t& rows)
+{
+	// grow geometrically so batch appends stay amortized O(1)
+	if (rows <= timestamps.capacity())
+		return;
+
+	const size_t capacity(rows > timestamps.capacity() * 2 ? rows : timestamps.capacity() * 2);
+	timestamps.reserve(capacity);
+	sourceAddresses.reserve(capacity);
+	destinationAddresses.reserve(capacity);
+	sourcePorts.reserve(capacity);
+	destinationPorts.reserve(capacity);
+	protocols.reserve(capacity);
+	tcpFlags.reserve(capacity);
+	lengths.reserve(capacity);
+}
+
+void PacketTable::clear()
+{
+	timestamps.clear();
+	sourceAddresses.clear();
+	destinationAddresses.clear();
+	sourcePorts.clear();
+	destinationPorts.clear();
+	protocols.clear();
+	tcpFlags.clear();
+	lengths.clear();
+}
+
+size_t PacketTable::size() const { return timestamps.size(); }
+
+const uint64_t* PacketTable::getTimestamps() const { return timestamps.data(); }
+const uint32_t* PacketTable::getSourceAddresses() const { return sourceAddresses.data(); }
+const uint32_t* PacketTable::getDestinationAddresses() const { return destinationAddresses.data(); }
+const uint16_t* PacketTable::getSourcePorts() const { return sourcePorts.data(); }
+const uint16_t* PacketTable::getDestinationPorts() const { return destinationPorts.data(); }
+const uint8_t* PacketTable::getProtocols() const { return protocols.data(); }
+const uint8_t* PacketTable::getTcpFlags() const { return tcpFlags.data(); }
+const uint16_t* PacketTable::getLengths() const { return lengths.data(); }
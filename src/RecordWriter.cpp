@@ -0,0 +1,254 @@
+#include <RecordWriter.hpp>
+#include <ByteOrder.hpp>
+#include <EthernetView.hpp>
+#include <IpFrame.hpp>
+
+#include <cstring>
+
+using namespace std;
+
+// both IPv6 addresses follow the first 8 octets of the fixed header
+#define RECORD_IPV6_ADDRESSES_OFFSET 8
+
+static const char csvHeader[] = "ts,len,ethertype,vlan,ip,src,dst,proto,ttl,tos,ip_len,df,mf,frag,"
+	"sport,dport,flags,seq,ack,win,payload\n";
+
+/* FORMATS */
+
+bool RecordWriter::parseFormat(const string& name, OutputFormat& format)
+{
+	if (name == "text")
+		format = OUTPUT_FORMAT_TEXT;
+	else if (name == "json")
+		format = OUTPUT_FORMAT_JSON;
+	else if (name == "csv")
+		format = OUTPUT_FORMAT_CSV;
+	else if (name == "bin")
+		format = OUTPUT_FORMAT_BINARY;
+	else
+		return false;
+	return true;
+}
+
+const char* RecordWriter::getFormatAsString(const OutputFormat& format)
+{
+	switch (format) {
+	case OUTPUT_FORMAT_JSON:
+		return "json";
+	case OUTPUT_FORMAT_CSV:
+		return "csv";
+	case OUTPUT_FORMAT_BINARY:
+		return "bin";
+	default:
+		return "text";
+	}
+}
+
+void RecordWriter::writeHeader(OutputBuffer& out, const OutputFormat& format)
+{
+	if (format == OUTPUT_FORMAT_CSV) {
+		out.text(csvHeader, sizeof(csvHeader) - 1);
+	} else if (format == OUTPUT_FORMAT_BINARY) {
+		RecordStreamHeader header;
+
+		memset(&header, 0, sizeof(header));
+		header.magic = RECORD_STREAM_MAGIC;
+		header.version = RECORD_STREAM_VERSION;
+		header.headerLength = sizeof(RecordStreamHeader);
+		header.recordLength = sizeof(PacketRecord);
+		out.text(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+}
+
+void RecordWriter::write(OutputBuffer& out, const OutputFormat& format, const PacketSummary& summary, const char* frame)
+{
+	switch (format) {
+	case OUTPUT_FORMAT_JSON:
+		writeJson(out, summary, frame);
+		break;
+	case OUTPUT_FORMAT_CSV:
+		writeCsv(out, summary, frame);
+		break;
+	case OUTPUT_FORMAT_BINARY:
+		writeBinary(out, summary, frame);
+		break;
+	default:
+		break;
+	}
+}
+
+/* HELPERS */
+
+// records are encoded straight into the output, which first makes room for the longest one
+#define RECORD_MAX_TEXT_LENGTH 512
+
+template <size_t N>
+static inline char* put(char* at, const char (&text)[N])
+{
+	memcpy(at, text, N - 1);
+	return at + N - 1;
+}
+
+static inline char* putDecimal(char* at, const uint64_t& value)
+{
+	return at + formatDecimal(at, value);
+}
+
+static unsigned getVlanId(const PacketSummary& summary, const char* frame)
+{
+	if (!(summary.layers & PACKET_LAYER_VLAN))
+		return 0;
+	return load16(reinterpret_cast<const uint8_t*>(frame) + ETH_VIEW_HEADER_LENGTH) & 0xFFF;
+}
+
+static const uint8_t* getAddresses6(const PacketSummary& summary, const char* frame)
+{
+	return reinterpret_cast<const uint8_t*>(frame) + summary.ipOffset + RECORD_IPV6_ADDRESSES_OFFSET;
+}
+
+static inline char* putSource(char* at, const PacketSummary& summary, const char* frame)
+{
+	if (summary.layers & PACKET_LAYER_IPV4)
+		return at + formatIpv4(at, summary.sourceAddress);
+	return at + formatIpv6(at, getAddresses6(summary, frame));
+}
+
+static inline char* putDestination(char* at, const PacketSummary& summary, const char* frame)
+{
+	if (summary.layers & PACKET_LAYER_IPV4)
+		return at + formatIpv4(at, summary.destinationAddress);
+	return at + formatIpv6(at, getAddresses6(summary, frame) + PACKET_RECORD_ADDRESS_LENGTH);
+}
+
+/* RECORDS */
+
+// fields of layers the frame does not have are left out
+void RecordWriter::writeJson(OutputBuffer& out, const PacketSummary& summary, const char* frame)
+{
+	char* const start(out.reserve(RECORD_MAX_TEXT_LENGTH));
+	char* at(start);
+
+	at = putDecimal(put(at, "{\"ts\":"), summary.timestamp);
+	at = putDecimal(put(at, ",\"len\":"), summary.frameLength);
+	at = putDecimal(put(at, ",\"ethertype\":"), summary.ethertype);
+	if (summary.layers & PACKET_LAYER_VLAN)
+		at = putDecimal(put(at, ",\"vlan\":"), getVlanId(summary, frame));
+
+	if (summary.layers & (PACKET_LAYER_IPV4 | PACKET_LAYER_IPV6)) {
+		at = summary.layers & PACKET_LAYER_IPV4 ? put(at, ",\"ip\":4,\"src\":\"") : put(at, ",\"ip\":6,\"src\":\"");
+		at = putSource(at, summary, frame);
+		at = putDestination(put(at, "\",\"dst\":\""), summary, frame);
+		at = putDecimal(put(at, "\",\"proto\":"), summary.protocol);
+		at = putDecimal(put(at, ",\"ttl\":"), summary.ttl);
+		at = putDecimal(put(at, ",\"tos\":"), summary.service);
+		at = putDecimal(put(at, ",\"ip_len\":"), summary.ipTotalLength);
+		at = put(at, ",\"df\":");
+		*at++ = summary.ipFlags & PACKET_IP_DF ? '1' : '0';
+		at = put(at, ",\"mf\":");
+		*at++ = summary.ipFlags & PACKET_IP_MF ? '1' : '0';
+		at = putDecimal(put(at, ",\"frag\":"), summary.fragmentOffset);
+	}
+	if (summary.layers & (PACKET_LAYER_TCP | PACKET_LAYER_UDP)) {
+		at = putDecimal(put(at, ",\"sport\":"), summary.sourcePort);
+		at = putDecimal(put(at, ",\"dport\":"), summary.destinationPort);
+	}
+	if (summary.layers & PACKET_LAYER_TCP) {
+		at = putDecimal(put(at, ",\"flags\":"), summary.tcpFlags);
+		at = putDecimal(put(at, ",\"seq\":"), summary.sequenceNumber);
+		at = putDecimal(put(at, ",\"ack\":"), summary.acknowledgementNumber);
+		at = putDecimal(put(at, ",\"win\":"), summary.window);
+	}
+	if (summary.layers & (PACKET_LAYER_IPV4 | PACKET_LAYER_IPV6))
+		at = putDecimal(put(at, ",\"payload\":"), summary.payloadLength);
+	at = put(at, "}\n");
+
+	out.advance(at - start);
+}
+
+// every row has every column, empty where the frame has no such layer
+void RecordWriter::writeCsv(OutputBuffer& out, const PacketSummary& summary, const char* frame)
+{
+	const bool ip(summary.layers & (PACKET_LAYER_IPV4 | PACKET_LAYER_IPV6));
+	char* const start(out.reserve(RECORD_MAX_TEXT_LENGTH));
+	char* at(start);
+
+	at = putDecimal(at, summary.timestamp);
+	*at++ = ',';
+	at = putDecimal(at, summary.frameLength);
+	*at++ = ',';
+	at = putDecimal(at, summary.ethertype);
+	*at++ = ',';
+	if (summary.layers & PACKET_LAYER_VLAN)
+		at = putDecimal(at, getVlanId(summary, frame));
+	*at++ = ',';
+
+	if (ip) {
+		*at++ = summary.layers & PACKET_LAYER_IPV4 ? '4' : '6';
+		*at++ = ',';
+		at = putSource(at, summary, frame);
+		*at++ = ',';
+		at = putDestination(at, summary, frame);
+		*at++ = ',';
+		at = putDecimal(at, summary.protocol);
+		*at++ = ',';
+		at = putDecimal(at, summary.ttl);
+		*at++ = ',';
+		at = putDecimal(at, summary.service);
+		*at++ = ',';
+		at = putDecimal(at, summary.ipTotalLength);
+		*at++ = ',';
+		*at++ = summary.ipFlags & PACKET_IP_DF ? '1' : '0';
+		*at++ = ',';
+		*at++ = summary.ipFlags & PACKET_IP_MF ? '1' : '0';
+		*at++ = ',';
+		at = putDecimal(at, summary.fragmentOffset);
+		*at++ = ',';
+	} else {
+		at = put(at, ",,,,,,,,,,");
+	}
+
+	if (summary.layers & (PACKET_LAYER_TCP | PACKET_LAYER_UDP)) {
+		at = putDecimal(at, summary.sourcePort);
+		*at++ = ',';
+		at = putDecimal(at, summary.destinationPort);
+		*at++ = ',';
+	} else {
+		at = put(at, ",,");
+	}
+
+	if (summary.layers & PACKET_LAYER_TCP) {
+		at = putDecimal(at, summary.tcpFlags);
+		*at++ = ',';
+		at = putDecimal(at, summary.sequenceNumber);
+		*at++ = ',';
+		at = putDecimal(at, summary.acknowledgementNumber);
+		*at++ = ',';
+		at = putDecimal(at, summary.window);
+		*at++ = ',';
+	} else {
+		at = put(at, ",,,,");
+	}
+
+	if (ip)
+		at = putDecimal(at, summary.payloadLength);
+	*at++ = '\n';
+
+	out.advance(at - start);
+}
+
+void RecordWriter::writeBinary(OutputBuffer& out, const PacketSummary& summary, const char* frame)
+{
+	PacketRecord record;
+
+	memset(&record, 0, offsetof(PacketRecord, summary));
+	record.length = sizeof(PacketRecord);
+	record.vlanId = getVlanId(summary, frame);
+	if (summary.layers & PACKET_LAYER_IPV6) {
+		const uint8_t* addresses(getAddresses6(summary, frame));
+		memcpy(record.sourceAddress6, addresses, PACKET_RECORD_ADDRESS_LENGTH);
+		memcpy(record.destinationAddress6, addresses + PACKET_RECORD_ADDRESS_LENGTH, PACKET_RECORD_ADDRESS_LENGTH);
+	}
+	record.summary = summary;
+
+	out.text(reinterpret_cast<const char*>(&record), sizeof(record));
+}
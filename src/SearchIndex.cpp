@@ -0,0 +1,259 @@
+#include <SearchIndex.hpp>
+#include <PacketSummary.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+SearchIndex::SearchIndex()
+	: data(nullptr), length(0), mapping(nullptr), header(nullptr), checkpoints(nullptr), addresses(nullptr),
+	ports(nullptr), bitmaps(nullptr)
+{
+}
+
+SearchIndex::~SearchIndex()
+{
+	unmap();
+}
+
+/* BUILDING */
+
+bool SearchIndex::build(const char* bytes, const uint64_t& captureSize, const int64_t& captureModified)
+{
+	CaptureFormat format;
+	CaptureRecord record;
+	PacketSummary summary;
+	vector<SearchCheckpoint> marks;
+	unordered_map<uint32_t, FrameBitmap> addressFrames;
+	vector<FrameBitmap> portFrames(0x10000);
+	uint32_t frame(0);
+
+	unmap();
+	image.clear();
+
+	const unsigned detected(captureSize < CAPTURE_DETECT_LENGTH ? captureSize : CAPTURE_DETECT_LENGTH);
+	// a raw frame has nothing worth indexing
+	if (!format.detect(bytes, detected) || format.getType() == CAPTURE_TYPE_RAW)
+		return false;
+
+	const unsigned headerLength(format.getRecordHeaderLength());
+	uint64_t position(format.getFileHeaderLength());
+
+	while (position + headerLength <= captureSize && frame < UINT32_MAX) {
+		const unsigned recordLength(format.getRecordLength(bytes + position));
+		if (recordLength < headerLength || position + recordLength > captureSize)
+			break;
+
+		if (format.parseRecord(bytes + position, recordLength, record)) {
+			if (frame % SEARCH_INDEX_STRIDE == 0) {
+				marks.push_back({ position, record.timestamp, record.timestamp });
+			} else {
+				SearchCheckpoint& mark(marks.back());
+				mark.minimumTimestamp = min(mark.minimumTimestamp, record.timestamp);
+				mark.maximumTimestamp = max(mark.maximumTimestamp, record.timestamp);
+			}
+
+			if (record.linkType == LINKTYPE_ETHERNET && summary.fromBytes(record.data, record.capturedLength, record.timestamp)) {
+				if (summary.layers & PACKET_LAYER_IPV4) {
+					addressFrames[summary.sourceAddress].add(frame);
+					addressFrames[summary.destinationAddress].add(frame);
+				}
+				if (summary.layers & (PACKET_LAYER_TCP | PACKET_LAYER_UDP)) {
+					portFrames[summary.sourcePort].add(frame);
+					portFrames[summary.destinationPort].add(frame);
+				}
+			}
+			frame++;
+		}
+		position += recordLength;
+	}
+
+	vector<uint32_t> addressValues;
+	addressValues.reserve(addressFrames.size());
+	for (const auto& entry : addressFrames)
+		addressValues.push_back(entry.first);
+	sort(addressValues.begin(), addressValues.end());
+
+	vector<uint32_t> portValues;
+	for (uint32_t port(0); port < portFrames.size(); port++) {
+		if (!portFrames[port].empty())
+			portValues.push_back(port);
+	}
+
+	Header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, SEARCH_INDEX_MAGIC, sizeof(h.magic));
+	h.captureSize = captureSize;
+	h.captureModified = captureModified;
+	h.captureType = format.getType();
+	h.stride = SEARCH_INDEX_STRIDE;
+	h.frames = frame;
+	h.checkpoints = marks.size();
+	h.addresses = addressValues.size();
+	h.ports = portValues.size();
+
+	// keys first, bitmaps after them, so each key can be given its offset as its bitmap goes in
+	const size_t keysStart(sizeof(Header) + marks.size() * sizeof(SearchCheckpoint));
+	const size_t bitmapsStart(keysStart + (addressValues.size() + portValues.size()) * sizeof(Key));
+	image.resize(bitmapsStart);
+	memcpy(image.data(), &h, sizeof(h));
+	memcpy(image.data() + sizeof(Header), marks.data(), marks.size() * sizeof(SearchCheckpoint));
+
+	size_t keyPosition(keysStart);
+	auto append = [&](const uint32_t& value, const FrameBitmap& frames) {
+		const size_t start(image.size());
+		frames.serialize(image);
+
+		const Key key = { value, static_cast<uint32_t>(image.size() - start), start - bitmapsStart };
+		memcpy(image.data() + keyPosition, &key, sizeof(key));
+		keyPosition += sizeof(key);
+	};
+	for (const uint32_t& address : addressValues)
+		append(address, addressFrames[address]);
+	for (const uint32_t& port : portValues)
+		append(port, portFrames[port]);
+
+	h.bitmapLength = image.size() - bitmapsStart;
+	memcpy(image.data(), &h, sizeof(h));
+
+	return attach(image.data(), image.size());
+}
+
+/* PERSISTENCE */
+
+bool SearchIndex::load(const string& filename, const uint64_t& captureSize, const int64_t& captureModified)
+{
+	unmap();
+	image.clear();
+
+	const int fd(open(filename.c_str(), O_RDONLY));
+	if (fd < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(fd, &status) != 0 || static_cast<uint64_t>(status.st_size) < sizeof(Header)) {
+		close(fd);
+		return false;
+	}
+
+	void* mapped(mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+	close(fd);
+	if (mapped == MAP_FAILED)
+		return false;
+
+	mapping = mapped;
+	length = status.st_size;
+	if (!attach(static_cast<const uint8_t*>(mapped), status.st_size) || header->captureSize != captureSize
+			|| header->captureModified != captureModified) {
+		unmap();
+		return false;
+	}
+	// lookups jump around the keys and bitmaps
+	madvise(mapped, status.st_size, MADV_RANDOM);
+	return true;
+}
+
+bool SearchIndex::save(const string& filename) const
+{
+	if (image.empty())
+		return false;
+
+	const string temporary(filename + ".tmp");
+	FILE* file(fopen(temporary.c_str(), "wb"));
+	if (!file)
+		return false;
+
+	bool saved(fwrite(image.data(), image.size(), 1, file) == 1);
+	saved = fclose(file) == 0 && saved;
+
+	if (!saved || rename(temporary.c_str(), filename.c_str()) != 0) {
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+/* LOOKUPS */
+
+bool SearchIndex::findAddress(const uint32_t& address, FrameBitmap& frames) const
+{
+	return header && find(addresses, header->addresses, address, frames);
+}
+
+bool SearchIndex::findPort(const uint16_t& port, FrameBitmap& frames) const
+{
+	return header && find(ports, header->ports, port, frames);
+}
+
+bool SearchIndex::find(const Key* keys, const uint64_t& count, const uint32_t& value, FrameBitmap& frames) const
+{
+	const Key* key(lower_bound(keys, keys + count, value, [](const Key& k, const uint32_t& v) { return k.value < v; }));
+
+	frames.clear();
+	if (key == keys + count || key->value != value)
+		return false;
+	return frames.deserialize(bitmaps + key->offset, key->length);
+}
+
+/* HELPERS */
+
+bool SearchIndex::attach(const uint8_t* bytes, const uint64_t& total)
+{
+	const Header* h(reinterpret_cast<const Header*>(bytes));
+
+	if (total < sizeof(Header) || memcmp(h->magic, SEARCH_INDEX_MAGIC, sizeof(h->magic)) != 0
+			|| h->stride != SEARCH_INDEX_STRIDE || h->checkpoints != (h->frames + SEARCH_INDEX_STRIDE - 1) / SEARCH_INDEX_STRIDE)
+		return false;
+
+	const uint64_t keysStart(sizeof(Header) + h->checkpoints * sizeof(SearchCheckpoint));
+	const uint64_t bitmapsStart(keysStart + (h->addresses + h->ports) * sizeof(Key));
+	if (h->addresses > 0xFFFFFFFFULL || h->ports > 0x10000 || bitmapsStart + h->bitmapLength != total)
+		return false;
+
+	data = bytes;
+	length = total;
+	header = h;
+	checkpoints = reinterpret_cast<const SearchCheckpoint*>(bytes + sizeof(Header));
+	addresses = reinterpret_cast<const Key*>(bytes + keysStart);
+	ports = addresses + h->addresses;
+	bitmaps = bytes + bitmapsStart;
+
+	// a key pointing outside the bitmaps would send a lookup outside the file
+	for (const Key* key(addresses); key < ports + h->ports; key++) {
+		if (key->offset + key->length > h->bitmapLength) {
+			header = nullptr;
+			return false;
+		}
+	}
+	return true;
+}
+
+void SearchIndex::unmap()
+{
+	if (mapping)
+		munmap(mapping, length);
+	mapping = nullptr;
+	data = nullptr;
+	length = 0;
+	header = nullptr;
+}
+
+/* ACCESS */
+
+uint64_t SearchIndex::getFrames() const { return header ? header->frames : 0; }
+uint64_t SearchIndex::getCheckpointCount() const { return header ? header->checkpoints : 0; }
+const SearchCheckpoint& SearchIndex::getCheckpoint(const uint64_t& i) const { return checkpoints[i]; }
+uint64_t SearchIndex::getAddressCount() const { return header ? header->addresses : 0; }
+uint64_t SearchIndex::getPortCount() const { return header ? header->ports : 0; }
+uint64_t SearchIndex::getLength() const { return length; }
+CaptureType SearchIndex::getType() const { return header ? static_cast<CaptureType>(header->captureType) : CAPTURE_TYPE_UNKNOWN; }
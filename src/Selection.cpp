@@ -0,0 +1,49 @@
+#include <Selection.hpp>
+
+using namespace std;
+
+Selection::Selection() : rows(0) {}
+
+void Selection::resize(const size_t& r)
+{
+	rows = r;
+	words.assign((r + 63) / 64, 0);
+}
+
+void Selection::intersect(const Selection& other)
+{
+	for (size_t i(0); i < words.size() && i < other.words.size(); i++)
+		words[i] &= other.words[i];
+}
+
+void Selection::unite(const Selection& other)
+{
+	for (size_t i(0); i < words.size() && i < other.words.size(); i++)
+		words[i] |= other.words[i];
+}
+
+void Selection::invert()
+{
+	for (uint64_t& word : words)
+		word = ~word;
+	// rows past the end must stay unselected
+	if (rows % 64)
+		words.back() &= (uint64_t(1) << (rows % 64)) - 1;
+}
+
+size_t Selection::count() const
+{
+	size_t total(0);
+	for (const uint64_t& word : words)
+		total += __builtin_popcountll(word);
+	return total;
+}
+
+bool Selection::test(const size_t& row) const
+{
+	return words[row / 64] >> (row % 64) & 1;
+}
+
+size_t Selection::size() const { return rows; }
+uint64_t* Selection::getWords() { return words.data(); }
+const uint64_t* Selection::getWords() const { return words.data(); }
@@ -0,0 +1,230 @@
+#include <SpaceSaving.hpp>
+
+#include <algorithm>
+
+using namespace std;
+
+#define HEAP_ARITY 4
+
+static inline uint64_t toSlot(const uint64_t& hash, const uint32_t& entry)
+{
+	return hash << 32 | (entry + 1);
+}
+
+static inline uint32_t getEntry(const uint64_t& slot)
+{
+	return static_cast<uint32_t>(slot) - 1;
+}
+
+SpaceSaving::SpaceSaving(const unsigned& c)
+	: capacity(c ? c : 1), total(0)
+{
+	size_t slotCount(1);
+	// at most half full, so probes stay short
+	while (slotCount < 2 * static_cast<size_t>(capacity))
+		slotCount <<= 1;
+
+	entries.reserve(capacity);
+	heap.reserve(capacity);
+	positions.reserve(capacity);
+	slots.assign(slotCount, 0);
+}
+
+/* UPDATES */
+
+void SpaceSaving::add(const SketchKey& key, const uint64_t& hash, const uint64_t& weight, const uint64_t& bound)
+{
+	const uint32_t slot(find(key, hash));
+
+	total += weight;
+	if (slots[slot]) {
+		const uint32_t entry(getEntry(slots[slot]));
+		const uint32_t at(positions[entry]);
+		entries[entry].count += weight;
+		heap[at].count += weight;
+		siftDown(at);
+		return;
+	}
+
+	if (entries.size() < capacity) {
+		const uint32_t entry(entries.size());
+		entries.push_back({key, hash, weight, 0});
+		heap.push_back({weight, entry});
+		positions.push_back(entry);
+		siftUp(entry);
+		slots[slot] = toSlot(hash, entry);
+		return;
+	}
+
+	// a key known to weigh no more than the lightest tracked one would only take its place to be evicted again
+	const uint64_t minimum(heap[0].count);
+	if (bound <= minimum)
+		return;
+
+	// the lightest key gives its counter up; all that is sure of the newcomer is this update
+	const uint32_t entry(heap[0].entry);
+	const uint64_t count(min(minimum + weight, bound));
+	eraseSlot(entry);
+	entries[entry] = {key, hash, count, count - weight};
+	heap[0].count = count;
+	siftDown(0);
+	slots[find(key, hash)] = toSlot(hash, entry);
+}
+
+void SpaceSaving::merge(const SpaceSaving& other)
+{
+	const uint64_t ours(getMinimum());
+	const uint64_t theirs(other.getMinimum());
+	vector<SpaceSavingEntry> merged;
+
+	merged.reserve(entries.size() + other.entries.size());
+	for (const SpaceSavingEntry& entry : entries) {
+		const uint64_t slot(other.slots[other.find(entry.key, entry.hash)]);
+		if (slot) {
+			const SpaceSavingEntry& match(other.entries[getEntry(slot)]);
+			merged.push_back({entry.key, entry.hash, entry.count + match.count, entry.error + match.error});
+		} else {
+			merged.push_back({entry.key, entry.hash, entry.count + theirs, entry.error + theirs});
+		}
+	}
+	for (const SpaceSavingEntry& entry : other.entries) {
+		if (!slots[find(entry.key, entry.hash)])
+			merged.push_back({entry.key, entry.hash, entry.count + ours, entry.error + ours});
+	}
+
+	if (merged.size() > capacity) {
+		nth_element(merged.begin(), merged.begin() + capacity, merged.end(),
+			[](const SpaceSavingEntry& a, const SpaceSavingEntry& b) { return a.count > b.count; });
+		merged.resize(capacity);
+	}
+	entries.swap(merged);
+	total += other.total;
+	rebuild();
+}
+
+void SpaceSaving::clear()
+{
+	entries.clear();
+	heap.clear();
+	positions.clear();
+	fill(slots.begin(), slots.end(), 0);
+	total = 0;
+}
+
+/* ACCESS */
+
+uint64_t SpaceSaving::getMinimum() const
+{
+	return entries.size() < capacity ? 0 : heap[0].count;
+}
+
+uint64_t SpaceSaving::getTotal() const { return total; }
+unsigned SpaceSaving::getCapacity() const { return capacity; }
+
+void SpaceSaving::getTop(const unsigned& count, vector<SpaceSavingEntry>& top) const
+{
+	const auto heavier([](const SpaceSavingEntry& a, const SpaceSavingEntry& b) { return a.count > b.count; });
+
+	top.assign(entries.begin(), entries.end());
+	if (top.size() > count) {
+		partial_sort(top.begin(), top.begin() + count, top.end(), heavier);
+		top.resize(count);
+	} else {
+		sort(top.begin(), top.end(), heavier);
+	}
+}
+
+/* TABLE */
+
+// the slot holding the key, or the free slot where it would go
+uint32_t SpaceSaving::find(const SketchKey& key, const uint64_t& hash) const
+{
+	const uint32_t mask(slots.size() - 1);
+
+	for (uint32_t slot(hash & mask);; slot = (slot + 1) & mask) {
+		if (!slots[slot])
+			return slot;
+		if (static_cast<uint32_t>(slots[slot] >> 32) == static_cast<uint32_t>(hash)
+			&& entries[getEntry(slots[slot])].key == key)
+			return slot;
+	}
+}
+
+// backward shift deletion, so no tombstones pile up as keys come and go
+void SpaceSaving::eraseSlot(const uint32_t& entry)
+{
+	const uint32_t mask(slots.size() - 1);
+	uint32_t hole(find(entries[entry].key, entries[entry].hash));
+
+	for (uint32_t slot((hole + 1) & mask); slots[slot]; slot = (slot + 1) & mask) {
+		const uint32_t home((slots[slot] >> 32) & mask);
+		// a key may move back into the hole unless its home lies cyclically in (hole, slot]
+		if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+			slots[hole] = slots[slot];
+			hole = slot;
+		}
+	}
+	slots[hole] = 0;
+}
+
+void SpaceSaving::rebuild()
+{
+	heap.resize(entries.size());
+	positions.resize(entries.size());
+	fill(slots.begin(), slots.end(), 0);
+
+	for (uint32_t entry(0); entry < entries.size(); entry++) {
+		heap[entry] = {entries[entry].count, entry};
+		positions[entry] = entry;
+		slots[find(entries[entry].key, entries[entry].hash)] = toSlot(entries[entry].hash, entry);
+	}
+	for (unsigned i(heap.size()); i-- > 0;)
+		siftDown(i);
+}
+
+/* HEAP */
+
+void SpaceSaving::siftUp(unsigned at)
+{
+	const HeapNode node(heap[at]);
+
+	while (at) {
+		const unsigned parent((at - 1) / HEAP_ARITY);
+		if (heap[parent].count <= node.count)
+			break;
+		heap[at] = heap[parent];
+		positions[heap[at].entry] = at;
+		at = parent;
+	}
+	heap[at] = node;
+	positions[node.entry] = at;
+}
+
+void SpaceSaving::siftDown(unsigned at)
+{
+	const HeapNode node(heap[at]);
+	const unsigned size(heap.size());
+
+	for (;;) {
+		const unsigned first(HEAP_ARITY * at + 1);
+		if (first >= size)
+			break;
+
+		// counts near the minimum are all alike, so the smallest child is picked without branches
+		const unsigned last(min(first + HEAP_ARITY, size));
+		unsigned child(first);
+		uint64_t smallest(heap[first].count);
+		for (unsigned c(first + 1); c < last; c++) {
+			const bool smaller(heap[c].count < smallest);
+			child = smaller ? c : child;
+			smallest = smaller ? heap[c].count : smallest;
+		}
+		if (smallest >= node.count)
+			break;
+		heap[at] = heap[child];
+		positions[heap[at].entry] = at;
+		at = child;
+	}
+	heap[at] = node;
+	positions[node.entry] = at;
+}
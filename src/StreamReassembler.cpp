@@ -0,0 +1,283 @@
+#include <StreamReassembler.hpp>
+#include <TcpFrame.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// sequence numbers wrap, so they are compared by their signed distance
+static bool before(const uint32_t& a, const uint32_t& b)
+{
+	return static_cast<int32_t>(a - b) < 0;
+}
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+StreamReassembler::StreamReassembler(const unsigned& flows, const unsigned& flowBytes, const uint64_t& maxBytes)
+	: streams(nullptr), chunks(nullptr), flowCount(flows), chunkCount(maxBytes / sizeof(Chunk)), usedChunks(0),
+	freeChunks(STREAM_NONE), maxFlowBytes(flowBytes), overlapped(0), dropped(0), bufferedBytes(0)
+{
+	static_assert(sizeof(Chunk) == STREAM_CHUNK_LENGTH, "Chunk must be exactly STREAM_CHUNK_LENGTH octets");
+
+	// like the flow pool, pages are only backed once used
+	streams = static_cast<Stream*>(calloc(static_cast<size_t>(flowCount) * 2, sizeof(Stream)));
+	chunks = static_cast<Chunk*>(malloc(static_cast<size_t>(chunkCount) * sizeof(Chunk)));
+	if (!streams)
+		return;
+
+	for (uint64_t i(0); i < static_cast<uint64_t>(flowCount) * 2; i++)
+		streams[i].head = STREAM_NONE;
+}
+
+StreamReassembler::~StreamReassembler()
+{
+	free(streams);
+	free(chunks);
+}
+
+bool StreamReassembler::isOk() const
+{
+	return streams && (chunks || chunkCount == 0);
+}
+
+/* SEGMENTS */
+
+void StreamReassembler::segment(const uint32_t& flow, const int& side, const uint32_t& sequence,
+	const uint8_t& flags, const char* payload, const unsigned& length)
+{
+	if (!isOk() || flow >= flowCount)
+		return;
+
+	Stream& stream(streams[flow * 2 + side]);
+	uint32_t start(sequence);
+
+	// the SYN takes up one sequence number before the first data octet
+	if (flags & TCP_FLAG_SYN)
+		start++;
+	if (!stream.started) {
+		stream.next = start;
+		stream.started = 1;
+	}
+
+	if (length)
+		place(flow, side, stream, start, payload, length);
+}
+
+void StreamReassembler::place(const uint32_t& flow, const int& side, Stream& stream, uint32_t start,
+	const char* payload, unsigned length)
+{
+	for (;;) {
+		if (!before(stream.next, start)) {
+			const uint32_t behind(stream.next - start);
+			if (behind >= length) {
+				overlapped += length;
+				return;
+			}
+
+			overlapped += behind;
+			start += behind;
+			payload += behind;
+			length -= behind;
+
+			// what is buffered came first, so the segment only fills the hole in front of it
+			unsigned piece(length);
+			if (stream.head != STREAM_NONE && before(chunks[stream.head].sequence, start + length))
+				piece = chunks[stream.head].sequence - start;
+
+			deliver(flow, side, stream, payload, piece);
+			drain(flow, side, stream);
+			if (piece == length)
+				return;
+
+			start += piece;
+			payload += piece;
+			length -= piece;
+			continue;
+		}
+
+		if (fits(stream, length)) {
+			insert(stream, start, payload, length);
+			return;
+		}
+
+		if (stream.head == STREAM_NONE) {
+			dropped += length;
+			return;
+		}
+
+		// no room to wait any longer: give up on the hole and hand over what is buffered
+		stream.skipped += chunks[stream.head].sequence - stream.next;
+		stream.next = chunks[stream.head].sequence;
+		drain(flow, side, stream);
+	}
+}
+
+void StreamReassembler::deliver(const uint32_t& flow, const int& side, Stream& stream, const char* data,
+	const unsigned& length)
+{
+	if (onData)
+		onData(flow, side, data, length);
+	stream.next += length;
+	stream.delivered += length;
+}
+
+void StreamReassembler::drain(const uint32_t& flow, const int& side, Stream& stream)
+{
+	while (stream.head != STREAM_NONE && !before(stream.next, chunks[stream.head].sequence)) {
+		const uint32_t index(stream.head);
+		const Chunk& chunk(chunks[index]);
+		const uint32_t behind(stream.next - chunk.sequence);
+
+		if (behind < chunk.length)
+			deliver(flow, side, stream, chunk.data + behind, chunk.length - behind);
+
+		stream.head = chunk.next;
+		stream.buffered -= chunk.length;
+		freeChunk(index);
+	}
+}
+
+/* BUFFERING */
+
+bool StreamReassembler::fits(const Stream& stream, const unsigned& length) const
+{
+	const uint64_t pieces(length / sizeof(Chunk::data) + 2);
+	return stream.buffered + length <= maxFlowBytes && usedChunks + pieces <= chunkCount;
+}
+
+void StreamReassembler::insert(Stream& stream, const uint32_t& start, const char* payload, const unsigned& length)
+{
+	const uint32_t end(start + length);
+	const uint32_t held(stream.buffered);
+	uint32_t at(start);
+	uint32_t covered(0);
+	uint32_t* link(&stream.head);
+
+	// walk the sorted list, filling only what no earlier segment already covers
+	while (link && *link != STREAM_NONE && before(at, end)) {
+		const Chunk& chunk(chunks[*link]);
+		const uint32_t chunkEnd(chunk.sequence + chunk.length);
+
+		if (!before(at, chunkEnd)) {
+			link = &chunks[*link].next;
+			continue;
+		}
+		if (!before(chunk.sequence, end))
+			break;
+
+		if (before(at, chunk.sequence)) {
+			link = insertPieces(stream, link, at, payload + (at - start), chunk.sequence - at);
+			if (!link)
+				break;
+			at = chunk.sequence;
+		}
+
+		const uint32_t overlapEnd(before(chunkEnd, end) ? chunkEnd : end);
+		covered += overlapEnd - at;
+		at = overlapEnd;
+		link = &chunks[*link].next;
+	}
+
+	if (link && before(at, end))
+		insertPieces(stream, link, at, payload + (at - start), end - at);
+
+	overlapped += covered;
+	dropped += length - covered - (stream.buffered - held);
+}
+
+uint32_t* StreamReassembler::insertPieces(Stream& stream, uint32_t* link, uint32_t sequence, const char* data,
+	unsigned length)
+{
+	while (length) {
+		const uint32_t index(allocate());
+		if (index == STREAM_NONE)
+			return nullptr;
+
+		Chunk& chunk(chunks[index]);
+		const unsigned piece(length < sizeof(chunk.data) ? length : sizeof(chunk.data));
+
+		memcpy(chunk.data, data, piece);
+		chunk.sequence = sequence;
+		chunk.length = piece;
+		chunk.next = *link;
+		*link = index;
+		link = &chunk.next;
+
+		stream.buffered += piece;
+		sequence += piece;
+		data += piece;
+		length -= piece;
+	}
+	return link;
+}
+
+/* CHUNK POOL */
+
+uint32_t StreamReassembler::allocate()
+{
+	uint32_t index(STREAM_NONE);
+
+	if (freeChunks != STREAM_NONE) {
+		index = freeChunks;
+		freeChunks = chunks[index].next;
+	} else if (usedChunks < chunkCount) {
+		// never handed out before, so the free list is empty and this is the high water mark
+		index = usedChunks;
+	}
+
+	if (index != STREAM_NONE) {
+		usedChunks++;
+		bufferedBytes += sizeof(Chunk);
+	}
+	return index;
+}
+
+void StreamReassembler::freeChunk(const uint32_t& index)
+{
+	chunks[index].next = freeChunks;
+	freeChunks = index;
+	usedChunks--;
+	bufferedBytes -= sizeof(Chunk);
+}
+
+void StreamReassembler::release(const uint32_t& flow)
+{
+	if (!isOk() || flow >= flowCount)
+		return;
+
+	for (int side(0); side < 2; side++) {
+		Stream& stream(streams[flow * 2 + side]);
+
+		while (stream.head != STREAM_NONE) {
+			const uint32_t index(stream.head);
+			stream.head = chunks[index].next;
+			freeChunk(index);
+		}
+		memset(&stream, 0, sizeof(stream));
+		stream.head = STREAM_NONE;
+	}
+}
+
+/* ACCESSORS */
+
+void StreamReassembler::setCallback(const StreamCallback& callback) { onData = callback; }
+
+uint64_t StreamReassembler::getDelivered(const uint32_t& flow, const int& side) const
+{
+	return flow < flowCount ? streams[flow * 2 + side].delivered : 0;
+}
+
+uint64_t StreamReassembler::getSkipped(const uint32_t& flow, const int& side) const
+{
+	return flow < flowCount ? streams[flow * 2 + side].skipped : 0;
+}
+
+uint64_t StreamReassembler::getBuffered() const { return bufferedBytes; }
+uint64_t StreamReassembler::getOverlapped() const { return overlapped; }
+uint64_t StreamReassembler::getDropped() const { return dropped; }
+
+uint64_t StreamReassembler::getMemoryUsage() const
+{
+	return static_cast<uint64_t>(flowCount) * 2 * sizeof(Stream) + static_cast<uint64_t>(chunkCount) * sizeof(Chunk);
+}
@@ -1,21 +1,25 @@
-#include <sstream>
-#include <iomanip>
 #include <TcpFrame.hpp>
+#include <TcpView.hpp>
+#include <Checksum.hpp>
+#include <TextFormat.hpp>
 
 using namespace std;
 
 void TcpFrame::fromBytes(const char* frameBytes)
 {
-	setSourcePort(frameBytes[0] * 0x100 + frameBytes[1]);
-	setDestinationPort(frameBytes[2] * 0x100 + frameBytes[3]);
-	setSequenceNumber(frameBytes[4] * 0x1000000 + frameBytes[5] * 0x10000 + frameBytes[6] * 0x100 + frameBytes[7]);
-	setAcknowledgementNumber(frameBytes[8] * 0x1000000 + frameBytes[9] * 0x10000 + frameBytes[10] * 0x100 + frameBytes[11]);
-	setDataOffset(frameBytes[12] >> 4);
-	setFlags(frameBytes[13] & 0b111111);
-	setWindow(frameBytes[14] * 0x100 + frameBytes[15]);
-	setCheckSum(frameBytes[16] * 0x100 + frameBytes[17]);
-	setUrgentPointer(frameBytes[18] * 0x100 + frameBytes[19]);
-	calculateCheckSum();
+	const TcpView view(frameBytes, TCP_MIN_HEADER_LENGTH);
+
+	setSourcePort(view.getSourcePort());
+	setDestinationPort(view.getDestinationPort());
+	setSequenceNumber(view.getSequenceNumber());
+	setAcknowledgementNumber(view.getAcknowledgementNumber());
+	setDataOffset(view.getDataOffset());
+	setFlags(view.getFlags());
+	setWindow(view.getWindow());
+	setCheckSum(view.getCheckSum());
+	setUrgentPointer(view.getUrgentPointer());
+	calculatedCheckSum = 0;
+	checkSumVerifiable = 0;
 }
 
 TcpFrame::TcpFrame(const char* frameBytes)
@@ -23,6 +27,19 @@ TcpFrame::TcpFrame(const char* frameBytes)
 	fromBytes(frameBytes);
 }
 
+TcpFrame::TcpFrame(const char* segment, const unsigned& length, const unsigned& pseudoHeader)
+	: TcpFrame(segment, length, pseudoHeader, length)
+{}
+
+TcpFrame::TcpFrame(const char* segment, const unsigned& capturedLength, const unsigned& pseudoHeader,
+	const unsigned& segmentLength)
+{
+	fromBytes(segment);
+	checkSumVerifiable = capturedLength >= segmentLength;
+	if (checkSumVerifiable)
+		calculateCheckSum(segment, segmentLength, pseudoHeader);
+}
+
 TcpFrame::~TcpFrame() {}
 
 std::string TcpFrame::getSourcePortAsString() const
@@ -37,28 +54,34 @@ std::string TcpFrame::getDestinationPortAsString() const
 
 std::string TcpFrame::getFlagsAsString() const
 {
-	stringstream ss;
-	if (flags & 0b100000)
-		ss << "URG ";
-	if (flags & 0b010000)
-		ss << "ACK ";
-	if (flags & 0b001000)
-		ss << "PSH ";
-	if (flags & 0b000100)
-		ss << "RST ";
-	if (flags & 0b000010)
-		ss << "SYN ";
-	if (flags & 0b000001)
-		ss << "FIN";
-
-	return ss.str();
+	char text[TCP_FLAGS_TEXT_LENGTH];
+	return string(text, formatFlags(text));
+}
+
+unsigned TcpFrame::formatFlags(char* out) const
+{
+	static const char names[] = "FINSYNRSTPSHACKURG";
+	char* at(out);
+
+	// most significant flag first, FIN goes last and without the space
+	for (int bit(5); bit > 0; bit--) {
+		if (flags >> bit & 1) {
+			memcpy(at, names + 3 * bit, 3);
+			at[3] = ' ';
+			at += 4;
+		}
+	}
+	if (flags & TCP_FLAG_FIN) {
+		memcpy(at, names, 3);
+		at += 3;
+	}
+	return at - out;
 }
 
 std::string TcpFrame::portToString(const unsigned& port) const
 {
-	stringstream ss;
-	ss << "::" << port;
-	return ss.str();
+	char text[2 + TEXT_MAX_DECIMAL_LENGTH] = { ':', ':' };
+	return string(text, 2 + formatDecimal(text + 2, port));
 }
 
 void TcpFrame::setSourcePort(const unsigned& s) { sourcePort = s; };
@@ -82,13 +105,19 @@ unsigned TcpFrame::getCheckSum() const { return checkSum; }
 unsigned TcpFrame::getUrgentPointer() const { return urgentPointer; }
 unsigned TcpFrame::getCalculatedCheckSum() const { return calculatedCheckSum; }
 
-void TcpFrame::calculateCheckSum()
+void TcpFrame::calculateCheckSum(const char* segment, const unsigned& length, const unsigned& pseudoHeader)
+{
+	// as for IPv4, the sent checksum is summed and then taken back out
+	const uint16_t sum(Checksum::sum(reinterpret_cast<const uint8_t*>(segment), length));
+	this->calculatedCheckSum = Checksum::finish(Checksum::add(Checksum::add(pseudoHeader, sum), ~getCheckSum() & 0xFFFF));
+}
+
+bool TcpFrame::checkSumIsVerifiable() const
 {
-	unsigned long cs(0);
-	this->calculatedCheckSum = cs;
+	return checkSumVerifiable;
 }
 
 bool TcpFrame::checkSumIsOk() const
 {
-	return getCheckSum() == getCalculatedCheckSum();
+	return checkSumVerifiable && getCheckSum() == getCalculatedCheckSum();
 }
@@ -0,0 +1,259 @@
+#include <TcpMetrics.hpp>
+#include <TcpFrame.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+#define NANOSECONDS_PER_MICROSECOND 1000
+
+/* HISTOGRAMS */
+
+void RttHistogram::add(const uint64_t& microseconds)
+{
+	const unsigned bucket(microseconds < 2 ? 0 : 63 - __builtin_clzll(microseconds));
+
+	buckets[bucket < TCP_METRICS_BUCKETS ? bucket : TCP_METRICS_BUCKETS - 1]++;
+	samples++;
+	total += microseconds;
+}
+
+uint64_t RttHistogram::getMean() const
+{
+	return samples ? total / samples : 0;
+}
+
+uint64_t RttHistogram::getBucketStart(const unsigned& bucket)
+{
+	return bucket ? uint64_t(1) << bucket : 0;
+}
+
+/* CONSTRUCTORS AND DESTRUCTORS */
+
+TcpMetrics::TcpMetrics(const unsigned& flows)
+	: connections(nullptr), flowCount(flows), handshakes(), roundTrips(), retransmissions(0), outOfOrder(0),
+	zeroWindows(0), windowShrinks(0)
+{
+	// like the flow pool, pages are only backed once used
+	connections = static_cast<Connection*>(calloc(flowCount, sizeof(Connection)));
+}
+
+TcpMetrics::~TcpMetrics()
+{
+	free(connections);
+}
+
+bool TcpMetrics::isOk() const
+{
+	return connections != nullptr;
+}
+
+/* SEGMENTS */
+
+void TcpMetrics::segment(const uint32_t& flow, const int& side, const PacketSummary& summary, const TcpView& tcp)
+{
+	if (!isOk() || flow >= flowCount)
+		return;
+
+	Connection& connection(connections[flow]);
+	Side& sender(connection.sides[side]);
+
+	if (summary.tcpFlags & TCP_FLAG_SYN)
+		handshake(connection, side, summary, tcp);
+	sequence(sender, summary);
+	// an ACK from this side answers what the other side sent
+	if (summary.tcpFlags & TCP_FLAG_ACK)
+		acknowledge(connection.sides[1 - side], summary);
+	window(connection, sender, summary);
+}
+
+void TcpMetrics::handshake(Connection& connection, const int& side, const PacketSummary& summary, const TcpView& tcp)
+{
+	unsigned scale;
+
+	connection.synOptions[side] = TCP_METRICS_SYN_SEEN;
+	if (tcp.isValid() && tcp.getWindowScale(scale))
+		connection.synOptions[side] |= TCP_METRICS_SYN_WINDOW_SCALE | scale;
+
+	// windows are scaled only if both SYNs offered it, and their scale is known only once both are seen
+	const uint8_t both(connection.synOptions[0] & connection.synOptions[1]);
+	if (both & TCP_METRICS_SYN_SEEN) {
+		for (int i(0); i < 2; i++)
+			connection.sides[i].windowScale = both & TCP_METRICS_SYN_WINDOW_SCALE ? connection.synOptions[i] & 0xF : 0;
+	}
+
+	if (!(summary.tcpFlags & TCP_FLAG_ACK)) {
+		// with two SYNs out there is no telling which one the SYN/ACK answers
+		if (connection.synAt)
+			connection.synResent = 1;
+		else
+			connection.synAt = summary.timestamp;
+		return;
+	}
+
+	if (!connection.synAt || connection.synResent || connection.handshakeRtt || summary.timestamp < connection.synAt)
+		return;
+
+	const uint64_t rtt((summary.timestamp - connection.synAt) / NANOSECONDS_PER_MICROSECOND);
+	handshakes.add(rtt);
+	connection.handshakeRtt = rtt ? (rtt < UINT32_MAX ? rtt : UINT32_MAX) : 1;
+}
+
+void TcpMetrics::sequence(Side& side, const PacketSummary& summary)
+{
+	// SYN and FIN take up a sequence number each
+	const uint32_t length(summary.payloadLength + (summary.tcpFlags & TCP_FLAG_SYN ? 1 : 0)
+		+ (summary.tcpFlags & TCP_FLAG_FIN ? 1 : 0));
+	const uint32_t start(summary.sequenceNumber);
+	const uint32_t end(start + length);
+	const uint64_t& now(summary.timestamp);
+
+	if (side.started && !length)
+		return;
+
+	if (side.started && before(start, side.next)) {
+		// a reordered segment fills a hole below the highest one; it comes sooner than a round trip
+		// after it, while a resent one comes at least a round trip after the original
+		const uint64_t window(side.smoothedRtt ? static_cast<uint64_t>(side.smoothedRtt) * NANOSECONDS_PER_MICROSECOND
+			: TCP_METRICS_REORDER_WINDOW);
+		if (before(end, side.next) && now >= side.advancedAt && now - side.advancedAt < window)
+			side.outOfOrder++;
+		else
+			side.retransmissions++;
+
+		if (side.timedAt && before(start, side.timedEnd))
+			side.timedAt = 0;
+		if (before(side.next, end)) {
+			side.next = end;
+			side.advancedAt = now;
+		}
+		return;
+	}
+
+	side.started = 1;
+	side.next = end;
+	side.advancedAt = now;
+	if (!side.timedAt && summary.payloadLength) {
+		side.timedAt = now;
+		side.timedEnd = end;
+	}
+}
+
+void TcpMetrics::acknowledge(Side& peer, const PacketSummary& summary)
+{
+	if (!peer.timedAt || before(summary.acknowledgementNumber, peer.timedEnd))
+		return;
+
+	if (summary.timestamp >= peer.timedAt) {
+		const uint64_t rtt((summary.timestamp - peer.timedAt) / NANOSECONDS_PER_MICROSECOND);
+		const uint32_t sample(rtt ? (rtt < UINT32_MAX ? rtt : UINT32_MAX) : 1);
+
+		roundTrips.add(rtt);
+		peer.rttSamples++;
+		// SRTT = 7/8 SRTT + 1/8 R, RFC 6298
+		if (peer.smoothedRtt)
+			peer.smoothedRtt = (static_cast<uint64_t>(peer.smoothedRtt) * 7 + sample) / 8;
+		else
+			peer.smoothedRtt = sample;
+	}
+	peer.timedAt = 0;
+}
+
+void TcpMetrics::window(Connection& connection, Side& side, const PacketSummary& summary)
+{
+	// SYN windows are never scaled and a reset has no window to speak of
+	if (!(summary.tcpFlags & TCP_FLAG_ACK) || summary.tcpFlags & (TCP_FLAG_SYN | TCP_FLAG_RST))
+		return;
+
+	if (!summary.window) {
+		if (!side.zeroWindow)
+			side.zeroWindows++;
+		side.zeroWindow = 1;
+	} else {
+		side.zeroWindow = 0;
+	}
+
+	// without both SYNs the window's unit is unknown; an ACK older than the last one says nothing new
+	if (!(connection.synOptions[0] & connection.synOptions[1] & TCP_METRICS_SYN_SEEN)
+			|| (side.edgeKnown && before(summary.acknowledgementNumber, side.acknowledged)))
+		return;
+
+	const uint32_t edge(summary.acknowledgementNumber + (static_cast<uint32_t>(summary.window) << side.windowScale));
+	if (side.edgeKnown && before(edge, side.rightEdge))
+		side.windowShrinks++;
+	side.rightEdge = edge;
+	side.acknowledged = summary.acknowledgementNumber;
+	side.edgeKnown = 1;
+}
+
+void TcpMetrics::release(const uint32_t& flow)
+{
+	if (!isOk() || flow >= flowCount)
+		return;
+
+	for (const Side& side : connections[flow].sides) {
+		retransmissions += side.retransmissions;
+		outOfOrder += side.outOfOrder;
+		zeroWindows += side.zeroWindows;
+		windowShrinks += side.windowShrinks;
+	}
+	memset(&connections[flow], 0, sizeof(Connection));
+}
+
+/* HELPERS */
+
+// sequence numbers wrap, so they are compared by their signed distance
+bool TcpMetrics::before(const uint32_t& a, const uint32_t& b)
+{
+	return static_cast<int32_t>(a - b) < 0;
+}
+
+/* GETTERS */
+
+uint32_t TcpMetrics::getHandshakeRtt(const uint32_t& flow) const
+{
+	return flow < flowCount && isOk() ? connections[flow].handshakeRtt : 0;
+}
+
+uint32_t TcpMetrics::getSmoothedRtt(const uint32_t& flow, const int& side) const
+{
+	return flow < flowCount && isOk() ? connections[flow].sides[side].smoothedRtt : 0;
+}
+
+uint32_t TcpMetrics::getRttSamples(const uint32_t& flow, const int& side) const
+{
+	return flow < flowCount && isOk() ? connections[flow].sides[side].rttSamples : 0;
+}
+
+uint32_t TcpMetrics::getRetransmissions(const uint32_t& flow, const int& side) const
+{
+	return flow < flowCount && isOk() ? connections[flow].sides[side].retransmissions : 0;
+}
+
+uint32_t TcpMetrics::getOutOfOrder(const uint32_t& flow, const int& side) const
+{
+	return flow < flowCount && isOk() ? connections[flow].sides[side].outOfOrder : 0;
+}
+
+uint32_t TcpMetrics::getZeroWindows(const uint32_t& flow, const int& side) const
+{
+	return flow < flowCount && isOk() ? connections[flow].sides[side].zeroWindows : 0;
+}
+
+uint32_t TcpMetrics::getWindowShrinks(const uint32_t& flow, const int& side) const
+{
+	return flow < flowCount && isOk() ? connections[flow].sides[side].windowShrinks : 0;
+}
+
+const RttHistogram& TcpMetrics::getHandshakes() const { return handshakes; }
+const RttHistogram& TcpMetrics::getRoundTrips() const { return roundTrips; }
+uint64_t TcpMetrics::getRetransmissions() const { return retransmissions; }
+uint64_t TcpMetrics::getOutOfOrder() const { return outOfOrder; }
+uint64_t TcpMetrics::getZeroWindows() const { return zeroWindows; }
+uint64_t TcpMetrics::getWindowShrinks() const { return windowShrinks; }
+
+uint64_t TcpMetrics::getMemoryUsage() const
+{
+	return static_cast<uint64_t>(flowCount) * sizeof(Connection);
+}
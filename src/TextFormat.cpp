@@ -0,0 +1,39 @@
+#include <TextFormat.hpp>
+
+constexpr TextTables textTables;
+
+unsigned formatIpv6(char* out, const uint8_t* address)
+{
+	unsigned groups[8];
+	int runStart(-1), runLength(0);
+	char* at(out);
+
+	for (unsigned i(0); i < 8; i++)
+		groups[i] = address[2 * i] * 0x100 + address[2 * i + 1];
+
+	// the longest run of zero groups is shortened, a single zero group is not worth it
+	for (int i(0); i < 8; i++) {
+		int j(i);
+		while (j < 8 && groups[j] == 0)
+			j++;
+		if (j - i > runLength && j - i > 1) {
+			runStart = i;
+			runLength = j - i;
+		}
+		if (j > i)
+			i = j - 1;
+	}
+
+	for (int i(0); i < 8; i++) {
+		if (i == runStart) {
+			*at++ = ':';
+			*at++ = ':';
+			i += runLength - 1;
+			continue;
+		}
+		if (i > 0 && i != runStart + runLength)
+			*at++ = ':';
+		at += formatHex(at, groups[i]);
+	}
+	return at - out;
+}
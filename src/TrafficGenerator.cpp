@@ -0,0 +1,378 @@
+#include <TrafficGenerator.hpp>
+#include <EthernetFrame.hpp>
+#include <IpFrame.hpp>
+#include <Ipv6Frame.hpp>
+#include <CaptureFormat.hpp>
+#include <ByteOrder.hpp>
+#include <Checksum.hpp>
+
+#include <cstring>
+
+using namespace std;
+
+// first capture timestamp, in seconds since the epoch
+#define TRAFFIC_START_TIME 1600000000
+// most packets of a flow go between these server ports and a random client port
+static const uint16_t tcpPorts[] = { 80, 443, 443, 22, 25, 8080 };
+static const uint16_t udpPorts[] = { 53, 53, 123, 161, 514, 4789 };
+
+TrafficProfile::TrafficProfile()
+	: seed(TRAFFIC_DEFAULT_SEED), packets(TRAFFIC_DEFAULT_PACKETS), flows(TRAFFIC_DEFAULT_FLOWS),
+	sizeMode(TRAFFIC_SIZE_IMIX), minSize(TRAFFIC_MIN_FRAME_LENGTH), maxSize(TRAFFIC_MAX_FRAME_LENGTH),
+	tcpWeight(80), udpWeight(15), icmpWeight(5), ipv6Rate(0), vlanRate(0), fragmentRate(0), reorderRate(0),
+	corruptRate(0)
+{
+}
+
+/* CONSTRUCTORS */
+
+TrafficGenerator::TrafficGenerator(const TrafficProfile& p)
+	: profile(p), state(p.seed), flows(p.flows ? p.flows : 1),
+	pool(TRAFFIC_PAYLOAD_POOL_LENGTH + TRAFFIC_MAX_FRAME_LENGTH),
+	// room for a full chunk plus a packet cut in two and a held one behind it
+	buffer(TRAFFIC_WRITE_LENGTH + 8 * (PCAP_RECORD_HEADER_LENGTH + TRAFFIC_MAX_FRAME_LENGTH + IPV6_STD_HEADER_LENGTH)),
+	position(0), heldFlow(nullptr), heldFromClient(false), time(static_cast<uint64_t>(TRAFFIC_START_TIME) * 1000000),
+	fragmentThreshold(threshold(p.fragmentRate)), reorderThreshold(threshold(p.reorderRate)),
+	corruptThreshold(threshold(p.corruptRate)), packets(0), bytes(0), fragmented(0), reordered(0), corrupted(0)
+{
+	for (size_t i(0); i < pool.size(); i += 8) {
+		const uint64_t word(next());
+		memcpy(&pool[i], &word, pool.size() - i < 8 ? pool.size() - i : 8);
+	}
+
+	for (Flow& flow : flows)
+		createFlow(flow);
+}
+
+/* RANDOM NUMBERS */
+
+// splitmix64: one add and a few multiplies, and the same stream everywhere
+uint64_t TrafficGenerator::next()
+{
+	uint64_t z(state += 0x9E3779B97F4A7C15);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+	return z ^ (z >> 31);
+}
+
+uint32_t TrafficGenerator::nextBelow(const uint32_t& bound)
+{
+	return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+}
+
+bool TrafficGenerator::draw(const uint64_t& limit)
+{
+	return limit && (next() >> 32) < limit;
+}
+
+uint64_t TrafficGenerator::threshold(const double& rate)
+{
+	if (rate <= 0)
+		return 0;
+	if (rate >= 1)
+		return uint64_t(1) << 32;
+	return static_cast<uint64_t>(rate * 4294967296.0);
+}
+
+/* FLOWS */
+
+void TrafficGenerator::createFlow(Flow& flow)
+{
+	const uint32_t weights(profile.tcpWeight + profile.udpWeight + profile.icmpWeight);
+	const uint32_t pick(nextBelow(weights ? weights : 1));
+	const uint64_t client(next()), server(next());
+
+	memset(&flow, 0, sizeof(flow));
+	flow.protocol = pick < profile.tcpWeight ? IP_PROTOCOL_TCP
+		: pick < profile.tcpWeight + profile.udpWeight ? IP_PROTOCOL_UDP : IP_PROTOCOL_ICMP;
+	flow.ipv6 = draw(threshold(profile.ipv6Rate));
+	flow.vlan = draw(threshold(profile.vlanRate)) ? 1 + nextBelow(4094) : 0;
+
+	if (flow.ipv6) {
+		// 2001:db8::/64 for clients, 2001:db8:1::/64 for servers
+		store32(flow.clientAddress, 0x20010DB8);
+		store32(flow.serverAddress, 0x20010DB8);
+		store16(flow.serverAddress + 4, 1);
+		memcpy(flow.clientAddress + 8, &client, 8);
+		memcpy(flow.serverAddress + 8, &server, 8);
+	} else {
+		// 10.0.0.0/8 for clients, 192.168.0.0/16 for servers
+		store32(flow.clientAddress, 0x0A000000 | (client & 0xFFFFFF));
+		store32(flow.serverAddress, 0xC0A80000 | (server & 0xFFFF));
+	}
+
+	if (flow.protocol == IP_PROTOCOL_TCP) {
+		flow.clientPort = 1024 + nextBelow(0x10000 - 1024);
+		flow.serverPort = tcpPorts[nextBelow(sizeof(tcpPorts) / sizeof(tcpPorts[0]))];
+	} else if (flow.protocol == IP_PROTOCOL_UDP) {
+		flow.clientPort = 1024 + nextBelow(0x10000 - 1024);
+		flow.serverPort = udpPorts[nextBelow(sizeof(udpPorts) / sizeof(udpPorts[0]))];
+	} else {
+		// the echo identifier
+		flow.clientPort = next();
+	}
+
+	flow.sequence[0] = next();
+	flow.sequence[1] = next();
+	flow.id = next();
+}
+
+unsigned TrafficGenerator::drawFrameLength()
+{
+	switch (profile.sizeMode) {
+	case TRAFFIC_SIZE_UNIFORM:
+		return profile.minSize + nextBelow(profile.maxSize - profile.minSize + 1);
+	case TRAFFIC_SIZE_IMIX: {
+		const uint32_t pick(nextBelow(12));
+		return pick < 7 ? TRAFFIC_MIN_FRAME_LENGTH : pick < 11 ? ETH_STD_HEADER_LENGTH + 576 : TRAFFIC_MAX_FRAME_LENGTH;
+	}
+	default:
+		return profile.minSize;
+	}
+}
+
+/* RECORDS */
+
+uint8_t* TrafficGenerator::beginRecord(const unsigned& length)
+{
+	uint8_t* header(&buffer[position]);
+
+	stamp(header);
+	memcpy(header + 8, &length, 4);
+	memcpy(header + 12, &length, 4);
+
+	position += PCAP_RECORD_HEADER_LENGTH + length;
+	packets++;
+	bytes += length;
+	return header + PCAP_RECORD_HEADER_LENGTH;
+}
+
+void TrafficGenerator::stamp(uint8_t* header)
+{
+	time += 1 + nextBelow(20);
+
+	const uint32_t seconds(time / 1000000), microseconds(time % 1000000);
+	memcpy(header, &seconds, 4);
+	memcpy(header + 4, &microseconds, 4);
+}
+
+unsigned TrafficGenerator::writeLink(uint8_t* frame, const Flow& flow, const bool& fromClient) const
+{
+	// locally administered addresses derived from the endpoints
+	uint8_t* destination(frame);
+	uint8_t* source(frame + ETH_STD_ADDRESS_LENGTH);
+	unsigned length(2 * ETH_STD_ADDRESS_LENGTH);
+
+	destination[0] = source[0] = 0x02;
+	destination[1] = source[1] = 0x00;
+	memcpy(fromClient ? source + 2 : destination + 2, flow.clientAddress + (flow.ipv6 ? 12 : 0), 4);
+	memcpy(fromClient ? destination + 2 : source + 2, flow.serverAddress + (flow.ipv6 ? 12 : 0), 4);
+
+	if (flow.vlan) {
+		store16(frame + length, ETHERTYPE_VLAN);
+		store16(frame + length + 2, flow.vlan);
+		length += ETH_STD_VLAN_TAG_LENGTH;
+	}
+
+	store16(frame + length, flow.ipv6 ? ETHERTYPE_IPV6 : ETHERTYPE_IPV4);
+	return length + ETH_STD_ETHERTYPE_LENGTH;
+}
+
+void TrafficGenerator::writeTransport(uint8_t* segment, Flow& flow, const bool& fromClient, const unsigned& payloadLength,
+	const unsigned& pseudoHeader)
+{
+	const unsigned side(fromClient ? 0 : 1);
+	unsigned headerLength(UDP_HEADER_LENGTH);
+	unsigned checkSumOffset(6);
+
+	if (flow.protocol == IP_PROTOCOL_TCP) {
+		// a handshake first, then data both ways
+		const unsigned flags(flow.sent == 0 ? TCP_FLAG_SYN : flow.sent == 1 ? TCP_FLAG_SYN | TCP_FLAG_ACK
+			: TCP_FLAG_ACK | (payloadLength ? TCP_FLAG_PSH : 0));
+
+		headerLength = TCP_MIN_HEADER_LENGTH;
+		checkSumOffset = 16;
+		store16(segment, fromClient ? flow.clientPort : flow.serverPort);
+		store16(segment + 2, fromClient ? flow.serverPort : flow.clientPort);
+		store32(segment + 4, flow.sequence[side]);
+		store32(segment + 8, flags == TCP_FLAG_SYN ? 0 : flow.sequence[1 - side]);
+		segment[12] = (TCP_MIN_HEADER_LENGTH / 4) << 4;
+		segment[13] = flags;
+		store16(segment + 14, 0xFFFF);
+		store32(segment + 16, 0);
+		flow.sequence[side] += payloadLength + (flags & TCP_FLAG_SYN ? 1 : 0);
+	} else if (flow.protocol == IP_PROTOCOL_UDP) {
+		store16(segment, fromClient ? flow.clientPort : flow.serverPort);
+		store16(segment + 2, fromClient ? flow.serverPort : flow.clientPort);
+		store16(segment + 4, UDP_HEADER_LENGTH + payloadLength);
+		store16(segment + 6, 0);
+	} else {
+		headerLength = ICMP_HEADER_LENGTH;
+		checkSumOffset = 2;
+		// echo request and reply, ICMPv6 numbers them differently
+		segment[0] = flow.ipv6 ? (fromClient ? 128 : 129) : (fromClient ? ICMP_TYPE_ECHO_REQUEST : ICMP_TYPE_ECHO_REPLY);
+		segment[1] = 0;
+		store16(segment + 2, 0);
+		store16(segment + 4, flow.clientPort);
+		store16(segment + 6, flow.sent);
+	}
+
+	memcpy(segment + headerLength, &pool[next() & (TRAFFIC_PAYLOAD_POOL_LENGTH - 1)], payloadLength);
+
+	uint16_t checkSum(Checksum::finish(Checksum::add(pseudoHeader, Checksum::sum(segment, headerLength + payloadLength))));
+	// zero would mean "no checksum" to a UDP receiver
+	if (flow.protocol == IP_PROTOCOL_UDP && checkSum == 0)
+		checkSum = 0xFFFF;
+	if (draw(corruptThreshold)) {
+		checkSum ^= 0x5A5A;
+		corrupted++;
+	}
+	store16(segment + checkSumOffset, checkSum);
+
+	flow.sent++;
+}
+
+void TrafficGenerator::writePacket(Flow& flow)
+{
+	const size_t start(position);
+	const bool handshake(flow.protocol == IP_PROTOCOL_TCP && flow.sent < 3);
+	// the packet after a held one takes its direction, so the two swap within one stream
+	const bool fromClient(handshake ? flow.sent != 1 : &flow == heldFlow ? heldFromClient : next() & 1);
+	const unsigned linkLength(ETH_STD_HEADER_LENGTH + (flow.vlan ? ETH_STD_VLAN_TAG_LENGTH : 0));
+	const unsigned networkLength(flow.ipv6 ? IPV6_STD_HEADER_LENGTH : IP_STD_MIN_HEADER_LENGTH);
+	const unsigned headerLength(linkLength + networkLength
+		+ (flow.protocol == IP_PROTOCOL_TCP ? TCP_MIN_HEADER_LENGTH : flow.protocol == IP_PROTOCOL_UDP ? UDP_HEADER_LENGTH : ICMP_HEADER_LENGTH));
+	const unsigned target(drawFrameLength() + (flow.vlan ? ETH_STD_VLAN_TAG_LENGTH : 0));
+	const unsigned payloadLength(handshake || target <= headerLength ? 0 : target - headerLength);
+	// short frames are padded on the wire, and so in the capture
+	const unsigned frameLength(headerLength + payloadLength < TRAFFIC_MIN_FRAME_LENGTH ? TRAFFIC_MIN_FRAME_LENGTH : headerLength + payloadLength);
+	// the second fragment must not push the count past what was asked for
+	const bool fragment(!flow.ipv6 && packets + 2 <= profile.packets
+		&& headerLength + payloadLength - linkLength - networkLength >= 16 && draw(fragmentThreshold));
+
+	uint8_t* frame(beginRecord(frameLength));
+	uint8_t* network(frame + writeLink(frame, flow, fromClient));
+	uint8_t* transport(network + networkLength);
+	const unsigned segmentLength(headerLength + payloadLength - linkLength - networkLength);
+
+	memset(frame + headerLength + payloadLength, 0, frameLength - headerLength - payloadLength);
+
+	if (flow.ipv6) {
+		store32(network, 0x60000000 | (flow.id & 0xFFFFF));
+		store16(network + 4, segmentLength);
+		network[6] = flow.protocol == IP_PROTOCOL_ICMP ? IPV6_PROTOCOL_ICMPV6 : flow.protocol;
+		network[7] = 64;
+		memcpy(network + 8, fromClient ? flow.clientAddress : flow.serverAddress, IPV6_STD_ADDRESS_LENGTH);
+		memcpy(network + 24, fromClient ? flow.serverAddress : flow.clientAddress, IPV6_STD_ADDRESS_LENGTH);
+		writeTransport(transport, flow, fromClient, payloadLength, Checksum::pseudoHeader(network + 8, network[6], segmentLength));
+	} else {
+		network[0] = 0x45;
+		network[1] = 0;
+		store16(network + 2, networkLength + segmentLength);
+		store16(network + 4, flow.id++);
+		store16(network + 6, fragment ? 0 : 0x4000);
+		network[8] = 64;
+		network[9] = flow.protocol;
+		store16(network + 10, 0);
+		memcpy(network + 12, fromClient ? flow.clientAddress : flow.serverAddress, 4);
+		memcpy(network + 16, fromClient ? flow.serverAddress : flow.clientAddress, 4);
+		store16(network + 10, Checksum::finish(Checksum::sum(network, IP_STD_MIN_HEADER_LENGTH)));
+		writeTransport(transport, flow, fromClient, payloadLength, flow.protocol == IP_PROTOCOL_ICMP ? 0
+			: Checksum::pseudoHeader(load32(network + 12), load32(network + 16), flow.protocol, segmentLength));
+	}
+
+	if (fragment)
+		writeFragments(start, linkLength);
+	release(start, flow, fromClient, !handshake);
+}
+
+void TrafficGenerator::writeFragments(const size_t& start, const unsigned& linkLength)
+{
+	const uint8_t* frame(&buffer[start + PCAP_RECORD_HEADER_LENGTH]);
+	const unsigned datagramLength(load16(frame + linkLength + 2));
+	const unsigned segmentLength(datagramLength - IP_STD_MIN_HEADER_LENGTH);
+	// offsets count 8 octet units, so every fragment but the last is a multiple of 8
+	const unsigned split((segmentLength / 2 + 7) & ~7u);
+
+	scratch.assign(frame, frame + linkLength + datagramLength);
+	position = start;
+	packets--;
+	bytes -= linkLength + datagramLength;
+
+	for (unsigned offset(0); offset < segmentLength; offset += split) {
+		const unsigned pieceLength(offset ? segmentLength - offset : split);
+		const unsigned frameLength(linkLength + IP_STD_MIN_HEADER_LENGTH + pieceLength);
+		uint8_t* piece(beginRecord(frameLength < TRAFFIC_MIN_FRAME_LENGTH ? TRAFFIC_MIN_FRAME_LENGTH : frameLength));
+		uint8_t* network(piece + linkLength);
+
+		memset(piece, 0, frameLength < TRAFFIC_MIN_FRAME_LENGTH ? TRAFFIC_MIN_FRAME_LENGTH : frameLength);
+		memcpy(piece, &scratch[0], linkLength + IP_STD_MIN_HEADER_LENGTH);
+		memcpy(network + IP_STD_MIN_HEADER_LENGTH, &scratch[linkLength + IP_STD_MIN_HEADER_LENGTH + offset], pieceLength);
+
+		store16(network + 2, IP_STD_MIN_HEADER_LENGTH + pieceLength);
+		store16(network + 6, (offset ? 0 : 0x2000) | offset / 8);
+		store16(network + 10, 0);
+		store16(network + 10, Checksum::finish(Checksum::sum(network, IP_STD_MIN_HEADER_LENGTH)));
+	}
+	fragmented++;
+}
+
+void TrafficGenerator::release(const size_t& start, Flow& flow, const bool& fromClient, const bool& reorderable)
+{
+	// something must follow a held packet, or it would be the last one anyway
+	if (held.empty() && reorderable && packets < profile.packets && draw(reorderThreshold)) {
+		held.assign(buffer.begin() + start, buffer.begin() + position);
+		heldFlow = &flow;
+		heldFromClient = fromClient;
+		position = start;
+		reordered++;
+		return;
+	}
+
+	if (held.empty())
+		return;
+
+	// the held records go out now, stamped now, so capture time stays monotonic
+	for (size_t at(0); at < held.size(); ) {
+		uint32_t length;
+		memcpy(&length, &held[at + 8], 4);
+		stamp(&held[at]);
+		at += PCAP_RECORD_HEADER_LENGTH + length;
+	}
+	memcpy(&buffer[position], held.data(), held.size());
+	position += held.size();
+	held.clear();
+	heldFlow = nullptr;
+}
+
+/* OUTPUT */
+
+bool TrafficGenerator::write(ostream& out)
+{
+	const uint32_t header[PCAP_FILE_HEADER_LENGTH / 4] = {
+		PCAP_MAGIC_MICROSECONDS, 0x00040002, 0, 0, TRAFFIC_MAX_FRAME_LENGTH + ETH_STD_VLAN_TAG_LENGTH, LINKTYPE_ETHERNET
+	};
+
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	while (packets < profile.packets) {
+		writePacket(heldFlow ? *heldFlow : flows[nextBelow(flows.size())]);
+		if (position >= TRAFFIC_WRITE_LENGTH && !flush(out))
+			return false;
+	}
+
+	return flush(out);
+}
+
+bool TrafficGenerator::flush(ostream& out)
+{
+	out.write(reinterpret_cast<const char*>(buffer.data()), position);
+	position = 0;
+	return static_cast<bool>(out);
+}
+
+uint64_t TrafficGenerator::getPackets() const { return packets; }
+uint64_t TrafficGenerator::getBytes() const { return bytes; }
+uint64_t TrafficGenerator::getFragmented() const { return fragmented; }
+uint64_t TrafficGenerator::getReordered() const { return reordered; }
+uint64_t TrafficGenerator::getCorrupted() const { return corrupted; }
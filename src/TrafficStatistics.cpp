@@ -0,0 +1,93 @@
+#include <TrafficStatistics.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+static const char* sizeBucketNames[STATISTICS_SIZE_BUCKETS] = {
+	"<=64", "65-127", "128-255", "256-511", "512-1023", "1024-1518", ">1518"
+};
+
+static const char* tcpFlagNames[STATISTICS_TCP_FLAGS] = {
+	"FIN", "SYN", "RST", "PSH", "ACK", "URG", "ECE", "CWR"
+};
+
+/* SNAPSHOTS */
+
+TrafficSnapshot::TrafficSnapshot()
+	: frames(0), bytes(0), ipv4(0), ipv6(0), ports(STATISTICS_PORTS)
+{
+	memset(sizes, 0, sizeof(sizes));
+	memset(protocols, 0, sizeof(protocols));
+	memset(precedences, 0, sizeof(precedences));
+	memset(tcpFlags, 0, sizeof(tcpFlags));
+}
+
+void TrafficSnapshot::getTopPorts(const unsigned& count, vector<uint16_t>& top) const
+{
+	top.clear();
+	for (unsigned port(0); port < STATISTICS_PORTS; port++) {
+		if (!ports[port])
+			continue;
+		// kept sorted by count, so the smallest of the top is always last
+		if (top.size() == count && ports[port] <= ports[top.back()])
+			continue;
+		if (top.size() == count)
+			top.pop_back();
+		const auto at(upper_bound(top.begin(), top.end(), port,
+			[this](const unsigned& p, const uint16_t& t) { return ports[p] > ports[t]; }));
+		top.insert(at, port);
+	}
+}
+
+const char* TrafficSnapshot::getSizeBucketName(const unsigned& bucket)
+{
+	return bucket < STATISTICS_SIZE_BUCKETS ? sizeBucketNames[bucket] : "unknown";
+}
+
+const char* TrafficSnapshot::getTcpFlagName(const unsigned& flag)
+{
+	return flag < STATISTICS_TCP_FLAGS ? tcpFlagNames[flag] : "unknown";
+}
+
+/* COUNTERS */
+
+TrafficStatistics::TrafficStatistics(const unsigned& t)
+	: counters(new TrafficCounters[t ? t : 1]()), threads(t ? t : 1)
+{
+}
+
+TrafficCounters& TrafficStatistics::getCounters(const unsigned& thread)
+{
+	return counters[thread];
+}
+
+// counters keep moving while they are read, so each one is as of some moment during the pass
+void TrafficStatistics::snapshot(TrafficSnapshot& out) const
+{
+	const memory_order relaxed(memory_order_relaxed);
+
+	out = TrafficSnapshot();
+	for (unsigned t(0); t < threads; t++) {
+		const TrafficCounters& c(counters[t]);
+
+		out.frames += c.frames.load(relaxed);
+		out.bytes += c.bytes.load(relaxed);
+		out.ipv4 += c.ipv4.load(relaxed);
+		out.ipv6 += c.ipv6.load(relaxed);
+		for (unsigned i(0); i < STATISTICS_SIZE_BUCKETS; i++)
+			out.sizes[i] += c.sizes[i].load(relaxed);
+		for (unsigned i(0); i < STATISTICS_PROTOCOLS; i++)
+			out.protocols[i] += c.protocols[i].load(relaxed);
+		for (unsigned i(0); i < STATISTICS_PRECEDENCES; i++)
+			out.precedences[i] += c.precedences[i].load(relaxed);
+		for (unsigned set(1); set < STATISTICS_TCP_FLAG_SETS; set++) {
+			const uint64_t segments(c.tcpFlagSets[set].load(relaxed));
+			for (unsigned i(0); i < STATISTICS_TCP_FLAGS; i++)
+				out.tcpFlags[i] += set >> i & 1 ? segments : 0;
+		}
+		for (unsigned i(0); i < STATISTICS_PORTS; i++)
+			out.ports[i] += c.ports[i].load(relaxed);
+	}
+}
@@ -0,0 +1,90 @@
+#include <UdpFrame.hpp>
+#include <UdpView.hpp>
+#include <Checksum.hpp>
+#include <TextFormat.hpp>
+
+using namespace std;
+
+void UdpFrame::fromBytes(const char* frameBytes)
+{
+	const UdpView view(frameBytes, UDP_HEADER_LENGTH);
+
+	setSourcePort(view.getSourcePort());
+	setDestinationPort(view.getDestinationPort());
+	setLength(view.getLength());
+	setCheckSum(view.getCheckSum());
+	calculatedCheckSum = 0;
+	checkSumVerifiable = 0;
+}
+
+UdpFrame::UdpFrame(const char* frameBytes)
+{
+	fromBytes(frameBytes);
+}
+
+UdpFrame::UdpFrame(const char* datagram, const unsigned& capturedLength, const unsigned& pseudoHeader)
+{
+	fromBytes(datagram);
+	checkSumVerifiable = capturedLength >= getLength();
+	if (checkSumVerifiable)
+		calculateCheckSum(datagram, getLength(), pseudoHeader);
+}
+
+UdpFrame::UdpFrame(const char* datagram, const unsigned& capturedLength, const unsigned& pseudoHeader, const unsigned&)
+	: UdpFrame(datagram, capturedLength, pseudoHeader)
+{}
+
+UdpFrame::~UdpFrame() {}
+
+std::string UdpFrame::getSourcePortAsString() const
+{
+	return portToString(getSourcePort());
+}
+
+std::string UdpFrame::getDestinationPortAsString() const
+{
+	return portToString(getDestinationPort());
+}
+
+std::string UdpFrame::portToString(const unsigned& port) const
+{
+	char text[2 + TEXT_MAX_DECIMAL_LENGTH] = { ':', ':' };
+	return string(text, 2 + formatDecimal(text + 2, port));
+}
+
+void UdpFrame::setSourcePort(const unsigned& s) { sourcePort = s; };
+void UdpFrame::setDestinationPort(const unsigned& d) { destinationPort = d; };
+void UdpFrame::setLength(const unsigned& l) { length = l; };
+void UdpFrame::setCheckSum(const unsigned& c) { checkSum = c; };
+
+unsigned UdpFrame::getSourcePort() const { return sourcePort; }
+unsigned UdpFrame::getDestinationPort() const { return destinationPort; }
+unsigned UdpFrame::getLength() const { return length; }
+unsigned UdpFrame::getCheckSum() const { return checkSum; }
+unsigned UdpFrame::getCalculatedCheckSum() const { return calculatedCheckSum; }
+
+void UdpFrame::calculateCheckSum(const char* datagram, const unsigned& datagramLength, const unsigned& pseudoHeader)
+{
+	// as for TCP, the sent checksum is summed and then taken back out
+	const uint16_t sum(Checksum::sum(reinterpret_cast<const uint8_t*>(datagram), datagramLength));
+	this->calculatedCheckSum = Checksum::finish(Checksum::add(Checksum::add(pseudoHeader, sum), ~getCheckSum() & 0xFFFF));
+
+	// zero means "no checksum" on the wire, so a computed zero is sent as all ones
+	if (this->calculatedCheckSum == 0)
+		this->calculatedCheckSum = 0xFFFF;
+}
+
+bool UdpFrame::checkSumIsPresent() const
+{
+	return getCheckSum() != 0;
+}
+
+bool UdpFrame::checkSumIsVerifiable() const
+{
+	return checkSumVerifiable;
+}
+
+bool UdpFrame::checkSumIsOk() const
+{
+	return !checkSumIsPresent() || (checkSumVerifiable && getCheckSum() == getCalculatedCheckSum());
+}
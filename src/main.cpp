@@ -1,11 +1,40 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <csignal>
+#include <unistd.h>
 
 #include <EthernetFrame.hpp>
+#include <CaptureReader.hpp>
+#include <MappedCapture.hpp>
+#include <DecodePipeline.hpp>
+#include <LiveCapture.hpp>
+#include <Options.hpp>
+#include <Filter.hpp>
+#include <FlowTable.hpp>
+#include <StreamReassembler.hpp>
+#include <TcpMetrics.hpp>
+#include <FragmentReassembler.hpp>
+#include <EthernetView.hpp>
+#include <PacketSummary.hpp>
+#include <OutputBuffer.hpp>
+#include <RecordWriter.hpp>
+#include <ColumnWriter.hpp>
+#include <TrafficStatistics.hpp>
+#include <HeavyHitters.hpp>
 
 using namespace std;
 
+// measured in octets
+#define FILE_STREAM_BUFFER_LENGTH 0x100000
+// streamed frames are copied into their batch, up to this many octets
+#define STREAM_BATCH_LENGTH 0x100000
+// live output is written once this much has gathered, or at the end of a ring block
+#define LIVE_OUTPUT_LENGTH 0x40000
+
 typedef enum {
 	OPT_FILE=1,
 	OPT_INTERFACE,
@@ -14,24 +43,77 @@ typedef enum {
 
 void clearScreen();
 
-void analizeFile(string);
-void analizeInterface();
+bool analizeFile(const Options&);
+bool compileFilter(const Options&, Filter&, ostream&);
+bool openFlowTable(const Options&, unique_ptr<FlowTable>&, unique_ptr<StreamReassembler>&, unique_ptr<TcpMetrics>&,
+	OutputBuffer&, ostream&);
+void trackFlow(FlowTable&, StreamReassembler*, TcpMetrics*, const CaptureRecord&, const bool&);
+void trackDatagram(FlowTable&, StreamReassembler*, TcpMetrics*, const FragmentReassembler&, const uint64_t&);
+void trackPacket(FlowTable&, StreamReassembler*, TcpMetrics*, const PacketSummary&, const char*, const unsigned&);
+void closeFlowTable(FlowTable&, StreamReassembler*, TcpMetrics*, OutputBuffer&);
+void printFlow(OutputBuffer&, const Flow&);
+void printStreams(OutputBuffer&, const StreamReassembler&, const uint32_t&);
+void printTcpMetrics(OutputBuffer&, const TcpMetrics&, const uint32_t&);
+void printRttHistogram(ostream&, const char*, const RttHistogram&);
+bool readStreamBatch(CaptureReader&, FrameBatch&);
+void decodeBatch(FrameBatch&, const Filter&, Arena&, const OutputFormat&, const bool&, TrafficCounters*, HeavyHitters*);
+bool openExport(const Options&, unique_ptr<ColumnWriter>&, ostream&);
+void closeExport(ColumnWriter&, ostream&);
+bool openStatistics(const Options&, const unsigned&, unique_ptr<TrafficStatistics>&, ofstream&);
+void reportStatistics(const TrafficStatistics&, TrafficSnapshot&, const double&, const double&, ofstream&);
+void printStatistics(ostream&, const TrafficSnapshot&, const TrafficSnapshot&, const double&, const double&);
+void writeStatistics(ostream&, const TrafficSnapshot&, const double&);
+void printHeavyHitters(ostream&, const HeavyHitters&, const unsigned&);
+void writeOutput(OutputBuffer&);
+bool analizeInterface(const Options&);
+void onInterrupt(int);
+void printFrame(OutputBuffer&, const EthernetFrame&);
+void printIpFrame(OutputBuffer&, const IpFrame&);
+void printIpv6Frame(OutputBuffer&, const Ipv6Frame&);
+void printTcpFrame(OutputBuffer&, const TcpFrame&);
+void printUdpFrame(OutputBuffer&, const UdpFrame&);
+void printIcmpFrame(OutputBuffer&, const IcmpFrame&);
+bool defragment(FragmentReassembler&, const CaptureRecord&, OutputBuffer&);
+void printDefragmentSummary(const FragmentReassembler&);
+void printThroughput(ostream&, const uint64_t&, const uint64_t&, const uint64_t&, const uint64_t&, const double&);
 
 MenuOption menu();
 
-int main()
+static volatile sig_atomic_t interrupted(0);
+
+int main(int argc, char** argv)
 {
 	MenuOption menuOption;
+	Options options;
+	string filename;
+
+	if (!options.parse(argc, argv)) {
+		cerr << options.getError() << endl;
+		Options::printUsage(cerr, argv[0]);
+		return 1;
+	}
+
+	// any argument means batch mode: analize and exit without the menu
+	if (!options.isInteractive() && !options.getInterface().empty())
+		return analizeInterface(options) ? 0 : 1;
+	if (!options.isInteractive())
+		return analizeFile(options) ? 0 : 1;
 
 	do {
 		menuOption = menu();
 		clearScreen();
 		switch (menuOption) {
 		case OPT_FILE:
-			analizeFile("test/frame.bin");
+			cout << "Capture file (pcap, pcapng or a raw frame): ";
+			cin >> filename;
+			options.setFilename(filename);
+			analizeFile(options);
 			break;
 		case OPT_INTERFACE:
-			analizeInterface();
+			cout << "Interface name: ";
+			cin >> filename;
+			options.setInterface(filename);
+			analizeInterface(options);
 			break;
 		case OPT_EXIT:
 			cout << "Exiting" << endl;
@@ -42,90 +124,893 @@ int main()
 	} while (menuOption != OPT_EXIT);
 }
 
-void analizeFile(string filename)
+bool analizeFile(const Options& options)
+{
+	const string& filename(options.getFilename());
+	MappedCapture capture;
+	vector<char> streamBuffer;
+	ifstream frameFile;
+	unique_ptr<CaptureReader> reader;
+	BatchSource source;
+	uint64_t nextFrame(0);
+	uint64_t bytes(0);
+	bool indexLoaded(false);
+	bool indexSaved(false);
+	Filter filter;
+	unique_ptr<FlowTable> flows;
+	unique_ptr<StreamReassembler> streams;
+	unique_ptr<TcpMetrics> metrics;
+	unique_ptr<FragmentReassembler> fragments(options.getDefragment() ? new FragmentReassembler() : nullptr);
+	unique_ptr<ColumnWriter> exporter;
+	// what the writer adds after a batch: ended flows and reassembled datagrams
+	OutputBuffer output;
+	// records own stdout, everything about the run goes to stderr then
+	const OutputFormat format(options.getFormat());
+	ostream& report(format == OUTPUT_FORMAT_TEXT ? cout : cerr);
+
+	if (!compileFilter(options, filter, report))
+		return false;
+	if (options.getFlows() && !openFlowTable(options, flows, streams, metrics, output, report))
+		return false;
+	if (!openExport(options, exporter, report))
+		return false;
+
+	const auto start(chrono::steady_clock::now());
+
+	if (capture.open(filename)) {
+		const CaptureIndex& index(capture.getIndex());
+		indexLoaded = capture.isIndexLoaded();
+		indexSaved = capture.isIndexSaved();
+		bytes = capture.getLength();
+
+		// mapped frames are lent to the batch, nothing is copied
+		source = [&](FrameBatch& batch) {
+			const uint64_t last(nextFrame + PIPELINE_BATCH_FRAMES < index.size()
+				? nextFrame + PIPELINE_BATCH_FRAMES : index.size());
+			for (; nextFrame < last; nextFrame++)
+				batch.records.push_back(capture.getRecord(nextFrame));
+			return !batch.records.empty();
+		};
+	} else {
+		// pipes and other unmappable inputs go through the streaming reader
+		streamBuffer.resize(FILE_STREAM_BUFFER_LENGTH);
+		frameFile.rdbuf()->pubsetbuf(streamBuffer.data(), streamBuffer.size());
+		frameFile.open(filename, ios_base::binary);
+		if (!frameFile.is_open()) {
+			report << "Error opening file: " << filename << endl;
+			return false;
+		}
+
+		reader.reset(new CaptureReader(frameFile));
+		if (!reader->isOk()) {
+			report << "Empty or unreadable capture: " << filename << endl;
+			return false;
+		}
+
+		source = [&](FrameBatch& batch) { return readStreamBatch(*reader, batch); };
+	}
+
+	DecodePipeline pipeline(options.getThreads());
+	vector<Arena> arenas(pipeline.getWorkers());
+	unique_ptr<TrafficStatistics> statistics;
+	ofstream statisticsFile;
+	TrafficSnapshot snapshot;
+	double lastSnapshot(0);
+
+	if (!openStatistics(options, pipeline.getWorkers(), statistics, statisticsFile))
+		return false;
+	// each worker sketches its own share, merged once they are done
+	vector<unique_ptr<HeavyHitters>> hitters;
+	for (unsigned i(0); options.getHeavyHitters() && i < pipeline.getWorkers(); i++)
+		hitters.emplace_back(new HeavyHitters());
+
+	RecordWriter::writeHeader(output, format);
+	writeOutput(output);
+	// the writer drops the exporter if it fails, which the workers must not race with
+	const bool exporting(exporter != nullptr);
+	uint64_t frames(0);
+	uint64_t skipped(0);
+	uint64_t filtered(0);
+
+	pipeline.run(source,
+		[&](FrameBatch& batch, const unsigned& worker) {
+			decodeBatch(batch, filter, arenas[worker], format, exporting,
+				statistics ? &statistics->getCounters(worker) : nullptr, hitters.empty() ? nullptr : hitters[worker].get());
+		},
+		[&](FrameBatch& batch) {
+			writeOutput(batch.output);
+			if (exporter && !exporter->append(batch.summaries.data(), batch.summaries.size())) {
+				report << exporter->getError() << endl;
+				exporter.reset();
+			}
+			// the table is not shared, so flows are tracked here, in capture order
+			for (const CaptureRecord& record : batch.records) {
+				if (!filter.matches(record.data, record.capturedLength))
+					continue;
+				if (flows)
+					trackFlow(*flows, streams.get(), metrics.get(), record, fragments != nullptr);
+				// fragments of one datagram may be spread over batches and workers
+				if (fragments && defragment(*fragments, record, output) && flows)
+					trackDatagram(*flows, streams.get(), metrics.get(), *fragments, record.timestamp);
+			}
+			writeOutput(output);
+			frames += batch.decoded;
+			skipped += batch.skipped;
+			filtered += batch.filtered;
+
+			// the workers keep counting while their counters are added up here
+			if (statistics && options.getStatisticsInterval()) {
+				const double now(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+				if (now - lastSnapshot >= options.getStatisticsInterval()) {
+					reportStatistics(*statistics, snapshot, now, now - lastSnapshot, statisticsFile);
+					lastSnapshot = now;
+				}
+			}
+		});
+
+	const chrono::duration<double> elapsed(chrono::steady_clock::now() - start);
+
+	if (reader) {
+		bytes = reader->getBytesRead();
+		if (!reader->isOk())
+			report << "Capture ends in a truncated or malformed record" << endl;
+	} else {
+		if (!capture.getIndex().isComplete())
+			report << "Capture ends in a truncated or malformed record" << endl;
+		if (indexLoaded || indexSaved)
+			report << "Frame index " << (indexLoaded ? "loaded from " : "saved to ")
+				<< filename << CAPTURE_INDEX_SUFFIX << endl;
+	}
+
+	if (flows)
+		closeFlowTable(*flows, streams.get(), metrics.get(), output);
+	if (fragments)
+		printDefragmentSummary(*fragments);
+	if (exporter)
+		closeExport(*exporter, report);
+	if (statistics)
+		reportStatistics(*statistics, snapshot, elapsed.count(), elapsed.count() - lastSnapshot, statisticsFile);
+	if (!hitters.empty()) {
+		for (size_t i(1); i < hitters.size(); i++)
+			hitters[0]->merge(*hitters[i]);
+		printHeavyHitters(report, *hitters[0], options.getHeavyHitters());
+	}
+	report << dec << "Decoded on " << pipeline.getWorkers() << " threads ("
+		<< pipeline.getSteals() << " batches stolen)" << endl;
+	printThroughput(report, frames, skipped, filtered, bytes, elapsed.count());
+	return true;
+}
+
+bool readStreamBatch(CaptureReader& reader, FrameBatch& batch)
+{
+	CaptureRecord record;
+
+	while (batch.records.size() < PIPELINE_BATCH_FRAMES && batch.storage.size() < STREAM_BATCH_LENGTH
+			&& reader.next(record)) {
+		batch.storage.insert(batch.storage.end(), record.data, record.data + record.capturedLength);
+		batch.records.push_back(record);
+	}
+
+	// storage may have moved while growing, so frames are pointed at once it is final
+	const char* data(batch.storage.data());
+	for (CaptureRecord& r : batch.records) {
+		r.data = data;
+		data += r.capturedLength;
+	}
+
+	return !batch.records.empty();
+}
+
+bool compileFilter(const Options& options, Filter& filter, ostream& report)
+{
+	if (!filter.compile(options.getFilter())) {
+		report << "Bad filter: " << filter.getError() << endl;
+		return false;
+	}
+	return true;
+}
+
+bool openFlowTable(const Options& options, unique_ptr<FlowTable>& flows, unique_ptr<StreamReassembler>& streams,
+	unique_ptr<TcpMetrics>& metrics, OutputBuffer& out, ostream& report)
+{
+	flows.reset(new FlowTable(options.getFlows()));
+	if (options.getStreams())
+		streams.reset(new StreamReassembler(options.getFlows()));
+	if (options.getTcpMetrics())
+		metrics.reset(new TcpMetrics(options.getFlows()));
+
+	if (!flows->isOk() || (streams && !streams->isOk()) || (metrics && !metrics->isOk())) {
+		report << "Not enough memory to track " << options.getFlows() << " flows" << endl;
+		return false;
+	}
+
+	FlowTable* table(flows.get());
+	StreamReassembler* reassembler(streams.get());
+	TcpMetrics* measured(metrics.get());
+	OutputBuffer* output(&out);
+	flows->setEvictionCallback([table, reassembler, measured, output](const Flow& flow) {
+		printFlow(*output, flow);
+		if (reassembler) {
+			printStreams(*output, *reassembler, table->getIndex(flow));
+			reassembler->release(table->getIndex(flow));
+		}
+		if (measured) {
+			if (flow.protocol == IP_PROTOCOL_TCP)
+				printTcpMetrics(*output, *measured, table->getIndex(flow));
+			measured->release(table->getIndex(flow));
+		}
+	});
+	return true;
+}
+
+void trackFlow(FlowTable& flows, StreamReassembler* streams, TcpMetrics* metrics, const CaptureRecord& record,
+	const bool& defragmenting)
+{
+	PacketSummary summary;
+
+	if (record.linkType != LINKTYPE_ETHERNET || !summary.fromBytes(record.data, record.capturedLength, record.timestamp))
+		return;
+	// reassembled, an IPv4 datagram is tracked once, whole, by trackDatagram
+	if (defragmenting && (summary.layers & PACKET_LAYER_IPV4) && ((summary.ipFlags & PACKET_IP_MF) || summary.fragmentOffset))
+		return;
+
+	trackPacket(flows, streams, metrics, summary, record.data, record.capturedLength);
+}
+
+void trackDatagram(FlowTable& flows, StreamReassembler* streams, TcpMetrics* metrics, const FragmentReassembler& fragments,
+	const uint64_t& timestamp)
+{
+	PacketSummary summary;
+
+	if (summary.fromDatagram(fragments.getDatagram(), fragments.getDatagramLength(), timestamp))
+		trackPacket(flows, streams, metrics, summary, fragments.getDatagram(), fragments.getDatagramLength());
+}
+
+// bytes and length are what the summary's offsets point into
+void trackPacket(FlowTable& flows, StreamReassembler* streams, TcpMetrics* metrics, const PacketSummary& summary,
+	const char* bytes, const unsigned& length)
+{
+	const Flow* flow(flows.update(summary));
+	// a first fragment holds only the start of its segment
+	if (!flow || !(summary.layers & PACKET_LAYER_TCP) || (summary.ipFlags & PACKET_IP_MF))
+		return;
+
+	const uint32_t index(flows.getIndex(*flow));
+	const int side(FlowTable::getSide(*flow, summary.sourceAddress, summary.sourcePort));
+	if (metrics)
+		metrics->segment(index, side, summary, TcpView(bytes + summary.transportOffset, length - summary.transportOffset));
+	if (streams)
+		streams->segment(index, side, summary.sequenceNumber, summary.tcpFlags, bytes + summary.payloadOffset,
+			summary.payloadLength);
+}
+
+void closeFlowTable(FlowTable& flows, StreamReassembler* streams, TcpMetrics* metrics, OutputBuffer& out)
+{
+	const uint64_t expired(flows.getExpired());
+	const uint64_t evicted(flows.getEvicted());
+
+	flows.flush();
+	writeOutput(out);
+	cout << dec << "Tracked " << flows.getCreated() << " flows (" << expired << " expired idle, "
+		<< evicted << " evicted from a full table, " << flows.getMemoryUsage() / 0x100000 << " MiB reserved)" << endl;
+	if (streams)
+		cout << "Reassembly: " << streams->getOverlapped() << " retransmitted or overlapping bytes trimmed, "
+			<< streams->getDropped() << " dropped at the memory cap" << endl;
+	if (!metrics)
+		return;
+	// every flow has been released by now, so the totals are complete
+	cout << "TCP: " << metrics->getRetransmissions() << " retransmissions, " << metrics->getOutOfOrder()
+		<< " out of order, " << metrics->getZeroWindows() << " zero windows, " << metrics->getWindowShrinks()
+		<< " window shrinks (" << metrics->getMemoryUsage() / 0x100000 << " MiB reserved)" << endl;
+	printRttHistogram(cout, "Handshake RTT", metrics->getHandshakes());
+	printRttHistogram(cout, "Data RTT", metrics->getRoundTrips());
+}
+
+void printFlow(OutputBuffer& out, const Flow& flow)
+{
+	out.text("FLOW ").ipv4(flow.addressA).put(':').decimal(flow.portA)
+		.text(" <-> ").ipv4(flow.addressB).put(':').decimal(flow.portB)
+		.text(flow.protocol == IP_PROTOCOL_TCP ? " TCP " : " UDP ").text(FlowTable::getStateAsString(flow.state))
+		.text(", ").decimal(flow.packets[0]).put('/').decimal(flow.packets[1]).text(" packets")
+		.text(", ").decimal(flow.bytes[0]).put('/').decimal(flow.bytes[1]).text(" bytes")
+		.text(", ").real((flow.lastSeen - flow.firstSeen) / 1e9).text("s\n");
+}
+
+void printStreams(OutputBuffer& out, const StreamReassembler& streams, const uint32_t& flow)
+{
+	out.text("\tStream: ").decimal(streams.getDelivered(flow, 0)).put('/').decimal(streams.getDelivered(flow, 1))
+		.text(" bytes reassembled, ").decimal(streams.getSkipped(flow, 0)).put('/').decimal(streams.getSkipped(flow, 1))
+		.text(" bytes missing\n");
+}
+
+// per direction, A -> B then B -> A; data RTTs are the time from a segment of that direction to the ACK covering it
+void printTcpMetrics(OutputBuffer& out, const TcpMetrics& metrics, const uint32_t& flow)
+{
+	out.text("\tTCP: handshake ");
+	if (metrics.getHandshakeRtt(flow))
+		out.decimal(metrics.getHandshakeRtt(flow)).text(" us");
+	else
+		out.text("not seen");
+	out.text(", RTT ").decimal(metrics.getSmoothedRtt(flow, 0)).put('/').decimal(metrics.getSmoothedRtt(flow, 1))
+		.text(" us (").decimal(metrics.getRttSamples(flow, 0)).put('/').decimal(metrics.getRttSamples(flow, 1))
+		.text(" samples), ").decimal(metrics.getRetransmissions(flow, 0)).put('/').decimal(metrics.getRetransmissions(flow, 1))
+		.text(" retransmissions, ").decimal(metrics.getOutOfOrder(flow, 0)).put('/').decimal(metrics.getOutOfOrder(flow, 1))
+		.text(" out of order, ").decimal(metrics.getZeroWindows(flow, 0)).put('/').decimal(metrics.getZeroWindows(flow, 1))
+		.text(" zero windows, ").decimal(metrics.getWindowShrinks(flow, 0)).put('/')
+		.decimal(metrics.getWindowShrinks(flow, 1)).text(" window shrinks\n");
+}
+
+// one line per power of two of microseconds, empty ones left out
+void printRttHistogram(ostream& out, const char* name, const RttHistogram& histogram)
 {
-	ifstream frameFile(filename, ios_base::binary);
-	if (!frameFile.is_open()) {
-		cout << "Error opening file: " << filename << endl;
+	out << dec << name << ": " << histogram.samples << " samples, mean " << histogram.getMean() << " us" << endl;
+	for (unsigned b(0); b < TCP_METRICS_BUCKETS; b++) {
+		if (!histogram.buckets[b])
+			continue;
+		out << "\t" << RttHistogram::getBucketStart(b);
+		if (b + 1 < TCP_METRICS_BUCKETS)
+			out << "-" << RttHistogram::getBucketStart(b + 1) - 1;
+		else
+			out << "+";
+		out << " us: " << histogram.buckets[b] << endl;
+	}
+}
+
+bool openExport(const Options& options, unique_ptr<ColumnWriter>& exporter, ostream& report)
+{
+	if (options.getExportFilename().empty())
+		return true;
+
+	exporter.reset(new ColumnWriter());
+	if (!exporter->open(options.getExportFilename())) {
+		report << exporter->getError() << endl;
+		return false;
+	}
+	return true;
+}
+
+void closeExport(ColumnWriter& exporter, ostream& report)
+{
+	if (!exporter.close()) {
+		report << exporter.getError() << endl;
 		return;
 	}
+	report << dec << "Exported " << exporter.getRows() << " rows in " << exporter.getBytesWritten() << " bytes ("
+		<< fixed << setprecision(1) << exporter.getBytesWritten() / (exporter.getRows() ? exporter.getRows() : 1.0)
+		<< " per row)" << endl;
+	report.unsetf(ios_base::floatfield);
+	report << setprecision(6);
+}
+
+bool openStatistics(const Options& options, const unsigned& threads, unique_ptr<TrafficStatistics>& statistics,
+	ofstream& file)
+{
+	if (!options.getStatistics())
+		return true;
+
+	statistics.reset(new TrafficStatistics(threads));
+	if (options.getStatisticsFilename().empty())
+		return true;
+
+	file.open(options.getStatisticsFilename(), ios_base::app);
+	if (!file.is_open()) {
+		cerr << "Error opening file: " << options.getStatisticsFilename() << endl;
+		return false;
+	}
+	return true;
+}
+
+// prints the counters as they are now next to how they moved since the previous snapshot, which they then become
+void reportStatistics(const TrafficStatistics& statistics, TrafficSnapshot& previous, const double& elapsed,
+	const double& interval, ofstream& file)
+{
+	TrafficSnapshot current;
+
+	statistics.snapshot(current);
+	printStatistics(cerr, current, previous, elapsed, interval);
+	if (file.is_open()) {
+		writeStatistics(file, current, elapsed);
+		file.flush();
+	}
+	swap(previous, current);
+}
+
+void printStatistics(ostream& out, const TrafficSnapshot& current, const TrafficSnapshot& previous, const double& elapsed,
+	const double& interval)
+{
+	const double seconds(interval > 0 ? interval : 1e-9);
+	vector<uint16_t> ports;
+
+	out << dec << fixed << setprecision(2) << "Statistics at " << elapsed << "s: " << current.frames << " frames, "
+		<< current.bytes << " bytes; " << setprecision(0) << (current.frames - previous.frames) / seconds << " frames/s, "
+		<< setprecision(2) << (current.bytes - previous.bytes) * 8 / seconds / 1e6 << " Mbit/s over the last "
+		<< interval << "s" << endl;
+	out.unsetf(ios_base::floatfield);
+	out << setprecision(6);
 
-	EthernetFrame ef(frameFile);
+	out << "\tIPv4 " << current.ipv4 << ", IPv6 " << current.ipv6 << ", other " << current.frames - current.ipv4 - current.ipv6 << endl;
+
+	const char* separator(" ");
+	out << "\tProtocols:";
+	for (unsigned p(0); p < STATISTICS_PROTOCOLS; p++) {
+		if (current.protocols[p]) {
+			out << separator << (p == IPV6_PROTOCOL_ICMPV6 ? "ICMPv6" : IpFrame::getProtocolName(p)) << " (" << p << ") "
+				<< current.protocols[p];
+			separator = ", ";
+		}
+	}
+	out << endl;
+
+	current.getTopPorts(STATISTICS_TOP_PORTS, ports);
+	out << "\tTop ports:";
+	for (size_t i(0); i < ports.size(); i++)
+		out << (i ? ", " : " ") << ports[i] << " " << current.ports[ports[i]];
+	out << endl;
+
+	separator = " ";
+	out << "\tPrecedence:";
+	for (unsigned p(0); p < STATISTICS_PRECEDENCES; p++) {
+		if (current.precedences[p]) {
+			out << separator << IpFrame::getPrecedenceName(p) << " " << current.precedences[p];
+			separator = ", ";
+		}
+	}
+	out << endl;
+
+	out << "\tTCP flags:";
+	for (unsigned f(0); f < STATISTICS_TCP_FLAGS; f++)
+		out << (f ? ", " : " ") << TrafficSnapshot::getTcpFlagName(f) << " " << current.tcpFlags[f];
+	out << endl;
+
+	out << "\tFrame sizes:";
+	for (unsigned b(0); b < STATISTICS_SIZE_BUCKETS; b++)
+		out << (b ? ", " : " ") << TrafficSnapshot::getSizeBucketName(b) << " " << current.sizes[b];
+	out << endl;
+}
+
+// one JSON object per line; zero counters and ports outside the top are left out
+void writeStatistics(ostream& out, const TrafficSnapshot& snapshot, const double& elapsed)
+{
+	vector<uint16_t> ports;
+
+	out << dec << "{\"elapsed\":" << elapsed << ",\"frames\":" << snapshot.frames << ",\"bytes\":" << snapshot.bytes
+		<< ",\"ipv4\":" << snapshot.ipv4 << ",\"ipv6\":" << snapshot.ipv6 << ",\"protocols\":{";
+	const char* separator("");
+	for (unsigned p(0); p < STATISTICS_PROTOCOLS; p++) {
+		if (snapshot.protocols[p]) {
+			out << separator << "\"" << p << "\":" << snapshot.protocols[p];
+			separator = ",";
+		}
+	}
+
+	out << "},\"top_ports\":{";
+	snapshot.getTopPorts(STATISTICS_TOP_PORTS, ports);
+	separator = "";
+	for (const uint16_t& port : ports) {
+		out << separator << "\"" << port << "\":" << snapshot.ports[port];
+		separator = ",";
+	}
+
+	out << "},\"precedence\":[";
+	for (unsigned p(0); p < STATISTICS_PRECEDENCES; p++)
+		out << (p ? "," : "") << snapshot.precedences[p];
+	out << "],\"tcp_flags\":{";
+	for (unsigned f(0); f < STATISTICS_TCP_FLAGS; f++)
+		out << (f ? ",\"" : "\"") << TrafficSnapshot::getTcpFlagName(f) << "\":" << snapshot.tcpFlags[f];
+	out << "},\"sizes\":{";
+	for (unsigned b(0); b < STATISTICS_SIZE_BUCKETS; b++)
+		out << (b ? ",\"" : "\"") << TrafficSnapshot::getSizeBucketName(b) << "\":" << snapshot.sizes[b];
+	out << "}}" << endl;
+}
+
+// estimates: each key weighs at least "at least" and at most the figure given, usually much closer to the latter
+void printHeavyHitters(ostream& out, const HeavyHitters& hitters, const unsigned& count)
+{
+	vector<HeavyHitter> top;
+
+	for (unsigned d(0); d < HEAVY_HITTER_DIMENSIONS; d++) {
+		const HeavyHitterDimension dimension(static_cast<HeavyHitterDimension>(d));
+		const uint64_t total(hitters.getTotal(dimension));
+
+		out << dec << "Top " << HeavyHitters::getDimensionName(dimension) << " of " << total << " bytes, about "
+			<< static_cast<uint64_t>(hitters.getDistinct(dimension) + 0.5) << " distinct:" << endl;
+		hitters.getTop(dimension, count, top);
+		for (const HeavyHitter& hitter : top) {
+			out << "\t" << HeavyHitters::keyToString(dimension, hitter.key) << " " << hitter.estimate << " bytes ("
+				<< fixed << setprecision(1) << 100.0 * hitter.estimate / (total ? total : 1) << "%), at least "
+				<< hitter.guaranteed << endl;
+			out.unsetf(ios_base::floatfield);
+			out << setprecision(6);
+		}
+	}
+}
+
+void decodeBatch(FrameBatch& batch, const Filter& filter, Arena& arena, const OutputFormat& format, const bool& exporting,
+	TrafficCounters* counters, HeavyHitters* hitters)
+{
+	for (const CaptureRecord& record : batch.records) {
+		if (record.linkType != LINKTYPE_ETHERNET) {
+			batch.skipped++;
+			continue;
+		}
+		// rejected frames never reach the decoders
+		if (!filter.matches(record.data, record.capturedLength)) {
+			batch.filtered++;
+			continue;
+		}
+
+		if (format == OUTPUT_FORMAT_TEXT) {
+			EthernetFrame ef(record.data, record.capturedLength, &arena);
+			printFrame(batch.output, ef);
+		}
+		if (format != OUTPUT_FORMAT_TEXT || exporting || counters || hitters) {
+			// records, columns, counters and sketches need no layer objects, the views are enough
+			PacketSummary summary;
+			summary.fromBytes(record.data, record.capturedLength, record.timestamp);
+			if (format != OUTPUT_FORMAT_TEXT)
+				RecordWriter::write(batch.output, format, summary, record.data);
+			if (exporting)
+				batch.summaries.push_back(summary);
+			if (counters)
+				TrafficStatistics::count(*counters, summary);
+			if (hitters)
+				hitters->count(summary, record.data);
+		}
+		batch.decoded++;
+	}
+
+	// every layer decoded from the batch goes at once
+	arena.reset();
+}
+
+void writeOutput(OutputBuffer& out)
+{
+	if (out.empty())
+		return;
+	// summaries and errors still go through cout, so whatever it holds must land first
+	cout.flush();
+	if (!out.flush(STDOUT_FILENO))
+		cerr << "Writing the output failed" << endl;
+}
+
+void printThroughput(ostream& out, const uint64_t& frames, const uint64_t& skipped, const uint64_t& filtered,
+	const uint64_t& bytes, const double& elapsed)
+{
+	const double seconds(elapsed > 0 ? elapsed : 1e-9);
+
+	out << dec << "Read " << frames << " frames (" << bytes << " bytes) in " << elapsed << "s" << endl;
+	if (skipped)
+		out << "Skipped " << skipped << " non-ethernet records" << endl;
+	if (filtered)
+		out << "Filtered out " << filtered << " frames" << endl;
+	out << fixed << setprecision(0) << frames / seconds << " frames/s, "
+		<< setprecision(2) << bytes / seconds / 1e6 << " MB/s" << endl;
+	out.unsetf(ios_base::floatfield);
+	out << setprecision(6);
+}
+
+void printFrame(OutputBuffer& out, const EthernetFrame& ef)
+{
 	const IpFrame* ipf(ef.getIpFrame());
+	const Ipv6Frame* ipv6f(ef.getIpv6Frame());
+
+	out.text("START ETHERNET FRAME\n");
+	out.text("Source MAC Address: ").mac(reinterpret_cast<const uint8_t*>(ef.getSourceAddress())).put('\n');
+	out.text("Destination MAC Address: ").mac(reinterpret_cast<const uint8_t*>(ef.getDestinationAddress())).put('\n');
+	for (unsigned i(0); i < ef.getVlanCount(); i++)
+		out.text("VLAN: ").decimal(ef.getVlanId(i)).text(" (priority ").decimal(ef.getVlanPriority(i)).text(")\n");
+	out.text("Type: ").hex(ef.getEthertype(), 4).text(" (").text(ef.getEthertypeName()).text(")\n");
+	if (ipf)
+		printIpFrame(out, *ipf);
+	if (ipv6f)
+		printIpv6Frame(out, *ipv6f);
+}
+
+void printIpFrame(OutputBuffer& out, const IpFrame& ip)
+{
+	const IpFrame* ipf(&ip);
 	const TcpFrame* tcpf(ipf->getTcpFrame());
+	const UdpFrame* udpf(ipf->getUdpFrame());
+	const IcmpFrame* icmpf(ipf->getIcmpFrame());
 
-	cout << "START ETHERNET FRAME" << endl;
-	cout << "Source MAC Address: ";
-	cout << ef.getSourceAddressAsString() << endl;
-	cout << "Destination MAC Address: ";
-	cout << ef.getDestinationAddressAsString() << endl;
-	cout << "Type: " << ef.getEthertypeAsString() << endl;
-	cout << "START IP HEADER:" << endl;
-	cout << "\tVersion: " << hex << ipf->getVersion() << endl;
-	cout << "\tIHL: " << ipf->getIhl() << endl;
-	cout << "\tTYPE OF SERVICE" << endl;
-	cout << "\t\t" << "Precedence: " << ipf->getPrecedence() << " (" << ipf->getPrecedenceAsString() << ")" << endl;
-	cout << "\t\t" << "Delay: " << ipf->getDelayAsString() << endl;
-	cout << "\t\t" << "Throughput: " << ipf->getThroughputAsString() << endl;
-	cout << "\t\t" << "Reliability: " << ipf->getReliabilityAsString() << endl;
-	cout << "\t\t" << "Reserved bits: " << (ipf->getReservedTosBits() ? "NOT ZERO" : "00 (OK)") << endl;
-	cout << "\tEND TYPE OF SERVICE" << endl;
-	cout << "\tTotal Length: " << dec << ipf->getTotalLength() << " bytes" << endl;
-	cout << "\tID (hex): " << hex << ipf->getId() << endl;
-	cout << "\tDF: " << ipf->getDf();
-
-	if (ipf->getDf())
-		cout << " (Don't fragment)";
-	else
-		cout << " (Is fragmented)";
-	cout << endl;
+	out.text("START IP HEADER:\n");
+	out.text("\tVersion: ").hex(ipf->getVersion()).put('\n');
+	out.text("\tIHL: ").hex(ipf->getIhl()).put('\n');
+	out.text("\tTYPE OF SERVICE\n");
+	out.text("\t\tPrecedence: ").hex(ipf->getPrecedence()).text(" (").text(ipf->getPrecedenceAsString()).text(")\n");
+	out.text("\t\tDelay: ").text(ipf->getDelayAsString()).put('\n');
+	out.text("\t\tThroughput: ").text(ipf->getThroughputAsString()).put('\n');
+	out.text("\t\tReliability: ").text(ipf->getReliabilityAsString()).put('\n');
+	out.text("\t\tReserved bits: ").text(ipf->getReservedTosBits() ? "NOT ZERO" : "00 (OK)").put('\n');
+	out.text("\tEND TYPE OF SERVICE\n");
+	out.text("\tTotal Length: ").decimal(ipf->getTotalLength()).text(" bytes\n");
+	out.text("\tID (hex): ").hex(ipf->getId()).put('\n');
+	out.text("\tDF: ").hex(ipf->getDf()).text(ipf->getDf() ? " (Don't fragment)\n" : " (Is fragmented)\n");
+	out.text("\tMF: ").hex(ipf->getMf()).text(ipf->getMf() ? " (More frames)\n" : " (Is last frame)\n");
+	out.text("\tOffset: ").hex(ipf->getOffset()).put('\n');
+
+	out.text("\tChecksum (hex): ").hex(ipf->getCheckSum()).put('\n');
+	out.text("\tCalculated checksum (hex): ").hex(ipf->getCalculatedCheckSum()).put('\n');
+	out.text(ipf->checksumIsOk() ? "\tChecksum OK\n" : "\tCHECKSUM NOT MATCHED\n");
 
-	cout << "\tMF: " << ipf->getMf();
-	
-	if (ipf->getMf()) {
-		cout << " (More frames)";
+	out.text("\tTTL: ").decimal(ipf->getTtl()).text("s\n");
+	out.text("\tProtocol (hex): ").hex(ipf->getProtocol()).text(" (").text(ipf->getProtocolAsString()).text(")\n");
+	out.text("\tSource Address: ").ipv4(ipf->getSourceAddress()).put('\n');
+	out.text("\tDestination Address: ").ipv4(ipf->getDestinationAddress()).put('\n');
+
+	if (udpf)
+		printUdpFrame(out, *udpf);
+	if (icmpf)
+		printIcmpFrame(out, *icmpf);
+	if (tcpf)
+		printTcpFrame(out, *tcpf);
+
+	out.text("END IP HEADER\n");
+}
+
+void printIpv6Frame(OutputBuffer& out, const Ipv6Frame& ip)
+{
+	const TcpFrame* tcpf(ip.getTcpFrame());
+	const UdpFrame* udpf(ip.getUdpFrame());
+
+	out.text("START IPV6 HEADER:\n");
+	out.text("\tVersion: ").decimal(ip.getVersion()).put('\n');
+	out.text("\tTraffic Class (hex): ").hex(ip.getTrafficClass()).put('\n');
+	out.text("\tFlow Label (hex): ").hex(ip.getFlowLabel()).put('\n');
+	out.text("\tPayload Length: ").decimal(ip.getPayloadLength()).text(" bytes\n");
+	out.text("\tNext Header (hex): ").hex(ip.getNextHeader()).put('\n');
+	out.text("\tHop Limit: ").decimal(ip.getHopLimit()).put('\n');
+	out.text("\tSource Address: ").ipv6(ip.getSourceAddress()).put('\n');
+	out.text("\tDestination Address: ").ipv6(ip.getDestinationAddress()).put('\n');
+
+	if (!ip.extensionHeadersAreOk()) {
+		out.text("\tEXTENSION HEADERS NOT FOLLOWED\n");
 	} else {
-		cout << " (Is last frame)";
+		out.text("\tExtension Headers: ").decimal(ip.getExtensionHeadersLength()).text(" bytes\n");
+		if (ip.isFragment())
+			out.text("\tFragment Offset: ").decimal(ip.getFragmentOffset())
+				.text(ip.getMoreFragments() ? " (More frames)\n" : " (Is last frame)\n");
+		out.text("\tProtocol (hex): ").hex(ip.getProtocol()).text(" (").text(ip.getProtocolAsString()).text(")\n");
 	}
 
-	cout << endl;
+	if (udpf)
+		printUdpFrame(out, *udpf);
+	if (tcpf)
+		printTcpFrame(out, *tcpf);
 
-	cout << "\tOffset: " << ipf->getOffset() << endl;
+	out.text("END IPV6 HEADER\n");
+}
 
-	cout << "\tChecksum (hex): " << hex << ipf->getCheckSum() << endl;
-	cout << "\tCalculated checksum (hex): " << hex << ipf->getCalculatedCheckSum() << endl;
-	cout << '\t';
-	if (ipf->checksumIsOk())
-		cout << "Checksum OK" << endl;
-	else
-		cout << "CHECKSUM NOT MATCHED" << endl;
+// numbers stay in hex, as they always have: the stream used to carry the IP protocol's hex over
+void printTcpFrame(OutputBuffer& out, const TcpFrame& tcp)
+{
+	const TcpFrame* tcpf(&tcp);
+	char flags[TCP_FLAGS_TEXT_LENGTH];
+
+	out.text("\tSTART TCP HEADER\n");
+	out.text("\t\tSource Port: ::").decimal(tcpf->getSourcePort()).put('\n');
+	out.text("\t\tDestination Port: ::").decimal(tcpf->getDestinationPort()).put('\n');
+	out.text("\t\tSequence Number: ").hex(tcpf->getSequenceNumber()).put('\n');
+	out.text("\t\tAcknowledgement Number: ").hex(tcpf->getAcknowledgementNumber()).put('\n');
+	out.text("\t\tData Offset: ").hex(tcpf->getDataOffset()).put('\n');
+	out.text("\t\tFlags: ").text(flags, tcpf->formatFlags(flags)).put('\n');
+	out.text("\t\tWindow: ").hex(tcpf->getWindow()).put('\n');
+	out.text("\t\tChecksum (hex): ").hex(tcpf->getCheckSum()).put('\n');
+	if (tcpf->checkSumIsVerifiable()) {
+		out.text("\t\tCalculated checksum (hex): ").hex(tcpf->getCalculatedCheckSum()).put('\n');
+		out.text(tcpf->checkSumIsOk() ? "\t\tChecksum OK\n" : "\t\tCHECKSUM NOT MATCHED\n");
+	} else {
+		out.text("\t\tChecksum not verifiable, segment snapped\n");
+	}
+	out.text("\t\tUrgent Pointer: ").hex(tcpf->getUrgentPointer()).put('\n');
+	out.text("\tEND TCP HEADER\n");
+}
+
+void printUdpFrame(OutputBuffer& out, const UdpFrame& udp)
+{
+	const UdpFrame* udpf(&udp);
+
+	out.text("\tSTART UDP HEADER\n");
+	out.text("\t\tSource Port: ::").decimal(udpf->getSourcePort()).put('\n');
+	out.text("\t\tDestination Port: ::").decimal(udpf->getDestinationPort()).put('\n');
+	out.text("\t\tLength: ").decimal(udpf->getLength()).put('\n');
+	out.text("\t\tChecksum (hex): ").hex(udpf->getCheckSum()).put('\n');
+	if (!udpf->checkSumIsPresent()) {
+		out.text("\t\tNo checksum\n");
+	} else if (udpf->checkSumIsVerifiable()) {
+		out.text("\t\tCalculated checksum (hex): ").hex(udpf->getCalculatedCheckSum()).put('\n');
+		out.text(udpf->checkSumIsOk() ? "\t\tChecksum OK\n" : "\t\tCHECKSUM NOT MATCHED\n");
+	} else {
+		out.text("\t\tChecksum not verifiable, datagram snapped\n");
+	}
+	out.text("\tEND UDP HEADER\n");
+}
 
-	cout << "\tTTL: " << dec << ipf->getTtl() << "s" << endl;
-	cout << "\tProtocol (hex): " << hex << ipf->getProtocol()
-		<< " (" << ipf->getProtocolAsString() << ")" << endl;
-	cout << "\tSource Address: " << ipf->getSourceAddressAsString() << endl;
-	cout << "\tDestination Address: " << ipf->getDestinationAddressAsString() << endl;
+void printIcmpFrame(OutputBuffer& out, const IcmpFrame& icmp)
+{
+	const IcmpFrame* icmpf(&icmp);
+
+	out.text("\tSTART ICMP HEADER\n");
+	out.text("\t\tType: ").decimal(icmpf->getType()).text(" (").text(icmpf->getTypeAsString()).text(")\n");
+	out.text("\t\tCode: ").decimal(icmpf->getCode()).put('\n');
+	if (icmpf->isEcho()) {
+		out.text("\t\tIdentifier: ").decimal(icmpf->getIdentifier()).put('\n');
+		out.text("\t\tSequence Number: ").decimal(icmpf->getSequenceNumber()).put('\n');
+	}
+	out.text("\t\tChecksum (hex): ").hex(icmpf->getCheckSum()).put('\n');
+	if (icmpf->checkSumIsVerifiable()) {
+		out.text("\t\tCalculated checksum (hex): ").hex(icmpf->getCalculatedCheckSum()).put('\n');
+		out.text(icmpf->checkSumIsOk() ? "\t\tChecksum OK\n" : "\t\tCHECKSUM NOT MATCHED\n");
+	} else {
+		out.text("\t\tChecksum not verifiable, message snapped\n");
+	}
+	out.text("\tEND ICMP HEADER\n");
+}
 
-	cout << "\tSTART TCP HEADER" << endl;
-	cout << "\t\tSource Port: " << tcpf->getSourcePortAsString() << endl;
-	cout << "\t\tDestination Port: " << tcpf->getDestinationPortAsString() << endl;
-	cout << "\t\tSequence Number: " << tcpf->getSequenceNumber() << endl;
-	cout << "\t\tAcknowledgement Number: " << tcpf->getAcknowledgementNumber() << endl;
-	cout << "\t\tData Offset: " << tcpf->getDataOffset() << endl;
-	cout << "\t\tFlags: " << tcpf->getFlagsAsString() << endl;
-	cout << "\t\tWindow: " << tcpf->getWindow() << endl;
-	cout << "\t\tCheckSum: " << tcpf->getCheckSum() << endl;
-	cout << "\t\tUrgent Pointer: " << tcpf->getUrgentPointer() << endl;
-	cout << "\tEND TCP HEADER" << endl;
+// true when the record completed a datagram, which the reassembler holds until the next add
+bool defragment(FragmentReassembler& fragments, const CaptureRecord& record, OutputBuffer& out)
+{
+	const EthernetView ethernet(record.data, record.capturedLength);
+
+	if (record.linkType != LINKTYPE_ETHERNET || !ethernet.isValid() || ethernet.getType() != ETHERTYPE_IPV4)
+		return false;
+
+	const char* ip(reinterpret_cast<const char*>(ethernet.getPayload()));
+	if (!FragmentReassembler::isFragment(ip, ethernet.getPayloadLength())
+			|| !fragments.add(ip, ethernet.getPayloadLength(), record.timestamp))
+		return false;
+
+	// the whole datagram goes through the same decoders as an unfragmented one
+	const IpFrame ipf(fragments.getDatagram(), fragments.getDatagramLength());
+	out.text("START REASSEMBLED DATAGRAM (").decimal(fragments.getDatagramFragments()).text(" fragments)\n");
+	printIpFrame(out, ipf);
+	out.text("END REASSEMBLED DATAGRAM\n");
+	return true;
+}
+
+void printDefragmentSummary(const FragmentReassembler& fragments)
+{
+	cout << dec << "Reassembled " << fragments.getReassembled() << " datagrams (" << fragments.getTimedOut()
+		<< " timed out, " << fragments.getEvicted() << " evicted from a full pool, " << fragments.getMalformed()
+		<< " bad fragments, " << fragments.size() << " incomplete)" << endl;
+}
+
+bool analizeInterface(const Options& options)
+{
+	const string& name(options.getInterface());
+	const unsigned limit(options.getCount());
+	LiveCapture capture;
+	Arena arena;
+	uint64_t frames(0);
+	uint64_t bytes(0);
+	uint64_t filtered(0);
+	uint64_t reportedDrops(0);
+	Filter filter;
+	unique_ptr<FlowTable> flows;
+	unique_ptr<StreamReassembler> streams;
+	unique_ptr<TcpMetrics> metrics;
+	unique_ptr<FragmentReassembler> fragments(options.getDefragment() ? new FragmentReassembler() : nullptr);
+	unique_ptr<ColumnWriter> exporter;
+	OutputBuffer output;
+	const OutputFormat format(options.getFormat());
+	ostream& report(format == OUTPUT_FORMAT_TEXT ? cout : cerr);
+
+	if (!compileFilter(options, filter, report))
+		return false;
+	if (options.getFlows() && !openFlowTable(options, flows, streams, metrics, output, report))
+		return false;
+	if (!openExport(options, exporter, report))
+		return false;
+
+	// one thread decodes everything here; fanout spreads the load over processes instead
+	unique_ptr<TrafficStatistics> statistics;
+	ofstream statisticsFile;
+	TrafficSnapshot snapshot;
+	double lastSnapshot(0);
+	if (!openStatistics(options, 1, statistics, statisticsFile))
+		return false;
+	unique_ptr<HeavyHitters> hitters(options.getHeavyHitters() ? new HeavyHitters() : nullptr);
+
+	if (!capture.open(name, options.getBlockSize(), options.getRingBlocks(), options.getFanout())) {
+		report << "Error opening interface " << name << ": " << capture.getError() << endl;
+		return false;
+	}
+
+	interrupted = 0;
+	signal(SIGINT, onInterrupt);
+	report << "Capturing on " << name << ", Ctrl-C to stop" << endl;
+	RecordWriter::writeHeader(output, format);
+
+	const auto start(chrono::steady_clock::now());
+	auto lastReport(start);
+
+	while (!interrupted && (!limit || frames < limit)) {
+		const int dispatched(capture.dispatch([&](const CaptureRecord& record) {
+			if (limit && frames >= limit)
+				return;
+			if (!filter.matches(record.data, record.capturedLength)) {
+				filtered++;
+				return;
+			}
+
+			if (format == OUTPUT_FORMAT_TEXT) {
+				EthernetFrame ef(record.data, record.capturedLength, &arena);
+				printFrame(output, ef);
+			}
+			if (format != OUTPUT_FORMAT_TEXT || exporter || statistics || hitters) {
+				PacketSummary summary;
+				summary.fromBytes(record.data, record.capturedLength, record.timestamp);
+				if (format != OUTPUT_FORMAT_TEXT)
+					RecordWriter::write(output, format, summary, record.data);
+				if (exporter && !exporter->append(&summary, 1)) {
+					report << exporter->getError() << endl;
+					exporter.reset();
+				}
+				if (statistics)
+					TrafficStatistics::count(statistics->getCounters(0), summary);
+				if (hitters)
+					hitters->count(summary, record.data);
+			}
+			if (flows)
+				trackFlow(*flows, streams.get(), metrics.get(), record, fragments != nullptr);
+			if (fragments && defragment(*fragments, record, output) && flows)
+				trackDatagram(*flows, streams.get(), metrics.get(), *fragments, record.timestamp);
+			frames++;
+			bytes += record.capturedLength;
+			if (output.size() >= LIVE_OUTPUT_LENGTH)
+				writeOutput(output);
+		}, LIVE_CAPTURE_BLOCK_TIMEOUT));
+		// a ring block is the live counterpart of a batch
+		arena.reset();
+		writeOutput(output);
+
+		if (dispatched < 0)
+			break;
+
+		// drops mean the ring filled up faster than frames were decoded
+		const auto now(chrono::steady_clock::now());
+		if (now - lastReport >= chrono::seconds(1)) {
+			capture.updateStatistics();
+			if (capture.getDropped() > reportedDrops) {
+				cerr << "Kernel dropped " << capture.getDropped() - reportedDrops
+					<< " frames, the analyzer is falling behind" << endl;
+				reportedDrops = capture.getDropped();
+			}
+			lastReport = now;
+		}
+
+		if (statistics && options.getStatisticsInterval()) {
+			const double seconds(chrono::duration<double>(now - start).count());
+			if (seconds - lastSnapshot >= options.getStatisticsInterval()) {
+				reportStatistics(*statistics, snapshot, seconds, seconds - lastSnapshot, statisticsFile);
+				lastSnapshot = seconds;
+			}
+		}
+	}
 
-	cout << "END IP HEADER" << endl;
+	signal(SIGINT, SIG_DFL);
+	capture.updateStatistics();
 
-	frameFile.close();
+	const chrono::duration<double> elapsed(chrono::steady_clock::now() - start);
+	if (flows)
+		closeFlowTable(*flows, streams.get(), metrics.get(), output);
+	if (fragments)
+		printDefragmentSummary(*fragments);
+	if (exporter)
+		closeExport(*exporter, report);
+	if (statistics)
+		reportStatistics(*statistics, snapshot, elapsed.count(), elapsed.count() - lastSnapshot, statisticsFile);
+	if (hitters)
+		printHeavyHitters(report, *hitters, options.getHeavyHitters());
+	report << dec << "Kernel: " << capture.getReceived() << " frames received, "
+		<< capture.getDropped() << " dropped, " << capture.getFreezes() << " ring freezes" << endl;
+	printThroughput(report, frames, 0, filtered, bytes, elapsed.count());
+	return true;
 }
 
-void analizeInterface()
+void onInterrupt(int)
 {
-	cout << "Working on it!" << endl;
+	interrupted = 1;
 }
 
 MenuOption menu()
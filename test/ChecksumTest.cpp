@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <Checksum.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define CHECKSUM_TEST_BUFFERS		20000
+// measured in octets
+#define CHECKSUM_TEST_MAX_LENGTH	0x10000
+// start offsets past an aligned buffer, so the kernels also load across lines
+#define CHECKSUM_TEST_MAX_OFFSET	64
+
+typedef uint16_t (*SumFunction)(const uint8_t*, const size_t&);
+
+struct Kernel {
+	const char* name;
+	SumFunction sum;
+	bool supported;
+};
+
+bool testChecksum(const uint64_t& seed, ostream& out)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	const bool sse2(__builtin_cpu_supports("sse2"));
+	const bool avx2(__builtin_cpu_supports("avx2"));
+#else
+	// off x86 the vector kernels are the scalar one under another name
+	const bool sse2(true);
+	const bool avx2(true);
+#endif
+	const Kernel kernels[] = {
+		{ "sum", Checksum::sum, true },
+		{ "scalar", Checksum::sumScalar, true },
+		{ "sse2", Checksum::sumSse2, sse2 },
+		{ "avx2", Checksum::sumAvx2, avx2 }
+	};
+
+	mt19937_64 random(seed);
+	vector<uint8_t> buffer(CHECKSUM_TEST_MAX_LENGTH + CHECKSUM_TEST_MAX_OFFSET);
+
+	for (const Kernel& kernel : kernels) {
+		if (!kernel.supported)
+			out << "checksum: " << kernel.name << " not supported here, skipped" << endl;
+	}
+
+	for (unsigned n(0); n < CHECKSUM_TEST_BUFFERS; n++) {
+		// short lengths are where the tails and the dispatch threshold are, so a quarter stay short
+		const size_t length(n % 4 ? random() % (CHECKSUM_TEST_MAX_LENGTH + 1) : random() % 257);
+		const size_t offset(random() % CHECKSUM_TEST_MAX_OFFSET);
+		// all-ones runs push the lanes to their largest carries
+		const bool saturated(n % 16 == 0);
+
+		for (size_t i(0); i < length; i += sizeof(uint64_t)) {
+			const uint64_t word(saturated ? ~uint64_t(0) : random());
+			memcpy(buffer.data() + offset + i, &word, min(sizeof(word), length - i));
+		}
+
+		const uint8_t* bytes(buffer.data() + offset);
+		const uint16_t expected(Checksum::sumReference(bytes, length));
+
+		for (const Kernel& kernel : kernels) {
+			if (!kernel.supported)
+				continue;
+			const uint16_t actual(kernel.sum(bytes, length));
+			if (actual != expected) {
+				out << "checksum: " << kernel.name << " gave " << hex << actual << " instead of " << expected << dec
+					<< " for " << length << " octets at offset " << offset << " (buffer " << n << ")" << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <ColumnFormat.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define COLUMN_TEST_ROUNDS		3000
+#define COLUMN_TEST_MAX_ROWS	5000
+
+typedef enum {
+	// every row in the same number of bits, up to all 64
+	COLUMN_TEST_WIDTH,
+	// both ends of the 64-bit range, so nothing fits in fewer bits
+	COLUMN_TEST_EXTREMES,
+	// a handful of values anywhere in the range, which a dictionary holds
+	COLUMN_TEST_FEW,
+	// close to one value per row, too many for a dictionary
+	COLUMN_TEST_MANY,
+	// growing like timestamps, with the odd step back
+	COLUMN_TEST_RISING,
+	COLUMN_TEST_SHAPES
+} ColumnTestShape;
+
+static const ColumnEncoding encodings[] = {
+	COLUMN_ENCODING_DELTA, COLUMN_ENCODING_DICTIONARY, COLUMN_ENCODING_BITPACKED
+};
+
+static void makeValues(mt19937_64& random, vector<uint64_t>& values)
+{
+	const unsigned shape(random() % COLUMN_TEST_SHAPES);
+	const unsigned width(random() % 65);
+	const uint64_t mask(width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1);
+	const uint64_t base(random());
+	vector<uint64_t> few(random() % 16 + 1);
+	uint64_t value(random());
+
+	for (uint64_t& v : few)
+		v = random();
+
+	// now and then none or hardly any
+	values.resize(random() % 8 ? random() % COLUMN_TEST_MAX_ROWS + 1 : random() % 3);
+
+	for (uint64_t& v : values) {
+		switch (shape) {
+		case COLUMN_TEST_WIDTH:
+			v = base + (random() & mask);
+			break;
+		case COLUMN_TEST_EXTREMES:
+			v = random() % 4 ? random() : random() % 2 ? 0 : ~uint64_t(0);
+			break;
+		case COLUMN_TEST_FEW:
+			v = few[random() % few.size()];
+			break;
+		case COLUMN_TEST_MANY:
+			v = random() % 8 ? random() : base;
+			break;
+		default:
+			value += random() % 8 ? random() % 1000000 : 0 - random() % 1000;
+			v = value;
+		}
+	}
+}
+
+static unsigned widthOf(const uint64_t& value)
+{
+	unsigned width(0);
+	for (uint64_t v(value); v; v >>= 1)
+		width++;
+	return width;
+}
+
+/*
+ * Every encoding must give back exactly what went in, from chunks that
+ * follow other data in the buffer. A dictionary with too many distinct
+ * values falls back to bit-packing, and a chunk cut short by one octet
+ * must fail to decode rather than make up values.
+ */
+static bool testColumnEncoding(const vector<uint64_t>& values, const ColumnEncoding& preferred, ostream& out)
+{
+	const set<uint64_t> distinct(values.begin(), values.end());
+	const uint64_t minimum(values.empty() ? 0 : *distinct.begin());
+	const uint64_t maximum(values.empty() ? 0 : *distinct.rbegin());
+	ColumnEncoding expected(preferred);
+	vector<uint8_t> bytes(values.size() % 5, 0xA5);
+	const size_t start(bytes.size());
+	vector<uint64_t> decoded;
+	ColumnChunk chunk;
+
+	if (values.empty() || (preferred == COLUMN_ENCODING_DICTIONARY && distinct.size() * COLUMN_DICTIONARY_RATIO > values.size()))
+		expected = COLUMN_ENCODING_BITPACKED;
+
+	ColumnFormat::encode(values.data(), values.size(), preferred, bytes, chunk);
+	if (chunk.encoding != expected || chunk.minimum != minimum || chunk.maximum != maximum
+			|| chunk.length != bytes.size() - start) {
+		out << "column format: " << values.size() << " rows as " << ColumnFormat::getEncodingAsString(preferred)
+			<< " came out as " << ColumnFormat::getEncodingAsString(static_cast<ColumnEncoding>(chunk.encoding))
+			<< ", minimum " << chunk.minimum << ", maximum " << chunk.maximum << endl;
+		return false;
+	}
+	if ((expected == COLUMN_ENCODING_BITPACKED && chunk.width != widthOf(maximum - minimum))
+			|| (expected == COLUMN_ENCODING_DICTIONARY && chunk.width != widthOf(distinct.size() - 1))) {
+		out << "column format: " << values.size() << " rows as " << ColumnFormat::getEncodingAsString(expected)
+			<< " packed in " << static_cast<unsigned>(chunk.width) << " bits" << endl;
+		return false;
+	}
+
+	bytes.resize(bytes.size() + COLUMN_DECODE_PADDING, 0);
+	if (!ColumnFormat::decode(bytes.data() + start, chunk.length, chunk, values.size(), decoded) || decoded != values) {
+		out << "column format: " << values.size() << " rows as " << ColumnFormat::getEncodingAsString(expected)
+			<< " did not decode to what was encoded" << endl;
+		return false;
+	}
+	if (chunk.length && ColumnFormat::decode(bytes.data() + start, chunk.length - 1, chunk, values.size(), decoded)) {
+		out << "column format: " << values.size() << " rows as " << ColumnFormat::getEncodingAsString(expected)
+			<< " decoded from a chunk one octet short" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool testColumnFormat(const uint64_t& seed, ostream& out)
+{
+	mt19937_64 random(seed);
+	vector<uint64_t> values;
+
+	for (unsigned r(0); r < COLUMN_TEST_ROUNDS; r++) {
+		makeValues(random, values);
+		for (const ColumnEncoding& encoding : encodings)
+			if (!testColumnEncoding(values, encoding, out))
+				return false;
+	}
+
+	// a full 64 bits a row, with a dictionary that only just fits, then only just does not
+	values.assign({ 0, ~uint64_t(0), 1, ~uint64_t(0) - 1, 0, ~uint64_t(0), 1, ~uint64_t(0) - 1 });
+	for (const ColumnEncoding& encoding : encodings)
+		if (!testColumnEncoding(values, encoding, out))
+			return false;
+	values.pop_back();
+	for (const ColumnEncoding& encoding : encodings)
+		if (!testColumnEncoding(values, encoding, out))
+			return false;
+	return true;
+}
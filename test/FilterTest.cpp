@@ -0,0 +1,237 @@
+#include <cstring>
+#include <random>
+#include <string>
+
+#include <Filter.hpp>
+#include <ByteOrder.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define FILTER_TEST_FRAMES	2000
+// ethernet, IPv6 and a TCP header, the longest frame built here
+#define FILTER_TEST_FRAME_LENGTH	74
+
+// what a frame was built from, for the plain predicates to read
+struct FilterTestFrame {
+	bool ipv6;
+	bool tcp;
+	uint32_t sourceAddress;
+	uint32_t destinationAddress;
+	uint16_t sourcePort;
+	uint16_t destinationPort;
+	uint8_t tcpFlags;
+};
+
+struct FilterCase {
+	const char* expression;
+	bool (*expected)(const FilterTestFrame&);
+};
+
+static bool isIp(const FilterTestFrame& f) { return !f.ipv6; }
+static bool isTcp(const FilterTestFrame& f) { return f.tcp; }
+static bool isUdp(const FilterTestFrame& f) { return !f.tcp; }
+static bool inPrefix(const uint32_t& address, const uint32_t& network, const unsigned& prefix)
+{
+	return prefix == 0 || (address ^ network) >> (32 - prefix) == 0;
+}
+
+static const FilterCase cases[] = {
+	// and binds tighter than or, not tighter than both
+	{ "tcp or udp and udp.dport == 53",
+		[](const FilterTestFrame& f) { return isTcp(f) || (isUdp(f) && f.destinationPort == 53); } },
+	{ "udp.dport == 53 and tcp or udp",
+		[](const FilterTestFrame& f) { return (isUdp(f) && f.destinationPort == 53 && isTcp(f)) || isUdp(f); } },
+	{ "not tcp and udp.sport == 53",
+		[](const FilterTestFrame& f) { return !isTcp(f) && isUdp(f) && f.sourcePort == 53; } },
+	{ "not (tcp and tcp.flags.syn)",
+		[](const FilterTestFrame& f) { return !(isTcp(f) && (f.tcpFlags & 0x02)); } },
+	{ "! tcp.flags.syn && tcp || ip.src == 10.0.0.1",
+		[](const FilterTestFrame& f) { return (isTcp(f) && !(f.tcpFlags & 0x02)) || (isIp(f) && f.sourceAddress == 0x0A000001); } },
+	{ "not not tcp",
+		[](const FilterTestFrame& f) { return isTcp(f); } },
+	{ "(tcp.dport == 80 or tcp.dport == 443) and not ip.dst == 192.168.1.0/24",
+		[](const FilterTestFrame& f) {
+			return isTcp(f) && (f.destinationPort == 80 || f.destinationPort == 443)
+				&& !(isIp(f) && inPrefix(f.destinationAddress, 0xC0A80100, 24));
+		} },
+	// a test on a layer the frame lacks is false, so its negation is true
+	{ "not tcp.dport == 80",
+		[](const FilterTestFrame& f) { return !(isTcp(f) && f.destinationPort == 80); } },
+	// prefixes mask the field before comparing
+	{ "ip.src == 10.0.0.0/8",
+		[](const FilterTestFrame& f) { return isIp(f) && inPrefix(f.sourceAddress, 0x0A000000, 8); } },
+	{ "ip.src != 10.0.0.0/8",
+		[](const FilterTestFrame& f) { return isIp(f) && !inPrefix(f.sourceAddress, 0x0A000000, 8); } },
+	{ "ip.dst == 192.168.1.0/24",
+		[](const FilterTestFrame& f) { return isIp(f) && inPrefix(f.destinationAddress, 0xC0A80100, 24); } },
+	{ "ip.dst == 192.168.1.7/32",
+		[](const FilterTestFrame& f) { return isIp(f) && f.destinationAddress == 0xC0A80107; } },
+	{ "ip.src == 10.1.2.3/0",
+		[](const FilterTestFrame& f) { return isIp(f); } },
+	// the host bits of a prefix are dropped
+	{ "ip.src == 10.1.255.255/16",
+		[](const FilterTestFrame& f) { return isIp(f) && inPrefix(f.sourceAddress, 0x0A010000, 16); } },
+	// aliases match either direction, but != needs both
+	{ "tcp.port == 80",
+		[](const FilterTestFrame& f) { return isTcp(f) && (f.sourcePort == 80 || f.destinationPort == 80); } },
+	{ "tcp.port != 80",
+		[](const FilterTestFrame& f) { return isTcp(f) && f.sourcePort != 80 && f.destinationPort != 80; } },
+	{ "udp.port == 53",
+		[](const FilterTestFrame& f) { return isUdp(f) && (f.sourcePort == 53 || f.destinationPort == 53); } },
+	{ "udp.port >= 1024",
+		[](const FilterTestFrame& f) { return isUdp(f) && (f.sourcePort >= 1024 || f.destinationPort >= 1024); } },
+	{ "ip.addr == 10.0.0.1",
+		[](const FilterTestFrame& f) { return isIp(f) && (f.sourceAddress == 0x0A000001 || f.destinationAddress == 0x0A000001); } },
+	{ "ip.addr == 192.168.1.0/24 and tcp.port == 443",
+		[](const FilterTestFrame& f) {
+			return isIp(f) && (inPrefix(f.sourceAddress, 0xC0A80100, 24) || inPrefix(f.destinationAddress, 0xC0A80100, 24))
+				&& isTcp(f) && (f.sourcePort == 443 || f.destinationPort == 443);
+		} },
+	{ "not ip.addr == 10.0.0.0/8",
+		[](const FilterTestFrame& f) {
+			return !(isIp(f) && (inPrefix(f.sourceAddress, 0x0A000000, 8) || inPrefix(f.destinationAddress, 0x0A000000, 8)));
+		} }
+};
+
+// each must fail to compile, with a message
+static const char* malformed[] = {
+	"tcp.dport ==",
+	"tcp.dport == == 80",
+	"(tcp",
+	"tcp)",
+	"tcp and",
+	"or tcp",
+	"not",
+	"()",
+	"tcp.nope == 1",
+	"ip.src == 10.0.0.256",
+	"ip.src == 10.0.0",
+	"ip.src == 10.0.0.0/33",
+	"ip.src == 10.0.0.0/",
+	"tcp.dport == 80x",
+	"tcp.dport == 0x100000000",
+	"tcp.dport == port",
+	"tcp $ udp"
+};
+
+static uint32_t makeAddress(mt19937_64& random)
+{
+	static const uint32_t networks[] = { 0x0A000000, 0x0A010000, 0xC0A80100, 0xAC100000 };
+	return random() % 8 == 0 ? 0x0A000001 : networks[random() % 4] | (random() & 0xFF);
+}
+
+static uint16_t makePort(mt19937_64& random)
+{
+	static const uint16_t ports[] = { 53, 80, 443 };
+	return random() % 2 ? ports[random() % 3] : random();
+}
+
+// ethernet, then IPv4 or IPv6, then TCP or UDP
+static unsigned makeFrame(mt19937_64& random, FilterTestFrame& frame, uint8_t* bytes)
+{
+	frame.ipv6 = random() % 5 == 0;
+	frame.tcp = random() % 2;
+	frame.sourceAddress = makeAddress(random);
+	frame.destinationAddress = makeAddress(random);
+	frame.sourcePort = makePort(random);
+	frame.destinationPort = makePort(random);
+	frame.tcpFlags = frame.tcp ? random() & 0x3F : 0;
+
+	const unsigned transportLength(frame.tcp ? 20 : 8);
+	unsigned ip(14), transport;
+
+	memset(bytes, 0, FILTER_TEST_FRAME_LENGTH);
+	if (frame.ipv6) {
+		store16(bytes + 12, 0x86DD);
+		bytes[ip] = 0x60;
+		store16(bytes + ip + 4, transportLength);
+		bytes[ip + 6] = frame.tcp ? 6 : 17;
+		bytes[ip + 7] = 64;
+		transport = ip + 40;
+	} else {
+		store16(bytes + 12, 0x0800);
+		bytes[ip] = 0x45;
+		store16(bytes + ip + 2, 20 + transportLength);
+		bytes[ip + 8] = 64;
+		bytes[ip + 9] = frame.tcp ? 6 : 17;
+		store32(bytes + ip + 12, frame.sourceAddress);
+		store32(bytes + ip + 16, frame.destinationAddress);
+		transport = ip + 20;
+	}
+
+	store16(bytes + transport, frame.sourcePort);
+	store16(bytes + transport + 2, frame.destinationPort);
+	if (frame.tcp) {
+		bytes[transport + 12] = 0x50;
+		bytes[transport + 13] = frame.tcpFlags;
+	} else {
+		store16(bytes + transport + 4, transportLength);
+	}
+	return transport + transportLength;
+}
+
+static bool testMalformed(ostream& out)
+{
+	Filter filter;
+
+	for (const char* expression : malformed) {
+		if (filter.compile(expression) || filter.getError().empty()) {
+			out << "filter: \"" << expression << "\" compiled" << endl;
+			return false;
+		}
+	}
+
+	// as deep as the parser allows, then one level more
+	const string open(FILTER_MAX_NESTING, '('), close(FILTER_MAX_NESTING, ')');
+	string nots;
+	for (unsigned i(0); i < FILTER_MAX_NESTING; i++)
+		nots += "not ";
+
+	if (!filter.compile(open + "tcp" + close) || !filter.compile(nots + "tcp")) {
+		out << "filter: nesting of " << FILTER_MAX_NESTING << " failed: " << filter.getError() << endl;
+		return false;
+	}
+	if (filter.compile("(" + open + "tcp" + close + ")") || filter.compile("not " + nots + "tcp")) {
+		out << "filter: nesting past " << FILTER_MAX_NESTING << " compiled" << endl;
+		return false;
+	}
+	// far past it, which used to overflow the stack
+	string bangs;
+	for (unsigned i(0); i < 60000; i++)
+		bangs += "! ";
+	if (filter.compile(string(60000, '(')) || filter.compile(bangs + "tcp")) {
+		out << "filter: 60000 levels of nesting compiled" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool testFilter(const uint64_t& seed, ostream& out)
+{
+	mt19937_64 random(seed);
+	FilterTestFrame frames[FILTER_TEST_FRAMES];
+	uint8_t bytes[FILTER_TEST_FRAMES][FILTER_TEST_FRAME_LENGTH];
+	unsigned lengths[FILTER_TEST_FRAMES];
+	Filter filter;
+
+	for (unsigned i(0); i < FILTER_TEST_FRAMES; i++)
+		lengths[i] = makeFrame(random, frames[i], bytes[i]);
+
+	for (const FilterCase& test : cases) {
+		if (!filter.compile(test.expression)) {
+			out << "filter: \"" << test.expression << "\" failed: " << filter.getError() << endl;
+			return false;
+		}
+		for (unsigned i(0); i < FILTER_TEST_FRAMES; i++) {
+			const bool expected(test.expected(frames[i]));
+			if (filter.matches(reinterpret_cast<const char*>(bytes[i]), lengths[i]) != expected) {
+				out << "filter: \"" << test.expression << "\" gave " << !expected << " for frame " << i << endl;
+				return false;
+			}
+		}
+	}
+
+	return testMalformed(out);
+}
@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <FlowTable.hpp>
+#include <IpFrame.hpp>
+#include <TcpFrame.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define FLOW_TABLE_TEST_ROUNDS		40
+#define FLOW_TABLE_TEST_UPDATES		4000
+// distinct conversations per round, more than most tables hold
+#define FLOW_TABLE_TEST_KEYS		600
+// measured in nanoseconds, far below the idle timeout so only expire() evicts for idleness
+#define FLOW_TABLE_TEST_STEP		1000
+
+// both endpoints of a conversation, ordered, so either direction finds it
+typedef pair<uint64_t, uint64_t> FlowTableTestKey;
+
+struct FlowTableTestEndpoints {
+	uint32_t addressA;
+	uint32_t addressB;
+	uint16_t portA;
+	uint16_t portB;
+};
+
+// what the table should hold for a flow
+struct FlowTableTestFlow {
+	FlowTableTestEndpoints endpoints;
+	uint32_t packets[2];
+	uint64_t bytes[2];
+	uint64_t lastSeen;
+	uint64_t touched;
+};
+
+static FlowTableTestKey makeKey(const uint32_t& source, const uint16_t& sourcePort, const uint32_t& destination,
+	const uint16_t& destinationPort)
+{
+	const uint64_t a(static_cast<uint64_t>(source) << 16 | sourcePort);
+	const uint64_t b(static_cast<uint64_t>(destination) << 16 | destinationPort);
+	return a < b ? FlowTableTestKey(a, b) : FlowTableTestKey(b, a);
+}
+
+static bool sameFlow(const Flow& flow, const FlowTableTestFlow& expected)
+{
+	return flow.addressA == expected.endpoints.addressA && flow.addressB == expected.endpoints.addressB
+		&& flow.portA == expected.endpoints.portA && flow.portB == expected.endpoints.portB
+		&& flow.packets[0] == expected.packets[0] && flow.packets[1] == expected.packets[1]
+		&& flow.bytes[0] == expected.bytes[0] && flow.bytes[1] == expected.bytes[1]
+		&& flow.lastSeen == expected.lastSeen;
+}
+
+// every flow of the model must be found from both ends, and nothing else
+static bool checkContents(const FlowTable& table, const map<FlowTableTestKey, FlowTableTestFlow>& model,
+	const vector<FlowTableTestEndpoints>& keys, ostream& out)
+{
+	if (table.size() != model.size()) {
+		out << "flow table: holds " << table.size() << " flows, expected " << model.size() << endl;
+		return false;
+	}
+
+	for (const FlowTableTestEndpoints& key : keys) {
+		const auto expected(model.find(makeKey(key.addressA, key.portA, key.addressB, key.portB)));
+		const Flow* forward(table.find(key.addressA, key.addressB, key.portA, key.portB, IP_PROTOCOL_UDP));
+		const Flow* backward(table.find(key.addressB, key.addressA, key.portB, key.portA, IP_PROTOCOL_UDP));
+
+		if (forward != backward) {
+			out << "flow table: the two directions of a conversation found different flows" << endl;
+			return false;
+		}
+		if ((expected == model.end()) != (forward == nullptr)) {
+			out << "flow table: " << (forward ? "found a flow that left" : "lost a flow that stayed") << endl;
+			return false;
+		}
+		if (forward && (!sameFlow(*forward, expected->second) || table.getIndex(*forward) >= table.getCapacity())) {
+			out << "flow table: a flow's endpoints, counters or index differ from the model" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// the same evictions in any order, since expiry walks the idle list and not the model
+static bool checkEvicted(vector<FlowTableTestKey>& evicted, vector<FlowTableTestKey>& expected, const char* why,
+	ostream& out)
+{
+	sort(evicted.begin(), evicted.end());
+	sort(expected.begin(), expected.end());
+	if (evicted != expected) {
+		out << "flow table: " << evicted.size() << " flows " << why << ", expected " << expected.size() << endl;
+		return false;
+	}
+	evicted.clear();
+	expected.clear();
+	return true;
+}
+
+/*
+ * UDP only, so no state gets in the way: random updates over a table that
+ * fills up and evicts its least recently active flow, with every so often
+ * a random half made idle and expired. Deleting arbitrary flows from the
+ * middle of probe runs is what backward shift deletion must survive.
+ */
+static bool testFlowTableModel(mt19937_64& random, const unsigned& capacity, ostream& out)
+{
+	FlowTable table(capacity);
+	map<FlowTableTestKey, FlowTableTestFlow> model;
+	vector<FlowTableTestEndpoints> keys(FLOW_TABLE_TEST_KEYS);
+	vector<FlowTableTestKey> evicted, expected;
+	uint64_t now(1000000000), touches(0), expiredCount(0), evictedCount(0);
+
+	table.setEvictionCallback([&evicted](const Flow& flow) {
+		evicted.push_back(makeKey(flow.addressA, flow.portA, flow.addressB, flow.portB));
+	});
+
+	// few addresses and ports, so keys share hash slots and probe runs get long
+	for (FlowTableTestEndpoints& key : keys) {
+		do {
+			key.addressA = 0x0A000000 | random() % 16;
+			key.addressB = 0xC0A80000 | random() % 16;
+			key.portA = 1024 + random() % 8;
+			key.portB = 80 + random() % 4;
+		} while (count_if(&keys[0], &key, [&key](const FlowTableTestEndpoints& k) {
+			return makeKey(k.addressA, k.portA, k.addressB, k.portB) == makeKey(key.addressA, key.portA, key.addressB, key.portB);
+		}));
+	}
+
+	for (unsigned u(0); u < FLOW_TABLE_TEST_UPDATES; u++) {
+		const FlowTableTestEndpoints& key(keys[random() % keys.size()]);
+		const bool reverse(random() % 2);
+		const uint32_t source(reverse ? key.addressB : key.addressA);
+		const uint32_t destination(reverse ? key.addressA : key.addressB);
+		const uint16_t sourcePort(reverse ? key.portB : key.portA);
+		const uint16_t destinationPort(reverse ? key.portA : key.portB);
+		const unsigned length(28 + random() % 1472);
+		const FlowTableTestKey id(makeKey(source, sourcePort, destination, destinationPort));
+
+		now += FLOW_TABLE_TEST_STEP;
+		auto found(model.find(id));
+		if (found == model.end()) {
+			if (model.size() == capacity) {
+				auto oldest(model.begin());
+				for (auto i(model.begin()); i != model.end(); i++)
+					oldest = i->second.touched < oldest->second.touched ? i : oldest;
+				expected.push_back(oldest->first);
+				model.erase(oldest);
+				evictedCount++;
+			}
+			FlowTableTestFlow& flow(model[id]);
+			flow.endpoints = { source, destination, sourcePort, destinationPort };
+			flow.packets[0] = flow.packets[1] = 0;
+			flow.bytes[0] = flow.bytes[1] = 0;
+			found = model.find(id);
+		}
+
+		FlowTableTestFlow& flow(found->second);
+		const int side(flow.endpoints.addressA == source && flow.endpoints.portA == sourcePort ? 0 : 1);
+		flow.packets[side]++;
+		flow.bytes[side] += length;
+		flow.lastSeen = now;
+		flow.touched = ++touches;
+
+		const Flow* updated(table.update(source, destination, sourcePort, destinationPort, IP_PROTOCOL_UDP, 0, length, now));
+		if (!updated || !sameFlow(*updated, flow)) {
+			out << "flow table: update " << u << " returned a flow that differs from the model" << endl;
+			return false;
+		}
+		if (!checkEvicted(evicted, expected, "evicted from a full table", out))
+			return false;
+
+		if (random() % 500)
+			continue;
+
+		// touch a random half, then expire whatever was last seen before that
+		const uint64_t cutoff(now);
+		for (auto& entry : model) {
+			if (random() % 2)
+				continue;
+			now += FLOW_TABLE_TEST_STEP;
+			const FlowTableTestEndpoints& endpoints(entry.second.endpoints);
+			table.update(endpoints.addressA, endpoints.addressB, endpoints.portA, endpoints.portB, IP_PROTOCOL_UDP, 0, 0, now);
+			entry.second.packets[0]++;
+			entry.second.lastSeen = now;
+			entry.second.touched = ++touches;
+		}
+		for (auto i(model.begin()); i != model.end();) {
+			if (i->second.lastSeen > cutoff) {
+				i++;
+				continue;
+			}
+			expected.push_back(i->first);
+			i = model.erase(i);
+			expiredCount++;
+		}
+
+		const unsigned count(table.expire(cutoff + FLOW_TABLE_IDLE_TIMEOUT));
+		if (count != expected.size() || !checkEvicted(evicted, expected, "expired idle", out))
+			return false;
+		if (!checkContents(table, model, keys, out))
+			return false;
+	}
+
+	if (table.getExpired() != expiredCount || table.getEvicted() != evictedCount) {
+		out << "flow table: counted " << table.getExpired() << " expired and " << table.getEvicted()
+			<< " evicted, expected " << expiredCount << " and " << evictedCount << endl;
+		return false;
+	}
+	if (!checkContents(table, model, keys, out))
+		return false;
+
+	table.flush();
+	if (table.size() || evicted.size() != model.size()) {
+		out << "flow table: flush left " << table.size() << " flows and reported " << evicted.size() << endl;
+		return false;
+	}
+	return true;
+}
+
+static const Flow* sendTcp(FlowTable& table, const bool& fromB, const uint8_t& flags, uint64_t& now)
+{
+	const uint32_t a(0x0A000001), b(0xC0A80001);
+	const uint16_t portA(40000), portB(443);
+
+	now += FLOW_TABLE_TEST_STEP;
+	return fromB ? table.update(b, a, portB, portA, IP_PROTOCOL_TCP, flags, 40, now)
+		: table.update(a, b, portA, portB, IP_PROTOCOL_TCP, flags, 40, now);
+}
+
+// a new SYN on a finished connection starts a new flow, one on a live connection does not
+static bool testFlowTableReuse(ostream& out)
+{
+	FlowTable table(16);
+	vector<uint8_t> states;
+	uint64_t now(1000000000);
+	const Flow* flow;
+
+	table.setEvictionCallback([&states](const Flow& gone) { states.push_back(gone.state); });
+
+	sendTcp(table, false, TCP_FLAG_SYN, now);
+	sendTcp(table, true, TCP_FLAG_SYN | TCP_FLAG_ACK, now);
+	flow = sendTcp(table, false, TCP_FLAG_ACK, now);
+	if (flow->state != FLOW_STATE_ESTABLISHED) {
+		out << "flow table: handshake left the flow " << FlowTable::getStateAsString(flow->state) << endl;
+		return false;
+	}
+
+	flow = sendTcp(table, false, TCP_FLAG_SYN, now);
+	if (table.getCreated() != 1 || !states.empty() || flow->packets[0] != 3) {
+		out << "flow table: a SYN on an established connection replaced it" << endl;
+		return false;
+	}
+
+	sendTcp(table, false, TCP_FLAG_FIN | TCP_FLAG_ACK, now);
+	flow = sendTcp(table, true, TCP_FLAG_FIN | TCP_FLAG_ACK, now);
+	if (flow->state != FLOW_STATE_CLOSED) {
+		out << "flow table: FIN from both sides left the flow " << FlowTable::getStateAsString(flow->state) << endl;
+		return false;
+	}
+
+	// reused from the other end, so that end is A now
+	flow = sendTcp(table, true, TCP_FLAG_SYN, now);
+	if (table.getCreated() != 2 || states.size() != 1 || states[0] != FLOW_STATE_CLOSED || table.size() != 1
+			|| flow->state != FLOW_STATE_SYN_SENT || flow->packets[0] != 1 || flow->packets[1] != 0
+			|| flow->addressA != 0xC0A80001) {
+		out << "flow table: a SYN on a closed connection did not start a new flow" << endl;
+		return false;
+	}
+
+	sendTcp(table, false, TCP_FLAG_RST, now);
+	flow = sendTcp(table, false, TCP_FLAG_SYN, now);
+	if (table.getCreated() != 3 || states.size() != 2 || states[1] != FLOW_STATE_RESET
+			|| flow->state != FLOW_STATE_SYN_SENT || flow->addressA != 0x0A000001) {
+		out << "flow table: a SYN on a reset connection did not start a new flow" << endl;
+		return false;
+	}
+
+	if (table.getExpired() || table.getEvicted()) {
+		out << "flow table: reusing a connection counted as an eviction" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool testFlowTable(const uint64_t& seed, ostream& out)
+{
+	mt19937_64 random(seed);
+	static const unsigned capacities[] = { 1, 2, 7, 64, 250, 1000 };
+
+	for (unsigned r(0); r < FLOW_TABLE_TEST_ROUNDS; r++)
+		if (!testFlowTableModel(random, capacities[r % (sizeof(capacities) / sizeof(capacities[0]))], out))
+			return false;
+	return testFlowTableReuse(out);
+}
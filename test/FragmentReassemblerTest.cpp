@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <FragmentReassembler.hpp>
+#include <IpView.hpp>
+#include <ByteOrder.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define FRAGMENT_TEST_ROUNDS		2000
+// measured in octets
+#define FRAGMENT_TEST_MAX_PAYLOAD	8000
+// pieces plus overlapping copies stay under FRAGMENT_MAX_HOLES
+#define FRAGMENT_TEST_MAX_PIECES	10
+#define FRAGMENT_TEST_MAX_COPIES	4
+#define FRAGMENT_TEST_POOL			8
+#define FRAGMENT_TEST_FLOOD			10000
+
+// measured in seconds
+#define FRAGMENT_TEST_TIMEOUT		(FRAGMENT_TIMEOUT / FRAGMENT_WHEEL_TICK)
+
+struct FragmentTestPiece {
+	uint32_t first;
+	uint32_t length;
+	bool more;
+	// overlapping copies carry other bytes, which must lose to the first copy
+	bool garbage;
+};
+
+static uint64_t seconds(const uint64_t& count)
+{
+	return count * FRAGMENT_WHEEL_TICK;
+}
+
+static uint8_t garbageAt(const uint32_t& offset)
+{
+	return ~offset * 0x9E;
+}
+
+// one IPv4 fragment: header, then length octets of payload from data
+static vector<uint8_t> makeFragment(const uint8_t* header, const unsigned& headerLength, const uint32_t& first,
+	const uint8_t* data, const uint32_t& length, const bool& more)
+{
+	vector<uint8_t> bytes(header, header + headerLength);
+
+	bytes.insert(bytes.end(), data, data + length);
+	store16(bytes.data() + 2, headerLength + length);
+	store16(bytes.data() + 6, (load16(bytes.data() + 6) & 0x4000) | (more ? 0x2000 : 0) | first / 8);
+	store16(bytes.data() + 10, 0);
+	store16(bytes.data() + 10, Checksum::finish(Checksum::sum(bytes.data(), headerLength)));
+	return bytes;
+}
+
+// the header every fragment of a datagram starts from, options included
+static unsigned makeHeader(mt19937_64& random, uint8_t* header, const uint32_t& source, const uint16_t& id)
+{
+	const unsigned headerLength(IP_VIEW_MIN_HEADER_LENGTH + random() % 11 * 4);
+
+	for (unsigned i(0); i < headerLength; i++)
+		header[i] = random();
+	header[0] = 0x40 | headerLength / 4;
+	store16(header + 4, id);
+	header[6] &= 0x40;
+	header[9] = IP_VIEW_PROTOCOL_UDP;
+	store32(header + 12, source);
+	return headerLength;
+}
+
+/*
+ * One datagram cut at random 8 octet boundaries, sent in any order with
+ * overlapping copies mixed in. It must complete with the fragment that
+ * fills the last hole and not before, hold the first copy of every octet,
+ * and come out as a single datagram with a correct header.
+ */
+static bool testFragmentOverlaps(mt19937_64& random, FragmentReassembler& fragments, const uint16_t& id, ostream& out)
+{
+	uint8_t header[FRAGMENT_HEADER_ROOM];
+	const unsigned headerLength(makeHeader(random, header, 0x0A000001, id));
+	const uint32_t length(random() % (FRAGMENT_TEST_MAX_PAYLOAD - 8) + 9);
+	vector<uint8_t> truth(length), first(length), garbage(length);
+	vector<bool> seen(length, false);
+	vector<uint32_t> cuts;
+	vector<FragmentTestPiece> pieces;
+
+	for (uint32_t i(0); i < length; i++) {
+		truth[i] = random();
+		garbage[i] = garbageAt(i);
+	}
+
+	for (unsigned i(random() % (FRAGMENT_TEST_MAX_PIECES - 1) + 1); i > 0; i--)
+		cuts.push_back((random() % ((length - 1) / 8) + 1) * 8);
+	cuts.push_back(0);
+	cuts.push_back(length);
+	sort(cuts.begin(), cuts.end());
+	cuts.erase(unique(cuts.begin(), cuts.end()), cuts.end());
+
+	for (unsigned i(0); i + 1 < cuts.size(); i++)
+		pieces.push_back({ cuts[i], cuts[i + 1] - cuts[i], i + 2 < cuts.size(), false });
+
+	// copies only cover what comes before the last fragment, as any but the last must
+	const uint32_t lastFirst(cuts[cuts.size() - 2] / 8);
+	for (unsigned i(random() % (FRAGMENT_TEST_MAX_COPIES + 1)); i > 0; i--) {
+		const uint32_t from(random() % lastFirst);
+		const uint32_t to(from + random() % (lastFirst - from) + 1);
+		pieces.push_back({ from * 8, (to - from) * 8, true, random() % 2 == 0 });
+	}
+	shuffle(pieces.begin(), pieces.end(), random);
+
+	uint32_t covered(0);
+	unsigned sent(0);
+	for (const FragmentTestPiece& piece : pieces) {
+		const uint8_t* data((piece.garbage ? garbage : truth).data() + piece.first);
+		const vector<uint8_t> bytes(makeFragment(header, headerLength, piece.first, data, piece.length, piece.more));
+
+		for (uint32_t i(0); i < piece.length; i++) {
+			if (!seen[piece.first + i]) {
+				seen[piece.first + i] = true;
+				first[piece.first + i] = data[i];
+				covered++;
+			}
+		}
+		sent++;
+
+		const bool complete(fragments.add(reinterpret_cast<const char*>(bytes.data()), bytes.size(), 0));
+		if (complete != (covered == length)) {
+			out << "fragment reassembler: datagram " << id << " " << (complete ? "completed" : "did not complete")
+				<< " with " << covered << " of " << length << " octets covered" << endl;
+			return false;
+		}
+		if (complete)
+			break;
+	}
+
+	const IpView ip(fragments.getDatagram(), fragments.getDatagramLength());
+	if (fragments.getDatagramLength() != headerLength + length || !ip.isValid() || !ip.checksumIsOk()
+			|| ip.getTotalLength() != headerLength + length || ip.getMf() || ip.getOffset()
+			|| ip.getDf() != static_cast<bool>(header[6] & 0x40) || fragments.getDatagramFragments() != sent) {
+		out << "fragment reassembler: datagram " << id << " came out with a wrong header, length "
+			<< fragments.getDatagramLength() << " of " << headerLength + length << endl;
+		return false;
+	}
+	if (memcmp(ip.getOptions(), header + IP_VIEW_MIN_HEADER_LENGTH, ip.getOptionsLength())
+			|| memcmp(ip.getPayload(), first.data(), length)) {
+		out << "fragment reassembler: datagram " << id << " does not hold the first copy of every octet" << endl;
+		return false;
+	}
+	return true;
+}
+
+// the first of two fragments of a datagram, which then waits for the other
+static bool addFirst(FragmentReassembler& fragments, const uint32_t& source, const uint16_t& id,
+	const uint64_t& timestamp)
+{
+	uint8_t header[IP_VIEW_MIN_HEADER_LENGTH] = { 0x45 };
+	uint8_t payload[16] = { 0 };
+
+	store16(header + 4, id);
+	store32(header + 12, source);
+	const vector<uint8_t> bytes(makeFragment(header, sizeof(header), 0, payload, 8, true));
+	return fragments.add(reinterpret_cast<const char*>(bytes.data()), bytes.size(), timestamp);
+}
+
+static bool addLast(FragmentReassembler& fragments, const uint32_t& source, const uint16_t& id,
+	const uint64_t& timestamp)
+{
+	uint8_t header[IP_VIEW_MIN_HEADER_LENGTH] = { 0x45 };
+	uint8_t payload[16] = { 0 };
+
+	store16(header + 4, id);
+	store32(header + 12, source);
+	const vector<uint8_t> bytes(makeFragment(header, sizeof(header), 8, payload, 8, false));
+	return fragments.add(reinterpret_cast<const char*>(bytes.data()), bytes.size(), timestamp);
+}
+
+/*
+ * Datagrams time out FRAGMENT_TIMEOUT after their first fragment and not
+ * a tick sooner, one slot of the wheel at a time, and a jump of more than
+ * a whole turn clears the wheel at once.
+ */
+static bool testFragmentTimeouts(ostream& out)
+{
+	FragmentReassembler fragments(FRAGMENT_TEST_POOL * 4);
+	const uint64_t start(1000);
+
+	for (uint16_t id(0); id < 5; id++)
+		addFirst(fragments, 1, id, seconds(start));
+	for (uint16_t id(5); id < 12; id++)
+		addFirst(fragments, 1, id, seconds(start + 3));
+
+	addLast(fragments, 2, 0, seconds(start + FRAGMENT_TEST_TIMEOUT - 1));
+	if (fragments.getTimedOut() || fragments.size() != 13) {
+		out << "fragment reassembler: " << fragments.getTimedOut() << " timed out a tick early" << endl;
+		return false;
+	}
+
+	addLast(fragments, 2, 1, seconds(start + FRAGMENT_TEST_TIMEOUT));
+	if (fragments.getTimedOut() != 5 || fragments.size() != 9) {
+		out << "fragment reassembler: " << fragments.getTimedOut() << " timed out on time, expected 5" << endl;
+		return false;
+	}
+
+	// the rest arrived three ticks later, so that much later is still in time
+	if (!addLast(fragments, 1, 5, seconds(start + FRAGMENT_TEST_TIMEOUT + 2))) {
+		out << "fragment reassembler: a datagram timed out before its time" << endl;
+		return false;
+	}
+
+	addLast(fragments, 3, 0, seconds(start + FRAGMENT_TEST_TIMEOUT + FRAGMENT_WHEEL_SLOTS * 10));
+	if (fragments.getTimedOut() != 5 + 6 + 2 || fragments.size() != 1) {
+		out << "fragment reassembler: a jump of ten turns left " << fragments.size() << " datagrams, expected 1" << endl;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * A full pool makes room by dropping the datagram closest to timing out,
+ * so under a flood of first fragments the newest ones are kept and the
+ * pool never grows.
+ */
+static bool testFragmentPool(mt19937_64& random, ostream& out)
+{
+	{
+		FragmentReassembler fragments(FRAGMENT_TEST_POOL);
+
+		for (uint16_t id(0); id < 20; id++)
+			addFirst(fragments, 1, id, seconds(id));
+		if (fragments.size() != FRAGMENT_TEST_POOL || fragments.getEvicted() != 20 - FRAGMENT_TEST_POOL) {
+			out << "fragment reassembler: a pool of " << FRAGMENT_TEST_POOL << " held " << fragments.size()
+				<< " and evicted " << fragments.getEvicted() << endl;
+			return false;
+		}
+		for (uint16_t id(20 - FRAGMENT_TEST_POOL); id < 20; id++) {
+			if (!addLast(fragments, 1, id, seconds(20))) {
+				out << "fragment reassembler: datagram " << id << " was evicted, not one of the oldest" << endl;
+				return false;
+			}
+		}
+	}
+
+	FragmentReassembler fragments(FRAGMENT_TEST_POOL);
+	uint64_t now(0);
+
+	for (uint32_t i(0); i < FRAGMENT_TEST_FLOOD; i++) {
+		now += random() % (FRAGMENT_WHEEL_TICK / 2);
+		addFirst(fragments, i, i, now);
+		if (fragments.size() > FRAGMENT_TEST_POOL
+				|| fragments.size() + fragments.getEvicted() + fragments.getTimedOut() != i + 1) {
+			out << "fragment reassembler: after " << i + 1 << " fragments the pool holds " << fragments.size()
+				<< ", evicted " << fragments.getEvicted() << " and timed out " << fragments.getTimedOut() << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool testFragmentReassembler(const uint64_t& seed, ostream& out)
+{
+	mt19937_64 random(seed);
+	FragmentReassembler fragments;
+
+	for (unsigned r(0); r < FRAGMENT_TEST_ROUNDS; r++)
+		if (!testFragmentOverlaps(random, fragments, r, out))
+			return false;
+	if (fragments.size() || fragments.getReassembled() != FRAGMENT_TEST_ROUNDS || fragments.getMalformed()) {
+		out << "fragment reassembler: " << fragments.getReassembled() << " of " << FRAGMENT_TEST_ROUNDS
+			<< " reassembled, " << fragments.size() << " left over" << endl;
+		return false;
+	}
+
+	return testFragmentTimeouts(out) && testFragmentPool(random, out);
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <FrameBitmap.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define FRAME_BITMAP_TEST_ROUNDS		40
+// containers per bitmap, drawn from a few keys so two bitmaps share most
+#define FRAME_BITMAP_TEST_CONTAINERS	5
+#define FRAME_BITMAP_TEST_KEYS			8
+
+// how many of a container's 64K frames to set, on either side of the array limit
+static unsigned makeCardinality(mt19937_64& random)
+{
+	switch (random() % 4) {
+	case 0:
+		return random() % 64 + 1;
+	case 1:
+		return FRAME_BITMAP_ARRAY_LIMIT - 8 + random() % 17;
+	case 2:
+		return random() % 0x10000 + 1;
+	default:
+		return FRAME_BITMAP_ARRAY_LIMIT * 2 + random() % FRAME_BITMAP_ARRAY_LIMIT;
+	}
+}
+
+// a few containers of random frames, sorted and without repeats
+static void makeFrames(mt19937_64& random, vector<uint32_t>& frames)
+{
+	vector<bool> taken(0x10000);
+
+	frames.clear();
+	for (unsigned c(random() % FRAME_BITMAP_TEST_CONTAINERS + 1); c > 0; c--) {
+		const uint32_t high(static_cast<uint32_t>(random() % FRAME_BITMAP_TEST_KEYS) << 16);
+		const unsigned cardinality(makeCardinality(random));
+
+		fill(taken.begin(), taken.end(), false);
+		for (unsigned set(0); set < cardinality;) {
+			const uint16_t low(random());
+			if (!taken[low]) {
+				taken[low] = true;
+				frames.push_back(high | low);
+				set++;
+			}
+		}
+	}
+	sort(frames.begin(), frames.end());
+	frames.erase(unique(frames.begin(), frames.end()), frames.end());
+}
+
+// some of the given frames, and some others, so an intersection keeps any share of them
+static void makeOverlapping(mt19937_64& random, const vector<uint32_t>& from, vector<uint32_t>& frames)
+{
+	static const unsigned shares[] = { 1, 30, 50, 99 };
+	const unsigned share(shares[random() % 4]);
+
+	makeFrames(random, frames);
+	for (const uint32_t& frame : from)
+		if (random() % 100 < share)
+			frames.push_back(frame);
+	sort(frames.begin(), frames.end());
+	frames.erase(unique(frames.begin(), frames.end()), frames.end());
+}
+
+// in order as an index pass adds them, or shuffled
+static void build(mt19937_64& random, const vector<uint32_t>& frames, FrameBitmap& bitmap)
+{
+	vector<uint32_t> order(frames);
+
+	if (random() % 2)
+		shuffle(order.begin(), order.end(), random);
+	// repeats must not count twice
+	for (unsigned i(0); i < order.size() / 16; i++)
+		order.push_back(order[random() % order.size()]);
+
+	bitmap.clear();
+	for (const uint32_t& frame : order)
+		bitmap.add(frame);
+}
+
+// a count, a header per container, then an array of low halves up to the limit or the whole bitmap past it
+static size_t serializedLength(const vector<uint32_t>& frames)
+{
+	map<uint16_t, size_t> containers;
+	size_t length(4);
+
+	for (const uint32_t& frame : frames)
+		containers[frame >> 16]++;
+	for (const auto& container : containers) {
+		length += 8;
+		length += container.second > FRAME_BITMAP_ARRAY_LIMIT ? FRAME_BITMAP_WORDS * sizeof(uint64_t)
+			: container.second * sizeof(uint16_t);
+	}
+	return length;
+}
+
+/*
+ * The bitmap must hold exactly the model's frames, in the container kind
+ * its cardinality calls for, which shows in the serialized length. What
+ * it serializes must read back to the same frames and the same octets,
+ * and anything cut short must be refused.
+ */
+static bool check(const FrameBitmap& bitmap, const vector<uint32_t>& expected, const char* what, ostream& out)
+{
+	vector<uint32_t> frames;
+	vector<uint8_t> bytes(expected.size() % 7, 0x5A), again;
+	const size_t start(bytes.size());
+	FrameBitmap copy;
+
+	bitmap.getFrames(frames);
+	if (frames != expected || bitmap.count() != expected.size() || bitmap.empty() != expected.empty()) {
+		out << "frame bitmap: " << what << " holds " << bitmap.count() << " frames, expected " << expected.size() << endl;
+		return false;
+	}
+	if (bitmap.getSerializedLength() != serializedLength(expected)) {
+		out << "frame bitmap: " << what << " serializes to " << bitmap.getSerializedLength() << " octets, expected "
+			<< serializedLength(expected) << ", so a container is of the wrong kind" << endl;
+		return false;
+	}
+
+	bitmap.serialize(bytes);
+	if (bytes.size() - start != bitmap.getSerializedLength() || !copy.deserialize(bytes.data() + start, bytes.size() - start)) {
+		out << "frame bitmap: " << what << " did not read back" << endl;
+		return false;
+	}
+	copy.getFrames(frames);
+	copy.serialize(again);
+	if (frames != expected || !equal(again.begin(), again.end(), bytes.begin() + start, bytes.end())) {
+		out << "frame bitmap: " << what << " read back differently" << endl;
+		return false;
+	}
+
+	if (copy.deserialize(bytes.data() + start, bytes.size() - start - 1) || !copy.empty()) {
+		out << "frame bitmap: " << what << " read back from one octet short" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool testFrameBitmap(const uint64_t& seed, ostream& out)
+{
+	mt19937_64 random(seed);
+	vector<uint32_t> ours, theirs, both;
+	FrameBitmap bitmap, other;
+
+	for (unsigned r(0); r < FRAME_BITMAP_TEST_ROUNDS; r++) {
+		makeFrames(random, ours);
+		makeOverlapping(random, ours, theirs);
+		build(random, ours, bitmap);
+		build(random, theirs, other);
+		if (!check(bitmap, ours, "a built bitmap", out) || !check(other, theirs, "a built bitmap", out))
+			return false;
+
+		// arrays with arrays and bitmaps, bitmaps with both, turning into arrays or staying bitmaps
+		both.clear();
+		set_intersection(ours.begin(), ours.end(), theirs.begin(), theirs.end(), back_inserter(both));
+		bitmap.intersect(other);
+		if (!check(bitmap, both, "an intersection", out))
+			return false;
+
+		other.clear();
+		bitmap.intersect(other);
+		if (!check(bitmap, vector<uint32_t>(), "an intersection with nothing", out))
+			return false;
+	}
+
+	// two bitmaps meeting in exactly the limit, which is an array, then one frame more, which is not
+	for (uint32_t extra(0); extra < 2; extra++) {
+		ours.clear();
+		theirs.clear();
+		for (uint32_t frame(0); frame < FRAME_BITMAP_ARRAY_LIMIT * 2; frame++)
+			ours.push_back(frame);
+		for (uint32_t frame(0); frame < FRAME_BITMAP_ARRAY_LIMIT + extra; frame++)
+			theirs.push_back(frame);
+		for (uint32_t frame(FRAME_BITMAP_ARRAY_LIMIT * 3); frame < FRAME_BITMAP_ARRAY_LIMIT * 4; frame++)
+			theirs.push_back(frame);
+
+		build(random, ours, bitmap);
+		build(random, theirs, other);
+		bitmap.intersect(other);
+		if (!check(bitmap, vector<uint32_t>(theirs.begin(), theirs.begin() + FRAME_BITMAP_ARRAY_LIMIT + extra),
+				"an intersection at the limit", out))
+			return false;
+	}
+	return true;
+}
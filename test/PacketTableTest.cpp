@@ -0,0 +1,149 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <PacketTable.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define PACKET_TABLE_TEST_TABLES	200
+#define PACKET_TABLE_TEST_SCANS		50
+// not a multiple of 64, so the scalar tail runs too
+#define PACKET_TABLE_TEST_MAX_ROWS	5000
+
+static const PacketColumn columns[] = {
+	COLUMN_TIMESTAMP, COLUMN_SOURCE_ADDRESS, COLUMN_DESTINATION_ADDRESS, COLUMN_SOURCE_PORT,
+	COLUMN_DESTINATION_PORT, COLUMN_PROTOCOL, COLUMN_TCP_FLAGS, COLUMN_LENGTH
+};
+
+static const char* columnNames[] = {
+	"timestamp", "source address", "destination address", "source port",
+	"destination port", "protocol", "TCP flags", "length"
+};
+
+// what the table should hold for a row, read straight from the summary
+static uint64_t getValue(const PacketSummary& packet, const PacketColumn& column)
+{
+	switch (column) {
+	case COLUMN_TIMESTAMP:
+		return packet.timestamp;
+	case COLUMN_SOURCE_ADDRESS:
+		return packet.sourceAddress;
+	case COLUMN_DESTINATION_ADDRESS:
+		return packet.destinationAddress;
+	case COLUMN_SOURCE_PORT:
+		return packet.sourcePort;
+	case COLUMN_DESTINATION_PORT:
+		return packet.destinationPort;
+	case COLUMN_PROTOCOL:
+		return packet.layers & (PACKET_LAYER_IPV4 | PACKET_LAYER_IPV6) ? packet.protocol : 0;
+	case COLUMN_TCP_FLAGS:
+		return packet.tcpFlags;
+	case COLUMN_LENGTH:
+		return packet.frameLength;
+	}
+	return 0;
+}
+
+static uint64_t getWidest(const PacketColumn& column)
+{
+	switch (column) {
+	case COLUMN_TIMESTAMP:
+		return ~uint64_t(0);
+	case COLUMN_SOURCE_ADDRESS:
+	case COLUMN_DESTINATION_ADDRESS:
+		return 0xFFFFFFFF;
+	case COLUMN_PROTOCOL:
+	case COLUMN_TCP_FLAGS:
+		return 0xFF;
+	default:
+		return 0xFFFF;
+	}
+}
+
+// few distinct values per column, so equality scans select something
+static void makePacket(mt19937_64& random, PacketSummary& packet)
+{
+	static const uint8_t layers[] = {
+		0, PACKET_LAYER_IPV4 | PACKET_LAYER_TCP, PACKET_LAYER_IPV4 | PACKET_LAYER_UDP,
+		PACKET_LAYER_IPV6 | PACKET_LAYER_TCP, PACKET_LAYER_IPV6 | PACKET_LAYER_UDP
+	};
+	static const uint8_t protocols[] = { 1, 6, 17, 58 };
+
+	memset(&packet, 0, sizeof(packet));
+	packet.timestamp = random() % 4 ? 1700000000000000000 + random() % 1000 : random();
+	packet.layers = layers[random() % 5];
+	packet.protocol = protocols[random() % 4];
+	packet.sourceAddress = 0x0A000000 | random() % 8;
+	packet.destinationAddress = random() % 2 ? 0xC0A80001 : random();
+	packet.sourcePort = random() % 2 ? 443 : random();
+	packet.destinationPort = random() % 4 ? random() % 8 + 1024 : random();
+	packet.tcpFlags = random();
+	packet.frameLength = random() % 1519;
+}
+
+// a value the column holds, or anything at all
+static uint64_t pickBound(mt19937_64& random, const vector<PacketSummary>& packets, const PacketColumn& column)
+{
+	if (packets.empty() || random() % 4 == 0)
+		return random() & (random() % 2 ? getWidest(column) : ~uint64_t(0));
+	return getValue(packets[random() % packets.size()], column);
+}
+
+bool testPacketTable(const uint64_t& seed, ostream& out)
+{
+	mt19937_64 random(seed);
+	vector<PacketSummary> packets;
+	PacketTable table;
+	Selection selection;
+
+	for (unsigned t(0); t < PACKET_TABLE_TEST_TABLES; t++) {
+		packets.resize(random() % (PACKET_TABLE_TEST_MAX_ROWS + 1));
+		for (PacketSummary& packet : packets)
+			makePacket(random, packet);
+
+		// appended in uneven batches, as the decoders hand them over
+		table.clear();
+		for (size_t done(0); done < packets.size();) {
+			const size_t batch(min<size_t>(packets.size() - done, random() % 300 + 1));
+			table.append(packets.data() + done, batch);
+			done += batch;
+		}
+
+		for (unsigned s(0); s < PACKET_TABLE_TEST_SCANS; s++) {
+			const unsigned c(random() % (sizeof(columns) / sizeof(columns[0])));
+			const PacketColumn column(columns[c]);
+			uint64_t low(pickBound(random, packets, column));
+			uint64_t high(random() % 3 ? low : pickBound(random, packets, column));
+			const uint64_t mask(random() % 2 ? ~uint64_t(0) : random() & getWidest(column));
+
+			if (random() % 8 && high < low)
+				swap(low, high);
+			table.scan(column, low, high, mask, selection);
+
+			if (selection.size() != packets.size()) {
+				out << "packet table: " << columnNames[c] << " scan covered " << selection.size()
+					<< " rows of " << packets.size() << endl;
+				return false;
+			}
+			for (size_t row(0); row < packets.size(); row++) {
+				// the table narrows each bound and mask to the column's width
+				const uint64_t value(getValue(packets[row], column) & mask & getWidest(column));
+				const bool expected(low <= value && value <= high);
+				if (selection.test(row) != expected) {
+					out << "packet table: " << columnNames[c] << " scan of [" << low << ", " << high << "] mask " << hex << mask
+						<< dec << " gave " << !expected << " for row " << row << " of " << packets.size() << endl;
+					return false;
+				}
+			}
+			const size_t words((packets.size() + 63) / 64);
+			if (packets.size() % 64 && selection.getWords()[words - 1] >> (packets.size() % 64)) {
+				out << "packet table: " << columnNames[c] << " scan selected rows past the end" << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <SpaceSaving.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define SPACE_SAVING_TEST_ROUNDS	30
+#define SPACE_SAVING_TEST_UPDATES	4000
+// measured in updates
+#define SPACE_SAVING_TEST_CHECK		97
+
+// true weight of every key index seen
+typedef map<uint32_t, uint64_t> SpaceSavingTestModel;
+
+static const unsigned capacities[] = { 1, 2, 7, 64, 300 };
+
+static SketchKey makeKey(const uint32_t& index)
+{
+	SketchKey key = { { index, static_cast<uint64_t>(index) * 0x9E3779B97F4A7C15ULL, 0, 0, 0 } };
+	return key;
+}
+
+// few distinct low halves, so keys share home slots and the table compares keys after the hashes agree
+static uint64_t makeHash(const uint32_t& index)
+{
+	return makeKey(index).getHash() << 32 | index % 5;
+}
+
+// a few heavy keys over a long tail
+static uint32_t pickKey(mt19937_64& random, const unsigned& keys)
+{
+	return random() % 3 ? random() % (keys / 16 + 1) : random() % keys;
+}
+
+static uint32_t indexOf(const SketchKey& key)
+{
+	return static_cast<uint32_t>(key.words[0]);
+}
+
+/*
+ * Whatever the summary kept, each key once, no key may be counted below
+ * its true weight nor have its count less its error above it. Until a
+ * bound or a merge cuts counts short or charges them extra, the counts
+ * add up to the total and every key heavier than total / capacity is kept.
+ */
+static bool check(const SpaceSaving& summary, const SpaceSavingTestModel& model, const bool& summed, const char* what,
+	ostream& out)
+{
+	vector<SpaceSavingEntry> top;
+	vector<uint32_t> kept;
+	uint64_t total(0), counted(0), smallest(UINT64_MAX);
+
+	for (const auto& key : model)
+		total += key.second;
+	summary.getTop(summary.getCapacity(), top);
+
+	for (const SpaceSavingEntry& entry : top) {
+		const auto found(model.find(indexOf(entry.key)));
+		const uint64_t weight(found == model.end() ? 0 : found->second);
+
+		if (entry.count < weight || entry.count - entry.error > weight || entry.hash != makeHash(indexOf(entry.key))) {
+			out << "space saving: " << what << ", key " << indexOf(entry.key) << " of weight " << weight << " counted "
+				<< entry.count << " with error " << entry.error << endl;
+			return false;
+		}
+		kept.push_back(indexOf(entry.key));
+		counted += entry.count;
+		smallest = min(smallest, entry.count);
+	}
+
+	sort(kept.begin(), kept.end());
+	if (adjacent_find(kept.begin(), kept.end()) != kept.end()
+			|| kept.size() != min<size_t>(model.size(), summary.getCapacity())) {
+		out << "space saving: " << what << ", " << kept.size() << " entries for " << model.size() << " keys, or a key twice"
+			<< endl;
+		return false;
+	}
+	if (summary.getTotal() != total || summary.getMinimum() != (kept.size() < summary.getCapacity() ? 0 : smallest)) {
+		out << "space saving: " << what << ", total " << summary.getTotal() << " and minimum " << summary.getMinimum()
+			<< ", expected " << total << " and " << smallest << endl;
+		return false;
+	}
+	if (!summed)
+		return true;
+
+	if (counted != total) {
+		out << "space saving: " << what << ", counts add up to " << counted << " of " << total << endl;
+		return false;
+	}
+	for (const auto& key : model) {
+		if (key.second * summary.getCapacity() > total && !binary_search(kept.begin(), kept.end(), key.first)) {
+			out << "space saving: " << what << ", key " << key.first << " of weight " << key.second << " in " << total
+				<< " was not kept" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// updates to both the summary and the model; with bounds, each is the key's true weight so far
+static bool feed(mt19937_64& random, SpaceSaving& summary, SpaceSavingTestModel& model, const unsigned& keys,
+	const bool& bounded, const bool& summed, ostream& out)
+{
+	for (unsigned u(1); u <= SPACE_SAVING_TEST_UPDATES; u++) {
+		const uint32_t index(pickKey(random, keys));
+		const uint64_t weight(random() % 10 + 1);
+
+		model[index] += weight;
+		if (bounded)
+			summary.add(makeKey(index), makeHash(index), weight, model[index]);
+		else
+			summary.add(makeKey(index), makeHash(index), weight);
+
+		if (u % SPACE_SAVING_TEST_CHECK == 0 && !check(summary, model, summed, "while adding", out))
+			return false;
+	}
+	return check(summary, model, summed, "after adding", out);
+}
+
+/*
+ * Keys keep taking each other's counters, which deletes them from the
+ * lookup table while their neighbours stay, and summaries merge both
+ * with and without room for every key.
+ */
+bool testSpaceSaving(const uint64_t& seed, ostream& out)
+{
+	mt19937_64 random(seed);
+
+	for (unsigned r(0); r < SPACE_SAVING_TEST_ROUNDS; r++) {
+		for (const unsigned& capacity : capacities) {
+			const unsigned keys(capacity * 4 + random() % 64 + 1);
+			const bool bounded(random() % 4 == 0);
+			SpaceSavingTestModel ours, theirs, both;
+			SpaceSaving summary(capacity), other(capacity), merged(capacity);
+
+			if (!feed(random, summary, ours, keys, bounded, !bounded, out)
+					|| !feed(random, other, theirs, keys, bounded, !bounded, out))
+				return false;
+
+			// into an empty summary, which changes nothing
+			merged.merge(other);
+			if (!check(merged, theirs, !bounded, "merged into an empty summary", out))
+				return false;
+
+			both = ours;
+			for (const auto& key : theirs)
+				both[key.first] += key.second;
+			summary.merge(other);
+			if (!check(summary, both, false, "merged", out))
+				return false;
+
+			// the merged table and heap must carry on like any other
+			if (!feed(random, summary, both, keys, bounded, false, out))
+				return false;
+		}
+	}
+
+	// room for every key on both sides, so nothing is estimated
+	for (const unsigned& capacity : capacities) {
+		SpaceSavingTestModel ours, theirs;
+		SpaceSaving summary(capacity), other(capacity);
+		vector<SpaceSavingEntry> top;
+
+		for (uint32_t index(0); index < capacity; index++) {
+			if (random() % 2) {
+				ours[index] = random() % 100 + 1;
+				summary.add(makeKey(index), makeHash(index), ours[index]);
+			}
+			if (random() % 2) {
+				theirs[index] = random() % 100 + 1;
+				other.add(makeKey(index), makeHash(index), theirs[index]);
+			}
+		}
+		summary.merge(other);
+		for (const auto& key : theirs)
+			ours[key.first] += key.second;
+
+		summary.getTop(capacity, top);
+		for (const SpaceSavingEntry& entry : top) {
+			if (entry.count != ours[indexOf(entry.key)] || entry.error) {
+				out << "space saving: merging room for " << capacity << " keys counted key " << indexOf(entry.key)
+					<< " as " << entry.count << " with error " << entry.error << endl;
+				return false;
+			}
+		}
+		if (!check(summary, ours, true, "merged with room for every key", out))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <StreamReassembler.hpp>
+#include <TcpFrame.hpp>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+#define STREAM_TEST_ROUNDS			200
+#define STREAM_TEST_FLOWS			4
+// measured in octets
+#define STREAM_TEST_MAX_LENGTH		30000
+#define STREAM_TEST_MAX_SEGMENT		3000
+// the segments of the capped tests, each fits one chunk
+#define STREAM_TEST_SEGMENT			1000
+
+struct StreamTestSegment {
+	uint32_t offset;
+	uint32_t length;
+	// retransmissions carry other bytes, which must lose to the first copy
+	bool garbage;
+};
+
+// what one direction should read, and what it did
+struct StreamTestSide {
+	uint32_t start;
+	string truth;
+	string first;
+	vector<bool> seen;
+	string read;
+};
+
+static unsigned streamIndex(const uint32_t& flow, const int& side)
+{
+	return flow * 2 + side;
+}
+
+static char garbageAt(const uint32_t& offset)
+{
+	return static_cast<char>(~offset * 0x9E);
+}
+
+/*
+ * Every octet sent at least once, out of order, with overlapping and
+ * conflicting retransmissions mixed in and the sequence space wrapping
+ * for some streams. With room to spare nothing may be skipped or dropped,
+ * and each side must read exactly the first copy of every octet.
+ */
+static bool testStreamOverlaps(mt19937_64& random, ostream& out)
+{
+	StreamReassembler streams(STREAM_TEST_FLOWS, STREAM_FLOW_MAX_BYTES, STREAM_MAX_BYTES);
+	StreamTestSide sides[STREAM_TEST_FLOWS * 2];
+	vector<pair<unsigned, StreamTestSegment>> segments;
+	uint64_t sent(0);
+
+	streams.setCallback([&sides](const uint32_t& flow, const int& side, const char* data, const unsigned& length) {
+		sides[streamIndex(flow, side)].read.append(data, length);
+	});
+
+	for (unsigned s(0); s < STREAM_TEST_FLOWS * 2; s++) {
+		StreamTestSide& side(sides[s]);
+		const uint32_t length(random() % STREAM_TEST_MAX_LENGTH + 1);
+
+		side.start = random() % 4 ? random() : 0xFFFFFFFF - random() % STREAM_TEST_MAX_LENGTH;
+		side.truth.resize(length);
+		for (char& c : side.truth)
+			c = random();
+		side.first.assign(length, 0);
+		side.seen.assign(length, false);
+
+		for (uint32_t at(0); at < length;) {
+			const uint32_t piece(min<uint32_t>(length - at, random() % STREAM_TEST_MAX_SEGMENT + 1));
+			segments.push_back({ s, { at, piece, false } });
+			at += piece;
+		}
+		for (unsigned r(random() % 20); r > 0; r--) {
+			const uint32_t at(random() % length);
+			const uint32_t piece(min<uint32_t>(length - at, random() % STREAM_TEST_MAX_SEGMENT + 1));
+			segments.push_back({ s, { at, piece, random() % 2 == 0 } });
+		}
+	}
+
+	// the SYNs go first, then everything else in any order
+	for (unsigned s(0); s < STREAM_TEST_FLOWS * 2; s++)
+		streams.segment(s / 2, s % 2, sides[s].start, TCP_FLAG_SYN, nullptr, 0);
+	shuffle(segments.begin(), segments.end(), random);
+
+	for (const auto& item : segments) {
+		StreamTestSide& side(sides[item.first]);
+		const StreamTestSegment& segment(item.second);
+		string payload(side.truth.substr(segment.offset, segment.length));
+
+		if (segment.garbage)
+			for (uint32_t i(0); i < segment.length; i++)
+				payload[i] = garbageAt(segment.offset + i);
+		for (uint32_t i(0); i < segment.length; i++) {
+			if (!side.seen[segment.offset + i]) {
+				side.seen[segment.offset + i] = true;
+				side.first[segment.offset + i] = payload[i];
+			}
+		}
+
+		streams.segment(item.first / 2, item.first % 2, side.start + 1 + segment.offset, TCP_FLAG_ACK, payload.data(),
+			segment.length);
+		sent += segment.length;
+	}
+
+	uint64_t delivered(0);
+	for (unsigned s(0); s < STREAM_TEST_FLOWS * 2; s++) {
+		const StreamTestSide& side(sides[s]);
+		if (side.read != side.first || streams.getSkipped(s / 2, s % 2)
+				|| streams.getDelivered(s / 2, s % 2) != side.truth.size()) {
+			out << "stream reassembler: side " << s << " read " << side.read.size() << " octets of "
+				<< side.truth.size() << ", or not the first copy of each" << endl;
+			return false;
+		}
+		delivered += side.read.size();
+	}
+
+	if (streams.getDropped() || streams.getOverlapped() != sent - delivered || streams.getBuffered()) {
+		out << "stream reassembler: " << streams.getOverlapped() << " octets trimmed and " << streams.getDropped()
+			<< " dropped, expected " << sent - delivered << " and 0" << endl;
+		return false;
+	}
+	return true;
+}
+
+// one segment of STREAM_TEST_SEGMENT octets, offset counted from the first data octet
+static void sendSegment(StreamReassembler& streams, const uint32_t& flow, const uint32_t& offset)
+{
+	char payload[STREAM_TEST_SEGMENT];
+
+	for (unsigned i(0); i < STREAM_TEST_SEGMENT; i++)
+		payload[i] = garbageAt(offset + i);
+	streams.segment(flow, 0, 1000 + 1 + offset, TCP_FLAG_ACK, payload, STREAM_TEST_SEGMENT);
+}
+
+static bool checkStream(const StreamReassembler& streams, const uint32_t& flow, const uint64_t& delivered,
+	const uint64_t& skipped, const char* when, ostream& out)
+{
+	if (streams.getDelivered(flow, 0) != delivered || streams.getSkipped(flow, 0) != skipped) {
+		out << "stream reassembler: " << when << ", flow " << flow << " delivered " << streams.getDelivered(flow, 0)
+			<< " and skipped " << streams.getSkipped(flow, 0) << ", expected " << delivered << " and " << skipped << endl;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * A flow with a hole at the front buffers until its own cap, then gives
+ * the hole up and delivers what it held. The global cap is shared: the
+ * flow that runs into it gives up its own hole, and with none to give up
+ * it drops the segment, without touching what another flow holds.
+ */
+static bool testStreamCaps(ostream& out)
+{
+	const unsigned perFlow(8 * STREAM_TEST_SEGMENT);
+	string read;
+
+	{
+		StreamReassembler streams(1, perFlow, STREAM_MAX_BYTES);
+		streams.setCallback([&read](const uint32_t&, const int&, const char* data, const unsigned& length) {
+			read.append(data, length);
+		});
+
+		streams.segment(0, 0, 1000, TCP_FLAG_SYN, nullptr, 0);
+		for (unsigned i(1); i <= 8; i++)
+			sendSegment(streams, 0, i * STREAM_TEST_SEGMENT);
+		if (!checkStream(streams, 0, 0, 0, "within the flow cap", out))
+			return false;
+
+		sendSegment(streams, 0, 9 * STREAM_TEST_SEGMENT);
+		if (!checkStream(streams, 0, 9 * STREAM_TEST_SEGMENT, STREAM_TEST_SEGMENT, "past the flow cap", out))
+			return false;
+		for (unsigned i(0); i < read.size(); i++) {
+			if (read[i] != garbageAt(STREAM_TEST_SEGMENT + i)) {
+				out << "stream reassembler: past the flow cap, octet " << i << " was not what was sent" << endl;
+				return false;
+			}
+		}
+
+		// the hole arriving late is behind the stream now
+		sendSegment(streams, 0, 0);
+		if (!checkStream(streams, 0, 9 * STREAM_TEST_SEGMENT, STREAM_TEST_SEGMENT, "after a late hole", out))
+			return false;
+		if (streams.getOverlapped() != STREAM_TEST_SEGMENT || streams.getBuffered()) {
+			out << "stream reassembler: a late hole left " << streams.getOverlapped() << " octets trimmed and "
+				<< streams.getBuffered() << " held" << endl;
+			return false;
+		}
+	}
+
+	// room for eight chunks, and a segment is only buffered with two to spare
+	StreamReassembler streams(3, STREAM_FLOW_MAX_BYTES, 8 * STREAM_CHUNK_LENGTH);
+
+	for (uint32_t flow(0); flow < 3; flow++)
+		streams.segment(flow, 0, 1000, TCP_FLAG_SYN, nullptr, 0);
+	for (unsigned i(1); i <= 6; i++)
+		sendSegment(streams, 0, i * STREAM_TEST_SEGMENT);
+	sendSegment(streams, 1, STREAM_TEST_SEGMENT);
+	if (streams.getBuffered() != 7 * STREAM_CHUNK_LENGTH) {
+		out << "stream reassembler: " << streams.getBuffered() << " octets of chunks held, expected "
+			<< 7 * STREAM_CHUNK_LENGTH << endl;
+		return false;
+	}
+
+	sendSegment(streams, 1, 2 * STREAM_TEST_SEGMENT);
+	if (!checkStream(streams, 1, 2 * STREAM_TEST_SEGMENT, STREAM_TEST_SEGMENT, "past the global cap", out)
+			|| !checkStream(streams, 0, 0, 0, "after another flow hit the global cap", out))
+		return false;
+
+	// flow 2 holds nothing, so a segment that cannot fit is dropped
+	streams.segment(2, 0, 1000 + 1 + STREAM_TEST_SEGMENT, TCP_FLAG_ACK, string(20 * STREAM_TEST_SEGMENT, 'x').data(),
+		20 * STREAM_TEST_SEGMENT);
+	if (streams.getDropped() != 20 * STREAM_TEST_SEGMENT || !checkStream(streams, 2, 0, 0, "after a drop", out)) {
+		out << "stream reassembler: dropped " << streams.getDropped() << " octets, expected "
+			<< 20 * STREAM_TEST_SEGMENT << endl;
+		return false;
+	}
+
+	for (uint32_t flow(0); flow < 3; flow++)
+		streams.release(flow);
+	if (streams.getBuffered()) {
+		out << "stream reassembler: " << streams.getBuffered() << " octets of chunks held after every flow left" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool testStreamReassembler(const uint64_t& seed, ostream& out)
+{
+	mt19937_64 random(seed);
+
+	for (unsigned r(0); r < STREAM_TEST_ROUNDS; r++)
+		if (!testStreamOverlaps(random, out))
+			return false;
+	return testStreamCaps(out);
+}
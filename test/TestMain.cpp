@@ -0,0 +1,40 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "Tests.hpp"
+
+using namespace std;
+
+struct Test {
+	const char* name;
+	bool (*run)(const uint64_t&, ostream&);
+};
+
+static const Test tests[] = {
+	{ "checksum", testChecksum },
+	{ "packet table", testPacketTable },
+	{ "filter", testFilter },
+	{ "flow table", testFlowTable },
+	{ "stream reassembler", testStreamReassembler },
+	{ "fragment reassembler", testFragmentReassembler },
+	{ "column format", testColumnFormat },
+	{ "frame bitmap", testFrameBitmap },
+	{ "space saving", testSpaceSaving }
+};
+
+// an optional argument replaces the seed, so a failure seen once can be replayed
+int main(int argc, char** argv)
+{
+	const uint64_t seed(argc > 1 ? strtoull(argv[1], nullptr, 0) : TEST_DEFAULT_SEED);
+	unsigned failed(0);
+
+	for (const Test& test : tests) {
+		const bool passed(test.run(seed, cerr));
+		cout << (passed ? "PASS " : "FAIL ") << test.name << endl;
+		failed += !passed;
+	}
+
+	cout << failed << " of " << sizeof(tests) / sizeof(tests[0]) << " failed (seed " << seed << ")" << endl;
+	return failed ? 1 : 0;
+}
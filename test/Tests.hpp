@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+/*
+ * Differential checks: every fast path is run on random input next to the
+ * plain loop it must agree with, and every table next to a plain model of
+ * what it should hold. Each check prints what differed and returns false
+ * on the first mismatch.
+ */
+
+#define TEST_DEFAULT_SEED 1
+
+bool testChecksum(const uint64_t&, std::ostream&);
+bool testPacketTable(const uint64_t&, std::ostream&);
+bool testFilter(const uint64_t&, std::ostream&);
+bool testFlowTable(const uint64_t&, std::ostream&);
+bool testStreamReassembler(const uint64_t&, std::ostream&);
+bool testFragmentReassembler(const uint64_t&, std::ostream&);
+bool testColumnFormat(const uint64_t&, std::ostream&);
+bool testFrameBitmap(const uint64_t&, std::ostream&);
+bool testSpaceSaving(const uint64_t&, std::ostream&);
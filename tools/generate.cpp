@@ -0,0 +1,220 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+
+#include <TrafficGenerator.hpp>
+
+using namespace std;
+
+// measured in octets
+#define OUTPUT_STREAM_BUFFER_LENGTH 0x100000
+
+bool parseOptions(int, char**, TrafficProfile&, string&, string&);
+bool parseNumber(const string&, uint64_t&, string&);
+bool parseRate(const string&, double&, string&);
+bool parseSize(const string&, TrafficProfile&, string&);
+bool parseMix(const string&, TrafficProfile&, string&);
+void printUsage(ostream&, const char*);
+
+int main(int argc, char** argv)
+{
+	TrafficProfile profile;
+	string filename;
+	string error;
+
+	if (!parseOptions(argc, argv, profile, filename, error)) {
+		cerr << error << endl;
+		printUsage(cerr, argv[0]);
+		return 1;
+	}
+
+	vector<char> streamBuffer(OUTPUT_STREAM_BUFFER_LENGTH);
+	ofstream file;
+	if (filename != "-") {
+		file.rdbuf()->pubsetbuf(streamBuffer.data(), streamBuffer.size());
+		file.open(filename, ios::binary | ios::trunc);
+		if (!file) {
+			cerr << "Cannot open " << filename << endl;
+			return 1;
+		}
+	}
+	ostream& out(filename == "-" ? cout : file);
+
+	TrafficGenerator generator(profile);
+	const auto start(chrono::steady_clock::now());
+	const bool ok(generator.write(out));
+	const double elapsed(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+	if (!ok) {
+		cerr << "Writing " << filename << " failed" << endl;
+		return 1;
+	}
+
+	cerr << "Wrote " << generator.getPackets() << " packets (" << generator.getBytes() << " bytes) in "
+		<< elapsed << "s" << endl;
+	cerr << generator.getFragmented() << " datagrams fragmented, " << generator.getReordered() << " packets reordered, "
+		<< generator.getCorrupted() << " checksums corrupted" << endl;
+	cerr << fixed << setprecision(0) << generator.getPackets() / (elapsed > 0 ? elapsed : 1e-9) << " packets/s" << endl;
+	return 0;
+}
+
+bool parseOptions(int argc, char** argv, TrafficProfile& profile, string& filename, string& error)
+{
+	for (int i(1); i < argc; i++) {
+		const string argument(argv[i]);
+		const size_t equals(argument.find('='));
+		const string name(argument.substr(0, equals));
+		const string value(equals == string::npos ? "" : argument.substr(equals + 1));
+		uint64_t number;
+
+		if (name == "--packets") {
+			if (!parseNumber(value, profile.packets, error))
+				return false;
+		} else if (name == "--flows") {
+			if (!parseNumber(value, number, error))
+				return false;
+			profile.flows = number;
+		} else if (name == "--seed") {
+			if (!parseNumber(value, profile.seed, error))
+				return false;
+		} else if (name == "--size") {
+			if (!parseSize(value, profile, error))
+				return false;
+		} else if (name == "--mix") {
+			if (!parseMix(value, profile, error))
+				return false;
+		} else if (name == "--ipv6") {
+			if (!parseRate(value, profile.ipv6Rate, error))
+				return false;
+		} else if (name == "--vlan") {
+			if (!parseRate(value, profile.vlanRate, error))
+				return false;
+		} else if (name == "--fragment") {
+			if (!parseRate(value, profile.fragmentRate, error))
+				return false;
+		} else if (name == "--reorder") {
+			if (!parseRate(value, profile.reorderRate, error))
+				return false;
+		} else if (name == "--corrupt") {
+			if (!parseRate(value, profile.corruptRate, error))
+				return false;
+		} else if (argument.size() > 1 && argument[0] == '-') {
+			error = "Unknown option: " + argument;
+			return false;
+		} else if (filename.empty()) {
+			filename = argument;
+		} else {
+			error = "Only one output file can be written at a time";
+			return false;
+		}
+	}
+
+	if (filename.empty()) {
+		error = "No output file given";
+		return false;
+	}
+	if (profile.flows == 0) {
+		error = "At least one flow is needed";
+		return false;
+	}
+	return true;
+}
+
+bool parseNumber(const string& value, uint64_t& out, string& error)
+{
+	char* end;
+	const unsigned long long parsed(strtoull(value.c_str(), &end, 10));
+
+	if (value.empty() || *end != '\0') {
+		error = "Expected a number, got: " + value;
+		return false;
+	}
+	out = parsed;
+	return true;
+}
+
+bool parseRate(const string& value, double& out, string& error)
+{
+	char* end;
+	const double parsed(strtod(value.c_str(), &end));
+
+	if (value.empty() || *end != '\0' || parsed < 0 || parsed > 1) {
+		error = "Expected a rate between 0 and 1, got: " + value;
+		return false;
+	}
+	out = parsed;
+	return true;
+}
+
+// N for a fixed length, MIN-MAX for a uniform spread, or imix
+bool parseSize(const string& value, TrafficProfile& profile, string& error)
+{
+	const size_t dash(value.find('-'));
+	uint64_t low, high;
+
+	if (value == "imix") {
+		profile.sizeMode = TRAFFIC_SIZE_IMIX;
+		return true;
+	}
+
+	if (!parseNumber(value.substr(0, dash), low, error))
+		return false;
+	high = low;
+	if (dash != string::npos && !parseNumber(value.substr(dash + 1), high, error))
+		return false;
+
+	if (low < TRAFFIC_MIN_FRAME_LENGTH || high > TRAFFIC_MAX_FRAME_LENGTH || low > high) {
+		error = "Frame lengths go from " + to_string(TRAFFIC_MIN_FRAME_LENGTH) + " to "
+			+ to_string(TRAFFIC_MAX_FRAME_LENGTH) + ", got: " + value;
+		return false;
+	}
+
+	profile.sizeMode = dash == string::npos ? TRAFFIC_SIZE_FIXED : TRAFFIC_SIZE_UNIFORM;
+	profile.minSize = low;
+	profile.maxSize = high;
+	return true;
+}
+
+// TCP:UDP:ICMP weights
+bool parseMix(const string& value, TrafficProfile& profile, string& error)
+{
+	const size_t first(value.find(':'));
+	const size_t second(first == string::npos ? string::npos : value.find(':', first + 1));
+	uint64_t tcp, udp, icmp;
+
+	if (second == string::npos) {
+		error = "Expected TCP:UDP:ICMP weights, got: " + value;
+		return false;
+	}
+	if (!parseNumber(value.substr(0, first), tcp, error) || !parseNumber(value.substr(first + 1, second - first - 1), udp, error)
+			|| !parseNumber(value.substr(second + 1), icmp, error))
+		return false;
+	if (tcp + udp + icmp == 0 || tcp + udp + icmp > 0xFFFFFFFF) {
+		error = "Weights must add up to something between 1 and 2^32 - 1, got: " + value;
+		return false;
+	}
+
+	profile.tcpWeight = tcp;
+	profile.udpWeight = udp;
+	profile.icmpWeight = icmp;
+	return true;
+}
+
+void printUsage(ostream& out, const char* program)
+{
+	out << "Usage: " << program << " [options] <output pcap, or - for stdout>" << endl;
+	out << "Options:" << endl;
+	out << "\t--packets=N\tpackets to write (default: " << TRAFFIC_DEFAULT_PACKETS << ")" << endl;
+	out << "\t--flows=N\tconversations to spread them over (default: " << TRAFFIC_DEFAULT_FLOWS << ")" << endl;
+	out << "\t--seed=N\tsame seed and options, same file (default: " << TRAFFIC_DEFAULT_SEED << ")" << endl;
+	out << "\t--size=N|MIN-MAX|imix\tframe length, fixed, uniform or 7:4:1 of 60, 590 and 1514 (default: imix)" << endl;
+	out << "\t--mix=T:U:I\tTCP, UDP and ICMP flow weights (default: 80:15:5)" << endl;
+	out << "\t--ipv6=R\tshare of flows over IPv6 (default: 0)" << endl;
+	out << "\t--vlan=R\tshare of flows with an 802.1Q tag (default: 0)" << endl;
+	out << "\t--fragment=R\tshare of IPv4 datagrams sent as two fragments (default: 0)" << endl;
+	out << "\t--reorder=R\tshare of packets swapped with the next one of their flow and direction (default: 0)" << endl;
+	out << "\t--corrupt=R\tshare of packets with a wrong transport checksum (default: 0)" << endl;
+}
@@ -0,0 +1,422 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <MappedCapture.hpp>
+#include <SearchIndex.hpp>
+#include <PacketSummary.hpp>
+#include <OutputBuffer.hpp>
+#include <IpFrame.hpp>
+
+using namespace std;
+
+// measured in octets
+#define OUTPUT_STREAM_BUFFER_LENGTH 0x100000
+// listed matches are written once this much has gathered
+#define QUERY_OUTPUT_LENGTH 0x40000
+// hosts and ports given are matched against either end, so two of each pin down a connection
+#define QUERY_MAX_HOSTS 2
+#define QUERY_MAX_PORTS 2
+
+// what a frame must have to be listed; each host and port may be at either end
+struct Query {
+	vector<uint32_t> hosts;
+	vector<uint16_t> ports;
+	int protocol;
+	uint64_t from;
+	uint64_t to;
+	string output;
+	bool rebuild;
+
+	Query() : protocol(-1), from(0), to(UINT64_MAX), rebuild(false) {}
+};
+
+bool parseOptions(int, char**, Query&, string&, string&);
+bool parseNumber(const string&, uint64_t&, string&);
+bool parseTime(const string&, uint64_t&, string&);
+bool parseProtocol(const string&, int&, string&);
+bool openIndex(const MappedCapture&, const string&, const bool&, SearchIndex&);
+bool run(const MappedCapture&, const SearchIndex&, const Query&);
+bool matches(const Query&, const CaptureRecord&);
+void printMatch(OutputBuffer&, const uint64_t&, const CaptureRecord&);
+void writePcapHeader(ostream&, const unsigned&);
+void writePcapRecord(ostream&, const CaptureRecord&);
+void printUsage(ostream&, const char*);
+
+int main(int argc, char** argv)
+{
+	Query query;
+	string filename;
+	string error;
+
+	if (!parseOptions(argc, argv, query, filename, error)) {
+		cerr << error << endl;
+		printUsage(cerr, argv[0]);
+		return 1;
+	}
+
+	MappedCapture capture;
+	if (!capture.open(filename)) {
+		cerr << "Cannot map " << filename << ", only regular capture files can be indexed" << endl;
+		return 1;
+	}
+
+	SearchIndex index;
+	if (!openIndex(capture, filename, query.rebuild, index))
+		return 1;
+	return run(capture, index, query) ? 0 : 1;
+}
+
+bool parseOptions(int argc, char** argv, Query& query, string& filename, string& error)
+{
+	for (int i(1); i < argc; i++) {
+		const string argument(argv[i]);
+		const size_t equals(argument.find('='));
+		const string name(argument.substr(0, equals));
+		const string value(equals == string::npos ? "" : argument.substr(equals + 1));
+		uint64_t number;
+
+		if (name == "--host") {
+			in_addr address;
+			if (inet_pton(AF_INET, value.c_str(), &address) != 1) {
+				error = "Expected an IPv4 address, got: " + value;
+				return false;
+			}
+			if (query.hosts.size() == QUERY_MAX_HOSTS) {
+				error = "At most two hosts can be given";
+				return false;
+			}
+			query.hosts.push_back(ntohl(address.s_addr));
+		} else if (name == "--port") {
+			if (!parseNumber(value, number, error))
+				return false;
+			if (number > 0xFFFF || query.ports.size() == QUERY_MAX_PORTS) {
+				error = number > 0xFFFF ? "Ports go up to 65535, got: " + value : "At most two ports can be given";
+				return false;
+			}
+			query.ports.push_back(number);
+		} else if (name == "--proto") {
+			if (!parseProtocol(value, query.protocol, error))
+				return false;
+		} else if (name == "--from") {
+			if (!parseTime(value, query.from, error))
+				return false;
+		} else if (name == "--to") {
+			if (!parseTime(value, query.to, error))
+				return false;
+		} else if (name == "--write") {
+			query.output = value;
+		} else if (name == "--rebuild") {
+			query.rebuild = true;
+		} else if (argument.size() > 1 && argument[0] == '-') {
+			error = "Unknown option: " + argument;
+			return false;
+		} else if (filename.empty()) {
+			filename = argument;
+		} else {
+			error = "Only one capture file can be searched at a time";
+			return false;
+		}
+	}
+
+	if (filename.empty()) {
+		error = "No capture file given";
+		return false;
+	}
+	if (query.from > query.to) {
+		error = "--from is after --to";
+		return false;
+	}
+	return true;
+}
+
+bool parseNumber(const string& value, uint64_t& out, string& error)
+{
+	char* end;
+	const unsigned long long parsed(strtoull(value.c_str(), &end, 10));
+
+	if (value.empty() || *end != '\0') {
+		error = "Expected a number, got: " + value;
+		return false;
+	}
+	out = parsed;
+	return true;
+}
+
+// seconds since the epoch, with up to nine decimals
+bool parseTime(const string& value, uint64_t& out, string& error)
+{
+	const size_t dot(value.find('.'));
+	const string fraction(dot == string::npos ? "" : value.substr(dot + 1));
+	uint64_t seconds;
+	uint64_t nanoseconds(0);
+
+	if (!parseNumber(value.substr(0, dot), seconds, error))
+		return false;
+	if (fraction.size() > 9 || (!fraction.empty() && !parseNumber(fraction, nanoseconds, error))) {
+		error = "Expected seconds with at most nine decimals, got: " + value;
+		return false;
+	}
+	for (size_t digits(fraction.size()); digits < 9; digits++)
+		nanoseconds *= 10;
+
+	out = seconds * 1000000000 + nanoseconds;
+	return true;
+}
+
+bool parseProtocol(const string& value, int& out, string& error)
+{
+	uint64_t number;
+
+	if (value == "tcp")
+		out = IP_PROTOCOL_TCP;
+	else if (value == "udp")
+		out = IP_PROTOCOL_UDP;
+	else if (value == "icmp")
+		out = IP_PROTOCOL_ICMP;
+	else if (parseNumber(value, number, error) && number <= 0xFF)
+		out = number;
+	else {
+		error = "Expected tcp, udp, icmp or a protocol number, got: " + value;
+		return false;
+	}
+	return true;
+}
+
+// loads the saved index if it still matches the capture, otherwise builds and saves it
+bool openIndex(const MappedCapture& capture, const string& filename, const bool& rebuild, SearchIndex& index)
+{
+	const string indexName(filename + SEARCH_INDEX_SUFFIX);
+
+	if (!rebuild && index.load(indexName, capture.getLength(), capture.getModified())) {
+		cerr << "Search index loaded from " << indexName << endl;
+		return true;
+	}
+
+	const auto start(chrono::steady_clock::now());
+	if (!index.build(capture.getBytes(), capture.getLength(), capture.getModified())) {
+		cerr << "Cannot index " << filename << ", only pcap and pcapng captures can be" << endl;
+		return false;
+	}
+	const double elapsed(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+	cerr << "Indexed " << index.getFrames() << " frames, " << index.getAddressCount() << " addresses and "
+		<< index.getPortCount() << " ports in " << elapsed << "s (" << index.getLength() << " bytes)" << endl;
+	if (index.save(indexName))
+		cerr << "Search index saved to " << indexName << endl;
+	else
+		cerr << "Search index could not be saved to " << indexName << ", it only lasts this run" << endl;
+	return true;
+}
+
+/*
+ * Hosts and ports narrow the frames down through their bitmaps, times
+ * through the checkpoint spans. Only the blocks of frames left are walked,
+ * each from its checkpoint, and every candidate is decoded once more to
+ * check it really has all of it: bitmaps say a frame has some host, not on
+ * which end, and a checkpoint span covers a whole block.
+ */
+bool run(const MappedCapture& capture, const SearchIndex& index, const Query& query)
+{
+	const char* bytes(capture.getBytes());
+	const uint64_t length(capture.getLength());
+	const bool narrowed(!query.hosts.empty() || !query.ports.empty());
+	FrameBitmap candidates;
+	FrameBitmap frames;
+	vector<uint32_t> wanted;
+	OutputBuffer out;
+	vector<char> streamBuffer;
+	ofstream file;
+	bool headerWritten(false);
+	uint64_t blocks(0);
+	uint64_t matched(0);
+
+	const auto start(chrono::steady_clock::now());
+
+	for (size_t i(0); i < query.hosts.size() + query.ports.size(); i++) {
+		if (i < query.hosts.size())
+			index.findAddress(query.hosts[i], frames);
+		else
+			index.findPort(query.ports[i - query.hosts.size()], frames);
+		if (i == 0)
+			swap(candidates, frames);
+		else
+			candidates.intersect(frames);
+	}
+	candidates.getFrames(wanted);
+
+	if (!query.output.empty() && query.output != "-") {
+		streamBuffer.resize(OUTPUT_STREAM_BUFFER_LENGTH);
+		file.rdbuf()->pubsetbuf(streamBuffer.data(), streamBuffer.size());
+		file.open(query.output, ios::binary | ios::trunc);
+		if (!file) {
+			cerr << "Cannot open " << query.output << endl;
+			return false;
+		}
+	}
+	ostream& pcap(query.output == "-" ? cout : file);
+
+	// pcapng keeps its interfaces in blocks ahead of the first frame, which every walk needs to have seen
+	CaptureFormat format;
+	CaptureRecord record;
+	format.detect(bytes, length < CAPTURE_DETECT_LENGTH ? length : CAPTURE_DETECT_LENGTH);
+	const unsigned headerLength(format.getRecordHeaderLength());
+	const uint64_t firstFrame(index.getCheckpointCount() ? index.getCheckpoint(0).offset : length);
+	for (uint64_t position(format.getFileHeaderLength()); position + headerLength <= firstFrame; ) {
+		const unsigned recordLength(format.getRecordLength(bytes + position));
+		if (recordLength < headerLength)
+			break;
+		format.parseRecord(bytes + position, recordLength, record);
+		position += recordLength;
+	}
+
+	auto next(wanted.begin());
+	for (uint64_t b(0); b < index.getCheckpointCount(); b++) {
+		const SearchCheckpoint& checkpoint(index.getCheckpoint(b));
+		const uint64_t first(b * SEARCH_INDEX_STRIDE);
+		const uint64_t last(first + SEARCH_INDEX_STRIDE < index.getFrames() ? first + SEARCH_INDEX_STRIDE : index.getFrames());
+
+		while (narrowed && next != wanted.end() && *next < first)
+			next++;
+		if (narrowed && (next == wanted.end() || *next >= last))
+			continue;
+		if (checkpoint.maximumTimestamp < query.from || checkpoint.minimumTimestamp > query.to)
+			continue;
+		blocks++;
+
+		uint64_t position(checkpoint.offset);
+		for (uint64_t frame(first); frame < last && position + headerLength <= length; ) {
+			const unsigned recordLength(format.getRecordLength(bytes + position));
+			if (recordLength < headerLength || position + recordLength > length)
+				break;
+
+			if (format.parseRecord(bytes + position, recordLength, record)) {
+				const bool candidate(!narrowed || (next != wanted.end() && *next == frame));
+				if (candidate && matches(query, record)) {
+					matched++;
+					if (query.output.empty()) {
+						printMatch(out, frame, record);
+					} else {
+						if (!headerWritten)
+							writePcapHeader(pcap, record.linkType);
+						headerWritten = true;
+						writePcapRecord(pcap, record);
+					}
+				}
+				if (narrowed && next != wanted.end() && *next == frame)
+					next++;
+				frame++;
+			}
+			position += recordLength;
+		}
+
+		if (out.size() >= QUERY_OUTPUT_LENGTH && !out.flush(STDOUT_FILENO)) {
+			cerr << "Writing the output failed" << endl;
+			return false;
+		}
+	}
+
+	if (!query.output.empty() && !headerWritten)
+		writePcapHeader(pcap, LINKTYPE_ETHERNET);
+	pcap.flush();
+	if (!out.flush(STDOUT_FILENO) || !pcap) {
+		cerr << "Writing the output failed" << endl;
+		return false;
+	}
+
+	const double elapsed(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+	if (narrowed)
+		cerr << wanted.size() << " candidate frames from the index, ";
+	cerr << matched << " matched, " << blocks << " of " << index.getCheckpointCount() << " blocks read in "
+		<< fixed << setprecision(3) << elapsed * 1000 << " ms" << endl;
+	return true;
+}
+
+bool matches(const Query& query, const CaptureRecord& record)
+{
+	PacketSummary summary;
+
+	if (record.timestamp < query.from || record.timestamp > query.to)
+		return false;
+	if (query.hosts.empty() && query.ports.empty() && query.protocol < 0)
+		return true;
+	if (record.linkType != LINKTYPE_ETHERNET || !summary.fromBytes(record.data, record.capturedLength, record.timestamp))
+		return false;
+
+	for (const uint32_t& host : query.hosts) {
+		if (!(summary.layers & PACKET_LAYER_IPV4) || (summary.sourceAddress != host && summary.destinationAddress != host))
+			return false;
+	}
+	for (const uint16_t& port : query.ports) {
+		if (!(summary.layers & (PACKET_LAYER_TCP | PACKET_LAYER_UDP))
+				|| (summary.sourcePort != port && summary.destinationPort != port))
+			return false;
+	}
+	return query.protocol < 0
+		|| ((summary.layers & (PACKET_LAYER_IPV4 | PACKET_LAYER_IPV6)) && summary.protocol == query.protocol);
+}
+
+void printMatch(OutputBuffer& out, const uint64_t& frame, const CaptureRecord& record)
+{
+	PacketSummary summary;
+	char fraction[10];
+	uint64_t nanoseconds(record.timestamp % 1000000000);
+
+	// zero padded, which the decimal encoder does not do
+	for (int i(8); i >= 0; i--, nanoseconds /= 10)
+		fraction[i] = '0' + nanoseconds % 10;
+	fraction[9] = ' ';
+
+	out.text("frame ").decimal(frame).put(' ').decimal(record.timestamp / 1000000000).put('.').text(fraction, sizeof(fraction));
+
+	if (record.linkType == LINKTYPE_ETHERNET && summary.fromBytes(record.data, record.capturedLength, record.timestamp)
+			&& (summary.layers & PACKET_LAYER_IPV4)) {
+		const bool ports(summary.layers & (PACKET_LAYER_TCP | PACKET_LAYER_UDP));
+		out.ipv4(summary.sourceAddress);
+		if (ports)
+			out.put(':').decimal(summary.sourcePort);
+		out.text(" -> ").ipv4(summary.destinationAddress);
+		if (ports)
+			out.put(':').decimal(summary.destinationPort);
+		out.text(" proto ").decimal(summary.protocol).put(' ');
+	}
+	out.decimal(record.capturedLength).text(" bytes\n");
+}
+
+void writePcapHeader(ostream& out, const unsigned& linkType)
+{
+	const uint32_t header[6] = { PCAP_MAGIC_NANOSECONDS, 2 | 4 << 16, 0, 0, CAPTURE_MAX_RECORD_LENGTH, linkType };
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+void writePcapRecord(ostream& out, const CaptureRecord& record)
+{
+	const uint32_t header[4] = {
+		static_cast<uint32_t>(record.timestamp / 1000000000),
+		static_cast<uint32_t>(record.timestamp % 1000000000),
+		record.capturedLength,
+		record.originalLength
+	};
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+	out.write(record.data, record.capturedLength);
+}
+
+void printUsage(ostream& out, const char* program)
+{
+	out << "Usage: " << program << " [options] <pcap or pcapng capture>" << endl;
+	out << "Indexes the capture on first use (saved as <capture>" << SEARCH_INDEX_SUFFIX << ") and lists the matching frames" << endl;
+	out << "Options:" << endl;
+	out << "\t--host=A.B.C.D\tframes to or from the host; give two for a conversation" << endl;
+	out << "\t--port=N\tframes with the TCP or UDP port at either end; give two for a connection" << endl;
+	out << "\t--proto=NAME\ttcp, udp, icmp or an IP protocol number" << endl;
+	out << "\t--from=SECONDS\tframes captured at or after, seconds since the epoch with up to nine decimals" << endl;
+	out << "\t--to=SECONDS\tframes captured at or before" << endl;
+	out << "\t--write=FILE\twrite the matching frames to a pcap instead of listing them (- for stdout)" << endl;
+	out << "\t--rebuild\tindex the capture again even if a saved index matches it" << endl;
+}
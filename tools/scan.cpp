@@ -0,0 +1,298 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <ColumnReader.hpp>
+#include <OutputBuffer.hpp>
+
+using namespace std;
+
+// output is written once this much has gathered
+#define SCAN_OUTPUT_LENGTH 0x40000
+
+// rows are kept when the column holds a value in [low, high]
+struct Condition {
+	ColumnId column;
+	uint64_t low;
+	uint64_t high;
+};
+
+bool parseOptions(int, char**, vector<ColumnId>&, vector<Condition>&, bool&, string&, string&);
+bool parseColumns(const string&, vector<ColumnId>&, string&);
+bool parseCondition(const string&, Condition&, string&);
+bool parseValue(const ColumnId&, const string&, uint64_t&, string&);
+bool scan(ColumnReader&, const vector<ColumnId>&, const vector<Condition>&);
+void describe(const ColumnReader&);
+void printValue(OutputBuffer&, const ColumnId&, const uint64_t&);
+void printUsage(ostream&, const char*);
+
+int main(int argc, char** argv)
+{
+	vector<ColumnId> columns;
+	vector<Condition> conditions;
+	bool describing(false);
+	string filename;
+	string error;
+
+	if (!parseOptions(argc, argv, columns, conditions, describing, filename, error)) {
+		cerr << error << endl;
+		printUsage(cerr, argv[0]);
+		return 1;
+	}
+
+	ColumnReader reader;
+	if (!reader.open(filename)) {
+		cerr << reader.getError() << endl;
+		return 1;
+	}
+
+	if (describing) {
+		describe(reader);
+		return 0;
+	}
+	return scan(reader, columns, conditions) ? 0 : 1;
+}
+
+bool parseOptions(int argc, char** argv, vector<ColumnId>& columns, vector<Condition>& conditions, bool& describing,
+	string& filename, string& error)
+{
+	for (int i(1); i < argc; i++) {
+		const string argument(argv[i]);
+		const size_t equals(argument.find('='));
+		const string name(argument.substr(0, equals));
+		const string value(equals == string::npos ? "" : argument.substr(equals + 1));
+
+		if (name == "--columns") {
+			if (!parseColumns(value, columns, error))
+				return false;
+		} else if (name == "--where") {
+			Condition condition;
+			if (!parseCondition(value, condition, error))
+				return false;
+			conditions.push_back(condition);
+		} else if (name == "--describe") {
+			describing = true;
+		} else if (argument.size() > 1 && argument[0] == '-') {
+			error = "Unknown option: " + argument;
+			return false;
+		} else if (filename.empty()) {
+			filename = argument;
+		} else {
+			error = "Only one column file can be scanned at a time";
+			return false;
+		}
+	}
+
+	if (filename.empty()) {
+		error = "No column file given";
+		return false;
+	}
+	if (columns.empty()) {
+		for (unsigned c(0); c < COLUMN_COUNT; c++)
+			columns.push_back(static_cast<ColumnId>(c));
+	}
+	return true;
+}
+
+bool parseColumns(const string& value, vector<ColumnId>& columns, string& error)
+{
+	size_t start(0);
+
+	columns.clear();
+	while (start <= value.size()) {
+		const size_t comma(value.find(',', start));
+		const string name(value.substr(start, comma == string::npos ? string::npos : comma - start));
+		ColumnId column;
+
+		if (!ColumnFormat::parseName(name, column)) {
+			error = "Unknown column: " + name;
+			return false;
+		}
+		columns.push_back(column);
+		if (comma == string::npos)
+			break;
+		start = comma + 1;
+	}
+	return true;
+}
+
+// COLUMN=VALUE or COLUMN=LOW-HIGH, addresses in dotted quads
+bool parseCondition(const string& value, Condition& condition, string& error)
+{
+	const size_t equals(value.find('='));
+	if (equals == string::npos || !ColumnFormat::parseName(value.substr(0, equals), condition.column)) {
+		error = "Expected COLUMN=VALUE or COLUMN=LOW-HIGH, got: " + value;
+		return false;
+	}
+
+	const string range(value.substr(equals + 1));
+	const size_t dash(range.find('-'));
+	if (!parseValue(condition.column, range.substr(0, dash), condition.low, error))
+		return false;
+	condition.high = condition.low;
+	if (dash != string::npos && !parseValue(condition.column, range.substr(dash + 1), condition.high, error))
+		return false;
+	if (condition.low > condition.high) {
+		error = "Empty range: " + value;
+		return false;
+	}
+	return true;
+}
+
+bool parseValue(const ColumnId& column, const string& value, uint64_t& out, string& error)
+{
+	if ((column == COLUMN_SOURCE_ADDRESS || column == COLUMN_DESTINATION_ADDRESS) && value.find('.') != string::npos) {
+		in_addr address;
+		if (inet_pton(AF_INET, value.c_str(), &address) != 1) {
+			error = "Expected an IPv4 address, got: " + value;
+			return false;
+		}
+		out = ntohl(address.s_addr);
+		return true;
+	}
+
+	char* end;
+	const unsigned long long parsed(strtoull(value.c_str(), &end, 10));
+	if (value.empty() || *end != '\0') {
+		error = "Expected a number, got: " + value;
+		return false;
+	}
+	out = parsed;
+	return true;
+}
+
+/*
+ * Row groups whose statistics rule out a condition are never read. In the
+ * rest, the condition columns are read first and the output columns only
+ * when some row is left.
+ */
+bool scan(ColumnReader& reader, const vector<ColumnId>& columns, const vector<Condition>& conditions)
+{
+	vector<vector<uint64_t>> values(COLUMN_COUNT);
+	vector<bool> loaded(COLUMN_COUNT);
+	vector<uint32_t> matching;
+	OutputBuffer out;
+	unsigned skipped(0);
+	uint64_t matched(0);
+
+	const auto start(chrono::steady_clock::now());
+
+	for (size_t c(0); c < columns.size(); c++)
+		out.text(c ? "," : "").text(ColumnFormat::getName(columns[c]));
+	out.put('\n');
+
+	for (unsigned g(0); g < reader.getRowGroupCount(); g++) {
+		const ColumnRowGroup& group(reader.getRowGroup(g));
+		bool possible(true);
+
+		for (const Condition& condition : conditions)
+			possible = possible && reader.mayContain(g, condition.column, condition.low, condition.high);
+		if (!possible) {
+			skipped++;
+			continue;
+		}
+
+		loaded.assign(COLUMN_COUNT, false);
+		matching.resize(group.rows);
+		for (uint32_t i(0); i < group.rows; i++)
+			matching[i] = i;
+
+		for (const Condition& condition : conditions) {
+			if (!loaded[condition.column]) {
+				if (!reader.read(g, condition.column, values[condition.column])) {
+					cerr << reader.getError() << endl;
+					return false;
+				}
+				loaded[condition.column] = true;
+			}
+
+			const vector<uint64_t>& column(values[condition.column]);
+			size_t kept(0);
+			for (const uint32_t& row : matching) {
+				if (column[row] >= condition.low && column[row] <= condition.high)
+					matching[kept++] = row;
+			}
+			matching.resize(kept);
+		}
+		if (matching.empty())
+			continue;
+
+		for (const ColumnId& column : columns) {
+			if (!loaded[column]) {
+				if (!reader.read(g, column, values[column])) {
+					cerr << reader.getError() << endl;
+					return false;
+				}
+				loaded[column] = true;
+			}
+		}
+
+		for (const uint32_t& row : matching) {
+			for (size_t c(0); c < columns.size(); c++) {
+				if (c)
+					out.put(',');
+				printValue(out, columns[c], values[columns[c]][row]);
+			}
+			out.put('\n');
+			if (out.size() >= SCAN_OUTPUT_LENGTH && !out.flush(STDOUT_FILENO)) {
+				cerr << "Writing the output failed" << endl;
+				return false;
+			}
+		}
+		matched += matching.size();
+	}
+
+	if (!out.flush(STDOUT_FILENO)) {
+		cerr << "Writing the output failed" << endl;
+		return false;
+	}
+
+	const double elapsed(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+	cerr << "Matched " << matched << " of " << reader.getRows() << " rows in " << elapsed << "s" << endl;
+	cerr << skipped << " of " << reader.getRowGroupCount() << " row groups skipped by their statistics, "
+		<< reader.getBytesRead() << " bytes read" << endl;
+	return true;
+}
+
+void describe(const ColumnReader& reader)
+{
+	for (unsigned g(0); g < reader.getRowGroupCount(); g++) {
+		const ColumnRowGroup& group(reader.getRowGroup(g));
+
+		cout << "Row group " << g << ": rows " << group.firstRow << " to " << group.firstRow + group.rows - 1 << endl;
+		for (unsigned c(0); c < COLUMN_COUNT; c++) {
+			const ColumnChunk& chunk(group.chunks[c]);
+			cout << "\t" << left << setw(10) << ColumnFormat::getName(static_cast<ColumnId>(c)) << right
+				<< setw(11) << ColumnFormat::getEncodingAsString(static_cast<ColumnEncoding>(chunk.encoding))
+				<< setw(3) << static_cast<unsigned>(chunk.width) << " bits" << setw(9) << chunk.length << " bytes"
+				<< "  min " << chunk.minimum << ", max " << chunk.maximum << endl;
+		}
+	}
+	cout << reader.getRows() << " rows in " << reader.getRowGroupCount() << " row groups" << endl;
+}
+
+void printValue(OutputBuffer& out, const ColumnId& column, const uint64_t& value)
+{
+	if (column == COLUMN_SOURCE_ADDRESS || column == COLUMN_DESTINATION_ADDRESS)
+		out.ipv4(value);
+	else
+		out.decimal(value);
+}
+
+void printUsage(ostream& out, const char* program)
+{
+	out << "Usage: " << program << " [options] <column file written by sniffer --export>" << endl;
+	out << "Options:" << endl;
+	out << "\t--columns=A,B,...\tcolumns to print as CSV (default: all)" << endl;
+	out << "\t--where=COLUMN=V|COLUMN=LOW-HIGH\tonly rows with the column in range, may be repeated" << endl;
+	out << "\t--describe\tprint the encoding, size and statistics of every chunk instead" << endl;
+	out << "Columns:";
+	for (unsigned c(0); c < COLUMN_COUNT; c++)
+		out << " " << ColumnFormat::getName(static_cast<ColumnId>(c));
+	out << endl;
+}